@@ -0,0 +1,4 @@
+--
+DELETE FROM `command` WHERE `name`='debug opcodes';
+INSERT INTO `command` (`name`, `help`) VALUES
+('debug opcodes', 'Syntax: .debug opcodes [reset] [#count]\n\nShows the #count (default 10) client opcodes whose handlers took the most time in World::UpdateSessions and Map::Update since the last reset, with packet count, total, average and max handler time.\n.debug opcodes reset starts counting over.');
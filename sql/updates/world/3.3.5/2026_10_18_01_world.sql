@@ -0,0 +1,8 @@
+--
+DELETE FROM `command` WHERE `name` IN ('debug profile','debug profile start','debug profile stop','debug profile reset','debug profile dump');
+INSERT INTO `command` (`name`, `help`) VALUES
+('debug profile', 'Syntax: .debug profile $subcommand\nType .debug profile to see the list of possible subcommands or .help debug profile $subcommand to see info on subcommands'),
+('debug profile start', 'Syntax: .debug profile start [#sampleRate]\n\nDiscards the recorded profile and starts measuring one in #sampleRate (default 16) map and session updates, with the opcode handlers, script hooks and AI updates they call.'),
+('debug profile stop', 'Syntax: .debug profile stop\n\nStops measuring, the recorded profile is kept until the next start or reset.'),
+('debug profile reset', 'Syntax: .debug profile reset\n\nDiscards the recorded profile.'),
+('debug profile dump', 'Syntax: .debug profile dump [$fileName]\n\nWrites the recorded profile to $fileName (default profile_<time>.folded) in the logs directory as folded stacks with estimated microseconds, the input of flamegraph.pl.');
@@ -0,0 +1,8 @@
+--
+DELETE FROM `command` WHERE `name` IN ('debug packetlog','debug packetlog status','debug packetlog account','debug packetlog opcode','debug packetlog map');
+INSERT INTO `command` (`name`, `help`) VALUES
+('debug packetlog', 'Syntax: .debug packetlog $subcommand\nType .debug packetlog to see the list of possible subcommands or .help debug packetlog $subcommand to see info on subcommands'),
+('debug packetlog status', 'Syntax: .debug packetlog status\n\nShows how many packets were logged, dropped because the writer fell behind and written, and the current filters.'),
+('debug packetlog account', 'Syntax: .debug packetlog account [#accountId...]\n\nLogs only packets of the given accounts, without ids packets of all accounts are logged.'),
+('debug packetlog opcode', 'Syntax: .debug packetlog opcode [$opcode...]\n\nLogs only the given opcodes (names or numbers), without opcodes all packets are logged.'),
+('debug packetlog map', 'Syntax: .debug packetlog map [#mapId...]\n\nLogs only packets of sessions whose character is on the given maps, without ids packets of all maps are logged.');
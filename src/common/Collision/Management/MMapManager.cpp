@@ -16,6 +16,8 @@
  */
 
 #include "MMapManager.h"
+#include "DetourCommon.h"
+#include "DetourNode.h"
 #include "Errors.h"
 #include "Log.h"
 #include "MapDefines.h"
@@ -24,6 +26,7 @@ namespace MMAP
 {
     constexpr char MAP_FILE_NAME_FORMAT[] = "{}mmaps/{:03}.mmap";
     constexpr char TILE_FILE_NAME_FORMAT[] = "{}mmaps/{:03}{:02}{:02}.mmtile";
+    constexpr int32 NAV_MESH_QUERY_MAX_NODES = 1024;
 
     // ######################## MMapManager ########################
     MMapManager::~MMapManager()
@@ -112,21 +115,8 @@ namespace MMAP
         return uint32(x << 16 | y);
     }
 
-    bool MMapManager::loadMap(std::string const& basePath, uint32 mapId, int32 x, int32 y)
+    bool MMapManager::ReadTile(std::string const& basePath, uint32 mapId, int32 x, int32 y, MMapTileData& tile)
     {
-        // make sure the mmap is loaded and ready to load tiles
-        if (!loadMapData(basePath, mapId))
-            return false;
-
-        // get this mmap data
-        MMapData* mmap = loadedMMaps[mapId];
-        ASSERT(mmap->navMesh);
-
-        // check if we already have this tile loaded
-        uint32 packedGridPos = packTileID(x, y);
-        if (mmap->loadedTileRefs.find(packedGridPos) != mmap->loadedTileRefs.end())
-            return false;
-
         // load this tile :: mmaps/MMMXXYY.mmtile
         std::string fileName = Trinity::StringFormat(TILE_FILE_NAME_FORMAT, basePath, mapId, x, y);
         FILE* file = fopen(fileName.c_str(), "rb");
@@ -164,11 +154,12 @@ namespace MMAP
 
         fseek(file, pos, SEEK_SET);
 
-        unsigned char* data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
-        ASSERT(data);
+        MMapTileData result;
+        result.data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
+        result.size = fileHeader.size;
+        ASSERT(result.data);
 
-        size_t result = fread(data, fileHeader.size, 1, file);
-        if (!result)
+        if (!fread(result.data, fileHeader.size, 1, file))
         {
             TC_LOG_ERROR("maps", "MMAP:loadMap: Bad header or data in mmap {:03}{:02}{:02}.mmtile", mapId, x, y);
             fclose(file);
@@ -177,12 +168,40 @@ namespace MMAP
 
         fclose(file);
 
-        dtMeshHeader* header = (dtMeshHeader*)data;
+        tile = std::move(result);
+        return true;
+    }
+
+    bool MMapManager::loadMap(std::string const& basePath, uint32 mapId, int32 x, int32 y, MMapTileData* preloaded /*= nullptr*/)
+    {
+        // make sure the mmap is loaded and ready to load tiles
+        if (!loadMapData(basePath, mapId))
+            return false;
+
+        // get this mmap data
+        MMapData* mmap = loadedMMaps[mapId];
+        ASSERT(mmap->navMesh);
+
+        // check if we already have this tile loaded
+        uint32 packedGridPos = packTileID(x, y);
+        if (mmap->loadedTileRefs.find(packedGridPos) != mmap->loadedTileRefs.end())
+            return false;
+
+        MMapTileData tile;
+        if (preloaded && preloaded->data)
+            tile = std::move(*preloaded);
+        else if (!ReadTile(basePath, mapId, x, y, tile))
+            return false;
+
+        dtMeshHeader* header = (dtMeshHeader*)tile.data;
         dtTileRef tileRef = 0;
 
+        std::unique_lock<std::shared_mutex> navMeshLock(mmap->navMeshLock);
+
         // memory allocated for data is now managed by detour, and will be deallocated when the tile is removed
-        if (dtStatusSucceed(mmap->navMesh->addTile(data, fileHeader.size, DT_TILE_FREE_DATA, 0, &tileRef)))
+        if (dtStatusSucceed(mmap->navMesh->addTile(tile.data, tile.size, DT_TILE_FREE_DATA, 0, &tileRef)))
         {
+            tile.data = nullptr;
             mmap->loadedTileRefs.insert(std::pair<uint32, dtTileRef>(packedGridPos, tileRef));
             ++loadedTiles;
             TC_LOG_DEBUG("maps", "MMAP:loadMap: Loaded mmtile {:03}[{:02}, {:02}] into {:03}[{:02}, {:02}]", mapId, x, y, mapId, header->x, header->y);
@@ -191,35 +210,8 @@ namespace MMAP
         else
         {
             TC_LOG_ERROR("maps", "MMAP:loadMap: Could not load {:03}{:02}{:02}.mmtile into navmesh", mapId, x, y);
-            dtFree(data);
-            return false;
-        }
-    }
-
-    bool MMapManager::loadMapInstance(std::string const& basePath, uint32 mapId, uint32 instanceId)
-    {
-        if (!loadMapData(basePath, mapId))
-            return false;
-
-        MMapData* mmap = loadedMMaps[mapId];
-        auto [queryItr, inserted] = mmap->navMeshQueries.try_emplace(instanceId, nullptr);
-        if (!inserted)
-            return true;
-
-        // allocate mesh query
-        dtNavMeshQuery* query = dtAllocNavMeshQuery();
-        ASSERT(query);
-        if (dtStatusFailed(query->init(mmap->navMesh, 1024)))
-        {
-            dtFreeNavMeshQuery(query);
-            mmap->navMeshQueries.erase(queryItr);
-            TC_LOG_ERROR("maps", "MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId {:03} instanceId {}", mapId, instanceId);
             return false;
         }
-
-        TC_LOG_DEBUG("maps", "MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId {:03} instanceId {}", mapId, instanceId);
-        queryItr->second = query;
-        return true;
     }
 
     bool MMapManager::unloadMap(uint32 mapId, int32 x, int32 y)
@@ -246,6 +238,8 @@ namespace MMAP
 
         dtTileRef tileRef = mmap->loadedTileRefs[packedGridPos];
 
+        std::unique_lock<std::shared_mutex> navMeshLock(mmap->navMeshLock);
+
         // unload, and mark as non loaded
         if (dtStatusFailed(mmap->navMesh->removeTile(tileRef, nullptr, nullptr)))
         {
@@ -278,6 +272,7 @@ namespace MMAP
 
         // unload all tiles from given map
         MMapData* mmap = itr->second;
+        std::unique_lock<std::shared_mutex> navMeshLock(mmap->navMeshLock);
         for (MMapTileSet::iterator i = mmap->loadedTileRefs.begin(); i != mmap->loadedTileRefs.end(); ++i)
         {
             uint32 x = (i->first >> 16);
@@ -291,6 +286,9 @@ namespace MMAP
             }
         }
 
+        navMeshLock.unlock();
+
+        navMeshQueryCount -= uint32(mmap->navMeshQueries.size());
         delete mmap;
         itr->second = nullptr;
         TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded {:03}.mmap", mapId);
@@ -298,51 +296,68 @@ namespace MMAP
         return true;
     }
 
-    bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
+    dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
     {
-        // check if we have this map loaded
         MMapDataSet::const_iterator itr = GetMMapData(mapId);
         if (itr == loadedMMaps.end())
-        {
-            // file may not exist, therefore not loaded
-            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded navmesh map {:03}", mapId);
-            return false;
-        }
+            return nullptr;
+
+        return itr->second->navMesh;
+    }
+
+    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId)
+    {
+        auto itr = GetMMapData(mapId);
+        if (itr == loadedMMaps.end())
+            return nullptr;
 
         MMapData* mmap = itr->second;
-        auto queryItr = mmap->navMeshQueries.find(instanceId);
-        if (queryItr == mmap->navMeshQueries.end())
+        std::thread::id thread = std::this_thread::get_id();
+
+        std::lock_guard<std::mutex> lock(mmap->navMeshQueriesLock);
+        auto [queryItr, inserted] = mmap->navMeshQueries.try_emplace(thread, nullptr);
+        if (!inserted)
+            return queryItr->second;
+
+        // allocate mesh query
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        ASSERT(query);
+        if (dtStatusFailed(query->init(mmap->navMesh, NAV_MESH_QUERY_MAX_NODES)))
         {
-            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId {:03} instanceId {}", mapId, instanceId);
-            return false;
+            dtFreeNavMeshQuery(query);
+            mmap->navMeshQueries.erase(queryItr);
+            TC_LOG_ERROR("maps", "MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId {:03}", mapId);
+            return nullptr;
         }
 
-        dtFreeNavMeshQuery(queryItr->second);
-        mmap->navMeshQueries.erase(queryItr);
-        TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Unloaded mapId {:03} instanceId {}", mapId, instanceId);
-
-        return true;
+        TC_LOG_DEBUG("maps", "MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId {:03} on a new thread", mapId);
+        queryItr->second = query;
+        ++navMeshQueryCount;
+        return query;
     }
 
-    dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
+    std::shared_lock<std::shared_mutex> MMapManager::AcquireNavMeshReadLock(uint32 mapId)
     {
         MMapDataSet::const_iterator itr = GetMMapData(mapId);
         if (itr == loadedMMaps.end())
-            return nullptr;
+            return std::shared_lock<std::shared_mutex>();
 
-        return itr->second->navMesh;
+        return std::shared_lock<std::shared_mutex>(itr->second->navMeshLock);
     }
 
-    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId, uint32 instanceId)
+    std::size_t MMapManager::GetNavMeshQueryMemory() const
     {
-        auto itr = GetMMapData(mapId);
-        if (itr == loadedMMaps.end())
-            return nullptr;
+        // what dtNavMeshQuery::init allocates: node pool, tiny node pool and open list
+        auto nodePoolSize = [](std::size_t maxNodes, std::size_t hashSize)
+        {
+            return sizeof(dtNodePool) + maxNodes * (sizeof(dtNode) + sizeof(dtNodeIndex)) + hashSize * sizeof(dtNodeIndex);
+        };
 
-        auto queryItr = itr->second->navMeshQueries.find(instanceId);
-        if (queryItr == itr->second->navMeshQueries.end())
-            return nullptr;
+        std::size_t const querySize = sizeof(dtNavMeshQuery)
+            + nodePoolSize(NAV_MESH_QUERY_MAX_NODES, dtNextPow2(NAV_MESH_QUERY_MAX_NODES / 4))
+            + nodePoolSize(64, 32)
+            + sizeof(dtNodeQueue) + (NAV_MESH_QUERY_MAX_NODES + 1) * sizeof(dtNode*);
 
-        return queryItr->second;
+        return querySize * navMeshQueryCount;
     }
 }
@@ -21,15 +21,20 @@
 #include "Define.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 //  move map related classes
 namespace MMAP
 {
     typedef std::unordered_map<uint32, dtTileRef> MMapTileSet;
-    typedef std::unordered_map<uint32, dtNavMeshQuery*> NavMeshQuerySet;
+    typedef std::unordered_map<std::thread::id, dtNavMeshQuery*> NavMeshQuerySet;
 
     // dummy struct to hold map's mmap data
     struct TC_COMMON_API MMapData
@@ -44,8 +49,13 @@ namespace MMAP
                 dtFreeNavMesh(navMesh);
         }
 
-        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
-        NavMeshQuerySet navMeshQueries;     // instanceId to query
+        // dtNavMeshQuery is not thread safe, every thread computing paths on this map gets its own
+        // which bounds their number by the thread count instead of the instance count
+        NavMeshQuerySet navMeshQueries;     // thread to query
+        std::mutex navMeshQueriesLock;
+
+        // held shared while the navmesh is searched and exclusively while tiles are added or removed
+        std::shared_mutex navMeshLock;
 
         dtNavMesh* navMesh;
         MMapTileSet loadedTileRefs;        // maps [map grid coords] to [dtTile]
@@ -53,35 +63,64 @@ namespace MMAP
 
     typedef std::unordered_map<uint32, MMapData*> MMapDataSet;
 
+    // raw contents of one .mmtile, read ahead of MMapManager::loadMap
+    struct TC_COMMON_API MMapTileData
+    {
+        MMapTileData() : data(nullptr), size(0) { }
+        ~MMapTileData() { if (data) dtFree(data); }
+
+        MMapTileData(MMapTileData&& right) noexcept : data(right.data), size(right.size) { right.data = nullptr; right.size = 0; }
+        MMapTileData& operator=(MMapTileData&& right) noexcept
+        {
+            std::swap(data, right.data);
+            std::swap(size, right.size);
+            return *this;
+        }
+
+        MMapTileData(MMapTileData const&) = delete;
+        MMapTileData& operator=(MMapTileData const&) = delete;
+
+        unsigned char* data;
+        int32 size;
+    };
+
     // singleton class
     // holds all all access to mmap loading unloading and meshes
     class TC_COMMON_API MMapManager
     {
         public:
-            MMapManager() : loadedTiles(0), thread_safe_environment(true) {}
+            MMapManager() : loadedTiles(0), thread_safe_environment(true), navMeshQueryCount(0) {}
             ~MMapManager();
 
             void InitializeThreadUnsafe(const std::vector<uint32>& mapIds);
-            bool loadMap(std::string const& basePath, uint32 mapId, int32 x, int32 y);
-            bool loadMapInstance(std::string const& basePath, uint32 mapId, uint32 instanceId);
+            // preloaded tile data (see ReadTile) is consumed when passed, the file is read otherwise
+            bool loadMap(std::string const& basePath, uint32 mapId, int32 x, int32 y, MMapTileData* preloaded = nullptr);
+            bool loadMapData(std::string const& basePath, uint32 mapId);
             bool unloadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId);
-            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
 
-            // the returned [dtNavMeshQuery const*] is NOT threadsafe
-            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId, uint32 instanceId);
+            // query of the calling thread, it must not be passed to other threads
+            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId);
             dtNavMesh const* GetNavMesh(uint32 mapId);
 
+            // keeps tiles from being loaded or unloaded while the navmesh is searched, not owning a lock when the map has no navmesh
+            std::shared_lock<std::shared_mutex> AcquireNavMeshReadLock(uint32 mapId);
+
             uint32 getLoadedTilesCount() const { return loadedTiles; }
             uint32 getLoadedMapsCount() const { return uint32(loadedMMaps.size()); }
+            uint32 GetNavMeshQueryCount() const { return navMeshQueryCount; }
+            std::size_t GetNavMeshQueryMemory() const;
+
+            // file access only, thread safe
+            static bool ReadTile(std::string const& basePath, uint32 mapId, int32 x, int32 y, MMapTileData& tile);
         private:
-            bool loadMapData(std::string const& basePath, uint32 mapId);
             uint32 packTileID(int32 x, int32 y);
 
             MMapDataSet::const_iterator GetMMapData(uint32 mapId) const;
             MMapDataSet loadedMMaps;
             uint32 loadedTiles;
             bool thread_safe_environment;
+            std::atomic<uint32> navMeshQueryCount;
     };
 }
 
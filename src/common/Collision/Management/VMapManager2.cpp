@@ -266,28 +266,39 @@ namespace VMAP
 
     WorldModel* VMapManager2::acquireModelInstance(const std::string& basepath, const std::string& filename, uint32 flags/* Only used when creating the model */)
     {
-        //! Critical section, thread safe access to iLoadedModelFiles
-        std::lock_guard<std::mutex> lock(LoadedModelFilesLock);
-
-        ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
-        if (model == iLoadedModelFiles.end())
         {
-            WorldModel* worldmodel = new WorldModel();
-            if (!worldmodel->readFile(basepath + filename + ".vmo"))
+            //! Critical section, thread safe access to iLoadedModelFiles
+            std::lock_guard<std::mutex> lock(LoadedModelFilesLock);
+
+            ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
+            if (model != iLoadedModelFiles.end())
             {
-                TC_LOG_ERROR("misc", "VMapManager2: could not load '{}{}.vmo'", basepath, filename);
-                delete worldmodel;
-                return nullptr;
+                model->second.incRefCount();
+                return model->second.getModel();
             }
-            TC_LOG_DEBUG("maps", "VMapManager2: loading file '{}{}'", basepath, filename);
-
-            worldmodel->Flags = flags;
+        }
 
-            model = iLoadedModelFiles.insert(std::pair<std::string, ManagedModel>(filename, ManagedModel())).first;
-            model->second.setModel(worldmodel);
+        // read outside of the lock, grid preloading acquires models from worker threads
+        WorldModel* worldmodel = new WorldModel();
+        if (!worldmodel->readFile(basepath + filename + ".vmo"))
+        {
+            TC_LOG_ERROR("misc", "VMapManager2: could not load '{}{}.vmo'", basepath, filename);
+            delete worldmodel;
+            return nullptr;
         }
-        model->second.incRefCount();
-        return model->second.getModel();
+        TC_LOG_DEBUG("maps", "VMapManager2: loading file '{}{}'", basepath, filename);
+
+        worldmodel->Flags = flags;
+
+        std::lock_guard<std::mutex> lock(LoadedModelFilesLock);
+        std::pair<ModelFileMap::iterator, bool> model = iLoadedModelFiles.insert(std::pair<std::string, ManagedModel>(filename, ManagedModel()));
+        if (model.second)
+            model.first->second.setModel(worldmodel);
+        else
+            delete worldmodel; // another thread loaded the same file meanwhile
+
+        model.first->second.incRefCount();
+        return model.first->second.getModel();
     }
 
     void VMapManager2::releaseModelInstance(const std::string &filename)
@@ -309,6 +320,21 @@ namespace VMAP
         }
     }
 
+    std::vector<std::string> VMapManager2::preloadMapTileModels(char const* basePath, unsigned int mapId, int x, int y)
+    {
+        std::vector<std::string> models;
+        if (isMapLoadingEnabled())
+            StaticMapTree::PreloadMapTile(basePath, mapId, x, y, this, models);
+
+        return models;
+    }
+
+    void VMapManager2::releaseModelInstances(std::vector<std::string> const& filenames)
+    {
+        for (std::string const& filename : filenames)
+            releaseModelInstance(filename);
+    }
+
     LoadResult VMapManager2::existsMap(char const* basePath, unsigned int mapId, int x, int y)
     {
         return StaticMapTree::CanLoadMap(std::string(basePath), mapId, x, y);
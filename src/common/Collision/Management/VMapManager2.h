@@ -120,6 +120,10 @@ namespace VMAP
             WorldModel* acquireModelInstance(const std::string& basepath, const std::string& filename, uint32 flags = 0);
             void releaseModelInstance(const std::string& filename);
 
+            // Thread safe, acquires the models used by a tile ahead of loadMap; the returned names must be passed to releaseModelInstances
+            std::vector<std::string> preloadMapTileModels(char const* basePath, unsigned int mapId, int x, int y);
+            void releaseModelInstances(std::vector<std::string> const& filenames);
+
             // what's the use of this? o.O
             virtual std::string getDirFileName(unsigned int mapId, int /*x*/, int /*y*/) const override
             {
@@ -241,6 +241,35 @@ namespace VMAP
         return result;
     }
 
+    bool StaticMapTree::PreloadMapTile(std::string const& vmapPath, uint32 mapID, uint32 tileX, uint32 tileY, VMapManager2* vm, std::vector<std::string>& acquiredModels)
+    {
+        std::string basePath = vmapPath;
+        if (basePath.length() > 0 && basePath[basePath.length()-1] != '/' && basePath[basePath.length()-1] != '\\')
+            basePath.push_back('/');
+
+        // untiled maps and empty tiles have no tile file, nothing to preload
+        std::string tilefile = basePath + getTileFileName(mapID, tileX, tileY);
+        FILE* tf = fopen(tilefile.c_str(), "rb");
+        if (!tf)
+            return true;
+
+        char chunk[8];
+        bool result = readChunk(tf, chunk, VMAP_MAGIC, 8);
+        uint32 numSpawns = 0;
+        if (result && fread(&numSpawns, sizeof(uint32), 1, tf) != 1)
+            result = false;
+        for (uint32 i = 0; i < numSpawns && result; ++i)
+        {
+            ModelSpawn spawn;
+            uint32 referencedVal;
+            result = ModelSpawn::readFromFile(tf, spawn) && fread(&referencedVal, sizeof(uint32), 1, tf) == 1;
+            if (result && vm->acquireModelInstance(basePath, spawn.name, spawn.flags))
+                acquiredModels.push_back(spawn.name);
+        }
+        fclose(tf);
+        return result;
+    }
+
     //=========================================================
 
     bool StaticMapTree::InitMap(const std::string &fname, VMapManager2* vm)
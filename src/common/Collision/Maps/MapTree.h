@@ -21,6 +21,7 @@
 #include "Define.h"
 #include "BoundingIntervalHierarchy.h"
 #include <unordered_map>
+#include <vector>
 
 namespace VMAP
 {
@@ -72,6 +73,8 @@ namespace VMAP
             static uint32 packTileID(uint32 tileX, uint32 tileY) { return tileX<<16 | tileY; }
             static void unpackTileID(uint32 ID, uint32 &tileX, uint32 &tileY) { tileX = ID>>16; tileY = ID&0xFF; }
             static LoadResult CanLoadMap(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY);
+            // reads the spawns of a tile file and acquires their models, a later LoadMapTile then finds them already loaded
+            static bool PreloadMapTile(std::string const& basePath, uint32 mapID, uint32 tileX, uint32 tileY, VMapManager2* vm, std::vector<std::string>& acquiredModels);
 
             StaticMapTree(uint32 mapID, const std::string &basePath);
             ~StaticMapTree();
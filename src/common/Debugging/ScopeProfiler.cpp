@@ -0,0 +1,347 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScopeProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#if TRINITY_COMPILER == TRINITY_COMPILER_GNU
+#include <cxxabi.h>
+#endif
+
+std::atomic<bool> ScopeProfiler::_running(false);
+std::atomic<uint32> ScopeProfiler::_sampleRate(1);
+
+namespace
+{
+    using ProfilerClock = std::chrono::steady_clock;
+
+    // nodes are only created and written by the thread owning the tree, other threads only read them when stacks are written
+    struct ProfileNode
+    {
+        ProfileNode(char const* category, char const* name) : Category(category), Name(name), SelfTime(0), Calls(0), FirstChild(nullptr), NextSibling(nullptr) { }
+
+        char const* Category;
+        char const* Name;
+        std::atomic<uint64> SelfTime;                       // nanoseconds, without time of children
+        std::atomic<uint64> Calls;
+
+        // list read by WriteFoldedStacks, a child is linked in once it is constructed
+        std::atomic<ProfileNode*> FirstChild;
+        ProfileNode* NextSibling;
+
+        // lookup of the owning thread, labels are string literals or cached type names, their addresses identify them
+        std::map<std::pair<char const*, char const*>, ProfileNode*> Children;
+    };
+
+    // counters are only written by one thread, a load and a store are enough
+    void Add(std::atomic<uint64>& counter, uint64 value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    struct ProfileFrame
+    {
+        ProfileNode* Node;
+        ProfilerClock::time_point Start;
+        ProfilerClock::duration ChildTime;
+    };
+
+    struct ThreadProfile
+    {
+        ThreadProfile() : Root(nullptr, nullptr), SkippedRoots(0), RootCount(0), Generation(0), InUse(true) { }
+
+        ProfileNode* GetChild(ProfileNode& parent, char const* category, char const* name)
+        {
+            ProfileNode*& child = parent.Children[{ category, name }];
+            if (!child)
+            {
+                child = &Nodes.emplace_back(category, name);
+                child->NextSibling = parent.FirstChild.load(std::memory_order_relaxed);
+                parent.FirstChild.store(child, std::memory_order_release);
+            }
+
+            return child;
+        }
+
+        // only called by the owning thread while no stacks are written, see ScopeProfiler::Reset
+        void Clear()
+        {
+            Root.FirstChild.store(nullptr, std::memory_order_relaxed);
+            Root.Children.clear();
+            Nodes.clear();
+            RootCount = 0;
+        }
+
+        ProfileNode Root;
+        std::deque<ProfileNode> Nodes;                      // all nodes but the root, never moved while the tree grows
+
+        std::vector<ProfileFrame> Stack;
+        std::unordered_map<std::type_index, char const*> TypeNames;
+        uint32 SkippedRoots;                                // depth of unsampled roots being executed
+        uint32 RootCount;
+        std::atomic<uint32> Generation;                     // the tree is cleared before this is set to a new generation
+        std::atomic<bool> InUse;
+    };
+
+    struct ProfilerData
+    {
+        ProfilerData() : Generation(0) { }
+
+        std::atomic<uint32> Generation;
+
+        // Reset waits for stacks being written, threads only clear their trees once the generation changed
+        std::mutex WriteLock;
+
+        // only locked when a thread enters its first scope and when stacks are written
+        std::mutex ThreadProfilesLock;
+        std::vector<std::unique_ptr<ThreadProfile>> ThreadProfiles;
+
+        std::mutex TypeNamesLock;
+        std::unordered_map<std::type_index, std::string> TypeNames;
+    };
+
+    // never destroyed, threads may still leave scopes while the process exits
+    ProfilerData& GetProfilerData()
+    {
+        static ProfilerData* data = new ProfilerData();
+        return *data;
+    }
+
+    // gives the profile of a thread back for reuse by threads started later, what it recorded is kept
+    struct ThreadProfileHolder
+    {
+        ~ThreadProfileHolder()
+        {
+            if (Profile)
+                Profile->InUse.store(false, std::memory_order_release);
+        }
+
+        ThreadProfile* Profile = nullptr;
+    };
+
+    ThreadProfile& GetThreadProfile()
+    {
+        thread_local ThreadProfileHolder holder;
+        if (holder.Profile)
+            return *holder.Profile;
+
+        ProfilerData& data = GetProfilerData();
+        std::lock_guard<std::mutex> lock(data.ThreadProfilesLock);
+        for (std::unique_ptr<ThreadProfile>& profile : data.ThreadProfiles)
+        {
+            bool inUse = false;
+            if (profile->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+            {
+                holder.Profile = profile.get();
+                return *holder.Profile;
+            }
+        }
+
+        holder.Profile = data.ThreadProfiles.emplace_back(std::make_unique<ThreadProfile>()).get();
+        holder.Profile->Generation.store(data.Generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *holder.Profile;
+    }
+
+    char const* GetTypeName(ThreadProfile& profile, std::type_info const& type)
+    {
+        char const*& cached = profile.TypeNames[type];
+        if (cached)
+            return cached;
+
+        ProfilerData& data = GetProfilerData();
+        std::lock_guard<std::mutex> lock(data.TypeNamesLock);
+        auto itr = data.TypeNames.find(type);
+        if (itr != data.TypeNames.end())
+            return itr->second.c_str();
+
+        std::string name = type.name();
+#if TRINITY_COMPILER == TRINITY_COMPILER_GNU
+        int status = 0;
+        if (char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status))
+        {
+            if (status == 0)
+                name = demangled;
+
+            free(demangled);
+        }
+#else
+        for (std::string_view prefix : { std::string_view("class "), std::string_view("struct ") })
+            if (name.compare(0, prefix.length(), prefix) == 0)
+                name.erase(0, prefix.length());
+#endif
+
+        // elements of unordered_map are not moved when it grows
+        cached = data.TypeNames.emplace(type, std::move(name)).first->second.c_str();
+        return cached;
+    }
+
+    std::string GetFrameLabel(ProfileNode const& node)
+    {
+        std::string label = node.Category ? std::string(node.Category) + "::" + node.Name : std::string(node.Name);
+
+        // separators of the folded format
+        for (char& c : label)
+            if (c == ';' || c == '\n')
+                c = '_';
+
+        return label;
+    }
+
+    void FoldStacks(ProfileNode const& node, std::string const& stack, std::map<std::string, uint64>& stacks)
+    {
+        for (ProfileNode const* child = node.FirstChild.load(std::memory_order_acquire); child; child = child->NextSibling)
+        {
+            std::string childStack = stack.empty() ? GetFrameLabel(*child) : stack + ';' + GetFrameLabel(*child);
+            if (uint64 selfTime = child->SelfTime.load(std::memory_order_relaxed))
+                stacks[childStack] += selfTime;
+
+            FoldStacks(*child, childStack, stacks);
+        }
+    }
+}
+
+void ScopeProfiler::Start(uint32 sampleRate)
+{
+    Reset();
+    _sampleRate.store(std::max<uint32>(sampleRate, 1), std::memory_order_relaxed);
+    _running.store(true, std::memory_order_relaxed);
+}
+
+void ScopeProfiler::Stop()
+{
+    _running.store(false, std::memory_order_relaxed);
+}
+
+void ScopeProfiler::Reset()
+{
+    ProfilerData& data = GetProfilerData();
+    std::lock_guard<std::mutex> lock(data.WriteLock);
+    data.Generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint8 ScopeProfiler::Enter(ScopeType type, char const* category, char const* name, std::type_info const* categoryType)
+{
+    ThreadProfile& profile = GetThreadProfile();
+    if (profile.SkippedRoots)
+    {
+        if (type != SCOPE_ROOT)
+            return STATE_INACTIVE;
+
+        ++profile.SkippedRoots;
+        return STATE_SKIPPED_ROOT;
+    }
+
+    if (profile.Stack.empty())
+    {
+        if (type != SCOPE_ROOT)
+            return STATE_INACTIVE;
+
+        // Reset only tells the threads to start over, trees are cleared between two roots
+        uint32 generation = GetProfilerData().Generation.load(std::memory_order_relaxed);
+        if (profile.Generation.load(std::memory_order_relaxed) != generation)
+        {
+            // the tree is not read before the new generation is published
+            profile.Clear();
+            profile.Generation.store(generation, std::memory_order_release);
+        }
+
+        if (profile.RootCount++ % GetSampleRate())
+        {
+            ++profile.SkippedRoots;
+            return STATE_SKIPPED_ROOT;
+        }
+    }
+
+    if (categoryType)
+        category = GetTypeName(profile, *categoryType);
+
+    ProfileNode* parent = profile.Stack.empty() ? &profile.Root : profile.Stack.back().Node;
+    ProfileNode* node = profile.GetChild(*parent, category, name);
+
+    profile.Stack.push_back({ node, ProfilerClock::now(), ProfilerClock::duration::zero() });
+    return STATE_MEASURED;
+}
+
+void ScopeProfiler::Leave(uint8 state)
+{
+    ThreadProfile& profile = GetThreadProfile();
+    if (state == STATE_SKIPPED_ROOT)
+    {
+        --profile.SkippedRoots;
+        return;
+    }
+
+    ProfileFrame frame = profile.Stack.back();
+    profile.Stack.pop_back();
+
+    ProfilerClock::duration elapsed = ProfilerClock::now() - frame.Start;
+    if (!profile.Stack.empty())
+        profile.Stack.back().ChildTime += elapsed;
+
+    Add(frame.Node->SelfTime, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - frame.ChildTime).count());
+    Add(frame.Node->Calls, 1);
+}
+
+bool ScopeProfiler::WriteFoldedStacks(std::string const& fileName, std::size_t& stacks)
+{
+    std::map<std::string, uint64> foldedStacks;
+    {
+        // trees only grow while they are read, their threads clear them after a Reset, which waits for this
+        ProfilerData& data = GetProfilerData();
+        std::lock_guard<std::mutex> writeLock(data.WriteLock);
+        uint32 generation = data.Generation.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(data.ThreadProfilesLock);
+        for (std::unique_ptr<ThreadProfile>& profile : data.ThreadProfiles)
+        {
+            // not reset yet by its thread
+            if (profile->Generation.load(std::memory_order_acquire) != generation)
+                continue;
+
+            FoldStacks(profile->Root, "", foldedStacks);
+        }
+    }
+
+    std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+    if (!file)
+        return false;
+
+    uint64 sampleRate = GetSampleRate();
+    stacks = 0;
+    for (auto const& [stack, nanoseconds] : foldedStacks)
+    {
+        uint64 microseconds = nanoseconds * sampleRate / 1000;
+        if (!microseconds)
+            continue;
+
+        file << stack << ' ' << microseconds << '\n';
+        ++stacks;
+    }
+
+    return bool(file);
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_SCOPE_PROFILER_H
+#define TRINITYCORE_SCOPE_PROFILER_H
+
+#include "Define.h"
+#include <atomic>
+#include <string>
+#include <typeinfo>
+
+/*
+ * Wall time profiler of instrumented scopes (map updates, opcode handlers, script hooks, AI updates).
+ * One in SampleRate root scopes is measured together with every scope nested in it, scopes of the
+ * other roots and scopes outside of any root only check if the profiler is running.
+ * Time spent in each call stack is written as folded stacks, the input of flamegraph.pl.
+ */
+class TC_COMMON_API ScopeProfiler
+{
+public:
+    enum ScopeType : uint8
+    {
+        SCOPE_ROOT,                                         // starts a call stack, sampled
+        SCOPE_NESTED                                        // only measured inside a sampled root
+    };
+
+    class Scope
+    {
+    public:
+        Scope(ScopeType type, char const* category, char const* name) : _state(STATE_INACTIVE)
+        {
+            if (IsRunning())
+                _state = Enter(type, category, name, nullptr);
+        }
+
+        // category is the name of a dynamic type, only looked up for measured scopes
+        Scope(ScopeType type, std::type_info const& category, char const* name) : _state(STATE_INACTIVE)
+        {
+            if (IsRunning())
+                _state = Enter(type, nullptr, name, &category);
+        }
+
+        ~Scope()
+        {
+            if (_state != STATE_INACTIVE)
+                Leave(_state);
+        }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+    private:
+        uint8 _state;
+    };
+
+    static bool IsRunning() { return _running.load(std::memory_order_relaxed); }
+    static uint32 GetSampleRate() { return _sampleRate.load(std::memory_order_relaxed); }
+
+    /// Discards what was recorded before and starts measuring one in sampleRate root scopes
+    static void Start(uint32 sampleRate);
+    static void Stop();
+    static void Reset();
+
+    /// Writes "frame;frame;frame microseconds" lines, times of unsampled roots are estimated from the sampled ones
+    static bool WriteFoldedStacks(std::string const& fileName, std::size_t& stacks);
+
+private:
+    enum ScopeState : uint8
+    {
+        STATE_INACTIVE,
+        STATE_MEASURED,
+        STATE_SKIPPED_ROOT
+    };
+
+    static uint8 Enter(ScopeType type, char const* category, char const* name, std::type_info const* categoryType);
+    static void Leave(uint8 state);
+
+    static std::atomic<bool> _running;
+    static std::atomic<uint32> _sampleRate;
+};
+
+#endif
@@ -31,6 +31,12 @@
 #include <ctime>
 #include <boost/core/demangle.hpp>
 
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
 void Trinity::VerifyOsVersion()
 {
 #if TRINITY_PLATFORM == TRINITY_PLATFORM_WINDOWS
@@ -346,6 +352,27 @@ uint32 GetPID()
     return uint32(pid);
 }
 
+uint64 GetPeakResidentMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return uint64(counters.PeakWorkingSetSize);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return 0;
+
+#if TRINITY_PLATFORM == TRINITY_PLATFORM_APPLE
+    return uint64(usage.ru_maxrss);
+#else
+    return uint64(usage.ru_maxrss) * 1024;                  // kilobytes
+#endif
+#endif
+}
+
 size_t utf8length(std::string& utf8str)
 {
     try
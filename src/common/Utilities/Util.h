@@ -324,6 +324,8 @@ TC_COMMON_API bool IsIPAddress(char const* ipaddress);
 
 TC_COMMON_API uint32 CreatePIDFile(std::string const& filename);
 TC_COMMON_API uint32 GetPID();
+/// Largest resident memory of the process so far, in bytes, 0 when unknown
+TC_COMMON_API uint64 GetPeakResidentMemory();
 
 namespace Trinity::Impl
 {
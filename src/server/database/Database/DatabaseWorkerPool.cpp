@@ -29,6 +29,7 @@
 #include "QueryCallback.h"
 #include "QueryHolder.h"
 #include "QueryResult.h"
+#include "QueryResultSnapshot.h"
 #include "SQLOperation.h"
 #include "Transaction.h"
 #include "MySQLWorkaround.h"
@@ -184,6 +185,15 @@ bool DatabaseWorkerPool<T>::PrepareStatements()
 template <class T>
 QueryResult DatabaseWorkerPool<T>::Query(char const* sql, T* connection /*= nullptr*/)
 {
+    if (!connection && _resultSnapshot && _resultSnapshot->IsLoading())
+    {
+        QueryResult result;
+        if (_resultSnapshot->Find(sql, result))
+            return result;
+
+        return _resultSnapshot->Record(sql, Query(sql, GetFreeConnection()));
+    }
+
     if (!connection)
         connection = GetFreeConnection();
 
@@ -201,6 +211,18 @@ QueryResult DatabaseWorkerPool<T>::Query(char const* sql, T* connection /*= null
 template <class T>
 PreparedQueryResult DatabaseWorkerPool<T>::Query(PreparedStatement<T>* stmt)
 {
+    std::string snapshotKey;
+    if (_resultSnapshot && _resultSnapshot->IsLoading())
+    {
+        snapshotKey = QueryResultSnapshot::GetKey(stmt);
+        PreparedQueryResult result;
+        if (_resultSnapshot->Find(snapshotKey, result))
+        {
+            delete stmt;
+            return result;
+        }
+    }
+
     auto connection = GetFreeConnection();
     PreparedResultSet* ret = connection->Query(stmt);
     connection->Unlock();
@@ -209,6 +231,62 @@ PreparedQueryResult DatabaseWorkerPool<T>::Query(PreparedStatement<T>* stmt)
     delete stmt;
 
     if (!ret || !ret->GetRowCount())
+    {
+        delete ret;
+        ret = nullptr;
+    }
+
+    if (!snapshotKey.empty())
+        return _resultSnapshot->Record(snapshotKey, PreparedQueryResult(ret));
+
+    return PreparedQueryResult(ret);
+}
+
+template <class T>
+QueryResult DatabaseWorkerPool<T>::StreamQuery(char const* sql)
+{
+    //! The snapshot holds whole results
+    if (_resultSnapshot && _resultSnapshot->IsLoading())
+        return Query(sql);
+
+    auto connection = GetFreeConnection();
+    ResultSet* result = connection->StreamQuery(sql);
+    if (!result)
+    {
+        connection->Unlock();
+        return QueryResult(nullptr);
+    }
+
+    //! From here on the result unlocks the connection
+    if (!result->NextRow())
+    {
+        delete result;
+        return QueryResult(nullptr);
+    }
+
+    return QueryResult(result);
+}
+
+template <class T>
+PreparedQueryResult DatabaseWorkerPool<T>::StreamQuery(PreparedStatement<T>* stmt)
+{
+    if (_resultSnapshot && _resultSnapshot->IsLoading())
+        return Query(stmt);
+
+    auto connection = GetFreeConnection();
+    PreparedResultSet* ret = connection->StreamQuery(stmt);
+
+    //! Delete proxy-class. Not needed anymore
+    delete stmt;
+
+    if (!ret)
+    {
+        connection->Unlock();
+        return PreparedQueryResult(nullptr);
+    }
+
+    //! From here on the result unlocks the connection, it already read the first row
+    if (!ret->GetRowCount())
     {
         delete ret;
         return PreparedQueryResult(nullptr);
@@ -273,6 +351,7 @@ void DatabaseWorkerPool<T>::CommitTransaction(SQLTransaction<T> transaction)
     }
 #endif // TRINITY_DEBUG
 
+    OnWrite();
     Enqueue(new TransactionTask(transaction));
 }
 
@@ -296,6 +375,7 @@ TransactionCallback DatabaseWorkerPool<T>::AsyncCommitTransaction(SQLTransaction
     }
 #endif // TRINITY_DEBUG
 
+    OnWrite();
     TransactionWithResultTask* task = new TransactionWithResultTask(transaction);
     TransactionFuture result = task->GetFuture();
     Enqueue(task);
@@ -305,6 +385,7 @@ TransactionCallback DatabaseWorkerPool<T>::AsyncCommitTransaction(SQLTransaction
 template <class T>
 void DatabaseWorkerPool<T>::DirectCommitTransaction(SQLTransaction<T>& transaction)
 {
+    OnWrite();
     T* connection = GetFreeConnection();
     int errorCode = connection->ExecuteTransaction(transaction);
     if (!errorCode)
@@ -473,12 +554,20 @@ char const* DatabaseWorkerPool<T>::GetDatabaseName() const
     return _connectionInfo->database.c_str();
 }
 
+template <class T>
+void DatabaseWorkerPool<T>::OnWrite()
+{
+    if (_resultSnapshot)
+        _resultSnapshot->OnDatabaseWrite();
+}
+
 template <class T>
 void DatabaseWorkerPool<T>::Execute(char const* sql)
 {
     if (Trinity::IsFormatEmptyOrNull(sql))
         return;
 
+    OnWrite();
     BasicStatementTask* task = new BasicStatementTask(sql);
     Enqueue(task);
 }
@@ -486,6 +575,7 @@ void DatabaseWorkerPool<T>::Execute(char const* sql)
 template <class T>
 void DatabaseWorkerPool<T>::Execute(PreparedStatement<T>* stmt)
 {
+    OnWrite();
     PreparedStatementTask* task = new PreparedStatementTask(stmt);
     Enqueue(task);
 }
@@ -496,6 +586,7 @@ void DatabaseWorkerPool<T>::DirectExecute(char const* sql)
     if (Trinity::IsFormatEmptyOrNull(sql))
         return;
 
+    OnWrite();
     T* connection = GetFreeConnection();
     connection->Execute(sql);
     connection->Unlock();
@@ -504,6 +595,7 @@ void DatabaseWorkerPool<T>::DirectExecute(char const* sql)
 template <class T>
 void DatabaseWorkerPool<T>::DirectExecute(PreparedStatement<T>* stmt)
 {
+    OnWrite();
     T* connection = GetFreeConnection();
     connection->Execute(stmt);
     connection->Unlock();
@@ -28,6 +28,7 @@
 template <typename T>
 class ProducerConsumerQueue;
 
+class QueryResultSnapshot;
 class SQLOperation;
 struct MySQLConnectionInfo;
 
@@ -143,6 +144,27 @@ class DatabaseWorkerPool
         //! Statement must be prepared with CONNECTION_SYNCH flag.
         PreparedQueryResult Query(PreparedStatement<T>* stmt);
 
+        //! Executes an SQL query in string format whose rows are read from the server while the caller iterates them
+        //! instead of being buffered whole, for large tables read once with forward iteration (see ResultSet).
+        //! The synch connection stays locked until the last row was read or the result is released.
+        QueryResult StreamQuery(char const* sql);
+
+        //! Executes an SQL query in string format -with variable args- whose rows are read from the server while the caller iterates them.
+        //! The synch connection stays locked until the last row was read or the result is released.
+        template<typename... Args>
+        QueryResult StreamPQuery(Trinity::FormatString<Args...> sql, Args&&... args)
+        {
+            if (Trinity::IsFormatEmptyOrNull(sql))
+                return QueryResult(nullptr);
+
+            return this->StreamQuery(Trinity::StringFormat(sql, std::forward<Args>(args)...).c_str());
+        }
+
+        //! Executes an SQL query in prepared format whose rows are read from the server while the caller iterates them.
+        //! The synch connection stays locked until the last row was read or the result is released.
+        //! Statement must be prepared with CONNECTION_SYNCH flag.
+        PreparedQueryResult StreamQuery(PreparedStatement<T>* stmt);
+
         /**
             Asynchronous query (with resultset) methods.
         */
@@ -215,6 +237,10 @@ class DatabaseWorkerPool
 
         size_t QueueSize() const;
 
+        //! Serves and records the results of synchronous queries without an explicit connection while the snapshot is loading,
+        //! statements changing the database are reported to it. Must be set before other threads use the pool.
+        void SetResultSnapshot(std::shared_ptr<QueryResultSnapshot> snapshot) { _resultSnapshot = std::move(snapshot); }
+
     private:
         uint32 OpenConnections(InternalIndex type, uint8 numConnections);
 
@@ -228,12 +254,15 @@ class DatabaseWorkerPool
 
         char const* GetDatabaseName() const;
 
+        void OnWrite();
+
         //! Queue shared by async worker threads.
         std::unique_ptr<ProducerConsumerQueue<SQLOperation*>> _queue;
         std::array<std::vector<std::unique_ptr<T>>, IDX_SIZE> _connections;
         std::unique_ptr<MySQLConnectionInfo> _connectionInfo;
         std::vector<uint8> _preparedStatementSize;
         uint8 _async_threads, _synch_threads;
+        std::shared_ptr<QueryResultSnapshot> _resultSnapshot;
 #ifdef TRINITY_DEBUG
         static inline thread_local bool _warnSyncQueries = false;
 #endif
@@ -199,7 +199,7 @@ enum CharacterDatabaseStatements : uint32
     CHAR_INS_EQUIP_SET,
     CHAR_DEL_EQUIP_SET,
 
-    CHAR_INS_AURA,
+    CHAR_REP_AURA,
 
     CHAR_SEL_ACCOUNT_DATA,
     CHAR_REP_ACCOUNT_DATA,
@@ -413,6 +413,7 @@ enum CharacterDatabaseStatements : uint32
     CHAR_DEL_CHARACTER,
     CHAR_DEL_CHAR_ACTION,
     CHAR_DEL_CHAR_AURA,
+    CHAR_DEL_CHAR_AURA_BY_KEY,
     CHAR_DEL_CHAR_GIFT,
     CHAR_DEL_CHAR_INSTANCE,
     CHAR_DEL_CHAR_INVENTORY,
@@ -426,6 +427,7 @@ enum CharacterDatabaseStatements : uint32
     CHAR_DEL_GUILD_EVENTLOG_BY_PLAYER,
     CHAR_DEL_GUILD_BANK_EVENTLOG_BY_PLAYER,
     CHAR_DEL_CHAR_GLYPHS,
+    CHAR_DEL_CHAR_GLYPHS_BY_SPEC,
     CHAR_DEL_CHAR_TALENT,
     CHAR_DEL_CHAR_SKILLS,
     CHAR_UPD_CHAR_HONOR_POINTS,
@@ -449,12 +451,12 @@ enum CharacterDatabaseStatements : uint32
     CHAR_UPD_CHAR_SKILLS,
     CHAR_INS_CHAR_SPELL,
     CHAR_DEL_CHAR_STATS,
-    CHAR_INS_CHAR_STATS,
+    CHAR_REP_CHAR_STATS,
     CHAR_DEL_PETITION_BY_OWNER,
     CHAR_DEL_PETITION_SIGNATURE_BY_OWNER,
     CHAR_DEL_PETITION_BY_OWNER_AND_TYPE,
     CHAR_DEL_PETITION_SIGNATURE_BY_OWNER_AND_TYPE,
-    CHAR_INS_CHAR_GLYPHS,
+    CHAR_REP_CHAR_GLYPHS,
     CHAR_DEL_CHAR_TALENT_BY_SPELL_SPEC,
     CHAR_INS_CHAR_TALENT,
     CHAR_DEL_CHAR_ACTION_EXCEPT_SPEC,
@@ -349,7 +349,23 @@ ResultSet* MySQLConnection::Query(char const* sql)
     return new ResultSet(result, fields, rowCount, fieldCount);
 }
 
-bool MySQLConnection::_Query(const char* sql, MySQLResult** pResult, MySQLField** pFields, uint64* pRowCount, uint32* pFieldCount)
+ResultSet* MySQLConnection::StreamQuery(char const* sql)
+{
+    if (!sql)
+        return nullptr;
+
+    MySQLResult* result = nullptr;
+    MySQLField* fields = nullptr;
+    uint64 rowCount = 0;
+    uint32 fieldCount = 0;
+
+    if (!_Query(sql, &result, &fields, &rowCount, &fieldCount, true))
+        return nullptr;
+
+    return new ResultSet(result, fields, 0, fieldCount, this);
+}
+
+bool MySQLConnection::_Query(const char* sql, MySQLResult** pResult, MySQLField** pFields, uint64* pRowCount, uint32* pFieldCount, bool stream /*= false*/)
 {
     if (!m_Mysql)
         return false;
@@ -364,22 +380,23 @@ bool MySQLConnection::_Query(const char* sql, MySQLResult** pResult, MySQLField*
             TC_LOG_ERROR("sql.sql", "[{}] {}", lErrno, mysql_error(m_Mysql));
 
             if (_HandleMySQLErrno(lErrno))      // If it returns true, an error was handled successfully (i.e. reconnection)
-                return _Query(sql, pResult, pFields, pRowCount, pFieldCount);    // We try again
+                return _Query(sql, pResult, pFields, pRowCount, pFieldCount, stream);    // We try again
 
             return false;
         }
         else
             TC_LOG_DEBUG("sql.sql", "[{} ms] SQL: {}", getMSTimeDiff(_s, getMSTime()), sql);
 
-        *pResult = reinterpret_cast<MySQLResult*>(mysql_store_result(m_Mysql));
-        *pRowCount = mysql_affected_rows(m_Mysql);
+        // a streamed result is read from the connection by mysql_fetch_row, the row count is only known at its end
+        *pResult = reinterpret_cast<MySQLResult*>(stream ? mysql_use_result(m_Mysql) : mysql_store_result(m_Mysql));
+        *pRowCount = stream ? 0 : mysql_affected_rows(m_Mysql);
         *pFieldCount = mysql_field_count(m_Mysql);
     }
 
     if (!*pResult )
         return false;
 
-    if (!*pRowCount)
+    if (!stream && !*pRowCount)
     {
         mysql_free_result(*pResult);
         return false;
@@ -547,6 +564,19 @@ PreparedResultSet* MySQLConnection::Query(PreparedStatementBase* stmt)
     return new PreparedResultSet(mysqlStmt->GetSTMT(), result, rowCount, fieldCount);
 }
 
+PreparedResultSet* MySQLConnection::StreamQuery(PreparedStatementBase* stmt)
+{
+    MySQLPreparedStatement* mysqlStmt = nullptr;
+    MySQLResult* result = nullptr;
+    uint64 rowCount = 0;
+    uint32 fieldCount = 0;
+
+    if (!_Query(stmt, &mysqlStmt, &result, &rowCount, &fieldCount))
+        return nullptr;
+
+    return new PreparedResultSet(mysqlStmt->GetSTMT(), result, 0, fieldCount, this);
+}
+
 bool MySQLConnection::_HandleMySQLErrno(uint32 errNo, uint8 attempts /*= 5*/)
 {
     switch (errNo)
@@ -20,8 +20,10 @@
 #include "Field.h"
 #include "FieldValueConverters.h"
 #include "Log.h"
+#include "MySQLConnection.h"
 #include "MySQLHacks.h"
 #include "MySQLWorkaround.h"
+#include "QueryResultSnapshot.h"
 #include <chrono>
 #include <cstring>
 
@@ -77,6 +79,33 @@ static uint32 SizeForType(MYSQL_FIELD* field)
     }
 }
 
+static bool IsStringType(enum_field_types type)
+{
+    switch (type)
+    {
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_VAR_STRING:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// the longest value of a column is not known before a streamed result is read, longer values get their own buffer
+constexpr unsigned long StreamStringBufferSize = 256;
+
+static uint32 StreamSizeForType(MYSQL_FIELD* field)
+{
+    if (IsStringType(field->type))
+        return uint32(std::min<unsigned long>(field->length, StreamStringBufferSize) + 1);
+
+    return SizeForType(field);
+}
+
 DatabaseFieldTypes MysqlTypeToFieldType(enum_field_types type, uint32 flags)
 {
     switch (type)
@@ -393,11 +422,14 @@ void InitializeDatabaseFieldMetadata(QueryResultFieldMetadata* meta, MySQLField
 }
 }
 
-ResultSet::ResultSet(MySQLResult* result, MySQLField* fields, uint64 rowCount, uint32 fieldCount) :
+ResultSet::ResultSet(MySQLResult* result, MySQLField* fields, uint64 rowCount, uint32 fieldCount, MySQLConnection* streamConnection /*= nullptr*/) :
 _rowCount(rowCount),
 _fieldCount(fieldCount),
 _result(result),
-_fields(fields)
+_fields(fields),
+_streamConnection(streamConnection),
+_snapshotRow(nullptr),
+_snapshotRowsLeft(0)
 {
     _fieldMetadata.resize(_fieldCount);
     _currentRow = new Field[_fieldCount];
@@ -408,13 +440,35 @@ _fields(fields)
     }
 }
 
-PreparedResultSet::PreparedResultSet(MySQLStmt* stmt, MySQLResult* result, uint64 rowCount, uint32 fieldCount) :
+ResultSet::ResultSet(std::vector<QueryResultFieldMetadata> fieldMetadata, uint64 rowCount, char const* rows, std::shared_ptr<void const> storage) :
+_fieldMetadata(std::move(fieldMetadata)),
+_rowCount(rowCount),
+_fieldCount(_fieldMetadata.size()),
+_result(nullptr),
+_fields(nullptr),
+_streamConnection(nullptr),
+_snapshotRow(rows),
+_snapshotRowsLeft(rowCount),
+_snapshotStorage(std::move(storage))
+{
+    _currentRow = new Field[_fieldCount];
+    for (uint32 i = 0; i < _fieldCount; i++)
+    {
+        _fieldMetadata[i].Converter = FromStringValueConverters[AsUnderlyingType(_fieldMetadata[i].Type)].get();
+        _currentRow[i].SetMetadata(&_fieldMetadata[i]);
+    }
+}
+
+PreparedResultSet::PreparedResultSet(MySQLStmt* stmt, MySQLResult* result, uint64 rowCount, uint32 fieldCount, MySQLConnection* streamConnection /*= nullptr*/) :
 m_rowCount(rowCount),
 m_rowPosition(0),
 m_fieldCount(fieldCount),
+m_stream(streamConnection != nullptr),
 m_rBind(nullptr),
 m_stmt(stmt),
-m_metadataResult(result)
+m_metadataResult(result),
+m_dataBuffer(nullptr),
+m_streamConnection(streamConnection)
 {
     if (!m_metadataResult)
         return;
@@ -437,17 +491,21 @@ m_metadataResult(result)
     memset(m_rBind, 0, sizeof(MySQLBind) * m_fieldCount);
     memset(m_length, 0, sizeof(unsigned long) * m_fieldCount);
 
-    //- This is where we store the (entire) resultset
-    if (mysql_stmt_store_result(m_stmt))
+    //- This is where we store the (entire) resultset, a streamed one stays on the server until mysql_stmt_fetch reads it
+    if (!m_stream)
     {
-        TC_LOG_WARN("sql.sql", "{}:mysql_stmt_store_result, cannot bind result from MySQL server. Error: {}", __FUNCTION__, mysql_stmt_error(m_stmt));
-        delete[] m_rBind;
-        delete[] m_isNull;
-        delete[] m_length;
-        return;
-    }
+        if (mysql_stmt_store_result(m_stmt))
+        {
+            TC_LOG_WARN("sql.sql", "{}:mysql_stmt_store_result, cannot bind result from MySQL server. Error: {}", __FUNCTION__, mysql_stmt_error(m_stmt));
+            delete[] m_rBind;
+            m_rBind = nullptr;
+            delete[] m_isNull;
+            delete[] m_length;
+            return;
+        }
 
-    m_rowCount = mysql_stmt_num_rows(m_stmt);
+        m_rowCount = mysql_stmt_num_rows(m_stmt);
+    }
 
     //- This is where we prepare the buffer based on metadata
     MySQLField* field = reinterpret_cast<MySQLField*>(mysql_fetch_fields(m_metadataResult));
@@ -455,7 +513,7 @@ m_metadataResult(result)
     std::size_t rowSize = 0;
     for (uint32 i = 0; i < m_fieldCount; ++i)
     {
-        uint32 size = SizeForType(&field[i]);
+        uint32 size = m_stream ? StreamSizeForType(&field[i]) : SizeForType(&field[i]);
         rowSize += size;
 
         InitializeDatabaseFieldMetadata(&m_fieldMetadata[i], &field[i], i, true);
@@ -468,10 +526,10 @@ m_metadataResult(result)
         m_rBind[i].is_unsigned = field[i].flags & UNSIGNED_FLAG;
     }
 
-    char* dataBuffer = new char[rowSize * m_rowCount];
+    m_dataBuffer = new char[rowSize * (m_stream ? 1 : m_rowCount)];
     for (uint32 i = 0, offset = 0; i < m_fieldCount; ++i)
     {
-        m_rBind[i].buffer = dataBuffer + offset;
+        m_rBind[i].buffer = m_dataBuffer + offset;
         offset += m_rBind[i].buffer_length;
     }
 
@@ -486,51 +544,32 @@ m_metadataResult(result)
         return;
     }
 
+    if (m_stream)
+    {
+        //- Only the current row is kept, the caller sees the first one right away
+        m_rows.resize(m_fieldCount);
+        m_streamBuffers.resize(m_fieldCount);
+        for (uint32 fIndex = 0; fIndex < m_fieldCount; ++fIndex)
+            m_rows[fIndex].SetMetadata(&m_fieldMetadata[fIndex]);
+
+        FetchStreamRow();
+        return;
+    }
+
     m_rows.resize(std::size_t(m_rowCount) * m_fieldCount);
     while (_NextRow())
     {
         for (uint32 fIndex = 0; fIndex < m_fieldCount; ++fIndex)
         {
-            m_rows[std::size_t(m_rowPosition) * m_fieldCount + fIndex].SetMetadata(&m_fieldMetadata[fIndex]);
-
-            unsigned long buffer_length = m_rBind[fIndex].buffer_length;
-            unsigned long fetched_length = *m_rBind[fIndex].length;
-            if (!*m_rBind[fIndex].is_null)
-            {
-                void* buffer = m_stmt->bind[fIndex].buffer;
-                switch (m_rBind[fIndex].buffer_type)
-                {
-                    case MYSQL_TYPE_TINY_BLOB:
-                    case MYSQL_TYPE_MEDIUM_BLOB:
-                    case MYSQL_TYPE_LONG_BLOB:
-                    case MYSQL_TYPE_BLOB:
-                    case MYSQL_TYPE_STRING:
-                    case MYSQL_TYPE_VAR_STRING:
-                        // warning - the string will not be null-terminated if there is no space for it in the buffer
-                        // when mysql_stmt_fetch returned MYSQL_DATA_TRUNCATED
-                        // we cannot blindly null-terminate the data either as it may be retrieved as binary blob and not specifically a string
-                        // in this case using Field::GetCString will result in garbage
-                        // TODO: remove Field::GetCString and use std::string_view in C++17
-                        if (fetched_length < buffer_length)
-                            *((char*)buffer + fetched_length) = '\0';
-                        break;
-                    default:
-                        break;
-                }
+            Field& field = m_rows[std::size_t(m_rowPosition) * m_fieldCount + fIndex];
+            field.SetMetadata(&m_fieldMetadata[fIndex]);
 
-                m_rows[std::size_t(m_rowPosition) * m_fieldCount + fIndex].SetValue(
-                    (char const*)buffer,
-                    fetched_length);
+            char* buffer = static_cast<char*>(m_stmt->bind[fIndex].buffer);
+            SetFieldValue(field, fIndex, buffer);
 
-                // move buffer pointer to next part
-                m_stmt->bind[fIndex].buffer = (char*)buffer + rowSize;
-            }
-            else
-            {
-                m_rows[std::size_t(m_rowPosition) * m_fieldCount + fIndex].SetValue(
-                    nullptr,
-                    *m_rBind[fIndex].length);
-            }
+            // move buffer pointer to next part
+            if (!*m_rBind[fIndex].is_null)
+                m_stmt->bind[fIndex].buffer = buffer + rowSize;
         }
         m_rowPosition++;
     }
@@ -540,6 +579,32 @@ m_metadataResult(result)
     mysql_stmt_free_result(m_stmt);
 }
 
+PreparedResultSet::PreparedResultSet(std::vector<QueryResultFieldMetadata> fieldMetadata, uint64 rowCount, char const* rows, std::shared_ptr<void const> storage) :
+m_fieldMetadata(std::move(fieldMetadata)),
+m_rowCount(rowCount),
+m_rowPosition(0),
+m_fieldCount(m_fieldMetadata.size()),
+m_stream(false),
+m_rBind(nullptr),
+m_stmt(nullptr),
+m_metadataResult(nullptr),
+m_dataBuffer(nullptr),
+m_streamConnection(nullptr),
+m_snapshotStorage(std::move(storage))
+{
+    for (QueryResultFieldMetadata& meta : m_fieldMetadata)
+        meta.Converter = BinaryValueConverters[AsUnderlyingType(meta.Type)].get();
+
+    m_rows.resize(std::size_t(m_rowCount) * m_fieldCount);
+    for (std::size_t offset = 0; offset < m_rows.size(); offset += m_fieldCount)
+    {
+        for (uint32 fIndex = 0; fIndex < m_fieldCount; ++fIndex)
+            m_rows[offset + fIndex].SetMetadata(&m_fieldMetadata[fIndex]);
+
+        rows = QueryResultSnapshot::ReadRow(rows, &m_rows[offset], m_fieldCount, true);
+    }
+}
+
 ResultSet::~ResultSet()
 {
     CleanUp();
@@ -552,12 +617,28 @@ PreparedResultSet::~PreparedResultSet()
 
 bool ResultSet::NextRow()
 {
+    if (_snapshotRow)
+    {
+        if (!_snapshotRowsLeft)
+        {
+            CleanUp();
+            return false;
+        }
+
+        --_snapshotRowsLeft;
+        _snapshotRow = QueryResultSnapshot::ReadRow(_snapshotRow, _currentRow, _fieldCount, false);
+        return true;
+    }
+
     if (!_result)
         return false;
 
     MYSQL_ROW row = mysql_fetch_row(_result);
     if (!row)
     {
+        if (_streamConnection && mysql_errno(_result->handle))
+            TC_LOG_ERROR("sql.sql", "{}:mysql_fetch_row, cannot read row from MySQL server. Error {}.", __FUNCTION__, mysql_error(_result->handle));
+
         CleanUp();
         return false;
     }
@@ -573,11 +654,17 @@ bool ResultSet::NextRow()
     for (uint32 i = 0; i < _fieldCount; i++)
         _currentRow[i].SetValue(row[i], lengths[i]);
 
+    if (_streamConnection)
+        ++_rowCount;
+
     return true;
 }
 
 bool PreparedResultSet::NextRow()
 {
+    if (m_stream)
+        return FetchStreamRow();
+
     /// Only updates the m_rowPosition so upper level code knows in which element
     /// of the rows vector to look
     if (++m_rowPosition >= m_rowCount)
@@ -597,6 +684,92 @@ bool PreparedResultSet::_NextRow()
     return retval == 0 || retval == MYSQL_DATA_TRUNCATED;
 }
 
+bool PreparedResultSet::FetchStreamRow()
+{
+    if (!m_streamConnection)
+        return false;
+
+    int retval = mysql_stmt_fetch(m_stmt);
+    if (retval != 0 && retval != MYSQL_DATA_TRUNCATED)
+    {
+        if (retval != MYSQL_NO_DATA)
+            TC_LOG_ERROR("sql.sql", "{}:mysql_stmt_fetch, cannot read row from MySQL server. Error: {}", __FUNCTION__, mysql_stmt_error(m_stmt));
+
+        FinishStream();
+        return false;
+    }
+
+    bool rebind = false;
+    for (uint32 fIndex = 0; fIndex < m_fieldCount; ++fIndex)
+    {
+        MySQLBind& bind = m_rBind[fIndex];
+        if (!*bind.is_null && IsStringType(bind.buffer_type) && *bind.length >= bind.buffer_length)
+        {
+            // value did not fit (with its null terminator), read it again into a buffer large enough for it
+            std::vector<char>& buffer = m_streamBuffers[fIndex];
+            buffer.resize(*bind.length + 1);
+            bind.buffer = buffer.data();
+            bind.buffer_length = buffer.size();
+            if (mysql_stmt_fetch_column(m_stmt, &bind, fIndex, 0))
+            {
+                TC_LOG_ERROR("sql.sql", "{}:mysql_stmt_fetch_column, cannot read column {} from MySQL server. Error: {}", __FUNCTION__, fIndex, mysql_stmt_error(m_stmt));
+                FinishStream();
+                return false;
+            }
+
+            rebind = true;
+        }
+
+        SetFieldValue(m_rows[fIndex], fIndex, static_cast<char*>(bind.buffer));
+    }
+
+    // following rows are read into the grown buffers directly
+    if (rebind && mysql_stmt_bind_result(m_stmt, m_rBind))
+    {
+        TC_LOG_ERROR("sql.sql", "{}:mysql_stmt_bind_result, cannot bind result from MySQL server. Error: {}", __FUNCTION__, mysql_stmt_error(m_stmt));
+        FinishStream();
+        return false;
+    }
+
+    m_rowPosition = m_rowCount++;
+    return true;
+}
+
+void PreparedResultSet::FinishStream()
+{
+    if (!m_streamConnection)
+        return;
+
+    /// Discards the rows not read yet, the connection can be used again afterwards
+    mysql_stmt_free_result(m_stmt);
+    m_streamConnection->Unlock();
+    m_streamConnection = nullptr;
+}
+
+void PreparedResultSet::SetFieldValue(Field& field, uint32 fieldIndex, char* buffer)
+{
+    unsigned long buffer_length = m_rBind[fieldIndex].buffer_length;
+    unsigned long fetched_length = *m_rBind[fieldIndex].length;
+    if (*m_rBind[fieldIndex].is_null)
+    {
+        field.SetValue(nullptr, fetched_length);
+        return;
+    }
+
+    if (IsStringType(m_rBind[fieldIndex].buffer_type))
+    {
+        // warning - the string will not be null-terminated if there is no space for it in the buffer
+        // when mysql_stmt_fetch returned MYSQL_DATA_TRUNCATED
+        // we cannot blindly null-terminate the data either as it may be retrieved as binary blob and not specifically a string
+        // in this case using Field::GetCString will result in garbage
+        // TODO: remove Field::GetCString and use std::string_view in C++17
+        if (fetched_length < buffer_length)
+            buffer[fetched_length] = '\0';
+    }
+
+    field.SetValue(buffer, fetched_length);
+}
+
 void ResultSet::CleanUp()
 {
     if (_currentRow)
@@ -607,9 +780,16 @@ void ResultSet::CleanUp()
 
     if (_result)
     {
+        // also discards the rows of a streamed result that were not read
         mysql_free_result(_result);
         _result = nullptr;
     }
+
+    if (_streamConnection)
+    {
+        _streamConnection->Unlock();
+        _streamConnection = nullptr;
+    }
 }
 
 Field const& ResultSet::operator[](std::size_t index) const
@@ -627,14 +807,14 @@ QueryResultFieldMetadata const& ResultSet::GetFieldMetadata(std::size_t index) c
 Field* PreparedResultSet::Fetch() const
 {
     ASSERT(m_rowPosition < m_rowCount);
-    return const_cast<Field*>(&m_rows[std::size_t(m_rowPosition) * m_fieldCount]);
+    return const_cast<Field*>(&m_rows[GetRowOffset()]);
 }
 
 Field const& PreparedResultSet::operator[](std::size_t index) const
 {
     ASSERT(m_rowPosition < m_rowCount);
     ASSERT(index < std::size_t(m_fieldCount));
-    return m_rows[std::size_t(m_rowPosition) * m_fieldCount + index];
+    return m_rows[GetRowOffset() + index];
 }
 
 QueryResultFieldMetadata const& PreparedResultSet::GetFieldMetadata(std::size_t index) const
@@ -645,12 +825,18 @@ QueryResultFieldMetadata const& PreparedResultSet::GetFieldMetadata(std::size_t
 
 void PreparedResultSet::CleanUp()
 {
+    FinishStream();
+
     if (m_metadataResult)
+    {
         mysql_free_result(m_metadataResult);
+        m_metadataResult = nullptr;
+    }
 
     if (m_rBind)
     {
-        delete[](char*)m_rBind->buffer;
+        delete[] m_dataBuffer;
+        m_dataBuffer = nullptr;
         delete[] m_rBind;
         m_rBind = nullptr;
     }
@@ -20,12 +20,21 @@
 
 #include "Define.h"
 #include "DatabaseEnvFwd.h"
+#include <memory>
 #include <vector>
 
+class MySQLConnection;
+
+/// Results of DatabaseWorkerPool::StreamQuery are read from the server row by row instead of being buffered whole.
+/// The connection stays locked until the last row was read or the result is destroyed, which must happen on the
+/// thread that started the query; synchronous queries of the same database meanwhile need another synch connection.
+/// GetRowCount of a streamed result only counts the rows read so far.
 class TC_DATABASE_API ResultSet
 {
     public:
-        ResultSet(MySQLResult* result, MySQLField* fields, uint64 rowCount, uint32 fieldCount);
+        ResultSet(MySQLResult* result, MySQLField* fields, uint64 rowCount, uint32 fieldCount, MySQLConnection* streamConnection = nullptr);
+        /// Rows read from a QueryResultSnapshot, rows and the metadata strings point into storage
+        ResultSet(std::vector<QueryResultFieldMetadata> fieldMetadata, uint64 rowCount, char const* rows, std::shared_ptr<void const> storage);
         ~ResultSet();
 
         bool NextRow();
@@ -47,6 +56,10 @@ class TC_DATABASE_API ResultSet
         void CleanUp();
         MySQLResult* _result;
         MySQLField* _fields;
+        MySQLConnection* _streamConnection;
+        char const* _snapshotRow;
+        uint64 _snapshotRowsLeft;
+        std::shared_ptr<void const> _snapshotStorage;
 
         ResultSet(ResultSet const& right) = delete;
         ResultSet& operator=(ResultSet const& right) = delete;
@@ -55,7 +68,9 @@ class TC_DATABASE_API ResultSet
 class TC_DATABASE_API PreparedResultSet
 {
     public:
-        PreparedResultSet(MySQLStmt* stmt, MySQLResult* result, uint64 rowCount, uint32 fieldCount);
+        PreparedResultSet(MySQLStmt* stmt, MySQLResult* result, uint64 rowCount, uint32 fieldCount, MySQLConnection* streamConnection = nullptr);
+        /// Rows read from a QueryResultSnapshot, rows and the metadata strings point into storage
+        PreparedResultSet(std::vector<QueryResultFieldMetadata> fieldMetadata, uint64 rowCount, char const* rows, std::shared_ptr<void const> storage);
         ~PreparedResultSet();
 
         bool NextRow();
@@ -73,14 +88,23 @@ class TC_DATABASE_API PreparedResultSet
         uint64 m_rowCount;
         uint64 m_rowPosition;
         uint32 m_fieldCount;
+        bool m_stream;
 
     private:
         MySQLBind* m_rBind;
         MySQLStmt* m_stmt;
         MySQLResult* m_metadataResult;    ///< Field metadata, returned by mysql_stmt_result_metadata
+        char* m_dataBuffer;
+        MySQLConnection* m_streamConnection;
+        std::vector<std::vector<char>> m_streamBuffers;   ///< string columns of streamed results that outgrew m_dataBuffer
+        std::shared_ptr<void const> m_snapshotStorage;
 
         void CleanUp();
         bool _NextRow();
+        bool FetchStreamRow();
+        void FinishStream();
+        void SetFieldValue(Field& field, uint32 fieldIndex, char* buffer);
+        std::size_t GetRowOffset() const { return m_stream ? 0 : std::size_t(m_rowPosition) * m_fieldCount; }
 
         PreparedResultSet(PreparedResultSet const& right) = delete;
         PreparedResultSet& operator=(PreparedResultSet const& right) = delete;
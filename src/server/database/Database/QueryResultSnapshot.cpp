@@ -0,0 +1,601 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "QueryResultSnapshot.h"
+#include "CryptoHash.h"
+#include "Errors.h"
+#include "Field.h"
+#include "Log.h"
+#include "PreparedStatement.h"
+#include "QueryResult.h"
+#include "StringFormat.h"
+#include "Util.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace
+{
+/*
+ * File layout, all values in host byte order:
+ *   SnapshotHeader, revision, padding to 8 bytes
+ *   per entry: uint32 key size, key, padding to 8 bytes, uint64 result size, result, padding to 8 bytes
+ * Result layout:
+ *   uint32 field count, uint32 binary protocol, uint64 row count
+ *   per field: uint32 type, table name, table alias, name, alias, type name (uint32 size, characters, '\0')
+ *   padding to 8 bytes, then the rows
+ *   per value: padding to 4 bytes, uint32 size or NullValueSize, for values not NULL the bytes (aligned to 8 bytes
+ *   for the binary protocol) followed by '\0'
+ * Results start at offsets aligned to 8 bytes so values of the binary protocol can be read in place.
+ */
+constexpr char SnapshotMagic[8] = { 'T', 'C', 'Q', 'R', 'S', 'N', 'A', 'P' };
+constexpr uint32 SnapshotVersion = 1;
+constexpr uint32 NullValueSize = 0xFFFFFFFF;
+
+struct SnapshotHeader
+{
+    char Magic[8];
+    uint32 Version;
+    uint32 RevisionSize;
+    uint64 EntryCount;
+    uint64 PayloadSize;
+    Trinity::Crypto::SHA1::Digest Checksum;
+    uint32 Padding;
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0);
+
+constexpr std::size_t AlignedSize(std::size_t size, std::size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+char const* AlignedPointer(char const* data, std::size_t alignment)
+{
+    return reinterpret_cast<char const*>(AlignedSize(reinterpret_cast<uintptr_t>(data), alignment));
+}
+
+template<typename T>
+void Append(std::vector<char>& buffer, T value)
+{
+    buffer.insert(buffer.end(), reinterpret_cast<char const*>(&value), reinterpret_cast<char const*>(&value) + sizeof(T));
+}
+
+void AppendBytes(std::vector<char>& buffer, char const* data, std::size_t size)
+{
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+void AppendPadding(std::vector<char>& buffer, std::size_t alignment)
+{
+    buffer.resize(AlignedSize(buffer.size(), alignment), '\0');
+}
+
+void AppendString(std::vector<char>& buffer, char const* value)
+{
+    std::size_t size = value ? std::strlen(value) : 0;
+    Append<uint32>(buffer, size);
+    AppendBytes(buffer, value, size);
+    buffer.push_back('\0');
+}
+
+/// Bounds checked reading of a mapped file, any read past the end fails all following ones
+class SnapshotReader
+{
+public:
+    SnapshotReader(char const* data, std::size_t size) : _data(data), _end(data + size) { }
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        if (!Has(sizeof(T)))
+            return false;
+
+        std::memcpy(&value, _data, sizeof(T));
+        _data += sizeof(T);
+        return true;
+    }
+
+    char const* Skip(std::size_t size)
+    {
+        if (!Has(size))
+            return nullptr;
+
+        char const* data = _data;
+        _data += size;
+        return data;
+    }
+
+    bool Align(std::size_t alignment)
+    {
+        char const* aligned = AlignedPointer(_data, alignment);
+        if (aligned > _end)
+            return false;
+
+        _data = aligned;
+        return true;
+    }
+
+    char const* ReadString()
+    {
+        uint32 size = 0;
+        if (!Read(size))
+            return nullptr;
+
+        char const* value = Skip(std::size_t(size) + 1);
+        return value && value[size] == '\0' ? value : nullptr;
+    }
+
+    char const* GetPosition() const { return _data; }
+
+private:
+    bool Has(std::size_t size) const { return _data && std::size_t(_end - _data) >= size; }
+
+    char const* _data;
+    char const* _end;
+};
+
+template<typename Result>
+constexpr bool IsBinaryProtocol = std::is_same_v<Result, PreparedQueryResult>;
+
+template<typename Result>
+Result CreateResult(char const* data, std::size_t size, std::shared_ptr<void const> storage)
+{
+    using ResultType = typename Result::element_type;
+
+    SnapshotReader reader(data, size);
+    uint32 fieldCount = 0;
+    uint32 binaryProtocol = 0;
+    uint64 rowCount = 0;
+    if (!reader.Read(fieldCount) || !reader.Read(binaryProtocol) || !reader.Read(rowCount))
+        return nullptr;
+
+    if (!rowCount || bool(binaryProtocol) != IsBinaryProtocol<Result>)
+        return nullptr;
+
+    std::vector<QueryResultFieldMetadata> fieldMetadata(fieldCount);
+    for (uint32 i = 0; i < fieldCount; ++i)
+    {
+        QueryResultFieldMetadata& meta = fieldMetadata[i];
+        uint32 type = 0;
+        if (!reader.Read(type) || type > AsUnderlyingType(DatabaseFieldTypes::Binary))
+            return nullptr;
+
+        meta.Index = i;
+        meta.Type = DatabaseFieldTypes(type);
+        meta.TableName = reader.ReadString();
+        meta.TableAlias = reader.ReadString();
+        meta.Name = reader.ReadString();
+        meta.Alias = reader.ReadString();
+        meta.TypeName = reader.ReadString();
+        if (!meta.TypeName)
+            return nullptr;
+    }
+
+    if (!reader.Align(8))
+        return nullptr;
+
+    Result result = std::make_shared<ResultType>(std::move(fieldMetadata), rowCount, reader.GetPosition(), std::move(storage));
+    if constexpr (!IsBinaryProtocol<Result>)
+        result->NextRow();
+
+    return result;
+}
+}
+
+template<typename Result>
+std::shared_ptr<std::vector<char>> QueryResultSnapshot::Serialize(Result const& result)
+{
+    std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>();
+    uint32 fieldCount = result ? result->GetFieldCount() : 0;
+    Append<uint32>(*buffer, fieldCount);
+    Append<uint32>(*buffer, IsBinaryProtocol<Result>);
+    std::size_t rowCountOffset = buffer->size();
+    Append<uint64>(*buffer, 0);
+    if (!result)
+        return buffer;
+
+    for (uint32 i = 0; i < fieldCount; ++i)
+    {
+        QueryResultFieldMetadata const& meta = result->GetFieldMetadata(i);
+        Append<uint32>(*buffer, AsUnderlyingType(meta.Type));
+        AppendString(*buffer, meta.TableName);
+        AppendString(*buffer, meta.TableAlias);
+        AppendString(*buffer, meta.Name);
+        AppendString(*buffer, meta.Alias);
+        AppendString(*buffer, meta.TypeName);
+    }
+
+    AppendPadding(*buffer, 8);
+
+    // results are returned positioned at their first row, streamed ones do not know their row count yet
+    uint64 rowCount = 0;
+    do
+    {
+        Field* fields = result->Fetch();
+        for (uint32 i = 0; i < fieldCount; ++i)
+        {
+            AppendPadding(*buffer, 4);
+            if (fields[i].IsNull())
+            {
+                Append<uint32>(*buffer, NullValueSize);
+                continue;
+            }
+
+            Append<uint32>(*buffer, fields[i]._length);
+            if constexpr (IsBinaryProtocol<Result>)
+                AppendPadding(*buffer, 8);
+
+            AppendBytes(*buffer, fields[i]._value, fields[i]._length);
+            buffer->push_back('\0');
+        }
+
+        ++rowCount;
+    } while (result->NextRow());
+
+    std::memcpy(buffer->data() + rowCountOffset, &rowCount, sizeof(rowCount));
+    return buffer;
+}
+
+struct QueryResultSnapshot::Storage
+{
+    boost::interprocess::file_mapping Mapping;
+    boost::interprocess::mapped_region Region;
+};
+
+QueryResultSnapshot::QueryResultSnapshot() : _loading(true), _changed(false), _removed(false), _invalidationFailed(false), _hits(0), _misses(0), _writes(0)
+{
+}
+
+QueryResultSnapshot::~QueryResultSnapshot() = default;
+
+bool QueryResultSnapshot::Open(std::string const& fileName, std::string const& revision)
+{
+    _revision = revision;
+
+    std::shared_ptr<Storage> file = std::make_shared<Storage>();
+    try
+    {
+        file->Mapping = boost::interprocess::file_mapping(fileName.c_str(), boost::interprocess::read_only);
+        file->Region = boost::interprocess::mapped_region(file->Mapping, boost::interprocess::read_only);
+    }
+    catch (boost::interprocess::interprocess_exception const& e)
+    {
+        TC_LOG_INFO("sql.sql", "QueryResultSnapshot: cannot map {} ({}), results are read from the database", fileName, e.what());
+        return false;
+    }
+
+    char const* data = static_cast<char const*>(file->Region.get_address());
+    std::size_t size = file->Region.get_size();
+
+    SnapshotHeader header;
+    SnapshotReader reader(data, size);
+    if (!reader.Read(header) || std::memcmp(header.Magic, SnapshotMagic, sizeof(SnapshotMagic)) || header.Version != SnapshotVersion)
+    {
+        TC_LOG_ERROR("sql.sql", "QueryResultSnapshot: {} is not a snapshot of this version, results are read from the database", fileName);
+        return false;
+    }
+
+    char const* fileRevision = reader.Skip(header.RevisionSize);
+    if (!fileRevision || std::string_view(fileRevision, header.RevisionSize) != revision)
+    {
+        TC_LOG_INFO("sql.sql", "QueryResultSnapshot: {} was written for another database revision, results are read from the database", fileName);
+        return false;
+    }
+
+    char const* payload = reader.Align(8) ? reader.Skip(header.PayloadSize) : nullptr;
+    if (!payload || Trinity::Crypto::SHA1::GetDigestOf(reinterpret_cast<uint8 const*>(payload), header.PayloadSize) != header.Checksum)
+    {
+        TC_LOG_ERROR("sql.sql", "QueryResultSnapshot: {} is damaged, results are read from the database", fileName);
+        return false;
+    }
+
+    std::unordered_map<std::string_view, Entry> entries;
+    SnapshotReader payloadReader(payload, header.PayloadSize);
+    for (uint64 i = 0; i < header.EntryCount; ++i)
+    {
+        uint32 keySize = 0;
+        uint64 resultSize = 0;
+        char const* key = payloadReader.Read(keySize) ? payloadReader.Skip(keySize) : nullptr;
+        if (!key || !payloadReader.Align(8) || !payloadReader.Read(resultSize))
+            return false;
+
+        Entry& entry = entries[std::string_view(key, keySize)];
+        entry.Data = payloadReader.Skip(resultSize);
+        entry.Size = resultSize;
+        if (!entry.Data || !payloadReader.Align(8))
+            return false;
+    }
+
+    _file = std::move(file);
+    _entries = std::move(entries);
+    TC_LOG_INFO("sql.sql", "QueryResultSnapshot: mapped {} results from {}", _entries.size(), fileName);
+    return true;
+}
+
+bool QueryResultSnapshot::Write(std::string const& fileName)
+{
+    std::lock_guard<std::mutex> lock(_recordLock);
+
+    // the same query may have been recorded twice by concurrent loaders
+    std::map<std::string_view, Entry> entries;
+    for (auto const& [key, entry] : _entries)
+        entries[key] = entry;
+
+    for (auto const& [key, buffer] : _recorded)
+        entries[key] = { buffer->data(), buffer->size() };
+
+    std::string tempFileName = fileName + ".tmp";
+    std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        TC_LOG_ERROR("sql.sql", "QueryResultSnapshot: cannot create {}", tempFileName);
+        return false;
+    }
+
+    SnapshotHeader header = { };
+    std::memcpy(header.Magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.Version = SnapshotVersion;
+    header.RevisionSize = _revision.size();
+    header.EntryCount = entries.size();
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    file.write(_revision.data(), _revision.size());
+
+    std::size_t written = sizeof(header) + _revision.size();
+    Trinity::Crypto::SHA1 checksum;
+    auto write = [&](char const* data, std::size_t size, bool payload)
+    {
+        file.write(data, size);
+        if (payload)
+            checksum.UpdateData(reinterpret_cast<uint8 const*>(data), size);
+
+        written += size;
+    };
+
+    auto pad = [&](bool payload)
+    {
+        static constexpr char Padding[8] = { };
+        write(Padding, AlignedSize(written, 8) - written, payload);
+    };
+
+    pad(false);
+    std::size_t payloadStart = written;
+    for (auto const& [key, entry] : entries)
+    {
+        uint32 keySize = key.size();
+        uint64 resultSize = entry.Size;
+        write(reinterpret_cast<char const*>(&keySize), sizeof(keySize), true);
+        write(key.data(), key.size(), true);
+        pad(true);
+        write(reinterpret_cast<char const*>(&resultSize), sizeof(resultSize), true);
+        write(entry.Data, entry.Size, true);
+        pad(true);
+    }
+
+    checksum.Finalize();
+    header.PayloadSize = written - payloadStart;
+    header.Checksum = checksum.GetDigest();
+    file.seekp(0);
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    file.close();
+
+    std::size_t entryCount = entries.size();
+    entries.clear();
+
+    // a mapped file cannot be replaced on every platform
+    Release();
+
+    boost::system::error_code error;
+    if (file)
+        boost::filesystem::rename(tempFileName, fileName, error);
+
+    if (!file || error)
+    {
+        TC_LOG_ERROR("sql.sql", "QueryResultSnapshot: cannot write {}: {}", fileName, file ? error.message() : "write to the temporary file failed");
+        boost::filesystem::remove(tempFileName, error);
+        return false;
+    }
+
+    TC_LOG_INFO("sql.sql", "QueryResultSnapshot: wrote {} results ({} bytes) to {}", entryCount, written, fileName);
+    return true;
+}
+
+void QueryResultSnapshot::Finish(std::string const& fileName)
+{
+    _finishedFileName = fileName;
+    _loading = false;
+
+    if (_changed)
+    {
+        TC_LOG_INFO("sql.sql", "QueryResultSnapshot: the database was changed while loading, {} is not used again", fileName);
+        std::lock_guard<std::mutex> lock(_recordLock);
+        Release();
+        Invalidate();
+    }
+    else if (HasChanges())
+        Write(fileName);
+    else
+    {
+        std::lock_guard<std::mutex> lock(_recordLock);
+        Release();
+    }
+}
+
+void QueryResultSnapshot::Release()
+{
+    // results still in use keep the mapping alive until they are destroyed
+    _entries.clear();
+    _file.reset();
+    _recorded.clear();
+}
+
+void QueryResultSnapshot::Invalidate()
+{
+    if (_removed.exchange(true))
+        return;
+
+    boost::system::error_code error;
+    boost::filesystem::remove(_finishedFileName, error);
+    if (!error)
+        return;
+
+    // still mapped by a result or opened by another process, an empty file is never accepted by Open either
+    std::ofstream file(_finishedFileName, std::ios::binary | std::ios::trunc);
+    if (file.is_open())
+    {
+        TC_LOG_WARN("sql.sql", "QueryResultSnapshot: cannot remove {} ({}), emptied it instead", _finishedFileName, error.message());
+        return;
+    }
+
+    // tried again on the next write, reported once
+    if (!_invalidationFailed.exchange(true))
+        TC_LOG_ERROR("sql.sql", "QueryResultSnapshot: cannot remove {} ({}), delete it before the next start", _finishedFileName, error.message());
+
+    _removed = false;
+}
+
+bool QueryResultSnapshot::Find(std::string_view key, QueryResult& result)
+{
+    return FindEntry(key, result);
+}
+
+bool QueryResultSnapshot::Find(std::string_view key, PreparedQueryResult& result)
+{
+    return FindEntry(key, result);
+}
+
+QueryResult QueryResultSnapshot::Record(std::string_view key, QueryResult result)
+{
+    return RecordEntry(key, std::move(result));
+}
+
+PreparedQueryResult QueryResultSnapshot::Record(std::string_view key, PreparedQueryResult result)
+{
+    return RecordEntry(key, std::move(result));
+}
+
+template<typename Result>
+bool QueryResultSnapshot::FindEntry(std::string_view key, Result& result)
+{
+    auto itr = _entries.find(key);
+    if (!_loading || itr == _entries.end())
+    {
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+    result = CreateResult<Result>(itr->second.Data, itr->second.Size, _file);
+    return true;
+}
+
+template<typename Result>
+Result QueryResultSnapshot::RecordEntry(std::string_view key, Result result)
+{
+    // results read after a write to the database may differ from the ones of the next start
+    if (!_loading || _changed)
+        return result;
+
+    std::shared_ptr<std::vector<char>> buffer = Serialize(result);
+    {
+        std::lock_guard<std::mutex> lock(_recordLock);
+        _recorded.emplace_back(key, buffer);
+    }
+
+    return CreateResult<Result>(buffer->data(), buffer->size(), buffer);
+}
+
+void QueryResultSnapshot::OnDatabaseWrite()
+{
+    ++_writes;
+    if (_loading)
+    {
+        _changed = true;
+        return;
+    }
+
+    if (!_finishedFileName.empty() && !_removed)
+    {
+        TC_LOG_INFO("sql.sql", "QueryResultSnapshot: database changed, removing {}", _finishedFileName);
+        Invalidate();
+    }
+}
+
+bool QueryResultSnapshot::HasChanges() const
+{
+    std::lock_guard<std::mutex> lock(_recordLock);
+    return !_recorded.empty() && !_changed;
+}
+
+QueryResultSnapshot::Statistics QueryResultSnapshot::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.Hits = _hits;
+    statistics.Misses = _misses;
+    statistics.Writes = _writes;
+    return statistics;
+}
+
+std::string QueryResultSnapshot::GetKey(PreparedStatementBase const* stmt)
+{
+    std::string key = Trinity::StringFormat("prepared statement {}", stmt->GetIndex());
+    for (PreparedStatementData const& data : stmt->GetParameters())
+    {
+        key += ", ";
+        std::visit([&key](auto&& value)
+        {
+            using ValueType = std::decay_t<decltype(value)>;
+            // strings and binary values carry their size so parameters cannot run into each other
+            if constexpr (std::is_same_v<ValueType, std::string>)
+                key += Trinity::StringFormat("{}:{}", value.size(), PreparedStatementData::ToString(value));
+            else if constexpr (std::is_same_v<ValueType, std::vector<uint8>>)
+                key += Trinity::StringFormat("{}:0x{}", value.size(), ByteArrayToHexStr(value));
+            else
+                key += PreparedStatementData::ToString(value);
+        }, data.data);
+    }
+
+    return key;
+}
+
+char const* QueryResultSnapshot::ReadRow(char const* row, Field* fields, uint32 fieldCount, bool binaryProtocol)
+{
+    for (uint32 i = 0; i < fieldCount; ++i)
+    {
+        row = AlignedPointer(row, 4);
+        uint32 size;
+        std::memcpy(&size, row, sizeof(size));
+        row += sizeof(size);
+        if (size == NullValueSize)
+        {
+            fields[i].SetValue(nullptr, 0);
+            continue;
+        }
+
+        if (binaryProtocol)
+            row = AlignedPointer(row, 8);
+
+        fields[i].SetValue(row, size);
+        row += size + 1;
+    }
+
+    return row;
+}
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUERYRESULTSNAPSHOT_H
+#define QUERYRESULTSNAPSHOT_H
+
+#include "Define.h"
+#include "DatabaseEnvFwd.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Binary file holding the results of the synchronous queries a database pool ran while it was attached,
+ * keyed by their SQL text or prepared statement and parameters.
+ * A snapshot opened from a file serves those results from a read-only memory mapping, queries it does not
+ * hold are run against the server and recorded so Write can store them for the next start.
+ * The file is only accepted when its revision matches the one it is opened with, the caller has to pick
+ * a revision that changes whenever the database content does.
+ * Any write to the database through the pool marks the snapshot as changed: while loading it is not written
+ * anymore, afterwards the file is removed so the next start reads the database again.
+ */
+class TC_DATABASE_API QueryResultSnapshot
+{
+public:
+    struct Statistics
+    {
+        uint32 Hits = 0;
+        uint32 Misses = 0;
+        uint32 Writes = 0;
+    };
+
+    QueryResultSnapshot();
+    ~QueryResultSnapshot();
+
+    /// Maps the file, returns false and keeps the snapshot empty if it is missing, damaged or of another revision
+    bool Open(std::string const& fileName, std::string const& revision);
+
+    /// Writes the results served from the file and the recorded ones, then releases them and the mapped file
+    bool Write(std::string const& fileName);
+
+    /// Stops serving and recording results and releases the mapped file. Writes fileName if results were recorded,
+    /// removes it if the database was changed while loading or when it is changed afterwards
+    void Finish(std::string const& fileName);
+
+    /// True if the snapshot holds the result of the query, result is null for queries without rows
+    bool Find(std::string_view key, QueryResult& result);
+    bool Find(std::string_view key, PreparedQueryResult& result);
+
+    /// Stores the rows of a result not found in the snapshot, returns a result of the same rows from the start
+    QueryResult Record(std::string_view key, QueryResult result);
+    PreparedQueryResult Record(std::string_view key, PreparedQueryResult result);
+
+    void OnDatabaseWrite();
+
+    bool IsLoading() const { return _loading; }
+    bool HasChanges() const;
+    Statistics GetStatistics() const;
+
+    static std::string GetKey(PreparedStatementBase const* stmt);
+
+    /// Reads the values of one row into fields, returns the start of the next row
+    static char const* ReadRow(char const* row, Field* fields, uint32 fieldCount, bool binaryProtocol);
+
+private:
+    struct Storage;
+    struct Entry
+    {
+        char const* Data = nullptr;
+        std::size_t Size = 0;
+    };
+
+    template<typename Result>
+    bool FindEntry(std::string_view key, Result& result);
+
+    template<typename Result>
+    Result RecordEntry(std::string_view key, Result result);
+
+    template<typename Result>
+    static std::shared_ptr<std::vector<char>> Serialize(Result const& result);
+
+    void Release();     ///< caller holds _recordLock
+    void Invalidate();
+
+    std::shared_ptr<Storage> _file;
+    std::string _revision;
+    std::unordered_map<std::string_view, Entry> _entries;
+
+    mutable std::mutex _recordLock;
+    std::vector<std::pair<std::string, std::shared_ptr<std::vector<char>>>> _recorded;
+
+    std::atomic<bool> _loading;
+    std::atomic<bool> _changed;
+    std::atomic<bool> _removed;
+    std::atomic<bool> _invalidationFailed;
+    std::string _finishedFileName;
+    std::atomic<uint32> _hits;
+    std::atomic<uint32> _misses;
+    std::atomic<uint32> _writes;
+};
+
+#endif
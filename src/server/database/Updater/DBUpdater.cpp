@@ -18,6 +18,7 @@
 #include "DBUpdater.h"
 #include "BuiltInConfig.h"
 #include "Config.h"
+#include "CryptoHash.h"
 #include "DatabaseEnv.h"
 #include "DatabaseLoader.h"
 #include "GitRevision.h"
@@ -25,6 +26,7 @@
 #include "QueryResult.h"
 #include "StartProcess.h"
 #include "UpdateFetcher.h"
+#include "Util.h"
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
 #include <iostream>
@@ -307,6 +309,27 @@ bool DBUpdater<T>::Populate(DatabaseWorkerPool<T>& pool)
     return true;
 }
 
+template<class T>
+std::string DBUpdater<T>::GetRevision(DatabaseWorkerPool<T>& pool)
+{
+    QueryResult const result = Retrieve(pool, "SELECT name, hash FROM updates ORDER BY name ASC");
+    if (!result)
+        return "";
+
+    Trinity::Crypto::SHA1 hash;
+    do
+    {
+        Field* fields = result->Fetch();
+        hash.UpdateData(fields[0].GetString());
+        hash.UpdateData(":");
+        hash.UpdateData(fields[1].GetString());
+        hash.UpdateData("\n");
+    } while (result->NextRow());
+
+    hash.Finalize();
+    return ByteArrayToHexStr(hash.GetDigest());
+}
+
 template<class T>
 QueryResult DBUpdater<T>::Retrieve(DatabaseWorkerPool<T>& pool, std::string const& query)
 {
@@ -84,6 +84,9 @@ public:
 
     static bool Populate(DatabaseWorkerPool<T>& pool);
 
+    /// Hash over the names and hashes of the updates applied to the database, empty if they cannot be read
+    static std::string GetRevision(DatabaseWorkerPool<T>& pool);
+
 private:
     static QueryResult Retrieve(DatabaseWorkerPool<T>& pool, std::string const& query);
     static void Apply(DatabaseWorkerPool<T>& pool, std::string const& query);
@@ -18284,8 +18284,8 @@ bool bot_ai::GlobalUpdate(uint32 diff)
         //Model size / Combat reach
         if (me->GetDisplayId() == me->GetNativeDisplayId())
         {
-            me->SetFloatValue(UNIT_FIELD_BOUNDINGRADIUS, DEFAULT_PLAYER_BOUNDING_RADIUS * me->GetObjectScale());
-            me->SetFloatValue(UNIT_FIELD_COMBATREACH,  DEFAULT_PLAYER_COMBAT_REACH * me->GetObjectScale());
+            me->SetBoundingRadius(DEFAULT_PLAYER_BOUNDING_RADIUS * me->GetObjectScale());
+            me->SetCombatReach(DEFAULT_PLAYER_COMBAT_REACH * me->GetObjectScale());
 
             //debug: restore offhand visual if needed
             if (me->GetUInt32Value(UNIT_VIRTUAL_ITEM_SLOT_ID + uint32(BOT_SLOT_OFFHAND)) == 0 && _canUseOffHand())
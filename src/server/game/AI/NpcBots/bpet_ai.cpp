@@ -2371,8 +2371,8 @@ bool bot_pet_ai::GlobalUpdate(uint32 diff)
         }
         if (myType == BOT_PET_LOCUST_SWARM)
         {
-            me->SetFloatValue(UNIT_FIELD_BOUNDINGRADIUS, 2.0f * DEFAULT_PLAYER_BOUNDING_RADIUS * me->GetObjectScale());
-            me->SetFloatValue(UNIT_FIELD_COMBATREACH,  2.0f * DEFAULT_PLAYER_COMBAT_REACH * me->GetObjectScale());
+            me->SetBoundingRadius(2.0f * DEFAULT_PLAYER_BOUNDING_RADIUS * me->GetObjectScale());
+            me->SetCombatReach(2.0f * DEFAULT_PLAYER_COMBAT_REACH * me->GetObjectScale());
         }
     }
 
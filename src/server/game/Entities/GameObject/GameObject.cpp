@@ -37,6 +37,7 @@
 #include "OutdoorPvPMgr.h"
 #include "PoolMgr.h"
 #include "QueryPackets.h"
+#include "ScopeProfiler.h"
 #include "ScriptMgr.h"
 #include "SpellMgr.h"
 #include "Transport.h"
@@ -484,8 +485,11 @@ void GameObject::Update(uint32 diff)
 #endif
     m_Events.Update(diff);
 
-    if (AI())
-        AI()->UpdateAI(diff);
+    if (GameObjectAI* ai = AI())
+    {
+        ScopeProfiler::Scope profileScope(ScopeProfiler::SCOPE_NESTED, typeid(*ai), "UpdateAI");
+        ai->UpdateAI(diff);
+    }
     else if (!AIM_Initialize())
         TC_LOG_ERROR("misc", "Could not initialize GameObjectAI");
 
@@ -2911,6 +2915,27 @@ void GameObject::BuildValuesUpdate(uint8 updateType, ByteBuffer* data, Player co
     data->append(fieldBuffer);
 }
 
+bool GameObject::GetValuesUpdateViewKey(Player const* target, uint32& viewKey) const
+{
+    viewKey = UF_FLAG_PUBLIC;
+    if (GetOwnerGUID() == target->GetGUID())
+        viewKey |= UF_FLAG_OWNER;
+
+    // the dynamic field is in every update, quest activation and chest flags are built for each target
+    switch (GetGoType())
+    {
+        case GAMEOBJECT_TYPE_QUESTGIVER:
+        case GAMEOBJECT_TYPE_CHEST:
+        case GAMEOBJECT_TYPE_GOOBER:
+        case GAMEOBJECT_TYPE_GENERIC:
+            return false;
+        default:
+            break;
+    }
+
+    return true;
+}
+
 void GameObject::GetRespawnPosition(float &x, float &y, float &z, float* ori /* = nullptr*/) const
 {
     if (m_goData)
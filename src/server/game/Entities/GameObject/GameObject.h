@@ -93,6 +93,7 @@ class TC_GAME_API GameObject : public WorldObject, public GridObject<GameObject>
         ~GameObject();
 
         void BuildValuesUpdate(uint8 updatetype, ByteBuffer* data, Player const* target) const override;
+        bool GetValuesUpdateViewKey(Player const* target, uint32& viewKey) const override;
 
         void AddToWorld() override;
         void RemoveFromWorld() override;
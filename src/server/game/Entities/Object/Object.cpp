@@ -49,6 +49,7 @@
 #include "Transport.h"
 #include "Unit.h"
 #include "UpdateFieldFlags.h"
+#include "UpdateFieldFragments.h"
 #include "Vehicle.h"
 #include "VMapFactory.h"
 #include "VMapManager2.h"
@@ -499,10 +500,43 @@ void Object::ClearUpdateMask(bool remove)
     }
 }
 
-void Object::BuildFieldsUpdate(Player* player, UpdateDataMapType& data_map) const
+void Object::BuildFieldsUpdate(Player* player, UpdateDataMapType& data_map, UpdateFieldFragments* fragments) const
 {
     UpdateDataMapType::iterator iter = data_map.try_emplace(player).first;
-    BuildValuesUpdateBlockForPlayer(&iter->second, iter->first);
+
+    uint32 viewKey = 0;
+    if (!fragments || !GetValuesUpdateViewKey(player, viewKey))
+    {
+        std::size_t size = iter->second.GetBuffer().size();
+        BuildValuesUpdateBlockForPlayer(&iter->second, iter->first);
+        if (fragments)
+            fragments->AddSerializedBytes(iter->second.GetBuffer().size() - size);
+        return;
+    }
+
+    ByteBuffer const* fragment = fragments->Find(viewKey);
+    if (!fragment)
+    {
+        ByteBuffer& values = fragments->Create(viewKey);
+        BuildValuesUpdate(UPDATETYPE_VALUES, &values, player);
+        fragments->AddSerializedBytes(values.size());
+        fragment = &values;
+    }
+    else
+        fragments->AddSharedBytes(fragment->size());
+
+    ByteBuffer& buf = iter->second.GetBuffer();
+    buf << uint8(UPDATETYPE_VALUES);
+    buf << GetPackGUID();
+    buf.append(*fragment);
+    iter->second.AddUpdateBlock();
+}
+
+bool Object::GetValuesUpdateViewKey(Player const* target, uint32& viewKey) const
+{
+    uint32* flags = nullptr;
+    viewKey = GetUpdateFieldData(target, flags);
+    return flags != nullptr;
 }
 
 uint32 Object::GetUpdateFieldData(Player const* target, uint32*& flags) const
@@ -946,7 +980,7 @@ void MovementInfo::OutDebug()
 WorldObject::WorldObject(bool isWorldObject) : Object(), WorldLocation(), LastUsedScriptID(0),
 m_movementInfo(), m_name(), m_isActive(false), m_isFarVisible(false), m_isStoredInWorldObjectGridContainer(isWorldObject), m_zoneScript(nullptr),
 m_transport(nullptr), m_zoneId(0), m_areaId(0), m_staticFloorZ(VMAP_INVALID_HEIGHT), m_outdoors(false), m_liquidStatus(LIQUID_MAP_NO_WATER),
-m_currMap(nullptr), m_InstanceId(0), m_phaseMask(PHASEMASK_NORMAL), m_notifyflags(0)
+m_currMap(nullptr), m_InstanceId(0), m_phaseMask(PHASEMASK_NORMAL), m_gridPositionStore(nullptr), m_gridPositionIndex(0), m_notifyflags(0)
 {
     m_serverSideVisibility.SetValue(SERVERSIDE_VISIBILITY_GHOST, GHOST_VISIBILITY_ALIVE | GHOST_VISIBILITY_GHOST);
     m_serverSideVisibilityDetect.SetValue(SERVERSIDE_VISIBILITY_GHOST, GHOST_VISIBILITY_ALIVE);
@@ -965,6 +999,10 @@ WorldObject::~WorldObject()
         }
         ResetMap();
     }
+
+    // deleted while still linked to a grid container, the grid reference itself unlinks on destruction
+    if (m_gridPositionStore)
+        m_gridPositionStore->Remove(this);
 }
 
 void WorldObject::SetIsStoredInWorldObjectGridContainer(bool on)
@@ -1821,12 +1859,32 @@ void WorldObject::SendMessageToSet(WorldPacket const* data, bool self) const
 
 void WorldObject::SendMessageToSetInRange(WorldPacket const* data, float dist, bool /*self*/) const
 {
+    if (GetMap()->ShouldDeferBroadcast(dist))
+    {
+        GetMap()->DeferBroadcast([source = this, packet = *data, dist]()
+        {
+            Trinity::MessageDistDeliverer notifier(source, &packet, dist);
+            Cell::VisitWorldObjects(source, notifier, dist);
+        });
+        return;
+    }
+
     Trinity::MessageDistDeliverer notifier(this, data, dist);
     Cell::VisitWorldObjects(this, notifier, dist);
 }
 
 void WorldObject::SendMessageToSet(WorldPacket const* data, Player const* skipped_rcvr) const
 {
+    if (GetMap()->ShouldDeferBroadcast(GetVisibilityRange()))
+    {
+        GetMap()->DeferBroadcast([source = this, packet = *data, skipped_rcvr]()
+        {
+            Trinity::MessageDistDeliverer notifier(source, &packet, source->GetVisibilityRange(), false, skipped_rcvr);
+            Cell::VisitWorldObjects(source, notifier, source->GetVisibilityRange());
+        });
+        return;
+    }
+
     Trinity::MessageDistDeliverer notifier(this, data, GetVisibilityRange(), false, skipped_rcvr);
     Cell::VisitWorldObjects(this, notifier, GetVisibilityRange());
 }
@@ -3680,6 +3738,7 @@ void WorldObject::MovePositionToFirstCollision(Position &pos, float dist, float
 void WorldObject::SetPhaseMask(uint32 newPhaseMask, bool update)
 {
     m_phaseMask = newPhaseMask;
+    UpdateGridPosition();
 
     if (update && IsInWorld())
         UpdateObjectVisibility();
@@ -3750,9 +3809,10 @@ void WorldObject::UpdateObjectVisibility(bool /*forced*/)
 struct WorldObjectChangeAccumulator
 {
     UpdateDataMapType& i_updateDatas;
+    UpdateFieldFragments& i_fragments;
     WorldObject& i_object;
     GuidSet plr_list;
-    WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d) : i_updateDatas(d), i_object(obj) { }
+    WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d, UpdateFieldFragments& fragments) : i_updateDatas(d), i_fragments(fragments), i_object(obj) { }
     void Visit(PlayerMapType &m)
     {
         Player* source = nullptr;
@@ -3809,7 +3869,7 @@ struct WorldObjectChangeAccumulator
         // Only send update once to a player
         if (plr_list.find(player->GetGUID()) == plr_list.end() && player->HaveAtClient(&i_object))
         {
-            i_object.BuildFieldsUpdate(player, i_updateDatas);
+            i_object.BuildFieldsUpdate(player, i_updateDatas, &i_fragments);
             plr_list.insert(player->GetGUID());
         }
     }
@@ -3819,7 +3879,12 @@ struct WorldObjectChangeAccumulator
 
 void WorldObject::BuildUpdate(UpdateDataMapType& data_map)
 {
-    WorldObjectChangeAccumulator notifier(*this, data_map);
+    // fragments of the map are reused between objects, except for updates sent from parallel region updates
+    UpdateFieldFragments localFragments;
+    UpdateFieldFragments& fragments = GetMap()->IsUpdatingRegionsInParallel() ? localFragments : GetMap()->GetUpdateFieldFragments();
+    fragments.Clear();
+
+    WorldObjectChangeAccumulator notifier(*this, data_map, fragments);
     //we must build packets for all visible players
     Cell::VisitWorldObjects(this, notifier, GetVisibilityRange());
 
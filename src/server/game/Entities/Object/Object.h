@@ -21,6 +21,7 @@
 #include "Common.h"
 #include "Duration.h"
 #include "EventProcessor.h"
+#include "GridPositionStore.h"
 #include "MapDefines.h"
 #include "ModelIgnoreFlags.h"
 #include "MovementInfo.h"
@@ -57,6 +58,7 @@ class TempSummon;
 class Transport;
 class Unit;
 class UpdateData;
+class UpdateFieldFragments;
 class WorldObject;
 class WorldPacket;
 class ZoneScript;
@@ -162,7 +164,8 @@ class TC_GAME_API Object
         virtual bool hasInvolvedQuest(uint32 /* quest_id */) const { return false; }
         void SetIsNewObject(bool enable) { m_isNewObject = enable; }
         virtual void BuildUpdate(UpdateDataMapType&) { }
-        void BuildFieldsUpdate(Player*, UpdateDataMapType &) const;
+        // fragments, when passed, hold the values updates of this object already built for other observers
+        void BuildFieldsUpdate(Player*, UpdateDataMapType &, UpdateFieldFragments* fragments = nullptr) const;
 
         void SetFieldNotifyFlag(uint16 flag) { _fieldNotifyFlags |= flag; }
         void RemoveFieldNotifyFlag(uint16 flag) { _fieldNotifyFlags &= uint16(~flag); }
@@ -241,6 +244,14 @@ class TC_GAME_API Object
         void BuildMovementUpdate(ByteBuffer* data, uint16 flags) const;
         virtual void BuildValuesUpdate(uint8 updatetype, ByteBuffer* data, Player const* target) const;
 
+        // Returns false when the values update for target contains fields serialized for target alone,
+        // otherwise all observers with the same viewKey receive the same update
+        virtual bool GetValuesUpdateViewKey(Player const* target, uint32& viewKey) const;
+        bool IsValuesUpdateFieldSent(uint16 index, uint32 const* flags, uint32 visibleFlag) const
+        {
+            return (_fieldNotifyFlags & flags[index]) || (_changesMask.GetBit(index) && (flags[index] & visibleFlag));
+        }
+
         uint16 m_objectType;
 
         TypeID m_objectTypeId;
@@ -356,6 +367,19 @@ class TC_GAME_API WorldObject : public Object, public WorldLocation
 
         void _Create(ObjectGuid::LowType guidlow, HighGuid guidhigh, uint32 phaseMask);
         void AddToWorld() override;
+
+        // hide the Position and WorldLocation setters so the packed grid positions follow every move,
+        // writes through a Position& or WorldLocation& bypass them (caught by GridPositionStore::AssertSynced with TRINITY_DEBUG)
+        void Relocate(float x, float y) { Position::Relocate(x, y); UpdateGridPosition(); }
+        void Relocate(float x, float y, float z) { Position::Relocate(x, y, z); UpdateGridPosition(); }
+        void Relocate(float x, float y, float z, float o) { Position::Relocate(x, y, z, o); UpdateGridPosition(); }
+        void Relocate(Position const& pos) { Position::Relocate(pos); UpdateGridPosition(); }
+        void Relocate(Position const* pos) { Position::Relocate(pos); UpdateGridPosition(); }
+        void RelocateOffset(Position const& offset) { Position::RelocateOffset(offset); UpdateGridPosition(); }
+        void WorldRelocate(WorldLocation const& loc) { WorldLocation::WorldRelocate(loc); UpdateGridPosition(); }
+        void WorldRelocate(WorldLocation const* loc) { WorldLocation::WorldRelocate(loc); UpdateGridPosition(); }
+        void WorldRelocate(uint32 mapId, Position const& pos) { WorldLocation::WorldRelocate(mapId, pos); UpdateGridPosition(); }
+        void WorldRelocate(uint32 mapId = MAPID_INVALID, float x = 0.f, float y = 0.f, float z = 0.f, float o = 0.f) { WorldLocation::WorldRelocate(mapId, x, y, z, o); UpdateGridPosition(); }
         void RemoveFromWorld() override;
 
         void GetNearPoint2D(WorldObject const* searcher, float& x, float& y, float distance, float absAngle) const;
@@ -621,6 +645,8 @@ class TC_GAME_API WorldObject : public Object, public WorldLocation
         bool CheckPrivateObjectOwnerVisibility(WorldObject const* seer) const;
 
     protected:
+        void UpdateGridPosition() { if (m_gridPositionStore) m_gridPositionStore->Update(this); }
+
         std::string m_name;
         bool m_isActive;
         bool m_isFarVisible;
@@ -655,6 +681,10 @@ class TC_GAME_API WorldObject : public Object, public WorldLocation
         uint32 m_InstanceId;                              // in map copy with instance id
         uint32 m_phaseMask;                               // in area phase state
 
+        friend class GridPositionStore;
+        GridPositionStore* m_gridPositionStore;           // packed position copy of the grid container we are linked to
+        uint32 m_gridPositionIndex;
+
         uint16 m_notifyflags;
 
         ObjectGuid _privateObjectOwner;
@@ -35,44 +35,77 @@ void UpdateData::AddOutOfRangeGUID(ObjectGuid guid)
     m_outOfRangeGUIDs.insert(guid);
 }
 
-void UpdateData::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
+namespace
 {
-    z_stream c_stream;
-
-    c_stream.zalloc = (alloc_func)nullptr;
-    c_stream.zfree = (free_func)nullptr;
-    c_stream.opaque = (voidpf)nullptr;
-
-    // default Z_BEST_SPEED (1)
-    int z_res = deflateInit(&c_stream, sWorld->getIntConfig(CONFIG_COMPRESSION));
-    if (z_res != Z_OK)
+    // deflate stream of the calling thread, reset for every packet instead of being initialized again
+    class UpdateCompressionStream
     {
-        TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateInit) Error code: {} ({})", z_res, zError(z_res));
-        *dst_size = 0;
-        return;
-    }
-
-    c_stream.next_out = (Bytef*)dst;
-    c_stream.avail_out = *dst_size;
-    c_stream.next_in = (Bytef*)src;
-    c_stream.avail_in = (uInt)src_size;
+    public:
+        UpdateCompressionStream() : _level(-1) { }
+        ~UpdateCompressionStream()
+        {
+            if (_level >= 0)
+                deflateEnd(&_stream);
+        }
+
+        UpdateCompressionStream(UpdateCompressionStream const&) = delete;
+        UpdateCompressionStream& operator=(UpdateCompressionStream const&) = delete;
+
+        z_stream* Acquire(int level)
+        {
+            if (_level == level)
+            {
+                int z_res = deflateReset(&_stream);
+                if (z_res == Z_OK)
+                    return &_stream;
+
+                TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateReset) Error code: {} ({})", z_res, zError(z_res));
+            }
+
+            if (_level >= 0)
+                deflateEnd(&_stream);
+
+            _stream.zalloc = (alloc_func)nullptr;
+            _stream.zfree = (free_func)nullptr;
+            _stream.opaque = (voidpf)nullptr;
+
+            int z_res = deflateInit(&_stream, level);
+            if (z_res != Z_OK)
+            {
+                TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateInit) Error code: {} ({})", z_res, zError(z_res));
+                _level = -1;
+                return nullptr;
+            }
+
+            _level = level;
+            return &_stream;
+        }
+
+    private:
+        z_stream _stream;
+        int _level;
+    };
+
+    thread_local UpdateCompressionStream CompressionStream;
+}
 
-    z_res = deflate(&c_stream, Z_NO_FLUSH);
-    if (z_res != Z_OK)
+void UpdateData::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
+{
+    // default Z_BEST_SPEED (1)
+    z_stream* c_stream = CompressionStream.Acquire(sWorld->getIntConfig(CONFIG_COMPRESSION));
+    if (!c_stream)
     {
-        TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate) Error code: {} ({})", z_res, zError(z_res));
         *dst_size = 0;
         return;
     }
 
-    if (c_stream.avail_in != 0)
-    {
-        TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate not greedy)");
-        *dst_size = 0;
-        return;
-    }
+    c_stream->next_out = (Bytef*)dst;
+    c_stream->avail_out = *dst_size;
+    c_stream->next_in = (Bytef*)src;
+    c_stream->avail_in = (uInt)src_size;
 
-    z_res = deflate(&c_stream, Z_FINISH);
+    // dst is at least compressBound(src_size) long, everything fits in a single call
+    int z_res = deflate(c_stream, Z_FINISH);
     if (z_res != Z_STREAM_END)
     {
         TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflate should report Z_STREAM_END instead {} ({})", z_res, zError(z_res));
@@ -80,15 +113,7 @@ void UpdateData::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
         return;
     }
 
-    z_res = deflateEnd(&c_stream);
-    if (z_res != Z_OK)
-    {
-        TC_LOG_ERROR("misc", "Can't compress update packet (zlib: deflateEnd) Error code: {} ({})", z_res, zError(z_res));
-        *dst_size = 0;
-        return;
-    }
-
-    *dst_size = c_stream.total_out;
+    *dst_size = c_stream->total_out;
 }
 
 bool UpdateData::BuildPacket(WorldPacket* packet)
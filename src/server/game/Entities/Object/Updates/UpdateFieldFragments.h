@@ -0,0 +1,84 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UPDATEFIELDFRAGMENTS_H
+#define __UPDATEFIELDFRAGMENTS_H
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include <utility>
+#include <vector>
+
+// view key bit of observers seeing fields the way gamemasters do, visible update field flags take the low bits
+uint32 constexpr UPDATE_VIEW_KEY_GAMEMASTER = 0x80000000;
+
+/*
+ * Values update of one object serialized once for every view of its observers.
+ * Observers with the same view key (see Object::GetValuesUpdateViewKey) receive the same
+ * update mask and field values, so the fragment is spliced into their UpdateData instead of
+ * being built again. Buffers are kept between objects to avoid reallocating them.
+ */
+class UpdateFieldFragments
+{
+public:
+    UpdateFieldFragments() : _count(0), _serializedBytes(0), _sharedBytes(0) { }
+
+    UpdateFieldFragments(UpdateFieldFragments const&) = delete;
+    UpdateFieldFragments& operator=(UpdateFieldFragments const&) = delete;
+
+    ByteBuffer const* Find(uint32 viewKey) const
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+            if (_fragments[i].first == viewKey)
+                return &_fragments[i].second;
+
+        return nullptr;
+    }
+
+    // returned buffer is only valid until the next call to Create
+    ByteBuffer& Create(uint32 viewKey)
+    {
+        if (_count == _fragments.size())
+            _fragments.emplace_back();
+
+        std::pair<uint32, ByteBuffer>& fragment = _fragments[_count++];
+        fragment.first = viewKey;
+        fragment.second.clear();
+        return fragment.second;
+    }
+
+    // starts the next object
+    void Clear() { _count = 0; }
+
+    std::size_t GetFragmentCount() const { return _count; }
+
+    // bytes of field values serialized and bytes copied from fragments built for a previous observer
+    void AddSerializedBytes(std::size_t bytes) { _serializedBytes += bytes; }
+    void AddSharedBytes(std::size_t bytes) { _sharedBytes += bytes; }
+    uint64 GetSerializedBytes() const { return _serializedBytes; }
+    uint64 GetSharedBytes() const { return _sharedBytes; }
+    void ResetCounters() { _serializedBytes = _sharedBytes = 0; }
+
+private:
+    std::vector<std::pair<uint32, ByteBuffer>> _fragments;
+    std::size_t _count;
+
+    uint64 _serializedBytes;
+    uint64 _sharedBytes;
+};
+
+#endif
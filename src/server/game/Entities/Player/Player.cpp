@@ -76,6 +76,7 @@
 #include "OutdoorPvPMgr.h"
 #include "Pet.h"
 #include "PetitionMgr.h"
+#include "PlayerSaveScheduler.h"
 #include "PoolMgr.h"
 #include "QueryHolder.h"
 #include "QuestDef.h"
@@ -220,6 +221,7 @@ Player::Player(WorldSession* session): Unit(true)
     m_needsZoneUpdate = false;
 
     m_nextSave = sWorld->getIntConfig(CONFIG_INTERVAL_SAVE);
+    m_saveDeferredTime = 0;
 
     memset(m_items, 0, sizeof(Item*)*PLAYER_SLOTS_COUNT);
 
@@ -352,6 +354,10 @@ Player::Player(WorldSession* session): Unit(true)
 
     m_seer = this;
 
+    m_visibilityTravelled = 0.0f;
+    m_visibilityFullUpdate = true;
+    m_visibilityFullUpdateTime = 0;
+
     m_homebindMapId = 0;
     m_homebindAreaId = 0;
     m_homebindX = 0;
@@ -1231,9 +1237,19 @@ void Player::Update(uint32 p_time)
     {
         if (p_time >= m_nextSave)
         {
-            // m_nextSave reset in SaveToDB call
-            SaveToDB();
-            TC_LOG_DEBUG("entities.player", "Player::Update: Player '{}' ({}) saved", GetName(), GetGUID().ToString());
+            if (sPlayerSaveScheduler->RequestAutosave(m_saveDeferredTime))
+            {
+                // m_nextSave reset in SaveToDB call
+                CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+                SaveToDB(trans);
+                CommitSave(trans);
+                TC_LOG_DEBUG("entities.player", "Player::Update: Player '{}' ({}) saved", GetName(), GetGUID().ToString());
+            }
+            else
+            {
+                m_nextSave = sPlayerSaveScheduler->GetRetryDelay();
+                m_saveDeferredTime += m_nextSave;
+            }
         }
         else
             m_nextSave -= p_time;
@@ -1932,8 +1948,18 @@ void Player::RemoveFromWorld()
         ObjectGuid lootGuid = GetLootGUID();
         if (!lootGuid.IsEmpty())
             m_session->DoLootRelease(lootGuid);
-        sOutdoorPvPMgr->HandlePlayerLeaveZone(this, m_zoneUpdateId);
-        sBattlefieldMgr->HandlePlayerLeaveZone(this, m_zoneUpdateId);
+
+        auto leaveZone = [player = this, zone = m_zoneUpdateId]()
+        {
+            sOutdoorPvPMgr->HandlePlayerLeaveZone(player, zone);
+            sBattlefieldMgr->HandlePlayerLeaveZone(player, zone);
+        };
+
+        // outdoor pvp and battlefields are shared by all regions of the map, see UpdateZone
+        if (GetMap()->IsUpdatingRegionsInParallel())
+            GetMap()->DeferToMergePhase(std::move(leaveZone));
+        else
+            leaveZone();
     }
 
     // Remove items from world before self - player must be found in Item::RemoveFromObjectUpdate
@@ -6356,11 +6382,7 @@ bool Player::UpdatePosition(float x, float y, float z, float orientation, bool t
 
 void Player::SendMessageToSetInRange(WorldPacket const* data, float dist, bool self) const
 {
-    if (self)
-        SendDirectMessage(data);
-
-    Trinity::MessageDistDeliverer notifier(this, data, dist);
-    Cell::VisitWorldObjects(this, notifier, dist);
+    SendMessageToSetInRange(data, dist, self, false);
 }
 
 void Player::SendMessageToSetInRange(WorldPacket const* data, float dist, bool self, bool own_team_only, bool required3dDist /*= false*/) const
@@ -6368,6 +6390,16 @@ void Player::SendMessageToSetInRange(WorldPacket const* data, float dist, bool s
     if (self)
         SendDirectMessage(data);
 
+    if (GetMap()->ShouldDeferBroadcast(dist))
+    {
+        GetMap()->DeferBroadcast([source = this, packet = *data, dist, own_team_only, required3dDist]()
+        {
+            Trinity::MessageDistDeliverer notifier(source, &packet, dist, own_team_only, nullptr, required3dDist);
+            Cell::VisitWorldObjects(source, notifier, dist);
+        });
+        return;
+    }
+
     Trinity::MessageDistDeliverer notifier(this, data, dist, own_team_only, nullptr, required3dDist);
     Cell::VisitWorldObjects(this, notifier, dist);
 }
@@ -6377,6 +6409,16 @@ void Player::SendMessageToSet(WorldPacket const* data, Player const* skipped_rcv
     if (skipped_rcvr != this)
         SendDirectMessage(data);
 
+    if (GetMap()->ShouldDeferBroadcast(GetVisibilityRange()))
+    {
+        GetMap()->DeferBroadcast([source = this, packet = *data, skipped_rcvr]()
+        {
+            Trinity::MessageDistDeliverer notifier(source, &packet, source->GetVisibilityRange(), false, skipped_rcvr);
+            Cell::VisitWorldObjects(source, notifier, source->GetVisibilityRange());
+        });
+        return;
+    }
+
     // we use World::GetMaxVisibleDistance() because i cannot see why not use a distance
     // update: replaced by GetMap()->GetVisibilityDistance()
     Trinity::MessageDistDeliverer notifier(this, data, GetVisibilityRange(), false, skipped_rcvr);
@@ -6388,6 +6430,11 @@ void Player::SendDirectMessage(WorldPacket const* data) const
     m_session->SendPacket(data);
 }
 
+void Player::SendDirectMessage(std::shared_ptr<WorldPacket const> const& data) const
+{
+    m_session->SendPacket(data);
+}
+
 void Player::SendCinematicStart(uint32 CinematicSequenceId) const
 {
     WorldPackets::Misc::TriggerCinematic packet;
@@ -7104,8 +7151,18 @@ void Player::UpdateZone(uint32 newZone, uint32 newArea)
     // call leave script hooks immedately (before updating flags)
     if (oldZone != newZone)
     {
-        sOutdoorPvPMgr->HandlePlayerLeaveZone(this, oldZone);
-        sBattlefieldMgr->HandlePlayerLeaveZone(this, oldZone);
+        auto leaveZone = [player = this, oldZone]()
+        {
+            sOutdoorPvPMgr->HandlePlayerLeaveZone(player, oldZone);
+            sBattlefieldMgr->HandlePlayerLeaveZone(player, oldZone);
+        };
+
+        // outdoor pvp and battlefields are shared by all regions of the map, while regions are updated in parallel
+        // the hooks run in the merge phase, in the same order as they were called
+        if (GetMap()->IsUpdatingRegionsInParallel())
+            GetMap()->DeferToMergePhase(std::move(leaveZone));
+        else
+            leaveZone();
     }
 
     // group update
@@ -7175,9 +7232,18 @@ void Player::UpdateZone(uint32 newZone, uint32 newArea)
     sScriptMgr->OnPlayerUpdateZone(this, newZone, newArea);
     if (oldZone != newZone)
     {
-        sOutdoorPvPMgr->HandlePlayerEnterZone(this, newZone);
-        sBattlefieldMgr->HandlePlayerEnterZone(this, newZone);
-        SendInitWorldStates(newZone, newArea);              // only if really enters to new zone, not just area change, works strange...
+        auto enterZone = [player = this, newZone, newArea]()
+        {
+            sOutdoorPvPMgr->HandlePlayerEnterZone(player, newZone);
+            sBattlefieldMgr->HandlePlayerEnterZone(player, newZone);
+            player->SendInitWorldStates(newZone, newArea);  // only if really enters to new zone, not just area change, works strange...
+        };
+
+        if (GetMap()->IsUpdatingRegionsInParallel())
+            GetMap()->DeferToMergePhase(std::move(enterZone));
+        else
+            enterZone();
+
         if (Guild* guild = GetGuild())
             guild->UpdateMemberData(this, GUILD_MEMBER_DATA_ZONEID, newZone);
     }
@@ -17747,9 +17813,9 @@ bool Player::LoadFromDB(ObjectGuid guid, CharacterDatabaseQueryHolder const& hol
     if (player_at_bg)
         map->ToBattlegroundMap()->GetBG()->AddPlayer(this);
 
-    // randomize first save time in range [CONFIG_INTERVAL_SAVE] around [CONFIG_INTERVAL_SAVE]
+    // spread first save time in range [CONFIG_INTERVAL_SAVE] around [CONFIG_INTERVAL_SAVE]
     // this must help in case next save after mass player load after server startup
-    m_nextSave = urand(m_nextSave / 2, m_nextSave * 3 / 2);
+    m_nextSave = sPlayerSaveScheduler->GetFirstSaveDelay();
 
     SaveRecallPosition();
 
@@ -19399,17 +19465,59 @@ bool Player::_LoadHomeBind(PreparedQueryResult result)
 
 void Player::SaveToDB(bool create /*=false*/)
 {
+    // logout and other saves that cannot wait, autosaves are started by Player::Update
+    sPlayerSaveScheduler->OnPrioritySave();
+
     CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
 
     SaveToDB(trans, create);
 
-    CharacterDatabase.CommitTransaction(trans);
+    CommitSave(trans);
+}
+
+static DeltaSaveStatements GetTransactionStatements(CharacterDatabaseTransaction trans)
+{
+    return
+    {
+        [](uint32 index) { return CharacterDatabase.GetPreparedStatement(CharacterDatabaseStatements(index)); },
+        [trans](CharacterDatabasePreparedStatement* stmt) { trans->Append(stmt); }
+    };
+}
+
+void Player::CommitSave(CharacterDatabaseTransaction trans)
+{
+    sPlayerSaveScheduler->CommitSave(trans, [guid = GetGUID()](bool success)
+    {
+        if (success)
+            return;
+
+        TC_LOG_ERROR("entities.player", "Player::CommitSave: Saving player {} failed, auras, glyphs and stats are rewritten by the next save", guid.ToString());
+
+        // the rows of the failed save were taken as written already
+        if (Player* player = ObjectAccessor::FindConnectedPlayer(guid))
+            player->InvalidateDeltaSaveRows();
+    });
+}
+
+void Player::SaveDeltaSaveRows(DeltaSaveStatements const& statements)
+{
+    _SaveAuras(statements);
+    _SaveGlyphs(statements);
+    _SaveStats(statements);
+}
+
+void Player::InvalidateDeltaSaveRows()
+{
+    m_auraSaveRows.Invalidate();
+    m_glyphSaveRows.Invalidate();
+    m_statsSaveRows.Invalidate();
 }
 
 void Player::SaveToDB(CharacterDatabaseTransaction trans, bool create /* = false */)
 {
     // delay auto save at any saves (manual, in code, or autosave)
     m_nextSave = sWorld->getIntConfig(CONFIG_INTERVAL_SAVE);
+    m_saveDeferredTime = 0;
 
     //lets allow only players in world to be saved
     if (IsBeingTeleportedFar())
@@ -19704,19 +19812,19 @@ void Player::SaveToDB(CharacterDatabaseTransaction trans, bool create /* = false
     _SaveSpells(trans);
     GetSpellHistory()->SaveToDB<Player>(trans);
     _SaveActions(trans);
-    _SaveAuras(trans);
+    _SaveAuras(GetTransactionStatements(trans));
     _SaveSkills(trans);
     m_achievementMgr->SaveToDB(trans);
     m_reputationMgr->SaveToDB(trans);
     _SaveEquipmentSets(trans);
     GetSession()->SaveTutorialsData(trans);                 // changed only while character in game
-    _SaveGlyphs(trans);
+    _SaveGlyphs(GetTransactionStatements(trans));
     GetSession()->SaveInstanceTimeRestrictions(trans);
 
     // check if stats should only be saved on logout
     // save stats can be out of transaction
     if (m_session->isLogingOut() || !sWorld->getBoolConfig(CONFIG_STATS_SAVE_ONLY_ON_LOGOUT))
-        _SaveStats(trans);
+        _SaveStats(GetTransactionStatements(trans));
 
     // save pet (hunter pet level and experience and all type pets health/mana).
     if (Pet* pet = GetPet())
@@ -19732,6 +19840,9 @@ void Player::SaveToDB(CharacterDatabaseTransaction trans, bool create /* = false
 // fast save function for item/money cheating preventing - save only inventory and money state
 void Player::SaveInventoryAndGoldToDB(CharacterDatabaseTransaction trans)
 {
+    // trades, mails and auctions
+    sPlayerSaveScheduler->OnPrioritySave();
+
     _SaveInventory(trans);
     SaveGoldToDB(trans);
 }
@@ -19792,12 +19903,9 @@ void Player::_SaveActions(CharacterDatabaseTransaction trans)
     }
 }
 
-void Player::_SaveAuras(CharacterDatabaseTransaction trans)
+void Player::_SaveAuras(DeltaSaveStatements const& statements)
 {
-    CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_AURA);
-    stmt->setUInt32(0, GetGUID().GetCounter());
-    trans->Append(stmt);
-
+    DeltaSaveRows<AuraSaveKey, AuraSaveRow>::RowMap rows;
     for (AuraMap::const_iterator itr = m_ownedAuras.begin(); itr != m_ownedAuras.end(); ++itr)
     {
         if (!itr->second->CanBeSaved())
@@ -19805,49 +19913,90 @@ void Player::_SaveAuras(CharacterDatabaseTransaction trans)
 
         Aura* aura = itr->second;
 
-        int32 damage[MAX_SPELL_EFFECTS];
-        int32 baseDamage[MAX_SPELL_EFFECTS];
+        AuraSaveRow row;
         uint8 effMask = 0;
-        uint8 recalculateMask = 0;
+        row.RecalculateMask = 0;
         for (uint8 i = 0; i < MAX_SPELL_EFFECTS; ++i)
         {
             if (AuraEffect const* effect = aura->GetEffect(i))
             {
-                baseDamage[i] = effect->GetBaseAmount();
-                damage[i] = effect->GetAmount();
+                row.BaseAmount[i] = effect->GetBaseAmount();
+                row.Amount[i] = effect->GetAmount();
                 effMask |= 1 << i;
                 if (effect->CanBeRecalculated())
-                    recalculateMask |= 1 << i;
+                    row.RecalculateMask |= 1 << i;
             }
             else
             {
-                baseDamage[i] = 0;
-                damage[i] = 0;
+                row.BaseAmount[i] = 0;
+                row.Amount[i] = 0;
             }
         }
 
-        uint8 index = 0;
-        stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_AURA);
-        stmt->setUInt32(index++, GetGUID().GetCounter());
-        stmt->setUInt64(index++, itr->second->GetCasterGUID().GetRawValue());
-        stmt->setUInt64(index++, itr->second->GetCastItemGUID().GetRawValue());
-        stmt->setUInt32(index++, itr->second->GetId());
-        stmt->setUInt8(index++, effMask);
-        stmt->setUInt8(index++, recalculateMask);
-        stmt->setUInt8(index++, itr->second->GetStackAmount());
-        stmt->setInt32(index++, damage[0]);
-        stmt->setInt32(index++, damage[1]);
-        stmt->setInt32(index++, damage[2]);
-        stmt->setInt32(index++, baseDamage[0]);
-        stmt->setInt32(index++, baseDamage[1]);
-        stmt->setInt32(index++, baseDamage[2]);
-        stmt->setInt32(index++, itr->second->GetMaxDuration());
-        stmt->setInt32(index++, itr->second->GetDuration());
-        stmt->setUInt8(index++, itr->second->GetCharges());
-        stmt->setFloat(index++, itr->second->GetCritChance());
-        stmt->setBool (index++, itr->second->CanApplyResilience());
-        trans->Append(stmt);
+        row.StackCount = aura->GetStackAmount();
+        row.MaxDuration = aura->GetMaxDuration();
+        row.Duration = aura->GetDuration();
+        row.Charges = aura->GetCharges();
+        row.CritChance = aura->GetCritChance();
+        row.ApplyResilience = aura->CanApplyResilience();
+
+        AuraSaveKey key(aura->GetCasterGUID().GetRawValue(), aura->GetCastItemGUID().GetRawValue(), aura->GetId(), effMask);
+        if (!rows.emplace(key, row).second)
+            TC_LOG_ERROR("entities.player", "Player::_SaveAuras: Player {} owns aura {} of caster {} (cast item {}, effect mask {}) more than once, only the first one is saved",
+                GetGUID().ToString(), aura->GetId(), aura->GetCasterGUID().ToString(), aura->GetCastItemGUID().ToString(), uint32(effMask));
     }
+
+    if (!sWorld->getBoolConfig(CONFIG_PLAYER_SAVE_DELTA))
+        m_auraSaveRows.Invalidate();
+
+    // remaining time only dirties a row once it is an autosave interval shorter than saved, the logout save writes it exactly
+    int32 durationTolerance = GetSession()->PlayerLogout() ? 0 : int32(sWorld->getIntConfig(CONFIG_INTERVAL_SAVE));
+    auto unchanged = [durationTolerance](AuraSaveRow const& saved, AuraSaveRow const& row)
+    {
+        AuraSaveRow ranDown = saved;
+        ranDown.Duration = row.Duration;
+        return ranDown == row && saved.Duration >= row.Duration && saved.Duration - row.Duration < std::max(durationTolerance, 1);
+    };
+
+    ObjectGuid::LowType guid = GetGUID().GetCounter();
+    PlayerSaveStatistics::Add(m_auraSaveRows.Save(std::move(rows), unchanged, [&](AuraSaveKey const& key, AuraSaveRow const& row)
+    {
+        uint8 index = 0;
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_REP_AURA);
+        stmt->setUInt32(index++, guid);
+        stmt->setUInt64(index++, std::get<0>(key));
+        stmt->setUInt64(index++, std::get<1>(key));
+        stmt->setUInt32(index++, std::get<2>(key));
+        stmt->setUInt8(index++, std::get<3>(key));
+        stmt->setUInt8(index++, row.RecalculateMask);
+        stmt->setUInt8(index++, row.StackCount);
+        stmt->setInt32(index++, row.Amount[0]);
+        stmt->setInt32(index++, row.Amount[1]);
+        stmt->setInt32(index++, row.Amount[2]);
+        stmt->setInt32(index++, row.BaseAmount[0]);
+        stmt->setInt32(index++, row.BaseAmount[1]);
+        stmt->setInt32(index++, row.BaseAmount[2]);
+        stmt->setInt32(index++, row.MaxDuration);
+        stmt->setInt32(index++, row.Duration);
+        stmt->setUInt8(index++, row.Charges);
+        stmt->setFloat(index++, row.CritChance);
+        stmt->setBool (index++, row.ApplyResilience);
+        statements.Append(stmt);
+    }, [&](AuraSaveKey const& key)
+    {
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_DEL_CHAR_AURA_BY_KEY);
+        stmt->setUInt32(0, guid);
+        stmt->setUInt64(1, std::get<0>(key));
+        stmt->setUInt64(2, std::get<1>(key));
+        stmt->setUInt32(3, std::get<2>(key));
+        stmt->setUInt8(4, std::get<3>(key));
+        statements.Append(stmt);
+    }, [&]()
+    {
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_DEL_CHAR_AURA);
+        stmt->setUInt32(0, guid);
+        statements.Append(stmt);
+    }));
 }
 
 void Player::_SaveInventory(CharacterDatabaseTransaction trans)
@@ -20349,51 +20498,78 @@ void Player::_SaveSpells(CharacterDatabaseTransaction trans)
 
 // save player stats -- only for external usage
 // real stats will be recalculated on player login
-void Player::_SaveStats(CharacterDatabaseTransaction trans) const
+void Player::_SaveStats(DeltaSaveStatements const& statements)
 {
     // check if stat saving is enabled and if char level is high enough
     if (!sWorld->getIntConfig(CONFIG_MIN_LEVEL_STAT_SAVE) || GetLevel() < sWorld->getIntConfig(CONFIG_MIN_LEVEL_STAT_SAVE))
         return;
 
-    CharacterDatabasePreparedStatement* stmt;
-
-    stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_STATS);
-    stmt->setUInt32(0, GetGUID().GetCounter());
-    trans->Append(stmt);
-
-    uint8 index = 0;
-
-    stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_STATS);
-    stmt->setUInt32(index++, GetGUID().GetCounter());
-    stmt->setUInt32(index++, GetMaxHealth());
+    StatsSaveRow row;
+    row.MaxHealth = GetMaxHealth();
 
     for (uint8 i = 0; i < MAX_POWERS; ++i)
-        stmt->setUInt32(index++, GetMaxPower(Powers(i)));
+        row.MaxPower[i] = GetMaxPower(Powers(i));
 
     for (uint8 i = 0; i < MAX_STATS; ++i)
-        stmt->setUInt32(index++, GetStat(Stats(i)));
+        row.Stat[i] = GetStat(Stats(i));
 
     for (int i = 0; i < MAX_SPELL_SCHOOL; ++i)
-        stmt->setUInt32(index++, GetResistance(SpellSchools(i)));
+        row.Resistance[i] = GetResistance(SpellSchools(i));
 
-    stmt->setFloat(index++, GetFloatValue(PLAYER_BLOCK_PERCENTAGE));
-    stmt->setFloat(index++, GetFloatValue(PLAYER_DODGE_PERCENTAGE));
-    stmt->setFloat(index++, GetFloatValue(PLAYER_PARRY_PERCENTAGE));
-    stmt->setFloat(index++, GetFloatValue(PLAYER_CRIT_PERCENTAGE));
-    stmt->setFloat(index++, GetFloatValue(PLAYER_RANGED_CRIT_PERCENTAGE));
+    row.BlockPct = GetFloatValue(PLAYER_BLOCK_PERCENTAGE);
+    row.DodgePct = GetFloatValue(PLAYER_DODGE_PERCENTAGE);
+    row.ParryPct = GetFloatValue(PLAYER_PARRY_PERCENTAGE);
+    row.CritPct = GetFloatValue(PLAYER_CRIT_PERCENTAGE);
+    row.RangedCritPct = GetFloatValue(PLAYER_RANGED_CRIT_PERCENTAGE);
 
     // Store the max spell crit percentage out of all the possible schools
-    float spellCrit = 0.0f;
+    row.SpellCritPct = 0.0f;
     for (int i = 0; i < MAX_SPELL_SCHOOL; ++i)
-        spellCrit = std::max(spellCrit, GetFloatValue(PLAYER_SPELL_CRIT_PERCENTAGE1 + i));
-    stmt->setFloat(index++, spellCrit);
+        row.SpellCritPct = std::max(row.SpellCritPct, GetFloatValue(PLAYER_SPELL_CRIT_PERCENTAGE1 + i));
 
-    stmt->setUInt32(index++, GetUInt32Value(UNIT_FIELD_ATTACK_POWER));
-    stmt->setUInt32(index++, GetUInt32Value(UNIT_FIELD_RANGED_ATTACK_POWER));
-    stmt->setUInt32(index++, GetBaseSpellPowerBonus());
-    stmt->setUInt32(index++, GetUInt32Value(PLAYER_FIELD_COMBAT_RATING_1 + AsUnderlyingType(CR_CRIT_TAKEN_SPELL)));
+    row.AttackPower = GetUInt32Value(UNIT_FIELD_ATTACK_POWER);
+    row.RangedAttackPower = GetUInt32Value(UNIT_FIELD_RANGED_ATTACK_POWER);
+    row.SpellPower = GetBaseSpellPowerBonus();
+    row.Resilience = GetUInt32Value(PLAYER_FIELD_COMBAT_RATING_1 + AsUnderlyingType(CR_CRIT_TAKEN_SPELL));
 
-    trans->Append(stmt);
+    if (!sWorld->getBoolConfig(CONFIG_PLAYER_SAVE_DELTA))
+        m_statsSaveRows.Invalidate();
+
+    // one row per character, it is only ever replaced
+    ObjectGuid::LowType guid = GetGUID().GetCounter();
+    PlayerSaveStatistics::Add(m_statsSaveRows.Save({ { 0, row } }, [&](uint8 /*key*/, StatsSaveRow const& stats)
+    {
+        uint8 index = 0;
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_REP_CHAR_STATS);
+        stmt->setUInt32(index++, guid);
+        stmt->setUInt32(index++, stats.MaxHealth);
+
+        for (uint8 i = 0; i < MAX_POWERS; ++i)
+            stmt->setUInt32(index++, stats.MaxPower[i]);
+
+        for (uint8 i = 0; i < MAX_STATS; ++i)
+            stmt->setUInt32(index++, stats.Stat[i]);
+
+        for (int i = 0; i < MAX_SPELL_SCHOOL; ++i)
+            stmt->setUInt32(index++, stats.Resistance[i]);
+
+        stmt->setFloat(index++, stats.BlockPct);
+        stmt->setFloat(index++, stats.DodgePct);
+        stmt->setFloat(index++, stats.ParryPct);
+        stmt->setFloat(index++, stats.CritPct);
+        stmt->setFloat(index++, stats.RangedCritPct);
+        stmt->setFloat(index++, stats.SpellCritPct);
+        stmt->setUInt32(index++, stats.AttackPower);
+        stmt->setUInt32(index++, stats.RangedAttackPower);
+        stmt->setUInt32(index++, stats.SpellPower);
+        stmt->setUInt32(index++, stats.Resilience);
+        statements.Append(stmt);
+    }, [](uint8 /*key*/) { }, [&]()
+    {
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_DEL_CHAR_STATS);
+        stmt->setUInt32(0, guid);
+        statements.Append(stmt);
+    }));
 }
 
 void Player::outDebugValues() const
@@ -22754,7 +22930,10 @@ void Player::UpdateObjectVisibility(bool forced)
         return;
 
     if (!forced)
+    {
+        m_visibilityFullUpdate = true;
         AddToNotify(NOTIFY_VISIBILITY_CHANGED);
+    }
     else
     {
         Unit::UpdateObjectVisibility(true);
@@ -22762,12 +22941,73 @@ void Player::UpdateObjectVisibility(bool forced)
     }
 }
 
+void Player::UpdateObjectVisibilityOnMove(float travelled)
+{
+    if (!IsInWorld())
+        return;
+
+    m_visibilityTravelled += travelled;
+    AddToNotify(NOTIFY_VISIBILITY_CHANGED);
+}
+
 void Player::UpdateVisibilityForPlayer()
 {
     // updates visibility of all objects around point of view for current player
     Trinity::VisibleNotifier notifier(*this);
     Cell::VisitAllObjects(m_seer, notifier, GetSightRange());
     notifier.SendToSelf();   // send gathered data
+    OnVisibilityUpdated(true);
+}
+
+float Player::GetVisibilityUpdateMargin() const
+{
+    if (!sWorld->getBoolConfig(CONFIG_VISIBILITY_INCREMENTAL) || m_visibilityFullUpdate)
+        return -1.0f;
+
+    // another point of view, corpse visibility and cinematics use a different sight range
+    if (m_seer != this || !IsAlive() || GetCinematicMgr()->IsOnCinematic())
+        return -1.0f;
+
+    if (GameTime::GetGameTimeMS() >= m_visibilityFullUpdateTime && !sWorld->getBoolConfig(CONFIG_VISIBILITY_INCREMENTAL_VERIFY))
+        return -1.0f;
+
+    // objects that did not move themselves are now at most this much closer or further away than at the last update
+    return std::max(m_visibilityTravelled, GetExactDist2d(m_visibilityUpdatePosition));
+}
+
+void Player::OnVisibilityUpdated(bool fullUpdate)
+{
+    uint32 const now = GameTime::GetGameTimeMS();
+
+    // only reached with Visibility.Incremental.Verify, anything the full update changes was missed by the incremental one
+    if (!fullUpdate && now >= m_visibilityFullUpdateTime)
+    {
+        GuidUnorderedSet const visibleBefore = m_clientGUIDs;
+
+        Trinity::VisibleNotifier notifier(*this);
+        Cell::VisitAllObjects(m_seer, notifier, MAX_VISIBILITY_DISTANCE, false);
+        notifier.SendToSelf();
+
+        for (ObjectGuid const& guid : visibleBefore)
+            if (m_clientGUIDs.find(guid) == m_clientGUIDs.end())
+                TC_LOG_ERROR("maps", "Player::OnVisibilityUpdated: Incremental visibility update of player {} kept {} visible", GetGUID().ToString(), guid.ToString());
+
+        for (ObjectGuid const& guid : m_clientGUIDs)
+            if (visibleBefore.find(guid) == visibleBefore.end())
+                TC_LOG_ERROR("maps", "Player::OnVisibilityUpdated: Incremental visibility update of player {} did not show {}", GetGUID().ToString(), guid.ToString());
+
+        fullUpdate = true;
+    }
+
+    m_visibilityUpdatePosition.Relocate(GetPositionX(), GetPositionY());
+    m_visibilityTravelled = 0.0f;
+    m_visibilityDeferredGuids.clear();
+
+    if (fullUpdate)
+    {
+        m_visibilityFullUpdate = false;
+        m_visibilityFullUpdateTime = now + sWorld->getIntConfig(CONFIG_VISIBILITY_INCREMENTAL_FULL_UPDATE_INTERVAL);
+    }
 }
 
 void Player::SetPhaseMask(uint32 newPhaseMask, bool update)
@@ -26119,26 +26359,45 @@ void Player::_LoadGlyphs(PreparedQueryResult result)
     while (result->NextRow());
 }
 
-void Player::_SaveGlyphs(CharacterDatabaseTransaction trans) const
+void Player::_SaveGlyphs(DeltaSaveStatements const& statements)
 {
-    CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_GLYPHS);
-    stmt->setUInt32(0, GetGUID().GetCounter());
-    trans->Append(stmt);
-
+    DeltaSaveRows<uint8, GlyphSaveRow>::RowMap rows;
     for (uint8 spec = 0; spec < GetSpecsCount(); ++spec)
+    {
+        GlyphSaveRow& row = rows[spec];
+        for (uint8 i = 0; i < MAX_GLYPH_SLOT_INDEX; ++i)
+            row[i] = GetGlyph(spec, i);
+    }
+
+    if (!sWorld->getBoolConfig(CONFIG_PLAYER_SAVE_DELTA))
+        m_glyphSaveRows.Invalidate();
+
+    ObjectGuid::LowType guid = GetGUID().GetCounter();
+    PlayerSaveStatistics::Add(m_glyphSaveRows.Save(std::move(rows), [&](uint8 spec, GlyphSaveRow const& row)
     {
         uint8 index = 0;
 
-        stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_GLYPHS);
-        stmt->setUInt32(index++, GetGUID().GetCounter());
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_REP_CHAR_GLYPHS);
+        stmt->setUInt32(index++, guid);
 
         stmt->setUInt8(index++, spec);
 
         for (uint8 i = 0; i < MAX_GLYPH_SLOT_INDEX; ++i)
-            stmt->setUInt16(index++, uint16(GetGlyph(spec, i)));
+            stmt->setUInt16(index++, uint16(row[i]));
 
-        trans->Append(stmt);
-    }
+        statements.Append(stmt);
+    }, [&](uint8 spec)
+    {
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_DEL_CHAR_GLYPHS_BY_SPEC);
+        stmt->setUInt32(0, guid);
+        stmt->setUInt8(1, spec);
+        statements.Append(stmt);
+    }, [&]()
+    {
+        CharacterDatabasePreparedStatement* stmt = statements.Create(CHAR_DEL_CHAR_GLYPHS);
+        stmt->setUInt32(0, guid);
+        statements.Append(stmt);
+    }));
 }
 
 void Player::_LoadTalents(PreparedQueryResult result)
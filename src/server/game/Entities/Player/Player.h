@@ -28,10 +28,12 @@
 #include "ItemEnchantmentMgr.h"
 #include "MapReference.h"
 #include "PetDefines.h"
+#include "PlayerSaveDelta.h"
 #include "PlayerTaxi.h"
 #include "QuestDef.h"
 #include <memory>
 #include <queue>
+#include <tuple>
 #include <unordered_set>
 
 struct AccessRequirement;
@@ -878,6 +880,46 @@ struct ResurrectionData
 
 #define SPELL_DK_RAISE_ALLY 46619
 
+// Rows of character_aura, character_glyphs and character_stats as written by the previous save
+typedef std::tuple<uint64 /*casterGuid*/, uint64 /*itemGuid*/, uint32 /*spell*/, uint8 /*effectMask*/> AuraSaveKey;
+
+struct AuraSaveRow
+{
+    uint8 RecalculateMask;
+    uint8 StackCount;
+    std::array<int32, MAX_SPELL_EFFECTS> Amount;
+    std::array<int32, MAX_SPELL_EFFECTS> BaseAmount;
+    int32 MaxDuration;
+    int32 Duration;
+    uint8 Charges;
+    float CritChance;
+    bool ApplyResilience;
+
+    bool operator==(AuraSaveRow const& right) const = default;
+};
+
+typedef std::array<uint32, MAX_GLYPH_SLOT_INDEX> GlyphSaveRow;
+
+struct StatsSaveRow
+{
+    uint32 MaxHealth;
+    std::array<uint32, MAX_POWERS> MaxPower;
+    std::array<uint32, MAX_STATS> Stat;
+    std::array<uint32, MAX_SPELL_SCHOOL> Resistance;
+    float BlockPct;
+    float DodgePct;
+    float ParryPct;
+    float CritPct;
+    float RangedCritPct;
+    float SpellCritPct;
+    uint32 AttackPower;
+    uint32 RangedAttackPower;
+    uint32 SpellPower;
+    uint32 Resilience;
+
+    bool operator==(StatsSaveRow const& right) const = default;
+};
+
 struct PlayerTalentInfo
 {
     PlayerTalentInfo() :
@@ -1391,6 +1433,11 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
         static void Customize(CharacterCustomizeInfo const* customizeInfo, CharacterDatabaseTransaction trans);
         static void SavePositionInDB(WorldLocation const& loc, uint16 zoneId, ObjectGuid guid, CharacterDatabaseTransaction trans);
 
+        // character_aura, character_glyphs and character_stats as SaveToDB writes them, statements may come from outside the database
+        void SaveDeltaSaveRows(DeltaSaveStatements const& statements);
+        // the next save rewrites those tables
+        void InvalidateDeltaSaveRows();
+
         static void DeleteFromDB(ObjectGuid playerguid, uint32 accountId, bool updateRealmChars = true, bool deleteFinally = false);
         static void DeleteOldCharacters();
         static void DeleteOldCharacters(uint32 keepDays);
@@ -1948,6 +1995,7 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
         void SendInitWorldStates(uint32 zoneId, uint32 areaId);
         void SendUpdateWorldState(uint32 variable, uint32 value) const;
         void SendDirectMessage(WorldPacket const* data) const;
+        void SendDirectMessage(std::shared_ptr<WorldPacket const> const& data) const;
         void SendBGWeekendWorldStates() const;
         void SendBattlefieldWorldStates() const;
 
@@ -2089,7 +2137,14 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
 
         void SendInitialVisiblePackets(Unit* target) const;
         void UpdateObjectVisibility(bool forced = true) override;
+        void UpdateObjectVisibilityOnMove(float travelled);
         void UpdateVisibilityForPlayer();
+
+        // incremental visibility updates (Visibility.Incremental.Enable)
+        float GetVisibilityUpdateMargin() const;
+        void OnVisibilityUpdated(bool fullUpdate);
+        bool IsVisibilityUpdateDeferred(ObjectGuid const& guid) const { return m_visibilityDeferredGuids.find(guid) != m_visibilityDeferredGuids.end(); }
+        void DeferVisibilityUpdateOf(WorldObject const* target) { m_visibilityDeferredGuids.insert(target->GetGUID()); }
         void UpdateVisibilityOf(WorldObject* target);
         void UpdateTriggerVisibility();
         void SetPhaseMask(uint32 newPhaseMask, bool update) override;// overwrite Unit::SetPhaseMask
@@ -2350,7 +2405,7 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
         /*********************************************************/
 
         void _SaveActions(CharacterDatabaseTransaction trans);
-        void _SaveAuras(CharacterDatabaseTransaction trans);
+        void _SaveAuras(DeltaSaveStatements const& statements);
         void _SaveInventory(CharacterDatabaseTransaction trans);
         void _SaveMail(CharacterDatabaseTransaction trans);
         void _SaveQuestStatus(CharacterDatabaseTransaction trans);
@@ -2362,9 +2417,17 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
         void _SaveSpells(CharacterDatabaseTransaction trans);
         void _SaveEquipmentSets(CharacterDatabaseTransaction trans);
         void _SaveBGData(CharacterDatabaseTransaction trans);
-        void _SaveGlyphs(CharacterDatabaseTransaction trans) const;
+        void _SaveGlyphs(DeltaSaveStatements const& statements);
         void _SaveTalents(CharacterDatabaseTransaction trans);
-        void _SaveStats(CharacterDatabaseTransaction trans) const;
+        void _SaveStats(DeltaSaveStatements const& statements);
+
+        // commits a transaction holding SaveToDB, a failed commit makes the next save rewrite the delta saved tables
+        void CommitSave(CharacterDatabaseTransaction trans);
+
+        // tables without per row state, only rows that differ from the previous save are written (PlayerSave.Delta)
+        DeltaSaveRows<AuraSaveKey, AuraSaveRow> m_auraSaveRows;
+        DeltaSaveRows<uint8, GlyphSaveRow> m_glyphSaveRows;
+        DeltaSaveRows<uint8, StatsSaveRow> m_statsSaveRows;
 
         /*********************************************************/
         /***              ENVIRONMENTAL SYSTEM                 ***/
@@ -2385,6 +2448,12 @@ class TC_GAME_API Player : public Unit, public GridObject<Player>
 
         uint32 m_team;
         uint32 m_nextSave;
+        uint32 m_saveDeferredTime;                          // time the due autosave waited for PlayerSaveScheduler
+        Position m_visibilityUpdatePosition;
+        float m_visibilityTravelled;
+        bool m_visibilityFullUpdate;
+        uint32 m_visibilityFullUpdateTime;
+        GuidUnorderedSet m_visibilityDeferredGuids;
         std::array<ChatFloodThrottle, ChatFloodThrottle::MAX> m_chatFloodData;
         Difficulty m_dungeonDifficulty;
         Difficulty m_raidDifficulty;
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PlayerSaveDelta.h"
+#include <atomic>
+
+namespace
+{
+    // players are saved from map threads
+    std::atomic<uint64> StatementsWritten(0);
+    std::atomic<uint64> StatementsAvoided(0);
+}
+
+void PlayerSaveStatistics::Add(DeltaSaveResult const& result)
+{
+    StatementsWritten.fetch_add(result.Written, std::memory_order_relaxed);
+    StatementsAvoided.fetch_add(result.Avoided, std::memory_order_relaxed);
+}
+
+uint64 PlayerSaveStatistics::GetStatementsWritten()
+{
+    return StatementsWritten.load(std::memory_order_relaxed);
+}
+
+uint64 PlayerSaveStatistics::GetStatementsAvoided()
+{
+    return StatementsAvoided.load(std::memory_order_relaxed);
+}
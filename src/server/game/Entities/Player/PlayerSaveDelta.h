@@ -0,0 +1,161 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_PLAYER_SAVE_DELTA_H
+#define TRINITYCORE_PLAYER_SAVE_DELTA_H
+
+#include "Define.h"
+#include "DatabaseEnvFwd.h"
+#include <functional>
+#include <map>
+
+struct DeltaSaveResult
+{
+    uint32 Written = 0;                                     // statements appended to the transaction
+    uint32 Avoided = 0;                                     // statements a full rewrite would have needed on top of that
+};
+
+/// Creates the statements of a save by CharacterDatabaseStatements index and appends them to its transaction
+struct DeltaSaveStatements
+{
+    std::function<CharacterDatabasePreparedStatement*(uint32 index)> Create;
+    std::function<void(CharacterDatabasePreparedStatement*)> Append;
+};
+
+/**
+ * Remembers the rows of one character table as they were last written, so a save only
+ * replaces rows that changed and deletes rows that are gone.
+ * Until the first save the stored rows are unknown and the table is rewritten: all rows
+ * deleted, then every current row inserted. The same happens when the difference would
+ * need more statements than the rewrite.
+ * The rows are taken as saved when the statements are appended, Invalidate must be called
+ * when the transaction holding them fails.
+ */
+template<typename Key, typename Row>
+class DeltaSaveRows
+{
+public:
+    using RowMap = std::map<Key, Row>;
+
+    DeltaSaveRows() : _synchronized(false) { }
+
+    /// Forgets what was saved, the next save rewrites the table
+    void Invalidate()
+    {
+        _synchronized = false;
+        _saved.clear();
+    }
+
+    bool IsSynchronized() const { return _synchronized; }
+
+    /// upsert(key, row) must replace the row, remove(key) delete it and removeAll() delete every row of the character
+    template<typename Upsert, typename Remove, typename RemoveAll>
+    DeltaSaveResult Save(RowMap current, Upsert&& upsert, Remove&& remove, RemoveAll&& removeAll)
+    {
+        return Save(std::move(current), std::equal_to<Row>(), upsert, remove, removeAll);
+    }
+
+    /// unchanged(saved, row) tells if the saved row may stay in the table in place of row, it is then kept as saved
+    template<typename Unchanged, typename Upsert, typename Remove, typename RemoveAll>
+    DeltaSaveResult Save(RowMap current, Unchanged&& unchanged, Upsert&& upsert, Remove&& remove, RemoveAll&& removeAll)
+    {
+        DeltaSaveResult result;
+        uint32 rewriteStatements = 1 + uint32(current.size());
+
+        uint32 changes = 0;
+        if (_synchronized)
+            ForEachChange(current, unchanged, [&](Key const&, Row const*) { ++changes; });
+
+        if (!_synchronized || changes > rewriteStatements)
+        {
+            removeAll();
+            for (auto const& [key, row] : current)
+                upsert(key, row);
+
+            result.Written = rewriteStatements;
+        }
+        else
+        {
+            ForEachChange(current, unchanged, [&](Key const& key, Row const* row)
+            {
+                if (row)
+                    upsert(key, *row);
+                else
+                    remove(key);
+            });
+
+            for (auto& [key, row] : current)
+            {
+                auto saved = _saved.find(key);
+                if (saved != _saved.end() && unchanged(saved->second, row))
+                    row = saved->second;
+            }
+
+            result.Written = changes;
+            result.Avoided = rewriteStatements - changes;
+        }
+
+        _saved = std::move(current);
+        _synchronized = true;
+        return result;
+    }
+
+private:
+    /// Calls change(key, row) for new and changed rows and change(key, nullptr) for removed ones
+    template<typename Unchanged, typename Change>
+    void ForEachChange(RowMap const& current, Unchanged& unchanged, Change&& change) const
+    {
+        auto saved = _saved.begin();
+        auto now = current.begin();
+        while (saved != _saved.end() || now != current.end())
+        {
+            if (now == current.end() || (saved != _saved.end() && saved->first < now->first))
+            {
+                change(saved->first, nullptr);
+                ++saved;
+            }
+            else if (saved == _saved.end() || now->first < saved->first)
+            {
+                change(now->first, &now->second);
+                ++now;
+            }
+            else
+            {
+                if (!unchanged(saved->second, now->second))
+                    change(now->first, &now->second);
+
+                ++saved;
+                ++now;
+            }
+        }
+    }
+
+    RowMap _saved;
+    bool _synchronized;
+};
+
+/// Totals of all character saves using DeltaSaveRows, reported as metrics
+class TC_GAME_API PlayerSaveStatistics
+{
+public:
+    static void Add(DeltaSaveResult const& result);
+
+    static uint64 GetStatementsWritten();
+    static uint64 GetStatementsAvoided();
+};
+
+#endif
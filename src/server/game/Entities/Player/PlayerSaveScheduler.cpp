@@ -0,0 +1,190 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PlayerSaveScheduler.h"
+#include "Common.h"
+#include "DatabaseEnv.h"
+#include "Duration.h"
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int64 SaveCost = 1000;
+
+    // autosaves of every online character fit into half of the interval, the rest is left for catching up
+    constexpr uint32 AutomaticRateHeadroom = 2;
+
+    constexpr uint32 RetryDelay = 1000;
+    constexpr uint32 RetryDelayJitter = 500;
+
+    // weight of a new measurement in the moving average, in 1/16
+    constexpr uint32 LatencyWeight = 2;
+}
+
+PlayerSaveScheduler::PlayerSaveScheduler() : _budget(0), _savesPerSecond(0), _loginCount(0),
+    _interval(15 * MINUTE * IN_MILLISECONDS), _maxPerSecond(0), _maxQueueSize(0), _pendingCount(0),
+    _autosaves(0), _prioritySaves(0), _deferredAutosaves(0), _forcedAutosaves(0), _averageLatency(0), _maxLatency(0)
+{
+}
+
+PlayerSaveScheduler::~PlayerSaveScheduler() = default;
+
+PlayerSaveScheduler* PlayerSaveScheduler::instance()
+{
+    static PlayerSaveScheduler instance;
+    return &instance;
+}
+
+void PlayerSaveScheduler::SetLimits(uint32 interval, uint32 maxPerSecond, uint32 maxQueueSize)
+{
+    _interval.store(interval, std::memory_order_relaxed);
+    _maxPerSecond.store(maxPerSecond, std::memory_order_relaxed);
+    _maxQueueSize.store(maxQueueSize, std::memory_order_relaxed);
+}
+
+uint32 PlayerSaveScheduler::GetFirstSaveDelay()
+{
+    // fractional parts of multiples of the golden ratio cover [0, 1) evenly for any number of logins,
+    // unlike random delays that leave gaps and clusters
+    uint32 login = _loginCount.fetch_add(1, std::memory_order_relaxed);
+    double position = std::fmod(login * 0.6180339887498949, 1.0);
+    uint32 interval = _interval.load(std::memory_order_relaxed);
+    return interval / 2 + uint32(interval * position);
+}
+
+uint32 PlayerSaveScheduler::GetRetryDelay() const
+{
+    return RetryDelay + urand(0, RetryDelayJitter);
+}
+
+bool PlayerSaveScheduler::RequestAutosave(uint32 overdue)
+{
+    int64 budget = _budget.load(std::memory_order_relaxed);
+    while (budget >= SaveCost)
+    {
+        if (_budget.compare_exchange_weak(budget, budget - SaveCost, std::memory_order_relaxed))
+        {
+            _autosaves.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // a character is never left unsaved for more than two intervals, even when the database cannot keep up
+    if (overdue >= _interval.load(std::memory_order_relaxed))
+    {
+        _budget.fetch_sub(SaveCost, std::memory_order_relaxed);
+        _forcedAutosaves.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    _deferredAutosaves.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void PlayerSaveScheduler::OnPrioritySave()
+{
+    _budget.fetch_sub(SaveCost, std::memory_order_relaxed);
+    _prioritySaves.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlayerSaveScheduler::CommitSave(CharacterDatabaseTransaction trans, std::function<void(bool)> callback)
+{
+    TimePoint start = std::chrono::steady_clock::now();
+    TransactionCallback commit = CharacterDatabase.AsyncCommitTransaction(trans);
+    commit.AfterComplete([this, start, callback = std::move(callback)](bool success)
+    {
+        uint32 latency = uint32(std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - start).count());
+        uint32 average = _averageLatency.load(std::memory_order_relaxed);
+        _averageLatency.store((average * (16 - LatencyWeight) + latency * LatencyWeight) / 16, std::memory_order_relaxed);
+        if (latency > _maxLatency.load(std::memory_order_relaxed))
+            _maxLatency.store(latency, std::memory_order_relaxed);
+
+        if (callback)
+            callback(success);
+    });
+
+    std::lock_guard<std::mutex> lock(_pendingLock);
+    _pendingCommits.push_back(std::move(commit));
+    _pendingCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlayerSaveScheduler::Update(uint32 diff, uint32 onlinePlayers, std::size_t databaseQueueSize)
+{
+    uint32 savesPerSecond = CalculateSavesPerSecond(onlinePlayers, databaseQueueSize);
+    _savesPerSecond.store(savesPerSecond, std::memory_order_relaxed);
+
+    // at most one second of budget is kept, so saves deferred during a long update do not all start together;
+    // a debt from priority saves is limited the same way
+    int64 limit = int64(savesPerSecond) * SaveCost;
+    int64 debtLimit = -std::max<int64>(limit, SaveCost);
+    int64 refill = int64(savesPerSecond) * diff;
+    int64 budget = _budget.load(std::memory_order_relaxed);
+    while (!_budget.compare_exchange_weak(budget, std::clamp(budget + refill, debtLimit, limit), std::memory_order_relaxed))
+        ;
+
+    ProcessPendingCommits();
+}
+
+PlayerSaveStatisticsSnapshot PlayerSaveScheduler::GetStatistics()
+{
+    PlayerSaveStatisticsSnapshot statistics;
+    statistics.Autosaves = _autosaves.load(std::memory_order_relaxed);
+    statistics.PrioritySaves = _prioritySaves.load(std::memory_order_relaxed);
+    statistics.DeferredAutosaves = _deferredAutosaves.load(std::memory_order_relaxed);
+    statistics.ForcedAutosaves = _forcedAutosaves.load(std::memory_order_relaxed);
+    statistics.SavesPerSecond = _savesPerSecond.load(std::memory_order_relaxed);
+    statistics.PendingCommits = _pendingCount.load(std::memory_order_relaxed);
+    statistics.AverageLatency = _averageLatency.load(std::memory_order_relaxed);
+    statistics.MaxLatency = _maxLatency.exchange(0, std::memory_order_relaxed);
+    return statistics;
+}
+
+uint32 PlayerSaveScheduler::CalculateSavesPerSecond(uint32 onlinePlayers, std::size_t databaseQueueSize) const
+{
+    uint32 savesPerSecond = _maxPerSecond.load(std::memory_order_relaxed);
+    if (!savesPerSecond)
+    {
+        uint32 interval = std::max<uint32>(_interval.load(std::memory_order_relaxed), IN_MILLISECONDS);
+        savesPerSecond = std::max<uint32>(uint32(uint64(onlinePlayers) * AutomaticRateHeadroom * IN_MILLISECONDS / interval), 1);
+    }
+
+    // above the limit the budget falls linearly and reaches zero at twice the limit
+    uint32 maxQueueSize = _maxQueueSize.load(std::memory_order_relaxed);
+    if (maxQueueSize && databaseQueueSize > maxQueueSize)
+    {
+        if (databaseQueueSize >= 2 * std::size_t(maxQueueSize))
+            return 0;
+
+        savesPerSecond = uint32(uint64(savesPerSecond) * (2 * maxQueueSize - databaseQueueSize) / maxQueueSize);
+    }
+
+    return savesPerSecond;
+}
+
+void PlayerSaveScheduler::ProcessPendingCommits()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pendingLock);
+        std::move(_pendingCommits.begin(), _pendingCommits.end(), std::back_inserter(_updateCommits));
+        _pendingCommits.clear();
+    }
+
+    std::size_t completed = std::erase_if(_updateCommits, [](TransactionCallback& callback) { return callback.InvokeIfReady(); });
+    _pendingCount.fetch_sub(completed, std::memory_order_relaxed);
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_PLAYER_SAVE_SCHEDULER_H
+#define TRINITYCORE_PLAYER_SAVE_SCHEDULER_H
+
+#include "DatabaseEnvFwd.h"
+#include "Define.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct PlayerSaveStatisticsSnapshot
+{
+    uint64 Autosaves;                                       // autosaves allowed by the budget
+    uint64 PrioritySaves;                                   // logout, trade, mail, auction and other explicit saves
+    uint64 DeferredAutosaves;                               // autosaves told to retry later
+    uint64 ForcedAutosaves;                                 // autosaves started over budget because they waited a whole interval
+    uint32 SavesPerSecond;                                  // current budget
+    std::size_t PendingCommits;                             // saves committed but not yet executed by the database
+    uint32 AverageLatency;                                  // milliseconds from commit to completion, moving average
+    uint32 MaxLatency;                                      // milliseconds, since the previous GetStatistics
+};
+
+/**
+ * Spreads autosaves of online characters over PlayerSaveInterval and limits how many
+ * start per second, so a restart or mass login does not flood the character database.
+ * Autosaves take one save from a budget that the world thread refills every update; the
+ * budget shrinks while the CharacterDatabase queue is longer than PlayerSave.MaxQueueSize.
+ * Saves that cannot wait (logout, trade, mail, auction) are never delayed but are taken
+ * from the same budget, so autosaves yield to them.
+ * RequestAutosave, OnPrioritySave and CommitSave are called from map threads.
+ */
+class TC_GAME_API PlayerSaveScheduler
+{
+public:
+    PlayerSaveScheduler();
+    ~PlayerSaveScheduler();
+
+    PlayerSaveScheduler(PlayerSaveScheduler const&) = delete;
+    PlayerSaveScheduler& operator=(PlayerSaveScheduler const&) = delete;
+
+    static PlayerSaveScheduler* instance();
+
+    /// maxPerSecond 0 lets the budget follow the number of online players, maxQueueSize 0 ignores the database queue
+    void SetLimits(uint32 interval, uint32 maxPerSecond, uint32 maxQueueSize);
+
+    /// Delay before the first autosave of a character that just logged in, consecutive logins are spread over the interval
+    uint32 GetFirstSaveDelay();
+    /// How long a deferred autosave waits before asking again
+    uint32 GetRetryDelay() const;
+
+    /// overdue is how long the autosave has been deferred already, false means retry after GetRetryDelay()
+    bool RequestAutosave(uint32 overdue);
+    void OnPrioritySave();
+
+    /// Commits the transaction of a character save and measures how long the database takes for it,
+    /// callback is called with the result on the world thread
+    void CommitSave(CharacterDatabaseTransaction trans, std::function<void(bool)> callback = nullptr);
+
+    /// World thread, refills the budget and completes finished commits
+    void Update(uint32 diff, uint32 onlinePlayers, std::size_t databaseQueueSize);
+
+    uint32 GetSavesPerSecond() const { return _savesPerSecond.load(std::memory_order_relaxed); }
+    PlayerSaveStatisticsSnapshot GetStatistics();
+
+private:
+    uint32 CalculateSavesPerSecond(uint32 onlinePlayers, std::size_t databaseQueueSize) const;
+    void ProcessPendingCommits();
+
+    // budget in thousandths of a save, can go below zero after priority saves
+    std::atomic<int64> _budget;
+    std::atomic<uint32> _savesPerSecond;
+    std::atomic<uint32> _loginCount;
+
+    std::atomic<uint32> _interval;
+    std::atomic<uint32> _maxPerSecond;
+    std::atomic<uint32> _maxQueueSize;
+
+    std::mutex _pendingLock;
+    std::vector<TransactionCallback> _pendingCommits;
+    std::vector<TransactionCallback> _updateCommits;        // world thread only
+    std::atomic<std::size_t> _pendingCount;
+
+    std::atomic<uint64> _autosaves;
+    std::atomic<uint64> _prioritySaves;
+    std::atomic<uint64> _deferredAutosaves;
+    std::atomic<uint64> _forcedAutosaves;
+    std::atomic<uint32> _averageLatency;
+    std::atomic<uint32> _maxLatency;
+};
+
+#define sPlayerSaveScheduler PlayerSaveScheduler::instance()
+
+#endif
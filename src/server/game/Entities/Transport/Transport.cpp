@@ -762,8 +762,11 @@ void Transport::BuildUpdate(UpdateDataMapType& data_map)
     if (players.isEmpty())
         return;
 
+    UpdateFieldFragments& fragments = GetMap()->GetUpdateFieldFragments();
+    fragments.Clear();
+
     for (Map::PlayerList::const_iterator itr = players.begin(); itr != players.end(); ++itr)
-        BuildFieldsUpdate(itr->GetSource(), data_map);
+        BuildFieldsUpdate(itr->GetSource(), data_map, &fragments);
 
     ClearUpdateMask(true);
 }
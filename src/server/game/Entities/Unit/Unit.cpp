@@ -64,6 +64,7 @@
 #include "QuestDef.h"
 #include "ReputationMgr.h"
 #include "ScheduledChangeAI.h"
+#include "ScopeProfiler.h"
 #include "SpellAuraEffects.h"
 #include "SpellAuras.h"
 #include "Spell.h"
@@ -77,6 +78,7 @@
 #include "Totem.h"
 #include "UnitAI.h"
 #include "UpdateFieldFlags.h"
+#include "UpdateFieldFragments.h"
 #include "Util.h"
 #include "Vehicle.h"
 #include "World.h"
@@ -10085,6 +10087,7 @@ void Unit::AIUpdateTick(uint32 diff)
 {
     if (UnitAI* ai = GetAI())
     {
+        ScopeProfiler::Scope profileScope(ScopeProfiler::SCOPE_NESTED, typeid(*ai), "UpdateAI");
         m_aiLocked = true;
         ai->UpdateAI(diff);
         m_aiLocked = false;
@@ -14392,16 +14395,8 @@ bool Unit::IsSplineEnabled() const
     return movespline->Initialized() && !movespline->Finalized();
 }
 
-void Unit::BuildValuesUpdate(uint8 updateType, ByteBuffer* data, Player const* target) const
+uint32 Unit::GetUpdateFieldVisibleFlag(Player const* target) const
 {
-    if (!target)
-        return;
-
-    ByteBuffer fieldBuffer;
-
-    UpdateMaskPacketBuilder updateMask(m_valuesCount);
-
-    uint32* flags = UnitUpdateFieldFlags;
     uint32 visibleFlag = UF_FLAG_PUBLIC;
 
     if (target == this)
@@ -14422,6 +14417,55 @@ void Unit::BuildValuesUpdate(uint8 updateType, ByteBuffer* data, Player const* t
         visibleFlag |= UF_FLAG_PARTY_MEMBER;
     //end npcbot
 
+    return visibleFlag;
+}
+
+bool Unit::GetValuesUpdateViewKey(Player const* target, uint32& viewKey) const
+{
+    // per caster aura states are forced into every update
+    if (HasFlag(UNIT_FIELD_AURASTATE, PER_CASTER_AURA_STATE_MASK))
+        return false;
+
+    uint32 visibleFlag = GetUpdateFieldVisibleFlag(target);
+    if (visibleFlag & UF_FLAG_SPECIAL_INFO)
+        return false;
+
+    // fields BuildValuesUpdate adjusts for each target, UNIT_FIELD_FLAGS and UNIT_FIELD_DISPLAYID only depend on gamemaster mode
+    uint16 const targetFields[] = { UNIT_FIELD_AURASTATE, UNIT_FIELD_BYTES_2, UNIT_FIELD_FACTIONTEMPLATE };
+    for (uint16 index : targetFields)
+        if (IsValuesUpdateFieldSent(index, UnitUpdateFieldFlags, visibleFlag))
+            return false;
+
+    // dynamic flags are in every update, only loot, tap and tracking flags depend on the target
+    if (m_uint32Values[UNIT_DYNAMIC_FLAGS] & (UNIT_DYNFLAG_LOOTABLE | UNIT_DYNFLAG_TRACK_UNIT))
+        return false;
+
+    if (Creature const* creature = ToCreature())
+        if (creature->hasLootRecipient())
+            return false;
+
+    if ((m_uint32Values[UNIT_NPC_FLAGS] & UNIT_NPC_FLAG_SPELLCLICK) && IsValuesUpdateFieldSent(UNIT_NPC_FLAGS, UnitUpdateFieldFlags, visibleFlag))
+        return false;
+
+    viewKey = visibleFlag;
+    if (target->IsGameMaster())
+        viewKey |= UPDATE_VIEW_KEY_GAMEMASTER;
+
+    return true;
+}
+
+void Unit::BuildValuesUpdate(uint8 updateType, ByteBuffer* data, Player const* target) const
+{
+    if (!target)
+        return;
+
+    ByteBuffer fieldBuffer;
+
+    UpdateMaskPacketBuilder updateMask(m_valuesCount);
+
+    uint32* flags = UnitUpdateFieldFlags;
+    uint32 visibleFlag = GetUpdateFieldVisibleFlag(target);
+
     Creature const* creature = ToCreature();
     for (uint16 index = 0; index < m_valuesCount; ++index)
     {
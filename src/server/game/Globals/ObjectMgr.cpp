@@ -2172,8 +2172,13 @@ void ObjectMgr::LoadCreatures()
 {
     uint32 oldMSTime = getMSTime();
 
-    //                                               0              1   2    3           4           5           6            7        8             9              10
-    QueryResult result = WorldDatabase.Query("SELECT creature.guid, id, map, position_x, position_y, position_z, orientation, modelid, equipment_id, spawntimesecs, wander_distance, "
+    // a streamed result does not know its size, and the connection it holds cannot be used for other queries until it was read
+    uint64 creatureCount = 0;
+    if (QueryResult countResult = WorldDatabase.Query("SELECT COUNT(*) FROM creature"))
+        creatureCount = (*countResult)[0].GetUInt64();
+
+    //                                                     0              1   2    3           4           5           6            7        8             9              10
+    QueryResult result = WorldDatabase.StreamQuery("SELECT creature.guid, id, map, position_x, position_y, position_z, orientation, modelid, equipment_id, spawntimesecs, wander_distance, "
     //   11               12         13       14            15         16          17          18                19                   20                    21
         "currentwaypoint, curhealth, curmana, MovementType, spawnMask, phaseMask, eventEntry, poolSpawnId, creature.npcflag, creature.unit_flags, creature.dynamicflags, "
     //   22                   23
@@ -2196,7 +2201,7 @@ void ObjectMgr::LoadCreatures()
                 if (GetMapDifficultyData(i, Difficulty(k)))
                     spawnMasks[i] |= (1 << k);
 
-    _creatureDataStore.rehash(result->GetRowCount());
+    _creatureDataStore.rehash(creatureCount);
 
     do
     {
@@ -2494,8 +2499,13 @@ void ObjectMgr::LoadGameObjects()
 {
     uint32 oldMSTime = getMSTime();
 
-    //                                                0                1   2    3           4           5           6
-    QueryResult result = WorldDatabase.Query("SELECT gameobject.guid, id, map, position_x, position_y, position_z, orientation, "
+    // a streamed result does not know its size, and the connection it holds cannot be used for other queries until it was read
+    uint64 gameObjectCount = 0;
+    if (QueryResult countResult = WorldDatabase.Query("SELECT COUNT(*) FROM gameobject"))
+        gameObjectCount = (*countResult)[0].GetUInt64();
+
+    //                                                      0                1   2    3           4           5           6
+    QueryResult result = WorldDatabase.StreamQuery("SELECT gameobject.guid, id, map, position_x, position_y, position_z, orientation, "
     //   7          8          9          10         11             12            13     14         15         16          17
         "rotation0, rotation1, rotation2, rotation3, spawntimesecs, animprogress, state, spawnMask, phaseMask, eventEntry, poolSpawnId, "
     //   18          19
@@ -2517,7 +2527,7 @@ void ObjectMgr::LoadGameObjects()
                 if (GetMapDifficultyData(i, Difficulty(k)))
                     spawnMasks[i] |= (1 << k);
 
-    _gameObjectDataStore.rehash(result->GetRowCount());
+    _gameObjectDataStore.rehash(gameObjectCount);
 
     do
     {
@@ -2940,8 +2950,13 @@ void ObjectMgr::LoadItemTemplates()
 {
     uint32 oldMSTime = getMSTime();
 
-    //                                                 0      1       2               3              4        5        6       7          8         9        10        11           12
-    QueryResult result = WorldDatabase.Query("SELECT entry, class, subclass, SoundOverrideSubclass, name, displayid, Quality, Flags, FlagsExtra, BuyCount, BuyPrice, SellPrice, InventoryType, "
+    // a streamed result does not know its size, and the connection it holds cannot be used for other queries until it was read
+    uint64 itemTemplateCount = 0;
+    if (QueryResult countResult = WorldDatabase.Query("SELECT COUNT(*) FROM item_template"))
+        itemTemplateCount = (*countResult)[0].GetUInt64();
+
+    //                                                       0      1       2               3              4        5        6       7          8         9        10        11           12
+    QueryResult result = WorldDatabase.StreamQuery("SELECT entry, class, subclass, SoundOverrideSubclass, name, displayid, Quality, Flags, FlagsExtra, BuyCount, BuyPrice, SellPrice, InventoryType, "
     //                                              13              14           15          16             17               18                19              20
                                              "AllowableClass, AllowableRace, ItemLevel, RequiredLevel, RequiredSkill, RequiredSkillRank, requiredspell, requiredhonorrank, "
     //                                              21                      22                       23               24        25          26             27           28
@@ -2979,7 +2994,7 @@ void ObjectMgr::LoadItemTemplates()
         return;
     }
 
-    _itemTemplateStore.reserve(result->GetRowCount());
+    _itemTemplateStore.reserve(itemTemplateCount);
     bool enforceDBCAttributes = sWorld->getBoolConfig(CONFIG_DBC_ENFORCE_ITEM_ATTRIBUTES);
 
     do
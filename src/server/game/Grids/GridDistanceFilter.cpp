@@ -0,0 +1,252 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GridDistanceFilter.h"
+#include "CompilerDefs.h"
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRINITY_GRID_FILTER_X86
+#include <immintrin.h>
+#if TRINITY_COMPILER == TRINITY_COMPILER_MICROSOFT
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(TRINITY_GRID_FILTER_X86) && TRINITY_COMPILER == TRINITY_COMPILER_GNU
+#define TRINITY_TARGET_SSE2 __attribute__((target("sse2")))
+#define TRINITY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TRINITY_TARGET_SSE2
+#define TRINITY_TARGET_AVX2
+#endif
+
+namespace
+{
+    using namespace Trinity;
+
+    uint32 FilterScalar(GridDistanceQuery const& query, GridPositionSpan const& span, uint32 first, uint32 found, uint32* matches)
+    {
+        float const zFactor = query.Is3D ? 1.0f : 0.0f;
+        float const reachFactor = query.AddTargetReach ? 1.0f : 0.0f;
+
+        for (uint32 i = first; i < span.Count; ++i)
+        {
+            float const dx = span.X[i] - query.X;
+            float const dy = span.Y[i] - query.Y;
+            float const dz = (span.Z[i] - query.Z) * zFactor;
+            float const limit = query.Range + span.CombatReach[i] * reachFactor;
+            bool const pass = (dx * dx + dy * dy + dz * dz <= limit * limit) & ((span.PhaseMask[i] & query.PhaseMask) != 0);
+
+            // branchless compaction, the slot is overwritten by the next candidate when this one fails
+            matches[found] = i;
+            found += pass;
+        }
+
+        return found;
+    }
+
+    uint32 FilterScalar(GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches)
+    {
+        return FilterScalar(query, span, 0, 0, matches);
+    }
+
+#ifdef TRINITY_GRID_FILTER_X86
+    TRINITY_TARGET_SSE2
+    uint32 FilterSSE2(GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches)
+    {
+        __m128 const x = _mm_set1_ps(query.X);
+        __m128 const y = _mm_set1_ps(query.Y);
+        __m128 const z = _mm_set1_ps(query.Z);
+        __m128 const range = _mm_set1_ps(query.Range);
+        __m128 const zFactor = _mm_set1_ps(query.Is3D ? 1.0f : 0.0f);
+        __m128 const reachFactor = _mm_set1_ps(query.AddTargetReach ? 1.0f : 0.0f);
+        __m128i const phaseMask = _mm_set1_epi32(int32(query.PhaseMask));
+        __m128i const zero = _mm_setzero_si128();
+
+        uint32 found = 0;
+        uint32 i = 0;
+        for (; i + 4 <= span.Count; i += 4)
+        {
+            __m128 const dx = _mm_sub_ps(_mm_loadu_ps(span.X + i), x);
+            __m128 const dy = _mm_sub_ps(_mm_loadu_ps(span.Y + i), y);
+            __m128 const dz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(span.Z + i), z), zFactor);
+            __m128 const distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 const limit = _mm_add_ps(range, _mm_mul_ps(_mm_loadu_ps(span.CombatReach + i), reachFactor));
+            __m128 const inRange = _mm_cmple_ps(distSq, _mm_mul_ps(limit, limit));
+            __m128i const phase = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(span.PhaseMask + i)), phaseMask);
+            __m128 const otherPhase = _mm_castsi128_ps(_mm_cmpeq_epi32(phase, zero));
+
+            uint32 mask = uint32(_mm_movemask_ps(_mm_andnot_ps(otherPhase, inRange)));
+            for (; mask; mask &= mask - 1)
+                matches[found++] = i + uint32(std::countr_zero(mask));
+        }
+
+        return FilterScalar(query, span, i, found, matches);
+    }
+
+    TRINITY_TARGET_AVX2
+    uint32 FilterAVX2(GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches)
+    {
+        __m256 const x = _mm256_set1_ps(query.X);
+        __m256 const y = _mm256_set1_ps(query.Y);
+        __m256 const z = _mm256_set1_ps(query.Z);
+        __m256 const range = _mm256_set1_ps(query.Range);
+        __m256 const zFactor = _mm256_set1_ps(query.Is3D ? 1.0f : 0.0f);
+        __m256 const reachFactor = _mm256_set1_ps(query.AddTargetReach ? 1.0f : 0.0f);
+        __m256i const phaseMask = _mm256_set1_epi32(int32(query.PhaseMask));
+        __m256i const zero = _mm256_setzero_si256();
+
+        uint32 found = 0;
+        uint32 i = 0;
+        for (; i + 8 <= span.Count; i += 8)
+        {
+            __m256 const dx = _mm256_sub_ps(_mm256_loadu_ps(span.X + i), x);
+            __m256 const dy = _mm256_sub_ps(_mm256_loadu_ps(span.Y + i), y);
+            __m256 const dz = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(span.Z + i), z), zFactor);
+            __m256 const distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 const limit = _mm256_add_ps(range, _mm256_mul_ps(_mm256_loadu_ps(span.CombatReach + i), reachFactor));
+            __m256 const inRange = _mm256_cmp_ps(distSq, _mm256_mul_ps(limit, limit), _CMP_LE_OQ);
+            __m256i const phase = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(span.PhaseMask + i)), phaseMask);
+            __m256 const otherPhase = _mm256_castsi256_ps(_mm256_cmpeq_epi32(phase, zero));
+
+            uint32 mask = uint32(_mm256_movemask_ps(_mm256_andnot_ps(otherPhase, inRange)));
+            for (; mask; mask &= mask - 1)
+                matches[found++] = i + uint32(std::countr_zero(mask));
+        }
+
+        // callers are built without avx, leaving the upper halves dirty slows down their sse code
+        _mm256_zeroupper();
+
+        return FilterScalar(query, span, i, found, matches);
+    }
+
+    bool HasSSE2()
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        return true;
+#elif TRINITY_COMPILER == TRINITY_COMPILER_MICROSOFT
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool HasAVX2()
+    {
+#if TRINITY_COMPILER == TRINITY_COMPILER_MICROSOFT
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // the os must save the ymm registers on context switches
+        __cpuid(info, 1);
+        bool const osxsave = (info[2] & (1 << 27)) != 0;
+        bool const avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        // may run from a static initializer, before the cpu model is set up
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    using FilterFunction = uint32(*)(GridDistanceQuery const&, GridPositionSpan const&, uint32*);
+
+    FilterFunction GetFunction(GridDistanceFilter::Implementation implementation)
+    {
+        switch (implementation)
+        {
+#ifdef TRINITY_GRID_FILTER_X86
+            case GridDistanceFilter::Implementation::SSE2:
+                return &FilterSSE2;
+            case GridDistanceFilter::Implementation::AVX2:
+                return &FilterAVX2;
+#endif
+            default:
+                return &FilterScalar;
+        }
+    }
+
+    GridDistanceFilter::Implementation SelectImplementation()
+    {
+        if (GridDistanceFilter::IsSupported(GridDistanceFilter::Implementation::AVX2))
+            return GridDistanceFilter::Implementation::AVX2;
+        if (GridDistanceFilter::IsSupported(GridDistanceFilter::Implementation::SSE2))
+            return GridDistanceFilter::Implementation::SSE2;
+        return GridDistanceFilter::Implementation::Scalar;
+    }
+
+    GridDistanceFilter::Implementation const ActiveImplementation = SelectImplementation();
+    FilterFunction const ActiveFunction = GetFunction(ActiveImplementation);
+}
+
+uint32 Trinity::GridDistanceFilter::Filter(GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches)
+{
+    return ActiveFunction(query, span, matches);
+}
+
+uint32 Trinity::GridDistanceFilter::Filter(Implementation implementation, GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches)
+{
+    return GetFunction(implementation)(query, span, matches);
+}
+
+Trinity::GridDistanceFilter::Implementation Trinity::GridDistanceFilter::GetActiveImplementation()
+{
+    return ActiveImplementation;
+}
+
+bool Trinity::GridDistanceFilter::IsSupported(Implementation implementation)
+{
+    switch (implementation)
+    {
+        case Implementation::Scalar:
+            return true;
+#ifdef TRINITY_GRID_FILTER_X86
+        case Implementation::SSE2:
+            return HasSSE2();
+        case Implementation::AVX2:
+            return HasAVX2();
+#endif
+        default:
+            return false;
+    }
+}
+
+char const* Trinity::GridDistanceFilter::GetImplementationName(Implementation implementation)
+{
+    switch (implementation)
+    {
+        case Implementation::Scalar:
+            return "scalar";
+        case Implementation::SSE2:
+            return "SSE2";
+        case Implementation::AVX2:
+            return "AVX2";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_GRID_DISTANCE_FILTER_H
+#define TRINITY_GRID_DISTANCE_FILTER_H
+
+#include "Define.h"
+
+namespace Trinity
+{
+    // Candidate test run on packed grid positions:
+    // (phase & PhaseMask) != 0 && distance(center, position) <= Range [+ target combat reach]
+    struct GridDistanceQuery
+    {
+        float X = 0.0f;
+        float Y = 0.0f;
+        float Z = 0.0f;
+        float Range = 0.0f;
+        bool Is3D = true;
+        bool AddTargetReach = false;
+        uint32 PhaseMask = 0;
+    };
+
+    struct GridPositionSpan
+    {
+        float const* X = nullptr;
+        float const* Y = nullptr;
+        float const* Z = nullptr;
+        float const* CombatReach = nullptr;
+        uint32 const* PhaseMask = nullptr;
+        uint32 Count = 0;
+    };
+
+    namespace GridDistanceFilter
+    {
+        enum class Implementation : uint8
+        {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+
+        // Writes the span indices passing the query to matches (room for span.Count entries) in ascending order, returns how many
+        TC_GAME_API uint32 Filter(GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches);
+        TC_GAME_API uint32 Filter(Implementation implementation, GridDistanceQuery const& query, GridPositionSpan const& span, uint32* matches);
+
+        // Best implementation supported by the running cpu, picked once at startup
+        TC_GAME_API Implementation GetActiveImplementation();
+        TC_GAME_API bool IsSupported(Implementation implementation);
+        TC_GAME_API char const* GetImplementationName(Implementation implementation);
+    }
+}
+
+#endif
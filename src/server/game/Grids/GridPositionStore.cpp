@@ -0,0 +1,120 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GridPositionStore.h"
+#include "Errors.h"
+#include "Object.h"
+#include <functional>
+
+GridPositionStore::~GridPositionStore()
+{
+    // objects still linked when the container goes away (grid unload) must not point back here
+    for (WorldObject* object : _objects)
+        if (object)
+            object->m_gridPositionStore = nullptr;
+}
+
+void GridPositionStore::Insert(WorldObject* object)
+{
+    ASSERT(!object->m_gridPositionStore);
+
+    object->m_gridPositionStore = this;
+    object->m_gridPositionIndex = uint32(_objects.size());
+
+    _x.push_back(object->GetPositionX());
+    _y.push_back(object->GetPositionY());
+    _z.push_back(object->GetPositionZ());
+    _combatReach.push_back(object->GetCombatReach());
+    _phaseMask.push_back(object->GetPhaseMask());
+    _objects.push_back(object);
+}
+
+void GridPositionStore::Remove(WorldObject* object)
+{
+    ASSERT(object->m_gridPositionStore == this);
+
+    uint32 index = object->m_gridPositionIndex;
+    object->m_gridPositionStore = nullptr;
+
+    // moving the last entry into this slot would hide it from the running visit
+    if (_visits)
+    {
+        _objects[index] = nullptr;
+        _phaseMask[index] = 0;
+        _removed.push_back(index);
+        return;
+    }
+
+    Erase(index);
+}
+
+void GridPositionStore::Update(WorldObject const* object)
+{
+    uint32 index = object->m_gridPositionIndex;
+    _x[index] = object->GetPositionX();
+    _y[index] = object->GetPositionY();
+    _z[index] = object->GetPositionZ();
+    _combatReach[index] = object->GetCombatReach();
+    _phaseMask[index] = object->GetPhaseMask();
+}
+
+void GridPositionStore::AssertSynced() const
+{
+    for (std::size_t i = 0; i < _objects.size(); ++i)
+    {
+        WorldObject const* object = _objects[i];
+        if (!object)
+            continue;
+
+        ASSERT(_x[i] == object->GetPositionX() && _y[i] == object->GetPositionY() && _z[i] == object->GetPositionZ(),
+            "Grid position of %s is stale, it was moved past WorldObject::Relocate", object->GetGUID().ToString().c_str());
+        ASSERT(_combatReach[i] == object->GetCombatReach() && _phaseMask[i] == object->GetPhaseMask(),
+            "Grid combat reach or phase mask of %s is stale", object->GetGUID().ToString().c_str());
+    }
+}
+
+void GridPositionStore::Erase(uint32 index)
+{
+    uint32 last = uint32(_objects.size() - 1);
+    if (index != last)
+    {
+        _x[index] = _x[last];
+        _y[index] = _y[last];
+        _z[index] = _z[last];
+        _combatReach[index] = _combatReach[last];
+        _phaseMask[index] = _phaseMask[last];
+        _objects[index] = _objects[last];
+        _objects[index]->m_gridPositionIndex = index;
+    }
+
+    _x.pop_back();
+    _y.pop_back();
+    _z.pop_back();
+    _combatReach.pop_back();
+    _phaseMask.pop_back();
+    _objects.pop_back();
+}
+
+void GridPositionStore::Compact()
+{
+    // highest first, every entry behind the erased one is then in use and can fill its slot
+    std::sort(_removed.begin(), _removed.end(), std::greater<uint32>());
+    for (uint32 index : _removed)
+        Erase(index);
+
+    _removed.clear();
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_GRID_POSITION_STORE_H
+#define TRINITY_GRID_POSITION_STORE_H
+
+#include "Define.h"
+#include "GridDistanceFilter.h"
+#include <algorithm>
+#include <vector>
+
+class WorldObject;
+
+/*
+ * Packed copy of the position, combat reach and phase mask of every object linked into one
+ * GridRefManager (one object type of one cell), kept in sync by GridObject and
+ * WorldObject. Searchers filter these contiguous arrays before dereferencing
+ * any object; the linked list stays the owner of the grid membership.
+ *
+ * Visit workers may add or remove objects of the visited container. Added objects
+ * can be visited or skipped. Removed objects are only marked while a visit runs and
+ * dropped from the arrays when the outermost visit ends, so no other entry moves and
+ * every object present when the visit started is visited at most once.
+ */
+class TC_GAME_API GridPositionStore
+{
+    public:
+        GridPositionStore() = default;
+        ~GridPositionStore();
+
+        GridPositionStore(GridPositionStore const&) = delete;
+        GridPositionStore& operator=(GridPositionStore const&) = delete;
+
+        void Insert(WorldObject* object);
+        void Remove(WorldObject* object);
+        void Update(WorldObject const* object);
+
+        std::size_t Size() const { return _objects.size() - _removed.size(); }
+
+        // Calls worker(object) for every object sharing a phase with phaseMask, stops when it returns false
+        template<class Worker>
+        bool VisitInPhase(uint32 phaseMask, Worker&& worker)
+        {
+#ifdef TRINITY_DEBUG
+            AssertSynced();
+#endif
+            VisitScope scope(*this);
+            std::size_t i = 0;
+            for (; i + BlockSize <= _objects.size(); i += BlockSize)
+            {
+                uint32 mask = 0;
+                for (uint32 j = 0; j < BlockSize; ++j)
+                    mask |= uint32((_phaseMask[i + j] & phaseMask) != 0) << j;
+
+                if (!VisitMask(i, mask, worker))
+                    return false;
+            }
+
+            for (; i < _objects.size(); ++i)
+                if ((_phaseMask[i] & phaseMask) != 0 && _objects[i] && !worker(_objects[i]))
+                    return false;
+
+            return true;
+        }
+
+        // Same as VisitInPhase, limited to the objects passing query (phase mask included), see GridDistanceFilter
+        template<class Worker>
+        bool VisitInRange(Trinity::GridDistanceQuery const& query, Worker&& worker)
+        {
+#ifdef TRINITY_DEBUG
+            AssertSynced();
+#endif
+            VisitScope scope(*this);
+            uint32 matches[ChunkSize];
+            for (std::size_t first = 0; first < _objects.size(); first += ChunkSize)
+            {
+                // spans are rebuilt per chunk, workers may add objects and reallocate the arrays
+                Trinity::GridPositionSpan span;
+                span.X = _x.data() + first;
+                span.Y = _y.data() + first;
+                span.Z = _z.data() + first;
+                span.CombatReach = _combatReach.data() + first;
+                span.PhaseMask = _phaseMask.data() + first;
+                span.Count = uint32(std::min<std::size_t>(ChunkSize, _objects.size() - first));
+
+                uint32 found = Trinity::GridDistanceFilter::Filter(query, span, matches);
+                // entries matched for this chunk may have been removed by the worker since
+                for (uint32 k = 0; k < found; ++k)
+                    if (WorldObject* object = _objects[first + matches[k]])
+                        if (!worker(object))
+                            return false;
+            }
+
+            return true;
+        }
+
+    private:
+        static constexpr uint32 BlockSize = 8;
+        static constexpr uint32 ChunkSize = 64;
+
+        struct VisitScope
+        {
+            explicit VisitScope(GridPositionStore& store) : Store(store) { ++Store._visits; }
+            ~VisitScope() { if (!--Store._visits && !Store._removed.empty()) Store.Compact(); }
+
+            GridPositionStore& Store;
+        };
+
+        template<class Worker>
+        bool VisitMask(std::size_t first, uint32 mask, Worker& worker) const
+        {
+            for (uint32 j = 0; mask; ++j, mask >>= 1)
+                if ((mask & 1) && _objects[first + j] && !worker(_objects[first + j]))
+                    return false;
+
+            return true;
+        }
+
+        void Erase(uint32 index);
+        void Compact();
+
+        // the entries are only copies, a position written past the WorldObject setters leaves them stale
+        void AssertSynced() const;
+
+        std::vector<float> _x;
+        std::vector<float> _y;
+        std::vector<float> _z;
+        std::vector<float> _combatReach;
+        std::vector<uint32> _phaseMask;
+        std::vector<WorldObject*> _objects;
+
+        uint32 _visits = 0;
+        std::vector<uint32> _removed;           // entries removed while visiting, null in _objects
+};
+
+#endif
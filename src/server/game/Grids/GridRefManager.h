@@ -18,6 +18,7 @@
 #ifndef _GRIDREFMANAGER
 #define _GRIDREFMANAGER
 
+#include "GridPositionStore.h"
 #include "RefManager.h"
 
 template<class OBJECT>
@@ -34,5 +35,11 @@ class GridRefManager : public RefManager<GridRefManager<OBJECT>, OBJECT>
 
         iterator begin() { return iterator(getFirst()); }
         iterator end() { return iterator(nullptr); }
+
+        GridPositionStore& GetPositions() { return _positions; }
+        GridPositionStore const& GetPositions() const { return _positions; }
+
+    private:
+        GridPositionStore _positions;
 };
 #endif
@@ -23,9 +23,40 @@
 #include "Transport.h"
 #include "ObjectAccessor.h"
 #include "CellImpl.h"
+#include "SpatialHash.h"
+#include "World.h"
 
 using namespace Trinity;
 
+VisibleNotifier::VisibleNotifier(Player &player, float visibilityMargin) : i_player(player), vis_guids(player.m_clientGUIDs),
+    i_visibilityMargin(visibilityMargin), i_visibilityRange(player.GetMap()->GetVisibilityRange()), i_checked(0), i_skipped(0)
+{
+}
+
+bool VisibleNotifier::IsVisibilityUnchanged(WorldObject const* target)
+{
+    if (i_visibilityMargin < 0.0f)
+        return false;
+
+    ++i_checked;
+
+    // moved or changed since the last update, or its own notifier left the update to us
+    if (target->isNeedNotify(NOTIFY_VISIBILITY_CHANGED) || i_player.IsVisibilityUpdateDeferred(target->GetGUID()))
+        return false;
+
+    // seen from further away or detected depending on distance
+    if (target->IsFarVisible() || target->IsVisibilityOverridden() || target->m_stealth.GetFlags() || target->m_invisibility.GetFlags())
+        return false;
+
+    // the player can not have crossed the edge of the visibility range of objects far enough from it
+    float distance = i_player.GetDistance2d(target);
+    if (distance + i_visibilityMargin >= i_visibilityRange && distance - i_visibilityMargin <= i_visibilityRange)
+        return false;
+
+    ++i_skipped;
+    return true;
+}
+
 void VisibleNotifier::SendToSelf()
 {
     // at this moment i_clientGUIDs have guids that not iterate at grid level checks
@@ -47,6 +78,8 @@ void VisibleNotifier::SendToSelf()
                         i_player.UpdateVisibilityOf((*itr)->ToPlayer(), i_data, i_visibleNow);
                         if (!(*itr)->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
                             (*itr)->ToPlayer()->UpdateVisibilityOf(&i_player);
+                        else
+                            (*itr)->ToPlayer()->DeferVisibilityUpdateOf(&i_player);
                         break;
                     case TYPEID_UNIT:
                         i_player.UpdateVisibilityOf((*itr)->ToCreature(), i_data, i_visibleNow);
@@ -68,9 +101,13 @@ void VisibleNotifier::SendToSelf()
 
         if (it->IsPlayer())
         {
-            Player* player = ObjectAccessor::FindPlayer(*it);
-            if (player && !player->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
-                player->UpdateVisibilityOf(&i_player);
+            if (Player* player = ObjectAccessor::FindPlayer(*it))
+            {
+                if (!player->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+                    player->UpdateVisibilityOf(&i_player);
+                else
+                    player->DeferVisibilityUpdateOf(&i_player);
+            }
         }
     }
 
@@ -148,10 +185,14 @@ void PlayerRelocationNotifier::Visit(PlayerMapType &m)
 
         vis_guids.erase(player->GetGUID());
 
-        i_player.UpdateVisibilityOf(player, i_data, i_visibleNow);
+        if (!IsVisibilityUnchanged(player))
+            i_player.UpdateVisibilityOf(player, i_data, i_visibleNow);
 
         if (player->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+        {
+            player->DeferVisibilityUpdateOf(&i_player);
             continue;
+        }
 
         player->UpdateVisibilityOf(&i_player);
     }
@@ -167,7 +208,8 @@ void PlayerRelocationNotifier::Visit(CreatureMapType &m)
 
         vis_guids.erase(c->GetGUID());
 
-        i_player.UpdateVisibilityOf(c, i_data, i_visibleNow);
+        if (!IsVisibilityUnchanged(c))
+            i_player.UpdateVisibilityOf(c, i_data, i_visibleNow);
 
         if (relocated_for_ai && !c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
             CreatureUnitRelocationWorker(c, &i_player);
@@ -182,6 +224,8 @@ void CreatureRelocationNotifier::Visit(PlayerMapType &m)
 
         if (!player->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
             player->UpdateVisibilityOf(&i_creature);
+        else
+            player->DeferVisibilityUpdateOf(&i_creature);
 
         CreatureUnitRelocationWorker(&i_creature, player);
     }
@@ -210,6 +254,12 @@ void DelayedUnitRelocation::Visit(CreatureMapType &m)
         if (!unit->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
             continue;
 
+        if (i_batch)
+        {
+            i_batch->i_movers.push_back(unit);
+            continue;
+        }
+
         CreatureRelocationNotifier relocate(*unit);
 
         TypeContainerVisitor<CreatureRelocationNotifier, WorldTypeMapContainer > c2world_relocation(relocate);
@@ -233,9 +283,179 @@ void DelayedUnitRelocation::Visit(PlayerMapType &m)
         if (player != viewPoint && !viewPoint->IsPositionValid())
             continue;
 
-        PlayerRelocationNotifier relocate(*player);
+        float const visibilityMargin = player->GetVisibilityUpdateMargin();
+        PlayerRelocationNotifier relocate(*player, visibilityMargin);
         Cell::VisitAllObjects(viewPoint, relocate, i_radius, false);
         relocate.SendToSelf();
+        player->OnVisibilityUpdated(visibilityMargin < 0.0f);
+
+        i_visibilityChecked += relocate.i_checked;
+        i_visibilitySkipped += relocate.i_skipped;
+    }
+}
+
+namespace
+{
+    struct RelocationCandidateCollector
+    {
+        SpatialHash<Creature*> &i_creatures;
+        SpatialHash<Creature*> &i_wideCreatures;
+        SpatialHash<Player*> &i_players;
+        float i_sightRange;
+        float i_creatureReach = 0.0f;
+        float i_wideCreatureReach = 0.0f;
+        float i_playerReach = 0.0f;
+
+        RelocationCandidateCollector(SpatialHash<Creature*> &creatures, SpatialHash<Creature*> &wideCreatures, SpatialHash<Player*> &players, float sightRange) :
+            i_creatures(creatures), i_wideCreatures(wideCreatures), i_players(players), i_sightRange(sightRange) { }
+
+        template<class T> void Visit(GridRefManager<T> &) { }
+
+        void Visit(CreatureMapType &m)
+        {
+            for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+            {
+                Creature* c = iter->GetSource();
+
+                // creatures with a longer sight or an owner they are always visible to can react beyond the usual sight range
+                if (c->m_SightDistance > i_sightRange || !c->GetCharmerOrOwnerGUID().IsEmpty() || c->GetCreator())
+                {
+                    i_wideCreatures.Insert(c->GetPositionX(), c->GetPositionY(), c);
+                    i_wideCreatureReach = std::max(i_wideCreatureReach, c->GetCombatReach());
+                }
+                else
+                {
+                    i_creatures.Insert(c->GetPositionX(), c->GetPositionY(), c);
+                    i_creatureReach = std::max(i_creatureReach, c->GetCombatReach());
+                }
+            }
+        }
+
+        void Visit(PlayerMapType &m)
+        {
+            for (PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+            {
+                Player* player = iter->GetSource();
+                i_players.Insert(player->GetPositionX(), player->GetPositionY(), player);
+                i_playerReach = std::max(i_playerReach, player->GetCombatReach());
+            }
+        }
+    };
+}
+
+void CreatureRelocationBatch::Process()
+{
+    std::vector<Creature*> movers;
+    movers.reserve(i_movers.size());
+
+    bool const batched = i_movers.size() >= i_minMovers;
+    for (Creature* mover : i_movers)
+    {
+        // visibility of these depends on more than the distance, keep notifying them one by one
+        if (!batched || mover->IsFarVisible() || mover->IsVisibilityOverridden() || !mover->GetCharmerOrOwnerGUID().IsEmpty() || mover->GetCreator())
+        {
+            CreatureRelocationNotifier relocate(*mover);
+            Cell::VisitAllObjects(mover, relocate, MAX_VISIBILITY_DISTANCE);
+        }
+        else
+            movers.push_back(mover);
+    }
+
+    if (movers.empty())
+        return;
+
+    // collect everything around the movers once, visiting each cell a single time
+    float moverReach = 0.0f;
+    std::vector<uint32> moverCells;
+    moverCells.reserve(movers.size());
+    for (Creature* mover : movers)
+    {
+        CellCoord p = Trinity::ComputeCellCoord(mover->GetPositionX(), mover->GetPositionY());
+        moverCells.push_back(p.y_coord * TOTAL_NUMBER_OF_CELLS_PER_MAP + p.x_coord);
+        moverReach = std::max(moverReach, mover->GetCombatReach());
+    }
+
+    std::sort(moverCells.begin(), moverCells.end());
+    moverCells.erase(std::unique(moverCells.begin(), moverCells.end()), moverCells.end());
+
+    int32 const cellRange = int32(std::ceil((MAX_VISIBILITY_DISTANCE + moverReach) / SIZE_OF_GRID_CELL));
+    std::vector<bool> visitedCells(TOTAL_NUMBER_OF_CELLS_PER_MAP * TOTAL_NUMBER_OF_CELLS_PER_MAP, false);
+
+    float const sightRange = sWorld->getFloatConfig(CONFIG_SIGHT_MONSTER);
+    SpatialHash<Creature*> creatures(std::max(sightRange, SIZE_OF_GRID_CELL));
+    SpatialHash<Creature*> wideCreatures(MAX_VISIBILITY_DISTANCE / 2);
+    SpatialHash<Player*> players(MAX_VISIBILITY_DISTANCE / 2);
+
+    RelocationCandidateCollector collector(creatures, wideCreatures, players, sightRange);
+    TypeContainerVisitor<RelocationCandidateCollector, WorldTypeMapContainer> worldCollector(collector);
+    TypeContainerVisitor<RelocationCandidateCollector, GridTypeMapContainer> gridCollector(collector);
+
+    for (uint32 cellId : moverCells)
+    {
+        int32 const moverX = int32(cellId % TOTAL_NUMBER_OF_CELLS_PER_MAP);
+        int32 const moverY = int32(cellId / TOTAL_NUMBER_OF_CELLS_PER_MAP);
+        for (int32 x = std::max(moverX - cellRange, 0); x <= std::min(moverX + cellRange, int32(TOTAL_NUMBER_OF_CELLS_PER_MAP) - 1); ++x)
+        {
+            for (int32 y = std::max(moverY - cellRange, 0); y <= std::min(moverY + cellRange, int32(TOTAL_NUMBER_OF_CELLS_PER_MAP) - 1); ++y)
+            {
+                uint32 const id = uint32(y) * TOTAL_NUMBER_OF_CELLS_PER_MAP + uint32(x);
+                if (visitedCells[id])
+                    continue;
+
+                visitedCells[id] = true;
+
+                CellCoord pair(x, y);
+                Cell cell(pair);
+                cell.SetNoCreate();
+                i_map.Visit(cell, worldCollector);
+                i_map.Visit(cell, gridCollector);
+            }
+        }
+    }
+
+    creatures.Build();
+    wideCreatures.Build();
+    players.Build();
+
+    for (Creature* mover : movers)
+    {
+        if (!mover->IsInWorld())
+            continue;
+
+        float const x = mover->GetPositionX();
+        float const y = mover->GetPositionY();
+        float const reach = mover->GetCombatReach();
+
+        players.VisitInRange(x, y, MAX_VISIBILITY_DISTANCE + reach + collector.i_playerReach, [mover](Player* player)
+        {
+            if (!player->IsInWorld())
+                return;
+
+            if (!player->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+                player->UpdateVisibilityOf(mover);
+            else
+                player->DeferVisibilityUpdateOf(mover);
+
+            CreatureUnitRelocationWorker(mover, player);
+        });
+
+        if (!mover->IsAlive())
+            continue;
+
+        auto relocateCreature = [mover](Creature* c)
+        {
+            if (!c->IsInWorld())
+                return;
+
+            CreatureUnitRelocationWorker(mover, c);
+
+            if (!c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+                CreatureUnitRelocationWorker(c, mover);
+        };
+
+        float const moverSight = std::min(std::max(mover->m_SightDistance, sightRange), MAX_VISIBILITY_DISTANCE);
+        creatures.VisitInRange(x, y, moverSight + reach + collector.i_creatureReach, relocateCreature);
+        wideCreatures.VisitInRange(x, y, MAX_VISIBILITY_DISTANCE + reach + collector.i_wideCreatureReach, relocateCreature);
     }
 }
 
@@ -252,22 +472,9 @@ void AIRelocationNotifier::Visit(CreatureMapType &m)
 
 void MessageDistDeliverer::Visit(PlayerMapType &m)
 {
-    for (PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        Player* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (required3dDist)
-        {
-            if (target->GetExactDistSq(i_source) > i_distSq)
-                continue;
-        }
-        else
-        {
-            if (target->GetExactDist2dSq(i_source) > i_distSq)
-                continue;
-        }
+        Player* target = static_cast<Player*>(object);
 
         // Send packet to all who are sharing the player's vision
         if (target->HasSharedVision())
@@ -280,27 +487,16 @@ void MessageDistDeliverer::Visit(PlayerMapType &m)
 
         if (target->m_seer == target || target->GetVehicle())
             SendPacket(target);
-    }
+
+        return true;
+    });
 }
 
 void MessageDistDeliverer::Visit(CreatureMapType &m)
 {
-    for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        Creature* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (required3dDist)
-        {
-            if (target->GetExactDistSq(i_source) > i_distSq)
-                continue;
-        }
-        else
-        {
-            if (target->GetExactDist2dSq(i_source) > i_distSq)
-                continue;
-        }
+        Creature* target = static_cast<Creature*>(object);
 
         // Send packet to all who are sharing the creature's vision
         if (target->HasSharedVision())
@@ -310,27 +506,16 @@ void MessageDistDeliverer::Visit(CreatureMapType &m)
                 if ((*i)->m_seer == target)
                     SendPacket(*i);
         }
-    }
+
+        return true;
+    });
 }
 
 void MessageDistDeliverer::Visit(DynamicObjectMapType &m)
 {
-    for (DynamicObjectMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        DynamicObject* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (required3dDist)
-        {
-            if (target->GetExactDistSq(i_source) > i_distSq)
-                continue;
-        }
-        else
-        {
-            if (target->GetExactDist2dSq(i_source) > i_distSq)
-                continue;
-        }
+        DynamicObject* target = static_cast<DynamicObject*>(object);
 
         if (Unit* caster = target->GetCaster())
         {
@@ -339,19 +524,16 @@ void MessageDistDeliverer::Visit(DynamicObjectMapType &m)
             if (player && player->m_seer == target)
                 SendPacket(player);
         }
-    }
+
+        return true;
+    });
 }
 
 void MessageDistDelivererToHostile::Visit(PlayerMapType &m)
 {
-    for (PlayerMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        Player* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        Player* target = static_cast<Player*>(object);
 
         // Send packet to all who are sharing the player's vision
         if (target->HasSharedVision())
@@ -364,19 +546,16 @@ void MessageDistDelivererToHostile::Visit(PlayerMapType &m)
 
         if (target->m_seer == target || target->GetVehicle())
             SendPacket(target);
-    }
+
+        return true;
+    });
 }
 
 void MessageDistDelivererToHostile::Visit(CreatureMapType &m)
 {
-    for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        Creature* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        Creature* target = static_cast<Creature*>(object);
 
         // Send packet to all who are sharing the creature's vision
         if (target->HasSharedVision())
@@ -386,19 +565,16 @@ void MessageDistDelivererToHostile::Visit(CreatureMapType &m)
                 if ((*i)->m_seer == target)
                     SendPacket(*i);
         }
-    }
+
+        return true;
+    });
 }
 
 void MessageDistDelivererToHostile::Visit(DynamicObjectMapType &m)
 {
-    for (DynamicObjectMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+    m.GetPositions().VisitInRange(i_query, [this](WorldObject* object)
     {
-        DynamicObject* target = iter->GetSource();
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        DynamicObject* target = static_cast<DynamicObject*>(object);
 
         if (Unit* caster = target->GetCaster())
         {
@@ -407,7 +583,9 @@ void MessageDistDelivererToHostile::Visit(DynamicObjectMapType &m)
             if (player && player->m_seer == target)
                 SendPacket(player);
         }
-    }
+
+        return true;
+    });
 }
 
 /*
@@ -23,6 +23,7 @@
 #include "CreatureAI.h"
 #include "DynamicObject.h"
 #include "GameObject.h"
+#include "GridDistanceFilter.h"
 #include "Group.h"
 #include "Player.h"
 #include "Spell.h"
@@ -47,9 +48,15 @@ namespace Trinity
         UpdateData i_data;
         std::set<Unit*> i_visibleNow;
         GuidUnorderedSet vis_guids;
+        float i_visibilityMargin;
+        float i_visibilityRange;
+        uint32 i_checked;
+        uint32 i_skipped;
 
-        VisibleNotifier(Player &player) : i_player(player), vis_guids(player.m_clientGUIDs) { }
+        // a negative margin checks every object, see Player::GetVisibilityUpdateMargin
+        VisibleNotifier(Player &player, float visibilityMargin = -1.0f);
         template<class T> void Visit(GridRefManager<T> &m);
+        bool IsVisibilityUnchanged(WorldObject const* target);
         void SendToSelf(void);
     };
 
@@ -66,7 +73,7 @@ namespace Trinity
 
     struct TC_GAME_API PlayerRelocationNotifier : public VisibleNotifier
     {
-        PlayerRelocationNotifier(Player &player) : VisibleNotifier(player) { }
+        PlayerRelocationNotifier(Player &player, float visibilityMargin = -1.0f) : VisibleNotifier(player, visibilityMargin) { }
 
         template<class T> void Visit(GridRefManager<T> &m) { VisibleNotifier::Visit(m); }
         void Visit(CreatureMapType &);
@@ -82,14 +89,29 @@ namespace Trinity
         void Visit(PlayerMapType &);
     };
 
+    // Collects the creatures waiting for a delayed relocation and notifies their surroundings in a single pass
+    // once there are at least minMovers of them, fewer are notified one by one as building the hashes costs more
+    struct TC_GAME_API CreatureRelocationBatch
+    {
+        Map &i_map;
+        std::size_t i_minMovers;
+        std::vector<Creature*> i_movers;
+
+        CreatureRelocationBatch(Map &map, std::size_t minMovers) : i_map(map), i_minMovers(minMovers) { }
+        void Process();
+    };
+
     struct TC_GAME_API DelayedUnitRelocation
     {
         Map &i_map;
         Cell &cell;
         CellCoord &p;
         const float i_radius;
-        DelayedUnitRelocation(Cell &c, CellCoord &pair, Map &map, float radius) :
-            i_map(map), cell(c), p(pair), i_radius(radius) { }
+        CreatureRelocationBatch* i_batch;
+        uint32 i_visibilityChecked;
+        uint32 i_visibilitySkipped;
+        DelayedUnitRelocation(Cell &c, CellCoord &pair, Map &map, float radius, CreatureRelocationBatch* batch = nullptr) :
+            i_map(map), cell(c), p(pair), i_radius(radius), i_batch(batch), i_visibilityChecked(0), i_visibilitySkipped(0) { }
         template<class T> void Visit(GridRefManager<T> &) { }
         void Visit(CreatureMapType &);
         void Visit(PlayerMapType   &);
@@ -127,17 +149,26 @@ namespace Trinity
     {
         WorldObject const* i_source;
         WorldPacket const* i_message;
+        std::shared_ptr<WorldPacket const> i_sharedMessage;     // copy of i_message queued by every receiver
         uint32 i_phaseMask;
         float i_distSq;
         uint32 team;
         Player const* skipped_receiver;
         bool required3dDist;
+        GridDistanceQuery i_query;
         MessageDistDeliverer(WorldObject const* src, WorldPacket const* msg, float dist, bool own_team_only = false, Player const* skipped = nullptr, bool req3dDist = false)
             : i_source(src), i_message(msg), i_phaseMask(src->GetPhaseMask()), i_distSq(dist * dist)
             , team(0)
             , skipped_receiver(skipped)
             , required3dDist(req3dDist)
         {
+            i_query.X = src->GetPositionX();
+            i_query.Y = src->GetPositionY();
+            i_query.Z = src->GetPositionZ();
+            i_query.Range = dist;
+            i_query.Is3D = req3dDist;
+            i_query.PhaseMask = i_phaseMask;
+
             if (own_team_only)
                 if (Player const* player = src->ToPlayer())
                     team = player->GetTeam();
@@ -157,7 +188,10 @@ namespace Trinity
             if (!player->HaveAtClient(i_source))
                 return;
 
-            player->SendDirectMessage(i_message);
+            if (!i_sharedMessage)
+                i_sharedMessage = MakeSharedWorldPacket(*i_message);
+
+            player->SendDirectMessage(i_sharedMessage);
         }
     };
 
@@ -165,12 +199,20 @@ namespace Trinity
     {
         Unit* i_source;
         WorldPacket const* i_message;
+        std::shared_ptr<WorldPacket const> i_sharedMessage;     // copy of i_message queued by every receiver
         uint32 i_phaseMask;
         float i_distSq;
+        GridDistanceQuery i_query;
 
         MessageDistDelivererToHostile(Unit* src, WorldPacket const* msg, float dist)
             : i_source(src), i_message(msg), i_phaseMask(src->GetPhaseMask()), i_distSq(dist * dist)
         {
+            i_query.X = src->GetPositionX();
+            i_query.Y = src->GetPositionY();
+            i_query.Z = src->GetPositionZ();
+            i_query.Range = dist;
+            i_query.Is3D = false;
+            i_query.PhaseMask = i_phaseMask;
         }
 
         void Visit(PlayerMapType &m);
@@ -184,7 +226,10 @@ namespace Trinity
             if (player == i_source || !player->HaveAtClient(i_source) || player->IsFriendlyTo(i_source))
                 return;
 
-            player->SendDirectMessage(i_message);
+            if (!i_sharedMessage)
+                i_sharedMessage = MakeSharedWorldPacket(*i_message);
+
+            player->SendDirectMessage(i_sharedMessage);
         }
     };
 
@@ -199,6 +244,50 @@ namespace Trinity
 
     // SEARCHERS & LIST SEARCHERS & WORKERS
 
+    // Checks can provide "bool GetDistanceQuery(GridDistanceQuery&) const" describing a range every accepted object
+    // lies in; searchers then reject candidates on the packed cell positions, several at once, before calling them.
+    // Returning false calls the check for every object of the cell.
+    template<class Check, class = void>
+    struct HasDistanceQuery : std::false_type { };
+
+    template<class Check>
+    struct HasDistanceQuery<Check, std::void_t<decltype(std::declval<Check const&>().GetDistanceQuery(std::declval<GridDistanceQuery&>()))>> : std::true_type { };
+
+    // Query for checks requiring center->IsWithinDist(target, range, is3D) or IsWithinDistInMap
+    inline bool BuildDistanceQuery(WorldObject const* center, float range, bool is3D, uint32 phaseMask, GridDistanceQuery& query)
+    {
+        // same transport distances use transport offsets and gameobjects their model bounds, see _IsWithinDist overrides
+        if (center->GetTransport() || center->GetTypeId() == TYPEID_GAMEOBJECT)
+            return false;
+
+        query.X = center->GetPositionX();
+        query.Y = center->GetPositionY();
+        query.Z = center->GetPositionZ();
+        // a little slack so float rounding never rejects an object the check accepts
+        query.Range = range + center->GetCombatReach() + 0.01f;
+        query.Is3D = is3D;
+        query.AddTargetReach = true;
+        query.PhaseMask = phaseMask;
+        return true;
+    }
+
+    template<class Check, class Worker>
+    void VisitCandidates(GridPositionStore& positions, uint32 phaseMask, Check const& check, Worker&& worker)
+    {
+        if constexpr (HasDistanceQuery<Check>::value)
+        {
+            GridDistanceQuery query;
+            if (check.GetDistanceQuery(query))
+            {
+                query.PhaseMask &= phaseMask;
+                positions.VisitInRange(query, worker);
+                return;
+            }
+        }
+
+        positions.VisitInPhase(phaseMask, worker);
+    }
+
     // WorldObject searchers & workers
     enum class WorldObjectSearcherContinuation
     {
@@ -327,9 +416,11 @@ namespace Trinity
         {
             if (!(i_mapTypeMask & GridMapTypeMaskForType<T>::value))
                 return;
-            for (auto itr = m.begin(); itr != m.end(); ++itr)
-                if (itr->GetSource()->InSamePhase(i_phaseMask))
-                    i_do(itr->GetSource());
+            m.GetPositions().VisitInPhase(i_phaseMask, [this](WorldObject* object)
+            {
+                i_do(static_cast<T*>(object));
+                return true;
+            });
         }
     };
 
@@ -381,9 +472,11 @@ namespace Trinity
 
         void Visit(GameObjectMapType& m)
         {
-            for (GameObjectMapType::iterator itr = m.begin(); itr != m.end(); ++itr)
-                if (itr->GetSource()->InSamePhase(_phaseMask))
-                    _func(itr->GetSource());
+            m.GetPositions().VisitInPhase(_phaseMask, [this](WorldObject* object)
+            {
+                _func(static_cast<GameObject*>(object));
+                return true;
+            });
         }
 
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) { }
@@ -490,9 +583,11 @@ namespace Trinity
 
         void Visit(CreatureMapType &m)
         {
-            for (CreatureMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                if (itr->GetSource()->InSamePhase(i_phaseMask))
-                    i_do(itr->GetSource());
+            m.GetPositions().VisitInPhase(i_phaseMask, [this](WorldObject* object)
+            {
+                i_do(static_cast<Creature*>(object));
+                return true;
+            });
         }
 
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) { }
@@ -552,9 +647,11 @@ namespace Trinity
 
         void Visit(PlayerMapType &m)
         {
-            for (PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                if (itr->GetSource()->InSamePhase(i_phaseMask))
-                    i_do(itr->GetSource());
+            m.GetPositions().VisitInPhase(i_phaseMask, [this](WorldObject* object)
+            {
+                i_do(static_cast<Player*>(object));
+                return true;
+            });
         }
 
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) { }
@@ -572,9 +669,13 @@ namespace Trinity
 
         void Visit(PlayerMapType &m)
         {
-            for (PlayerMapType::iterator itr=m.begin(); itr != m.end(); ++itr)
-                if (itr->GetSource()->InSamePhase(i_searcher) && itr->GetSource()->IsWithinDist(i_searcher, i_dist))
-                    i_do(itr->GetSource());
+            m.GetPositions().VisitInPhase(i_searcher->GetPhaseMask(), [this](WorldObject* object)
+            {
+                Player* target = static_cast<Player*>(object);
+                if (target->IsWithinDist(i_searcher, i_dist))
+                    i_do(target);
+                return true;
+            });
         }
 
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) { }
@@ -725,6 +826,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(&i_obj, i_range, true, i_obj.GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const& i_obj;
             float i_range;
@@ -749,6 +855,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(&i_obj, i_range, true, i_obj.GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const& i_obj;
             uint32 i_entry;
@@ -775,6 +886,11 @@ namespace Trinity
             return false;
         }
 
+        bool GetDistanceQuery(GridDistanceQuery& query) const
+        {
+            return BuildDistanceQuery(&i_obj, i_range, true, i_obj.GetPhaseMask(), query);
+        }
+
     private:
         WorldObject const& i_obj;
         uint32 i_entry;
@@ -800,6 +916,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(&i_obj, i_range, true, i_obj.GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const& i_obj;
             GameobjectTypes i_type;
@@ -826,6 +947,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             Unit const* i_obj;
             float i_range;
@@ -932,6 +1058,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             Unit const* i_obj;
             float i_range;
@@ -950,6 +1081,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             Unit const* i_obj;
             float i_range;
@@ -969,6 +1105,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* i_obj;
             Unit const* i_funit;
@@ -1001,6 +1142,11 @@ namespace Trinity
                 return true;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* i_obj;
             float i_range;
@@ -1098,6 +1244,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* i_obj;
             float i_range;
@@ -1121,6 +1272,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* i_obj;
             Unit const* i_funit;
@@ -1225,6 +1381,11 @@ namespace Trinity
                 return true;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(me, m_range, true, me->GetPhaseMask(), query);
+            }
+
         private:
             Creature const* me;
             float m_range;
@@ -1261,6 +1422,11 @@ namespace Trinity
                 return true;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(me, m_range, true, me->GetPhaseMask(), query);
+            }
+
         private:
             Creature const* me;
             float m_range;
@@ -1390,6 +1556,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(&i_obj, i_range, true, i_obj.GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const& i_obj;
             uint32 i_entry;
@@ -1524,6 +1695,11 @@ namespace Trinity
                 return true;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(_obj, _range, true, _obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* _obj;
             float _range;
@@ -1566,6 +1742,12 @@ namespace Trinity
 
                 return false;
             }
+
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(i_obj, i_range, true, i_obj->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* i_obj;
             float i_range;
@@ -1603,6 +1785,11 @@ namespace Trinity
                 return false;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(m_pObject, m_fRange, false, PHASEMASK_ANYWHERE, query);
+            }
+
         private:
             WorldObject const* m_pObject;
             uint32 m_uiEntry;
@@ -1633,6 +1820,11 @@ namespace Trinity
                 return true;
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return m_fRange > 0.0f && BuildDistanceQuery(m_pObject, m_fRange, false, PHASEMASK_ANYWHERE, query);
+            }
+
         private:
             WorldObject const* m_pObject;
             uint32 m_uiEntry;
@@ -1686,6 +1878,11 @@ namespace Trinity
                 return m_pObject->IsWithinDist(go, m_fRange, false) && m_pObject->InSamePhase(go);
             }
 
+            bool GetDistanceQuery(GridDistanceQuery& query) const
+            {
+                return BuildDistanceQuery(m_pObject, m_fRange, false, m_pObject->GetPhaseMask(), query);
+            }
+
         private:
             WorldObject const* m_pObject;
             float m_fRange;
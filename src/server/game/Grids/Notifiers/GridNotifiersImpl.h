@@ -33,7 +33,8 @@ inline void Trinity::VisibleNotifier::Visit(GridRefManager<T> &m)
     for (typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
         vis_guids.erase(iter->GetSource()->GetGUID());
-        i_player.UpdateVisibilityOf(iter->GetSource(), i_data, i_visibleNow);
+        if (!IsVisibilityUnchanged(iter->GetSource()))
+            i_player.UpdateVisibilityOf(iter->GetSource(), i_data, i_visibleNow);
     }
 }
 
@@ -51,16 +52,29 @@ void Trinity::WorldObjectSearcherBase<Check, Result>::Visit(GridRefManager<T>& m
     if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
         return;
 
-    for (GridReference<T> const& ref : m)
+    auto visit = [this](T* target)
     {
-        if (i_check(ref.GetSource()))
-        {
-            this->Insert(ref.GetSource());
+        if (!i_check(target))
+            return true;
+
+        this->Insert(target);
+        return this->ShouldContinue() != WorldObjectSearcherContinuation::Return;
+    };
 
-            if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
-                return;
+    // phase is left to the check here, only checks with a distance query go through the packed positions
+    if constexpr (HasDistanceQuery<Check>::value)
+    {
+        GridDistanceQuery query;
+        if (i_check.GetDistanceQuery(query))
+        {
+            m.GetPositions().VisitInRange(query, [&visit](WorldObject* object) { return visit(static_cast<T*>(object)); });
+            return;
         }
     }
+
+    for (GridReference<T> const& ref : m)
+        if (!visit(ref.GetSource()))
+            return;
 }
 
 // Gameobject searchers
@@ -71,19 +85,15 @@ void Trinity::GameObjectSearcherBase<Check, Result>::Visit(GameObjectMapType& m)
     if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
         return;
 
-    for (GridReference<GameObject> const& ref : m)
+    VisitCandidates(m.GetPositions(), i_phaseMask, i_check, [this](WorldObject* object)
     {
-        if (!ref.GetSource()->InSamePhase(i_phaseMask))
-            continue;
-
-        if (i_check(ref.GetSource()))
-        {
-            this->Insert(ref.GetSource());
+        GameObject* target = static_cast<GameObject*>(object);
+        if (!i_check(target))
+            return true;
 
-            if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
-                return;
-        }
-    }
+        this->Insert(target);
+        return this->ShouldContinue() != WorldObjectSearcherContinuation::Return;
+    });
 }
 
 // Unit searchers
@@ -95,19 +105,15 @@ void Trinity::UnitSearcherBase<Check, Result>::VisitImpl(GridRefManager<T>& m)
     if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
         return;
 
-    for (GridReference<T> const& ref : m)
+    VisitCandidates(m.GetPositions(), i_phaseMask, i_check, [this](WorldObject* object)
     {
-        if (!ref.GetSource()->InSamePhase(i_phaseMask))
-            continue;
+        T* target = static_cast<T*>(object);
+        if (!i_check(target))
+            return true;
 
-        if (i_check(ref.GetSource()))
-        {
-            this->Insert(ref.GetSource());
-
-            if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
-                return;
-        }
-    }
+        this->Insert(target);
+        return this->ShouldContinue() != WorldObjectSearcherContinuation::Return;
+    });
 }
 
 // Creature searchers
@@ -118,19 +124,15 @@ void Trinity::CreatureSearcherBase<Check, Result>::Visit(CreatureMapType& m)
     if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
         return;
 
-    for (GridReference<Creature> const& ref : m)
+    VisitCandidates(m.GetPositions(), i_phaseMask, i_check, [this](WorldObject* object)
     {
-        if (!ref.GetSource()->InSamePhase(i_phaseMask))
-            continue;
-
-        if (i_check(ref.GetSource()))
-        {
-            this->Insert(ref.GetSource());
+        Creature* target = static_cast<Creature*>(object);
+        if (!i_check(target))
+            return true;
 
-            if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
-                return;
-        }
-    }
+        this->Insert(target);
+        return this->ShouldContinue() != WorldObjectSearcherContinuation::Return;
+    });
 }
 
 // Player searchers
@@ -141,19 +143,15 @@ void Trinity::PlayerSearcherBase<Check, Result>::Visit(PlayerMapType& m)
     if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
         return;
 
-    for (GridReference<Player> const& ref : m)
+    VisitCandidates(m.GetPositions(), i_phaseMask, i_check, [this](WorldObject* object)
     {
-        if (!ref.GetSource()->InSamePhase(i_phaseMask))
-            continue;
-
-        if (i_check(ref.GetSource()))
-        {
-            this->Insert(ref.GetSource());
+        Player* target = static_cast<Player*>(object);
+        if (!i_check(target))
+            return true;
 
-            if (this->ShouldContinue() == WorldObjectSearcherContinuation::Return)
-                return;
-        }
-    }
+        this->Insert(target);
+        return this->ShouldContinue() != WorldObjectSearcherContinuation::Return;
+    });
 }
 
 template<class Builder>
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_SPATIAL_HASH_H
+#define TRINITY_SPATIAL_HASH_H
+
+#include "Define.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace Trinity
+{
+    /*
+     * Flat 2D spatial hash used to answer many range queries over the same set of points.
+     * Points are stored as a structure of arrays sorted by bucket, so a query only walks
+     * contiguous coordinate arrays and touches the stored values of the points it accepts.
+     * Insert all points, call Build() once, then query.
+     */
+    template<class T>
+    class SpatialHash
+    {
+    public:
+        explicit SpatialHash(float bucketSize) : _bucketSize(bucketSize) { }
+
+        void Reserve(std::size_t count)
+        {
+            _x.reserve(count);
+            _y.reserve(count);
+            _values.reserve(count);
+        }
+
+        void Insert(float x, float y, T const& value)
+        {
+            _x.push_back(x);
+            _y.push_back(y);
+            _values.push_back(value);
+        }
+
+        std::size_t Size() const { return _values.size(); }
+
+        void Build()
+        {
+            std::vector<uint64> keys(_values.size());
+            for (std::size_t i = 0; i < keys.size(); ++i)
+                keys[i] = MakeKey(GetBucket(_x[i]), GetBucket(_y[i]));
+
+            std::vector<uint32> order(keys.size());
+            std::iota(order.begin(), order.end(), 0u);
+            std::stable_sort(order.begin(), order.end(), [&keys](uint32 left, uint32 right) { return keys[left] < keys[right]; });
+
+            std::vector<float> x(order.size()), y(order.size());
+            std::vector<T> values;
+            values.reserve(order.size());
+            _bucketKeys.clear();
+            _bucketStarts.clear();
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                x[i] = _x[order[i]];
+                y[i] = _y[order[i]];
+                values.push_back(std::move(_values[order[i]]));
+
+                if (_bucketKeys.empty() || _bucketKeys.back() != keys[order[i]])
+                {
+                    _bucketKeys.push_back(keys[order[i]]);
+                    _bucketStarts.push_back(uint32(i));
+                }
+            }
+            _bucketStarts.push_back(uint32(order.size()));
+
+            _x = std::move(x);
+            _y = std::move(y);
+            _values = std::move(values);
+        }
+
+        // calls callback(value) for every point within range (2D) of x, y
+        template<class Callback>
+        void VisitInRange(float x, float y, float range, Callback&& callback) const
+        {
+            float const rangeSq = range * range;
+            int32 const minX = GetBucket(x - range), maxX = GetBucket(x + range);
+            int32 const minY = GetBucket(y - range), maxY = GetBucket(y + range);
+
+            for (int32 bucketX = minX; bucketX <= maxX; ++bucketX)
+            {
+                for (int32 bucketY = minY; bucketY <= maxY; ++bucketY)
+                {
+                    auto itr = std::lower_bound(_bucketKeys.begin(), _bucketKeys.end(), MakeKey(bucketX, bucketY));
+                    if (itr == _bucketKeys.end() || *itr != MakeKey(bucketX, bucketY))
+                        continue;
+
+                    std::size_t bucket = std::distance(_bucketKeys.begin(), itr);
+                    VisitBucket(_bucketStarts[bucket], _bucketStarts[bucket + 1], x, y, rangeSq, callback);
+                }
+            }
+        }
+
+    private:
+        int32 GetBucket(float coord) const { return int32(std::floor(coord / _bucketSize)); }
+        static uint64 MakeKey(int32 x, int32 y) { return (uint64(uint32(x)) << 32) | uint32(y); }
+
+        template<class Callback>
+        void VisitBucket(uint32 begin, uint32 end, float x, float y, float rangeSq, Callback& callback) const
+        {
+            // distances of a block are computed without branches so the compiler can vectorize them
+            uint32 i = begin;
+            for (; i + 8 <= end; i += 8)
+            {
+                uint32 mask = 0;
+                for (uint32 j = 0; j < 8; ++j)
+                {
+                    float dx = _x[i + j] - x;
+                    float dy = _y[i + j] - y;
+                    mask |= uint32(dx * dx + dy * dy <= rangeSq) << j;
+                }
+
+                for (uint32 j = 0; mask; ++j, mask >>= 1)
+                    if (mask & 1)
+                        callback(_values[i + j]);
+            }
+
+            for (; i < end; ++i)
+            {
+                float dx = _x[i] - x;
+                float dy = _y[i] - y;
+                if (dx * dx + dy * dy <= rangeSq)
+                    callback(_values[i]);
+            }
+        }
+
+        float _bucketSize;
+        std::vector<float> _x;
+        std::vector<float> _y;
+        std::vector<T> _values;
+        std::vector<uint64> _bucketKeys;
+        std::vector<uint32> _bucketStarts;
+    };
+}
+
+#endif // TRINITY_SPATIAL_HASH_H
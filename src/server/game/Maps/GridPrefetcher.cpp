@@ -0,0 +1,274 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GridPrefetcher.h"
+#include "DisableMgr.h"
+#include "Log.h"
+#include "Map.h"
+#include "MapManager.h"
+#include "MapReference.h"
+#include "Metric.h"
+#include "MoveSpline.h"
+#include "Player.h"
+#include "StringFormat.h"
+#include "ThreadPool.h"
+#include "VMapFactory.h"
+#include "VMapManager2.h"
+#include "World.h"
+#include <algorithm>
+
+namespace
+{
+    // predicted paths are checked every half grid, grids are larger than any visibility range
+    constexpr float SampleDistance = SIZE_OF_GRIDS / 2;
+    // players moving slower than this (yards per second) are considered standing
+    constexpr float MinPredictedSpeed = 1.0f;
+    constexpr uint32 UpdateInterval = 500;
+}
+
+PrefetchedGridTerrain::PrefetchedGridTerrain() : TerrainLoaded(false) { }
+
+PrefetchedGridTerrain::~PrefetchedGridTerrain()
+{
+    if (!Models.empty())
+        VMAP::VMapFactory::createOrGetVMapManager()->releaseModelInstances(Models);
+}
+
+GridPrefetcher::GridPrefetcher(Map* map) : _map(map), _dataPath(sWorld->GetDataPath())
+{
+    _updateTimer.SetInterval(UpdateInterval);
+}
+
+GridPrefetcher::~GridPrefetcher()
+{
+    // jobs write into the requests, they must be done before these go away
+    std::lock_guard<std::mutex> lock(_lock);
+    for (std::pair<uint32 const, Request>& request : _requests)
+        request.second.Done.wait();
+}
+
+void GridPrefetcher::Update(uint32 diff)
+{
+    _updateTimer.Update(diff);
+    if (!_updateTimer.Passed())
+        return;
+
+    _updateTimer.Reset();
+
+    std::vector<std::pair<uint32, uint32>> grids;
+    PredictGrids(grids);
+
+    TimePoint now = std::chrono::steady_clock::now();
+    Milliseconds cacheTimeout(sWorld->getIntConfig(CONFIG_GRID_PREFETCH_CACHE_TIMEOUT));
+
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // drop predictions that did not come true
+    std::size_t pending = 0;
+    for (auto itr = _requests.begin(); itr != _requests.end();)
+    {
+        bool done = itr->second.Done.wait_for(Seconds::zero()) == std::future_status::ready;
+        if (done && now - itr->second.RequestTime > cacheTimeout)
+        {
+            TC_METRIC_VALUE("map_grid_prefetch", uint64(1), TC_METRIC_TAG("map_id", std::to_string(_map->GetId())), TC_METRIC_TAG("result", "expired"));
+            itr = _requests.erase(itr);
+            continue;
+        }
+
+        if (!done)
+            ++pending;
+        ++itr;
+    }
+
+    std::size_t maxPending = sWorld->getIntConfig(CONFIG_GRID_PREFETCH_MAX_PENDING);
+    for (std::pair<uint32, uint32> const& grid : grids)
+    {
+        if (pending >= maxPending)
+            break;
+
+        if (_map->GridMaps[grid.first][grid.second] || _requests.count(MakeKey(grid.first, grid.second)))
+            continue;
+
+        RequestGrid(grid.first, grid.second, now);
+        ++pending;
+    }
+}
+
+std::unique_ptr<PrefetchedGridTerrain> GridPrefetcher::Take(uint32 gx, uint32 gy)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    auto itr = _requests.find(MakeKey(gx, gy));
+    if (itr == _requests.end())
+    {
+        TC_METRIC_VALUE("map_grid_prefetch", uint64(1), TC_METRIC_TAG("map_id", std::to_string(_map->GetId())), TC_METRIC_TAG("result", "miss"));
+        return nullptr;
+    }
+
+    Request request = std::move(itr->second);
+    _requests.erase(itr);
+    lock.unlock();
+
+    if (request.Done.wait_for(Seconds::zero()) == std::future_status::ready)
+    {
+        TC_METRIC_VALUE("map_grid_prefetch", uint64(1), TC_METRIC_TAG("map_id", std::to_string(_map->GetId())), TC_METRIC_TAG("result", "hit"));
+    }
+    else
+    {
+        TC_METRIC_VALUE("map_grid_prefetch", uint64(1), TC_METRIC_TAG("map_id", std::to_string(_map->GetId())), TC_METRIC_TAG("result", "late"));
+        request.Done.wait();
+    }
+
+    return std::move(request.Result);
+}
+
+void GridPrefetcher::PredictGrids(std::vector<std::pair<uint32, uint32>>& grids)
+{
+    TimePoint now = std::chrono::steady_clock::now();
+    float lookAhead = float(sWorld->getIntConfig(CONFIG_GRID_PREFETCH_LOOKAHEAD_TIME)) / IN_MILLISECONDS;
+
+    std::unordered_map<ObjectGuid, MovementSample> positions;
+    for (MapReference const& ref : _map->GetPlayers())
+    {
+        Player* player = ref.GetSource();
+        if (!player || !player->IsInWorld())
+            continue;
+
+        float x = player->GetPositionX();
+        float y = player->GetPositionY();
+        positions[player->GetGUID()] = { x, y, now };
+
+        // walks from the last point towards (toX, toY), checking a point every SampleDistance yards
+        float distance = 0.0f;
+        float maxDistance = 0.0f;
+        auto walkTo = [&](float toX, float toY)
+        {
+            float dx = toX - x;
+            float dy = toY - y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            for (float step = SampleDistance; step < length && distance + step <= maxDistance; step += SampleDistance)
+                AddGridsAround(x + dx * step / length, y + dy * step / length, grids);
+
+            if (distance + length > maxDistance)
+            {
+                float partial = std::max(maxDistance - distance, 0.0f) / length;
+                toX = x + dx * partial;
+                toY = y + dy * partial;
+                length = maxDistance - distance;
+            }
+
+            AddGridsAround(toX, toY, grids);
+            distance += length;
+            x = toX;
+            y = toY;
+        };
+
+        if (player->IsInFlight() && player->movespline->Initialized() && !player->movespline->Finalized())
+        {
+            // taxi flights know their path, follow it as far as the player gets in the look ahead time
+            Movement::MoveSpline const* spline = player->movespline;
+            maxDistance = spline->Velocity() * lookAhead;
+            for (int32 i = spline->_currentSplineIdx() + 1; i <= spline->_Spline().last() && distance < maxDistance; ++i)
+                walkTo(spline->_Spline().getPoint(i).x, spline->_Spline().getPoint(i).y);
+        }
+        else
+        {
+            auto last = _lastPositions.find(player->GetGUID());
+            if (last == _lastPositions.end())
+                continue;
+
+            float elapsed = std::chrono::duration<float>(now - last->second.Time).count();
+            if (elapsed <= 0.0f)
+                continue;
+
+            float vx = (x - last->second.X) / elapsed;
+            float vy = (y - last->second.Y) / elapsed;
+            float speed = std::sqrt(vx * vx + vy * vy);
+            if (speed < MinPredictedSpeed)
+                continue;
+
+            // teleports and transport hops are not movement
+            if (speed > std::max(player->GetSpeed(MOVE_RUN), player->GetSpeed(MOVE_FLIGHT)) * 2.0f)
+                continue;
+
+            maxDistance = speed * lookAhead;
+            walkTo(x + vx * lookAhead, y + vy * lookAhead);
+        }
+    }
+
+    _lastPositions.swap(positions);
+}
+
+void GridPrefetcher::AddGridsAround(float x, float y, std::vector<std::pair<uint32, uint32>>& grids) const
+{
+    // everything that can get visible from the predicted position, plus the cell the visit rounds up to
+    float range = _map->GetVisibilityRange() + SIZE_OF_GRID_CELL;
+    float minX = x - range, maxX = x + range;
+    float minY = y - range, maxY = y + range;
+    Trinity::NormalizeMapCoord(minX);
+    Trinity::NormalizeMapCoord(maxX);
+    Trinity::NormalizeMapCoord(minY);
+    Trinity::NormalizeMapCoord(maxY);
+
+    // grid coords grow with world coords, map file coords are mirrored
+    GridCoord low = Trinity::ComputeGridCoord(minX, minY);
+    GridCoord high = Trinity::ComputeGridCoord(maxX, maxY);
+    for (uint32 gridX = low.x_coord; gridX <= high.x_coord; ++gridX)
+    {
+        for (uint32 gridY = low.y_coord; gridY <= high.y_coord; ++gridY)
+        {
+            std::pair<uint32, uint32> grid((MAX_NUMBER_OF_GRIDS - 1) - gridX, (MAX_NUMBER_OF_GRIDS - 1) - gridY);
+            if (std::find(grids.begin(), grids.end(), grid) == grids.end())
+                grids.push_back(grid);
+        }
+    }
+}
+
+void GridPrefetcher::RequestGrid(uint32 gx, uint32 gy, TimePoint now)
+{
+    Trinity::ThreadPool* pool = sMapMgr->GetGridPrefetchPool();
+    if (!pool)
+        return;
+
+    Request& request = _requests[MakeKey(gx, gy)];
+    request.Result = std::make_unique<PrefetchedGridTerrain>();
+    request.RequestTime = now;
+
+    // the job only touches the result and thread safe parts of the terrain managers
+    PrefetchedGridTerrain* result = request.Result.get();
+    std::string dataPath = _dataPath;
+    uint32 mapId = _map->GetId();
+    bool loadMMap = DisableMgr::IsPathfindingEnabled(mapId);
+    auto job = std::make_shared<std::packaged_task<void()>>([result, dataPath, mapId, gx, gy, loadMMap]()
+    {
+        TimePoint start = std::chrono::steady_clock::now();
+
+        std::string fileName = Trinity::StringFormat("{}maps/{:03}{:02}{:02}.map", dataPath, mapId, gx, gy);
+        result->Terrain = std::make_unique<GridMap>();
+        result->TerrainLoaded = result->Terrain->loadData(fileName.c_str());
+
+        result->Models = VMAP::VMapFactory::createOrGetVMapManager()->preloadMapTileModels((dataPath + "vmaps").c_str(), mapId, gx, gy);
+
+        if (loadMMap)
+            MMAP::MMapManager::ReadTile(dataPath, mapId, gx, gy, result->NavMeshTile);
+
+        TC_METRIC_VALUE("map_grid_prefetch_read_time", std::chrono::steady_clock::now() - start, TC_METRIC_TAG("map_id", std::to_string(mapId)));
+    });
+
+    request.Done = job->get_future();
+    pool->PostWork([job]() { (*job)(); });
+}
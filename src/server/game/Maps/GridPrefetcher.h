@@ -0,0 +1,102 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_GRID_PREFETCHER_H
+#define TRINITY_GRID_PREFETCHER_H
+
+#include "Define.h"
+#include "Duration.h"
+#include "MMapManager.h"
+#include "ObjectGuid.h"
+#include "Timer.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GridMap;
+class Map;
+
+// Terrain of one grid read ahead of time, published by Map::LoadMapAndVMap
+struct TC_GAME_API PrefetchedGridTerrain
+{
+    PrefetchedGridTerrain();
+    ~PrefetchedGridTerrain();
+
+    PrefetchedGridTerrain(PrefetchedGridTerrain const&) = delete;
+    PrefetchedGridTerrain& operator=(PrefetchedGridTerrain const&) = delete;
+
+    std::unique_ptr<GridMap> Terrain;
+    bool TerrainLoaded;
+    std::vector<std::string> Models;            // vmap models acquired for the tile, released with this object
+    MMAP::MMapTileData NavMeshTile;
+};
+
+/*
+ * Predicts the grids players of a continent are about to enter (flight paths and the
+ * movement of the last update interval) and reads their terrain, vmap models and
+ * navmesh tile on a worker pool. Only file reading and decoding happens there,
+ * creating the grid, spawning its objects and inserting vmap and mmap data stays
+ * on the map update thread.
+ */
+class TC_GAME_API GridPrefetcher
+{
+public:
+    explicit GridPrefetcher(Map* map);
+    ~GridPrefetcher();
+
+    GridPrefetcher(GridPrefetcher const&) = delete;
+    GridPrefetcher& operator=(GridPrefetcher const&) = delete;
+
+    void Update(uint32 diff);
+
+    // Prefetched terrain of grid [gx, gy] (file coordinates), waits when it is still being read.
+    // Returns nullptr when the grid was not predicted
+    std::unique_ptr<PrefetchedGridTerrain> Take(uint32 gx, uint32 gy);
+
+private:
+    struct Request
+    {
+        std::unique_ptr<PrefetchedGridTerrain> Result;
+        std::future<void> Done;
+        TimePoint RequestTime;
+    };
+
+    struct MovementSample
+    {
+        float X;
+        float Y;
+        TimePoint Time;
+    };
+
+    void PredictGrids(std::vector<std::pair<uint32, uint32>>& grids);
+    void AddGridsAround(float x, float y, std::vector<std::pair<uint32, uint32>>& grids) const;
+    void RequestGrid(uint32 gx, uint32 gy, TimePoint now);
+
+    static uint32 MakeKey(uint32 gx, uint32 gy) { return gx << 16 | gy; }
+
+    Map* _map;
+    std::string _dataPath;
+    IntervalTimer _updateTimer;
+    std::mutex _lock;
+    std::unordered_map<uint32, Request> _requests;
+    std::unordered_map<ObjectGuid, MovementSample> _lastPositions;
+};
+
+#endif // TRINITY_GRID_PREFETCHER_H
@@ -27,11 +27,13 @@
 #include "GridNotifiers.h"
 #include "GridNotifiersImpl.h"
 #include "GridStates.h"
+#include "GridPrefetcher.h"
 #include "Group.h"
 #include "InstanceScript.h"
 #include "Log.h"
 #include "MapInstanced.h"
 #include "MapManager.h"
+#include "MapRegionPartitioner.h"
 #include "Metric.h"
 #include "MiscPackets.h"
 #include "MMapFactory.h"
@@ -41,7 +43,10 @@
 #include "ObjectMgr.h"
 #include "Pet.h"
 #include "PoolMgr.h"
+#include "ScopeProfiler.h"
 #include "ScriptMgr.h"
+#include "TerrainFileStore.h"
+#include "ThreadPool.h"
 #include "Transport.h"
 #include "Vehicle.h"
 #include "VMapFactory.h"
@@ -55,6 +60,7 @@
 #include "WeatherMgr.h"
 #include "World.h"
 #include <boost/heap/fibonacci_heap.hpp>
+#include <condition_variable>
 #include <unordered_set>
 #include <vector>
 
@@ -112,8 +118,6 @@ Map::~Map()
 
     if (!m_scriptSchedule.empty())
         sMapMgr->DecreaseScheduledScriptCount(m_scriptSchedule.size());
-
-    MMAP::MMapFactory::createOrGetMMapManager()->unloadMapInstance(GetId(), i_InstanceId);
 }
 
 bool Map::ExistMap(uint32 mapid, int gx, int gy)
@@ -172,12 +176,12 @@ bool Map::ExistVMap(uint32 mapid, int gx, int gy)
     return true;
 }
 
-void Map::LoadMMap(int gx, int gy)
+void Map::LoadMMap(int gx, int gy, MMAP::MMapTileData* preloaded /*= nullptr*/)
 {
     if (!DisableMgr::IsPathfindingEnabled(GetId()))
         return;
 
-    bool mmapLoadResult = MMAP::MMapFactory::createOrGetMMapManager()->loadMap(sWorld->GetDataPath(), GetId(), gx, gy);
+    bool mmapLoadResult = MMAP::MMapFactory::createOrGetMMapManager()->loadMap(sWorld->GetDataPath(), GetId(), gx, gy, preloaded);
 
     if (mmapLoadResult)
         TC_LOG_DEBUG("mmaps.tiles", "MMAP loaded name:{}, id:{}, x:{}, y:{} (mmap rep.: x:{}, y:{})", GetMapName(), GetId(), gx, gy, gx, gy);
@@ -205,7 +209,7 @@ void Map::LoadVMap(int gx, int gy)
     }
 }
 
-void Map::LoadMap(int gx, int gy, bool reload)
+void Map::LoadMap(int gx, int gy, bool reload, PrefetchedGridTerrain* prefetched /*= nullptr*/)
 {
     if (i_InstanceId != 0)
     {
@@ -237,22 +241,38 @@ void Map::LoadMap(int gx, int gy, bool reload)
     // map file name
     std::string fileName = Trinity::StringFormat("{}maps/{:03}{:02}{:02}.map", sWorld->GetDataPath(), GetId(), gx, gy);
     TC_LOG_DEBUG("maps", "Loading map {}", fileName);
-    // loading data
-    GridMaps[gx][gy] = new GridMap();
-    if (!GridMaps[gx][gy]->loadData(fileName.c_str()))
-        TC_LOG_ERROR("maps", "Error loading map file: \n {}\n", fileName);
+    // loading data, the prefetcher may have read it already
+    if (prefetched && prefetched->Terrain)
+    {
+        GridMaps[gx][gy] = prefetched->Terrain.release();
+        if (!prefetched->TerrainLoaded)
+            TC_LOG_ERROR("maps", "Error loading map file: \n {}\n", fileName);
+    }
+    else
+    {
+        GridMaps[gx][gy] = new GridMap();
+        if (!GridMaps[gx][gy]->loadData(fileName.c_str()))
+            TC_LOG_ERROR("maps", "Error loading map file: \n {}\n", fileName);
+    }
 
     sScriptMgr->OnLoadGridMap(this, GridMaps[gx][gy], gx, gy);
 }
 
 void Map::LoadMapAndVMap(int gx, int gy)
 {
-    LoadMap(gx, gy);
+    std::unique_ptr<PrefetchedGridTerrain> prefetched;
+    TC_METRIC_TIMER("map_grid_terrain_load_time", TC_METRIC_TAG("map_id", std::to_string(GetId())), TC_METRIC_TAG("prefetched", prefetched ? "true" : "false"));
+
+    if (_gridPrefetcher)
+        prefetched = _gridPrefetcher->Take(gx, gy);
+
+    LoadMap(gx, gy, false, prefetched.get());
    // Only load the data for the base map
     if (i_InstanceId == 0)
     {
+        // prefetched vmap models are already loaded, only the tile is inserted into the tree
         LoadVMap(gx, gy);
-        LoadMMap(gx, gy);
+        LoadMMap(gx, gy, prefetched ? &prefetched->NavMeshTile : nullptr);
     }
 }
 
@@ -281,6 +301,7 @@ void Map::DeleteStateMachine()
 
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode, Map* _parent):
 _creatureToMoveLock(false), _gameObjectsToMoveLock(false), _dynamicObjectsToMoveLock(false),
+_parallelRegionGuardBand(0.0f),
 i_mapEntry(sMapStore.LookupEntry(id)), i_spawnMode(SpawnMode), i_InstanceId(InstanceId),
 m_unloadTimer(0), m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE),
 m_VisibilityNotifyPeriod(DEFAULT_VISIBILITY_NOTIFY_PERIOD),
@@ -314,7 +335,10 @@ i_scriptLock(false), _respawnTimes(std::make_unique<RespawnListContainer>()), _r
 
     _weatherUpdateTimer.SetInterval(time_t(1 * IN_MILLISECONDS));
 
-    MMAP::MMapFactory::createOrGetMMapManager()->loadMapInstance(sWorld->GetDataPath(), GetId(), GetInstanceId());
+    if (sWorld->getBoolConfig(CONFIG_GRID_PREFETCH) && !Instanceable())
+        _gridPrefetcher = std::make_unique<GridPrefetcher>(this);
+
+    MMAP::MMapFactory::createOrGetMMapManager()->loadMapData(sWorld->GetDataPath(), GetId());
 }
 
 void Map::InitVisibilityDistance()
@@ -534,6 +558,8 @@ void Map::EnsureGridCreated_i(GridCoord const& p)
 //Load NGrid and make it active
 void Map::EnsureGridLoadedForActiveObject(Cell const& cell, WorldObject* object)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     EnsureGridLoaded(cell);
     NGridType *grid = getNGrid(cell.GridX(), cell.GridY());
     ASSERT(grid != nullptr);
@@ -550,6 +576,8 @@ void Map::EnsureGridLoadedForActiveObject(Cell const& cell, WorldObject* object)
 //Create NGrid and load the object data in it
 bool Map::EnsureGridLoaded(Cell const& cell)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     EnsureGridCreated(GridCoord(cell.GridX(), cell.GridY()));
     NGridType *grid = getNGrid(cell.GridX(), cell.GridY());
 
@@ -647,6 +675,8 @@ void Map::InitializeObject(GameObject* obj)
 template<class T>
 bool Map::AddToMap(T* obj)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     /// @todo Needs clean up. An object should not be added to map twice.
     if (obj->IsInWorld())
     {
@@ -734,6 +764,21 @@ bool Map::IsGridLoaded(GridCoord const& p) const
 }
 
 void Map::VisitNearbyCellsOf(WorldObject* obj, TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer> &gridVisitor, TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer> &worldVisitor)
+{
+    VisitNearbyCellsOf(obj, gridVisitor, worldVisitor, [this](uint32 cellId)
+    {
+        // marked cells are those that have been visited
+        // don't visit the same cell twice
+        if (isCellMarked(cellId))
+            return false;
+
+        markCell(cellId);
+        return true;
+    });
+}
+
+template<class CellMarker>
+void Map::VisitNearbyCellsOf(WorldObject* obj, TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer>& gridVisitor, TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer>& worldVisitor, CellMarker&& markCell)
 {
     // Check for valid position
     if (!obj->IsPositionValid())
@@ -746,13 +791,10 @@ void Map::VisitNearbyCellsOf(WorldObject* obj, TypeContainerVisitor<Trinity::Obj
     {
         for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
         {
-            // marked cells are those that have been visited
-            // don't visit the same cell twice
             uint32 cell_id = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
-            if (isCellMarked(cell_id))
+            if (!markCell(cell_id))
                 continue;
 
-            markCell(cell_id);
             CellCoord pair(x, y);
             Cell cell(pair);
             cell.SetNoCreate();
@@ -768,6 +810,7 @@ void Map::UpdatePlayerZoneStats(uint32 oldZone, uint32 newZone)
     if (oldZone == newZone)
         return;
 
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
     if (oldZone != MAP_INVALID_ZONE)
     {
         uint32& oldZoneCount = _zonePlayerCountMap[oldZone];
@@ -779,7 +822,14 @@ void Map::UpdatePlayerZoneStats(uint32 oldZone, uint32 newZone)
 
 void Map::Update(uint32 t_diff)
 {
+    ScopeProfiler::Scope profileScope(ScopeProfiler::SCOPE_ROOT, nullptr, "Map::Update");
+    ScopeProfiler::Scope profileMapScope(ScopeProfiler::SCOPE_NESTED, nullptr, GetMapName());
+
     _dynamicTree.update(t_diff);
+
+    if (_gridPrefetcher)
+        _gridPrefetcher->Update(t_diff);
+
     /// update worldsessions for existing players
     for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
     {
@@ -811,58 +861,29 @@ void Map::Update(uint32 t_diff)
     // for pets
     TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer > world_object_update(updater);
 
-    // the player iterator is stored in the map object
-    // to make sure calls to Map::Remove don't invalidate it
-    for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
+    if (!UpdateRegionsInParallel(t_diff))
     {
-        Player* player = m_mapRefIter->GetSource();
+        // the player iterator is stored in the map object
+        // to make sure calls to Map::Remove don't invalidate it
+        for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
+        {
+            Player* player = m_mapRefIter->GetSource();
 
-        if (!player || !player->IsInWorld())
-            continue;
+            if (!player || !player->IsInWorld())
+                continue;
 
-        // update players at tick
-        player->Update(t_diff);
+            // update players at tick
+            player->Update(t_diff);
 
-        VisitNearbyCellsOf(player, grid_object_update, world_object_update);
+            VisitNearbyCellsOf(player, grid_object_update, world_object_update);
 
-        // If player is using far sight or mind vision, visit that object too
-        if (WorldObject* viewPoint = player->GetViewpoint())
-            VisitNearbyCellsOf(viewPoint, grid_object_update, world_object_update);
+            // If player is using far sight or mind vision, visit that object too
+            if (WorldObject* viewPoint = player->GetViewpoint())
+                VisitNearbyCellsOf(viewPoint, grid_object_update, world_object_update);
 
-        // Handle updates for creatures in combat with player and are more than 60 yards away
-        if (player->IsInCombat())
-        {
+            // Handle updates for creatures in combat with player, owning auras on the player or summoned by the player that are too far away
             std::vector<Unit*> toVisit;
-            for (auto const& pair : player->GetCombatManager().GetPvECombatRefs())
-                if (Creature* unit = pair.second->GetOther(player)->ToCreature())
-                    if (unit->GetMapId() == player->GetMapId() && !unit->IsWithinDistInMap(player, GetVisibilityRange(), false))
-                        toVisit.push_back(unit);
-            for (Unit* unit : toVisit)
-                VisitNearbyCellsOf(unit, grid_object_update, world_object_update);
-        }
-
-        { // Update any creatures that own auras the player has applications of
-            std::unordered_set<Unit*> toVisit;
-            for (std::pair<uint32, AuraApplication*> pair : player->GetAppliedAuras())
-            {
-                if (Unit* caster = pair.second->GetBase()->GetCaster())
-                    if (caster->GetTypeId() != TYPEID_PLAYER && !caster->IsWithinDistInMap(player, GetVisibilityRange(), false))
-                        toVisit.insert(caster);
-            }
-            for (Unit* unit : toVisit)
-                VisitNearbyCellsOf(unit, grid_object_update, world_object_update);
-        }
-
-        { // Update player's summons
-            std::vector<Unit*> toVisit;
-
-            // Totems
-            for (ObjectGuid const& summonGuid : player->m_SummonSlot)
-                if (summonGuid)
-                    if (Creature* unit = GetCreature(summonGuid))
-                        if (unit->GetMapId() == player->GetMapId() && !unit->IsWithinDistInMap(player, GetVisibilityRange(), false))
-                            toVisit.push_back(unit);
-
+            CollectDistantUnitsToUpdate(player, toVisit);
             for (Unit* unit : toVisit)
                 VisitNearbyCellsOf(unit, grid_object_update, world_object_update);
         }
@@ -940,8 +961,236 @@ struct ResetNotifier
     void Visit(PlayerMapType &m) { resetNotify<Player>(m);}
 };
 
+void Map::CollectDistantUnitsToUpdate(Player* player, std::vector<Unit*>& units)
+{
+    // Handle updates for creatures in combat with player and are more than 60 yards away
+    if (player->IsInCombat())
+    {
+        for (auto const& pair : player->GetCombatManager().GetPvECombatRefs())
+            if (Creature* unit = pair.second->GetOther(player)->ToCreature())
+                if (unit->GetMapId() == player->GetMapId() && !unit->IsWithinDistInMap(player, GetVisibilityRange(), false))
+                    units.push_back(unit);
+    }
+
+    { // Update any creatures that own auras the player has applications of
+        std::unordered_set<Unit*> casters;
+        for (std::pair<uint32, AuraApplication*> pair : player->GetAppliedAuras())
+        {
+            if (Unit* caster = pair.second->GetBase()->GetCaster())
+                if (caster->GetTypeId() != TYPEID_PLAYER && !caster->IsWithinDistInMap(player, GetVisibilityRange(), false))
+                    casters.insert(caster);
+        }
+        units.insert(units.end(), casters.begin(), casters.end());
+    }
+
+    { // Update player's summons
+        // Totems
+        for (ObjectGuid const& summonGuid : player->m_SummonSlot)
+            if (summonGuid)
+                if (Creature* unit = GetCreature(summonGuid))
+                    if (unit->GetMapId() == player->GetMapId() && !unit->IsWithinDistInMap(player, GetVisibilityRange(), false))
+                        units.push_back(unit);
+    }
+}
+
+struct Map::RegionUpdateContext
+{
+    std::vector<Player*> Players;
+    // objects far from the players of this region that are known to be inside the region
+    std::unordered_set<ObjectGuid> LinkedObjects;
+    std::unordered_set<uint32> VisitedCells;
+    // objects that got attached to a player of this region during its update, their cells may belong to another region
+    std::vector<std::pair<Player*, ObjectGuid>> DeferredVisits;
+};
+
+bool Map::UpdateRegionsInParallel(uint32 diff)
+{
+    Trinity::ThreadPool* pool = sMapMgr->GetRegionUpdatePool();
+    if (!pool || Instanceable())
+        return false;
+
+    std::vector<Player*> players;
+    for (MapRefManager::iterator itr = m_mapRefManager.begin(); itr != m_mapRefManager.end(); ++itr)
+        if (Player* player = itr->GetSource())
+            if (player->IsInWorld() && player->IsPositionValid())
+                players.push_back(player);
+
+    if (players.size() < 2)
+        return false;
+
+#ifdef ELUNA
+    // a Lua state can't be used by several threads
+    if (GetEluna())
+    {
+        TC_METRIC_VALUE("map_parallel_update_fallback", uint64(1), TC_METRIC_TAG("map_id", std::to_string(GetId())), TC_METRIC_TAG("reason", "lua"));
+        return false;
+    }
+#endif
+
+    // every player is an anchor, followed by the far objects that are updated along with it
+    std::vector<CellCoord> anchors;
+    std::vector<ObjectGuid> anchorGuids;
+    std::vector<std::pair<std::size_t, std::size_t>> links;
+    std::unordered_map<ObjectGuid, std::size_t> playerAnchors;
+    std::vector<std::size_t> anchorPlayers;
+    for (std::size_t i = 0; i < players.size(); ++i)
+    {
+        Player* player = players[i];
+        std::size_t playerAnchor = anchors.size();
+        anchors.push_back(Trinity::ComputeCellCoord(player->GetPositionX(), player->GetPositionY()));
+        anchorGuids.push_back(player->GetGUID());
+        anchorPlayers.push_back(i);
+        playerAnchors[player->GetGUID()] = playerAnchor;
+
+        std::vector<WorldObject*> linkedObjects;
+        if (WorldObject* viewPoint = player->GetViewpoint())
+            linkedObjects.push_back(viewPoint);
+
+        std::vector<Unit*> distantUnits;
+        CollectDistantUnitsToUpdate(player, distantUnits);
+        linkedObjects.insert(linkedObjects.end(), distantUnits.begin(), distantUnits.end());
+
+        for (WorldObject* linkedObject : linkedObjects)
+        {
+            if (!linkedObject->IsPositionValid())
+                continue;
+
+            links.emplace_back(playerAnchor, anchors.size());
+            anchors.push_back(Trinity::ComputeCellCoord(linkedObject->GetPositionX(), linkedObject->GetPositionY()));
+            anchorGuids.push_back(linkedObject->GetGUID());
+            anchorPlayers.push_back(players.size());
+        }
+    }
+
+    // group members share a lot of state (loot, group updates, out of range stats), keep them on one thread
+    for (Player* player : players)
+    {
+        Group* group = player->GetGroup();
+        if (!group)
+            continue;
+
+        for (GroupReference* itr = group->GetFirstMember(); itr != nullptr; itr = itr->next())
+        {
+            Player* member = itr->GetSource();
+            if (!member || member == player || member->GetMap() != this)
+                continue;
+
+            auto memberAnchor = playerAnchors.find(member->GetGUID());
+            if (memberAnchor != playerAnchors.end())
+                links.emplace_back(playerAnchors[player->GetGUID()], memberAnchor->second);
+        }
+    }
+
+    float guardBand = sWorld->getFloatConfig(CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND);
+    float activationRange = std::max(GetVisibilityRange(), DEFAULT_VISIBILITY_INSTANCE);
+    std::vector<MapRegionPartitioner::Region> regions = MapRegionPartitioner::Partition(anchors, links, MapRegionPartitioner::GetRequiredSeparation(activationRange, guardBand));
+    if (regions.size() < 2)
+    {
+        TC_METRIC_VALUE("map_parallel_update_fallback", uint64(1), TC_METRIC_TAG("map_id", std::to_string(GetId())), TC_METRIC_TAG("reason", "single_region"));
+        return false;
+    }
+
+    std::vector<RegionUpdateContext> contexts(regions.size());
+    for (std::size_t i = 0; i < regions.size(); ++i)
+    {
+        for (std::size_t anchor : regions[i])
+        {
+            if (anchorPlayers[anchor] < players.size())
+                contexts[i].Players.push_back(players[anchorPlayers[anchor]]);
+            else
+                contexts[i].LinkedObjects.insert(anchorGuids[anchor]);
+        }
+    }
+
+    _parallelRegionGuardBand = guardBand;
+    _parallelRegionUpdate.Run(*pool, contexts.size(), [this, &contexts, diff](std::size_t i)
+    {
+        UpdateRegion(contexts[i], diff);
+    });
+
+    // merge phase, everything below runs on the map update thread again
+    std::size_t deferredVisits = 0;
+    for (RegionUpdateContext const& region : contexts)
+    {
+        for (uint32 cellId : region.VisitedCells)
+            markCell(cellId);
+
+        deferredVisits += region.DeferredVisits.size();
+    }
+
+    Trinity::ObjectUpdater updater(diff);
+    TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer> gridObjectUpdate(updater);
+    TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer> worldObjectUpdate(updater);
+    for (RegionUpdateContext const& region : contexts)
+    {
+        for (std::pair<Player*, ObjectGuid> const& deferredVisit : region.DeferredVisits)
+            if (deferredVisit.first->IsInWorld() && deferredVisit.first->GetMap() == this)
+                if (WorldObject* obj = ObjectAccessor::GetWorldObject(*deferredVisit.first, deferredVisit.second))
+                    VisitNearbyCellsOf(obj, gridObjectUpdate, worldObjectUpdate);
+    }
+
+    ParallelRegionUpdate::DeferredCounts deferred = _parallelRegionUpdate.RunDeferred();
+
+    TC_METRIC_VALUE("map_parallel_update_regions", uint64(contexts.size()), TC_METRIC_TAG("map_id", std::to_string(GetId())));
+    if (deferredVisits)
+        TC_METRIC_VALUE("map_parallel_update_fallback", uint64(deferredVisits), TC_METRIC_TAG("map_id", std::to_string(GetId())), TC_METRIC_TAG("reason", "deferred_visit"));
+    if (deferred.Broadcasts)
+        TC_METRIC_VALUE("map_parallel_update_fallback", uint64(deferred.Broadcasts), TC_METRIC_TAG("map_id", std::to_string(GetId())), TC_METRIC_TAG("reason", "broadcast"));
+
+    return true;
+}
+
+void Map::UpdateRegion(RegionUpdateContext& region, uint32 diff)
+{
+    // root of its own when updated by a pool thread
+    ScopeProfiler::Scope profileScope(ScopeProfiler::SCOPE_ROOT, nullptr, "Map::UpdateRegion");
+
+    Trinity::ObjectUpdater updater(diff);
+    TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer> gridObjectUpdate(updater);
+    TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer> worldObjectUpdate(updater);
+
+    auto markCell = [&region](uint32 cellId)
+    {
+        return region.VisitedCells.insert(cellId).second;
+    };
+
+    for (Player* player : region.Players)
+    {
+        if (!player->IsInWorld())
+            continue;
+
+        // update players at tick
+        player->Update(diff);
+
+        VisitNearbyCellsOf(player, gridObjectUpdate, worldObjectUpdate, markCell);
+
+        std::vector<WorldObject*> toVisit;
+        if (WorldObject* viewPoint = player->GetViewpoint())
+            toVisit.push_back(viewPoint);
+
+        std::vector<Unit*> distantUnits;
+        CollectDistantUnitsToUpdate(player, distantUnits);
+        toVisit.insert(toVisit.end(), distantUnits.begin(), distantUnits.end());
+
+        for (WorldObject* obj : toVisit)
+        {
+            if (obj == player)
+                continue;
+
+            if (region.LinkedObjects.count(obj->GetGUID()))
+                VisitNearbyCellsOf(obj, gridObjectUpdate, worldObjectUpdate, markCell);
+            else
+                region.DeferredVisits.emplace_back(player, obj->GetGUID());
+        }
+    }
+}
+
 void Map::ProcessRelocationNotifies(const uint32 diff)
 {
+    Trinity::CreatureRelocationBatch creature_relocation(*this, sWorld->getIntConfig(CONFIG_RELOCATION_BATCH_MIN_CREATURES));
+    uint32 visibilityChecked = 0;
+    uint32 visibilitySkipped = 0;
+
     for (GridRefManager<NGridType>::iterator i = GridRefManager<NGridType>::begin(); i != GridRefManager<NGridType>::end(); ++i)
     {
         NGridType *grid = i->GetSource();
@@ -970,15 +1219,28 @@ void Map::ProcessRelocationNotifies(const uint32 diff)
                 Cell cell(pair);
                 cell.SetNoCreate();
 
-                Trinity::DelayedUnitRelocation cell_relocation(cell, pair, *this, MAX_VISIBILITY_DISTANCE);
+                Trinity::DelayedUnitRelocation cell_relocation(cell, pair, *this, MAX_VISIBILITY_DISTANCE, &creature_relocation);
                 TypeContainerVisitor<Trinity::DelayedUnitRelocation, GridTypeMapContainer  > grid_object_relocation(cell_relocation);
                 TypeContainerVisitor<Trinity::DelayedUnitRelocation, WorldTypeMapContainer > world_object_relocation(cell_relocation);
                 Visit(cell, grid_object_relocation);
                 Visit(cell, world_object_relocation);
+
+                visibilityChecked += cell_relocation.i_visibilityChecked;
+                visibilitySkipped += cell_relocation.i_visibilitySkipped;
             }
         }
     }
 
+    creature_relocation.Process();
+
+    if (visibilityChecked)
+    {
+        TC_METRIC_VALUE("map_visibility_incremental_checks", uint64(visibilityChecked),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())));
+        TC_METRIC_VALUE("map_visibility_incremental_skipped", uint64(visibilitySkipped),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())));
+    }
+
     ResetNotifier reset;
     TypeContainerVisitor<ResetNotifier, GridTypeMapContainer >  grid_notifier(reset);
     TypeContainerVisitor<ResetNotifier, WorldTypeMapContainer > world_notifier(reset);
@@ -1044,6 +1306,8 @@ void Map::RemovePlayerFromMap(Player* player, bool remove)
 template<class T>
 void Map::RemoveFromMap(T *obj, bool remove)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     bool const inWorld = obj->IsInWorld() && obj->GetTypeId() >= TYPEID_UNIT && obj->GetTypeId() <= TYPEID_GAMEOBJECT;
     obj->RemoveFromWorld();
 
@@ -1102,6 +1366,7 @@ void Map::PlayerRelocation(Player* player, float x, float y, float z, float orie
 
     Cell old_cell(player->GetPositionX(), player->GetPositionY());
     Cell new_cell(x, y);
+    float travelled = player->GetExactDist2d(x, y);
 
     player->Relocate(x, y, z, orientation);
     if (player->IsVehicle())
@@ -1120,7 +1385,7 @@ void Map::PlayerRelocation(Player* player, float x, float y, float z, float orie
     }
 
     player->UpdatePositionData();
-    player->UpdateObjectVisibility(false);
+    player->UpdateObjectVisibilityOnMove(travelled);
 }
 
 void Map::CreatureRelocation(Creature* creature, float x, float y, float z, float ang, bool respawnRelocationOnFail)
@@ -1224,6 +1489,8 @@ void Map::DynamicObjectRelocation(DynamicObject* dynObj, float x, float y, float
 
 void Map::AddCreatureToMoveList(Creature* c, float x, float y, float z, float ang)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_creatureToMoveLock) //can this happen?
         return;
 
@@ -1234,6 +1501,8 @@ void Map::AddCreatureToMoveList(Creature* c, float x, float y, float z, float an
 
 void Map::RemoveCreatureFromMoveList(Creature* c)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_creatureToMoveLock) //can this happen?
         return;
 
@@ -1243,6 +1512,8 @@ void Map::RemoveCreatureFromMoveList(Creature* c)
 
 void Map::AddGameObjectToMoveList(GameObject* go, float x, float y, float z, float ang)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_gameObjectsToMoveLock) //can this happen?
         return;
 
@@ -1253,6 +1524,8 @@ void Map::AddGameObjectToMoveList(GameObject* go, float x, float y, float z, flo
 
 void Map::RemoveGameObjectFromMoveList(GameObject* go)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_gameObjectsToMoveLock) //can this happen?
         return;
 
@@ -1262,6 +1535,8 @@ void Map::RemoveGameObjectFromMoveList(GameObject* go)
 
 void Map::AddDynamicObjectToMoveList(DynamicObject* dynObj, float x, float y, float z, float ang)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_dynamicObjectsToMoveLock) //can this happen?
         return;
 
@@ -1272,6 +1547,8 @@ void Map::AddDynamicObjectToMoveList(DynamicObject* dynObj, float x, float y, fl
 
 void Map::RemoveDynamicObjectFromMoveList(DynamicObject* dynObj)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (_dynamicObjectsToMoveLock) //can this happen?
         return;
 
@@ -1836,68 +2113,59 @@ bool GridMap::loadData(char const* filename)
     // Unload old data if exist
     unloadData();
 
-    map_fileheader header;
     // Not return error if file not found
-    FILE* in = fopen(filename, "rb");
-    if (!in)
+    std::shared_ptr<TerrainFile const> file = sTerrainFileStore->Acquire(filename);
+    if (!file)
         return true;
 
-    if (fread(&header, sizeof(header), 1, in) != 1)
+    _file = std::move(file);
+
+    map_fileheader header;
+    uint32 offset = 0;
+    if (!readFromFile(offset, header))
     {
-        fclose(in);
+        unloadData();
         return false;
     }
 
     if (header.mapMagic.asUInt == MapMagic.asUInt && header.versionMagic == MapVersionMagic)
     {
         // load up area data
-        if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
+        if (header.areaMapOffset && !loadAreaData(header.areaMapOffset, header.areaMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map area data\n");
-            fclose(in);
             return false;
         }
         // load up height data
-        if (header.heightMapOffset && !loadHeightData(in, header.heightMapOffset, header.heightMapSize))
+        if (header.heightMapOffset && !loadHeightData(header.heightMapOffset, header.heightMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map height data\n");
-            fclose(in);
             return false;
         }
         // load up liquid data
-        if (header.liquidMapOffset && !loadLiquidData(in, header.liquidMapOffset, header.liquidMapSize))
+        if (header.liquidMapOffset && !loadLiquidData(header.liquidMapOffset, header.liquidMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map liquids data\n");
-            fclose(in);
             return false;
         }
         // loadup holes data (if any. check header.holesOffset)
-        if (header.holesSize && !loadHolesData(in, header.holesOffset, header.holesSize))
+        if (header.holesSize && !loadHolesData(header.holesOffset, header.holesSize))
         {
             TC_LOG_ERROR("maps", "Error loading map holes data\n");
-            fclose(in);
             return false;
         }
-        fclose(in);
         return true;
     }
 
     TC_LOG_ERROR("maps", "Map file '{}' is from an incompatible map version (%.*s v{}), %.*s v{} is expected. Please pull your source, recompile tools and recreate maps using the updated mapextractor, then replace your old map files with new files. If you still have problems search on forum for error TCE00018.",
         filename, 4, header.mapMagic.asChar, header.versionMagic, 4, MapMagic.asChar, MapVersionMagic);
-    fclose(in);
+    unloadData();
     return false;
 }
 
 void GridMap::unloadData()
 {
-    delete[] _areaMap;
-    delete[] m_V9;
-    delete[] m_V8;
     delete[] _minHeightPlanes;
-    delete[] _liquidEntry;
-    delete[] _liquidFlags;
-    delete[] _liquidMap;
-    delete[] _holes;
     _areaMap = nullptr;
     m_V9 = nullptr;
     m_V8 = nullptr;
@@ -1907,32 +2175,60 @@ void GridMap::unloadData()
     _liquidMap  = nullptr;
     _holes = nullptr;
     _gridGetHeight = &GridMap::getHeightFromFlat;
+    _unalignedCopies.clear();
+    _file.reset();
 }
 
-bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
+template<class T>
+bool GridMap::readFromFile(uint32& offset, T& value) const
 {
-    map_areaHeader header;
-    fseek(in, offset, SEEK_SET);
+    if (std::size_t(offset) + sizeof(T) > _file->GetSize())
+        return false;
+
+    memcpy(&value, _file->GetData() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+template<class T>
+bool GridMap::mapFromFile(uint32& offset, uint32 count, T const*& array)
+{
+    std::size_t size = std::size_t(count) * sizeof(T);
+    if (std::size_t(offset) + size > _file->GetSize())
+        return false;
+
+    uint8 const* data = _file->GetData() + offset;
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(T) == 0)
+        array = reinterpret_cast<T const*>(data);
+    else
+    {
+        std::unique_ptr<uint8[]>& copy = _unalignedCopies.emplace_back(new uint8[size]);
+        memcpy(copy.get(), data, size);
+        array = reinterpret_cast<T const*>(copy.get());
+    }
+
+    offset += uint32(size);
+    return true;
+}
 
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapAreaMagic.asUInt)
+bool GridMap::loadAreaData(uint32 offset, uint32 /*size*/)
+{
+    map_areaHeader header;
+    if (!readFromFile(offset, header) || header.fourcc != MapAreaMagic.asUInt)
         return false;
 
     _gridArea = header.gridArea;
     if (!(header.flags & MAP_AREA_NO_AREA))
-    {
-        _areaMap = new uint16[16 * 16];
-        if (fread(_areaMap, sizeof(uint16), 16*16, in) != 16*16)
+        if (!mapFromFile(offset, 16 * 16, _areaMap))
             return false;
-    }
+
     return true;
 }
 
-bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeightData(uint32 offset, uint32 /*size*/)
 {
     map_heightHeader header;
-    fseek(in, offset, SEEK_SET);
-
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapHeightMagic.asUInt)
+    if (!readFromFile(offset, header) || header.fourcc != MapHeightMagic.asUInt)
         return false;
 
     _gridHeight = header.gridHeight;
@@ -1940,30 +2236,24 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     {
         if ((header.flags & MAP_HEIGHT_AS_INT16))
         {
-            m_uint16_V9 = new uint16 [129*129];
-            m_uint16_V8 = new uint16 [128*128];
-            if (fread(m_uint16_V9, sizeof(uint16), 129*129, in) != 129*129 ||
-                fread(m_uint16_V8, sizeof(uint16), 128*128, in) != 128*128)
+            if (!mapFromFile(offset, 129*129, m_uint16_V9) ||
+                !mapFromFile(offset, 128*128, m_uint16_V8))
                 return false;
             _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
             _gridGetHeight = &GridMap::getHeightFromUint16;
         }
         else if ((header.flags & MAP_HEIGHT_AS_INT8))
         {
-            m_uint8_V9 = new uint8 [129*129];
-            m_uint8_V8 = new uint8 [128*128];
-            if (fread(m_uint8_V9, sizeof(uint8), 129*129, in) != 129*129 ||
-                fread(m_uint8_V8, sizeof(uint8), 128*128, in) != 128*128)
+            if (!mapFromFile(offset, 129*129, m_uint8_V9) ||
+                !mapFromFile(offset, 128*128, m_uint8_V8))
                 return false;
             _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
             _gridGetHeight = &GridMap::getHeightFromUint8;
         }
         else
         {
-            m_V9 = new float [129*129];
-            m_V8 = new float [128*128];
-            if (fread(m_V9, sizeof(float), 129*129, in) != 129*129 ||
-                fread(m_V8, sizeof(float), 128*128, in) != 128*128)
+            if (!mapFromFile(offset, 129*129, m_V9) ||
+                !mapFromFile(offset, 128*128, m_V8))
                 return false;
             _gridGetHeight = &GridMap::getHeightFromFloat;
         }
@@ -1975,8 +2265,7 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     {
         std::array<int16, 9> maxHeights;
         std::array<int16, 9> minHeights;
-        if (fread(maxHeights.data(), sizeof(int16), maxHeights.size(), in) != maxHeights.size() ||
-            fread(minHeights.data(), sizeof(int16), minHeights.size(), in) != minHeights.size())
+        if (!readFromFile(offset, maxHeights) || !readFromFile(offset, minHeights))
             return false;
 
         static uint32 constexpr indices[8][3] =
@@ -2016,12 +2305,10 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     return true;
 }
 
-bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadLiquidData(uint32 offset, uint32 /*size*/)
 {
     map_liquidHeader header;
-    fseek(in, offset, SEEK_SET);
-
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapLiquidMagic.asUInt)
+    if (!readFromFile(offset, header) || header.fourcc != MapLiquidMagic.asUInt)
         return false;
 
     _liquidGlobalEntry = header.liquidType;
@@ -2034,30 +2321,23 @@ bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
 
     if (!(header.flags & MAP_LIQUID_NO_TYPE))
     {
-        _liquidEntry = new uint16[16*16];
-        if (fread(_liquidEntry, sizeof(uint16), 16*16, in) != 16*16)
+        if (!mapFromFile(offset, 16*16, _liquidEntry))
             return false;
 
-        _liquidFlags = new uint8[16*16];
-        if (fread(_liquidFlags, sizeof(uint8), 16*16, in) != 16*16)
+        if (!mapFromFile(offset, 16*16, _liquidFlags))
             return false;
     }
     if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
     {
-        _liquidMap = new float[uint32(_liquidWidth) * uint32(_liquidHeight)];
-        if (fread(_liquidMap, sizeof(float), _liquidWidth*_liquidHeight, in) != (uint32(_liquidWidth) * uint32(_liquidHeight)))
+        if (!mapFromFile(offset, uint32(_liquidWidth) * uint32(_liquidHeight), _liquidMap))
             return false;
     }
     return true;
 }
 
-bool GridMap::loadHolesData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHolesData(uint32 offset, uint32 /*size*/)
 {
-    if (fseek(in, offset, SEEK_SET) != 0)
-        return false;
-
-    _holes = new uint16[16 * 16];
-    if (fread(_holes, sizeof(uint16), 16 * 16, in) != 16 * 16)
+    if (!mapFromFile(offset, 16 * 16, _holes))
         return false;
 
     return true;
@@ -2184,7 +2464,7 @@ float GridMap::getHeightFromUint8(float x, float y) const
         return INVALID_HEIGHT;
 
     int32 a, b, c;
-    uint8 *V9_h1_ptr = &m_uint8_V9[x_int*128 + x_int + y_int];
+    uint8 const* V9_h1_ptr = &m_uint8_V9[x_int*128 + x_int + y_int];
     if (x+y < 1)
     {
         if (x > y)
@@ -2254,7 +2534,7 @@ float GridMap::getHeightFromUint16(float x, float y) const
         return INVALID_HEIGHT;
 
     int32 a, b, c;
-    uint16 *V9_h1_ptr = &m_uint16_V9[x_int*128 + x_int + y_int];
+    uint16 const* V9_h1_ptr = &m_uint16_V9[x_int*128 + x_int + y_int];
     if (x+y < 1)
     {
         if (x > y)
@@ -2566,7 +2846,11 @@ bool Map::GetAreaInfo(uint32 phaseMask, float x, float y, float z, uint32& flags
     VMAP::AreaAndLiquidData ddata;
 
     bool hasVmapAreaInfo = vmgr->getAreaAndLiquidData(GetId(), x, y, z, {}, vdata) && vdata.areaInfo.has_value();
-    bool hasDynamicAreaInfo = _dynamicTree.getAreaAndLiquidData(x, y, z, phaseMask, {}, ddata) && ddata.areaInfo.has_value();
+    bool hasDynamicAreaInfo = [&]
+    {
+        std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
+        return _dynamicTree.getAreaAndLiquidData(x, y, z, phaseMask, {}, ddata) && ddata.areaInfo.has_value();
+    }();
     auto useVmap = [&] { check_z = vdata.floorZ; groupId = vdata.areaInfo->groupId; adtId = vdata.areaInfo->adtId; rootId = vdata.areaInfo->rootId; flags = vdata.areaInfo->mogpFlags; };
     auto useDyn = [&] { check_z = ddata.floorZ; groupId = ddata.areaInfo->groupId; adtId = ddata.areaInfo->adtId; rootId = ddata.areaInfo->rootId; flags = ddata.areaInfo->mogpFlags; };
     if (hasVmapAreaInfo)
@@ -2746,7 +3030,10 @@ void Map::GetFullTerrainStatusForPosition(uint32 phaseMask, float x, float y, fl
     VMAP::AreaAndLiquidData* wmoData = nullptr;
     GridMap* gmap = const_cast<Map*>(this)->GetGrid(x, y);
     vmgr->getAreaAndLiquidData(GetId(), x, y, z, reqLiquidType, vmapData);
-    _dynamicTree.getAreaAndLiquidData(x, y, z, phaseMask, reqLiquidType, dynData);
+    {
+        std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
+        _dynamicTree.getAreaAndLiquidData(x, y, z, phaseMask, reqLiquidType, dynData);
+    }
 
     uint32 gridAreaId = 0;
     float gridMapHeight = INVALID_HEIGHT;
@@ -2890,9 +3177,12 @@ bool Map::isInLineOfSight(float x1, float y1, float z1, float x2, float y2, floa
     if ((checks & LINEOFSIGHT_CHECK_VMAP)
       && !VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2, ignoreFlags))
         return false;
-    if (sWorld->getBoolConfig(CONFIG_CHECK_GOBJECT_LOS) && (checks & LINEOFSIGHT_CHECK_GOBJECT)
-      && !_dynamicTree.isInLineOfSight(x1, y1, z1, x2, y2, z2, phasemask))
-        return false;
+    if (sWorld->getBoolConfig(CONFIG_CHECK_GOBJECT_LOS) && (checks & LINEOFSIGHT_CHECK_GOBJECT))
+    {
+        std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
+        if (!_dynamicTree.isInLineOfSight(x1, y1, z1, x2, y2, z2, phasemask))
+            return false;
+    }
     return true;
 }
 
@@ -2902,6 +3192,7 @@ bool Map::getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float
     G3D::Vector3 dstPos(x2, y2, z2);
 
     G3D::Vector3 resultPos;
+    std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
     bool result = _dynamicTree.getObjectHitPos(phasemask, startPos, dstPos, resultPos, modifyDist);
 
     rx = resultPos.x;
@@ -3023,10 +3314,83 @@ inline void Map::setNGrid(NGridType *grid, uint32 x, uint32 y)
     i_grids[x][y] = grid;
 }
 
+// Serializes and compresses the object update packets of several players, on the MapUpdate.ParallelPacketBuild threads when there are enough of them
+static void BuildObjectUpdatePackets(std::vector<std::pair<Player*, UpdateData*>> const& updates, std::vector<WorldPacket>& packets)
+{
+    Trinity::ThreadPool* pool = sMapMgr->GetPacketBuildPool();
+    if (!pool || updates.size() < sWorld->getIntConfig(CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_MIN_PLAYERS))
+    {
+        for (std::size_t i = 0; i < updates.size(); ++i)
+            if (!updates[i].second->BuildPacket(&packets[i]))
+                packets[i].SetOpcode(NULL_OPCODE);
+        return;
+    }
+
+    // outlives this call, pool tasks that only start once all packets are taken just return
+    struct BuildState
+    {
+        std::vector<std::pair<Player*, UpdateData*>> const* Updates;
+        std::vector<WorldPacket>* Packets;
+        std::size_t Count;
+        std::atomic<std::size_t> Next;
+        std::atomic<std::size_t> Built;
+        std::mutex Lock;
+        std::condition_variable AllBuilt;
+    };
+
+    std::shared_ptr<BuildState> state = std::make_shared<BuildState>();
+    state->Updates = &updates;
+    state->Packets = &packets;
+    state->Count = updates.size();
+    state->Next = 0;
+    state->Built = 0;
+
+    auto buildPackets = [](BuildState& state)
+    {
+        for (std::size_t i = state.Next++; i < state.Count; i = state.Next++)
+        {
+            if (!(*state.Updates)[i].second->BuildPacket(&(*state.Packets)[i]))
+                (*state.Packets)[i].SetOpcode(NULL_OPCODE);
+
+            if (++state.Built == state.Count)
+            {
+                std::lock_guard<std::mutex> lock(state.Lock);
+                state.AllBuilt.notify_one();
+            }
+        }
+    };
+
+    for (uint32 i = 0; i < sWorld->getIntConfig(CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS); ++i)
+        pool->PostWork([state, buildPackets]() { buildPackets(*state); });
+
+    // the pool is shared by all maps: when it is busy the map update thread builds every packet itself,
+    // otherwise it only waits for the packets the pool threads are still building
+    buildPackets(*state);
+
+    std::unique_lock<std::mutex> lock(state->Lock);
+    state->AllBuilt.wait(lock, [&state]() { return state->Built == state->Count; });
+}
+
 void Map::SendObjectUpdates()
 {
     UpdateDataMapType update_players;
 
+    // stage times in microseconds, most stages of a map update take less than the millisecond TC_METRIC_DETAILED_TIMER
+    // reports. Logged by every map sending updates on every tick, so only with detailed metrics
+    auto logStageTime = [&](char const* stage, TimePoint start)
+    {
+#if defined WITH_DETAILED_METRICS
+        TC_METRIC_VALUE("map_object_updates_time", uint64(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())),
+            TC_METRIC_TAG("map_instanceid", std::to_string(GetInstanceId())),
+            TC_METRIC_TAG("stage", stage));
+#else
+        (void)stage;
+        (void)start;
+#endif
+    };
+
+    TimePoint stageStart = std::chrono::steady_clock::now();
     while (!_updateObjects.empty())
     {
         Object* obj = *_updateObjects.begin();
@@ -3036,13 +3400,61 @@ void Map::SendObjectUpdates()
         obj->BuildUpdate(update_players);
     }
 
-    WorldPacket packet;                                     // here we allocate a std::vector with a size of 0x10000
+    if (_updateFieldFragments.GetSerializedBytes())
+    {
+        TC_METRIC_VALUE("map_update_fields_serialized_bytes", _updateFieldFragments.GetSerializedBytes(),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())),
+            TC_METRIC_TAG("map_instanceid", std::to_string(GetInstanceId())));
+
+        TC_METRIC_VALUE("map_update_fields_shared_bytes", _updateFieldFragments.GetSharedBytes(),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())),
+            TC_METRIC_TAG("map_instanceid", std::to_string(GetInstanceId())));
+
+        _updateFieldFragments.ResetCounters();
+    }
+
+    if (update_players.empty())
+        return;
+
+    // maps without players nearby have nothing to send, their ticks are not worth a metric
+    logStageTime("gather", stageStart);
+
+    std::vector<std::pair<Player*, UpdateData*>> updates;
+    updates.reserve(update_players.size());
     for (UpdateDataMapType::iterator iter = update_players.begin(); iter != update_players.end(); ++iter)
+        updates.emplace_back(iter->first, &iter->second);
+
+    std::vector<WorldPacket> packets(updates.size());
+
+    stageStart = std::chrono::steady_clock::now();
+    BuildObjectUpdatePackets(updates, packets);
+    logStageTime("build", stageStart);
+
+    // packets are sent from the map update thread in the order they were gathered, sessions and bots don't expect other threads here
+    uint64 uncompressedBytes = 0;
+    uint64 packetBytes = 0;
+    stageStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < updates.size(); ++i)
     {
-        iter->second.BuildPacket(&packet);
-        iter->first->SendDirectMessage(&packet);
-        packet.clear();                                     // clean the string
+        WorldPacket& packet = packets[i];
+        if (packet.GetOpcode() == NULL_OPCODE)
+            continue;
+
+        packetBytes += packet.size();
+        uncompressedBytes += packet.GetOpcode() == SMSG_COMPRESSED_UPDATE_OBJECT ? packet.read<uint32>(0) : packet.size();
+        updates[i].first->SendDirectMessage(MakeSharedWorldPacket(std::move(packet)));
     }
+
+    logStageTime("send", stageStart);
+
+    TC_METRIC_VALUE("map_update_packets_bytes", packetBytes,
+        TC_METRIC_TAG("map_id", std::to_string(GetId())),
+        TC_METRIC_TAG("map_instanceid", std::to_string(GetInstanceId())));
+
+    if (uncompressedBytes)
+        TC_METRIC_VALUE("map_update_packets_compression_ratio", double(packetBytes) / double(uncompressedBytes),
+            TC_METRIC_TAG("map_id", std::to_string(GetId())),
+            TC_METRIC_TAG("map_instanceid", std::to_string(GetInstanceId())));
 }
 
 // CheckRespawn MUST do one of the following:
@@ -3152,6 +3564,8 @@ size_t Map::DespawnAll(SpawnObjectType type, ObjectGuid::LowType spawnId)
 
 bool Map::AddRespawnInfo(RespawnInfo const& info)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     if (!info.spawnId)
     {
         TC_LOG_ERROR("maps", "Attempt to insert respawn info for zero spawn id (type {})", uint32(info.type));
@@ -3218,6 +3632,8 @@ void Map::UnloadAllRespawnInfos() // delete everything from memory
 
 void Map::DeleteRespawnInfo(RespawnInfo* info, CharacterDatabaseTransaction dbTrans)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     // Delete from all relevant containers to ensure consistency
     ASSERT(info);
 
@@ -3353,6 +3769,7 @@ void Map::ApplyDynamicModeRespawnScaling(WorldObject const* obj, ObjectGuid::Low
     if (!(data->spawnGroupData->flags & SPAWNGROUP_FLAG_DYNAMIC_SPAWN_RATE))
         return;
 
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
     auto it = _zonePlayerCountMap.find(obj->GetZoneId());
     if (it == _zonePlayerCountMap.end())
         return;
@@ -3577,6 +3994,8 @@ void Map::DelayedUpdate(uint32 t_diff)
 
 void Map::AddObjectToRemoveList(WorldObject* obj)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     ASSERT(obj->GetMapId() == GetId() && obj->GetInstanceId() == GetInstanceId());
 
 #ifdef ELUNA
@@ -3596,6 +4015,8 @@ void Map::AddObjectToRemoveList(WorldObject* obj)
 
 void Map::AddObjectToSwitchList(WorldObject* obj, bool on)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     ASSERT(obj->GetMapId() == GetId() && obj->GetInstanceId() == GetInstanceId());
     // i_objectsToSwitch is iterated only in Map::RemoveAllObjectsInRemoveList() and it uses
     // the contained objects only if GetTypeId() == TYPEID_UNIT , so we can return in all other cases
@@ -3776,6 +4197,8 @@ bool Map::ActiveObjectsNearGrid(NGridType const& ngrid) const
 
 void Map::AddToActive(WorldObject* obj)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     AddToActiveHelper(obj);
 
     Optional<Position> respawnLocation;
@@ -3819,6 +4242,8 @@ void Map::AddToActive(WorldObject* obj)
 
 void Map::RemoveFromActive(WorldObject* obj)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     RemoveFromActiveHelper(obj);
 
     Optional<Position> respawnLocation;
@@ -4464,16 +4889,22 @@ Player* Map::GetPlayer(ObjectGuid const& guid)
 
 Corpse* Map::GetCorpse(ObjectGuid const& guid)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     return _objectsStore.Find<Corpse>(guid);
 }
 
 Creature* Map::GetCreature(ObjectGuid const& guid)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     return _objectsStore.Find<Creature>(guid);
 }
 
 Creature* Map::GetCreatureBySpawnId(ObjectGuid::LowType spawnId) const
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     auto const bounds = GetCreatureBySpawnIdStore().equal_range(spawnId);
     if (bounds.first == bounds.second)
         return nullptr;
@@ -4488,6 +4919,8 @@ Creature* Map::GetCreatureBySpawnId(ObjectGuid::LowType spawnId) const
 
 GameObject* Map::GetGameObjectBySpawnId(ObjectGuid::LowType spawnId) const
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     auto const bounds = GetGameObjectBySpawnIdStore().equal_range(spawnId);
     if (bounds.first == bounds.second)
         return nullptr;
@@ -4502,11 +4935,15 @@ GameObject* Map::GetGameObjectBySpawnId(ObjectGuid::LowType spawnId) const
 
 GameObject* Map::GetGameObject(ObjectGuid const& guid)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     return _objectsStore.Find<GameObject>(guid);
 }
 
 Pet* Map::GetPet(ObjectGuid const& guid)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     return _objectsStore.Find<Pet>(guid);
 }
 
@@ -4521,6 +4958,8 @@ Transport* Map::GetTransport(ObjectGuid const& guid)
 
 DynamicObject* Map::GetDynamicObject(ObjectGuid const& guid)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     return _objectsStore.Find<DynamicObject>(guid);
 }
 
@@ -4680,6 +5119,8 @@ void Map::DeleteCorpseData()
 
 void Map::AddCorpse(Corpse* corpse)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     corpse->SetMap(this);
 
     _corpsesByCell[corpse->GetCellCoord().GetId()].insert(corpse);
@@ -4691,6 +5132,8 @@ void Map::AddCorpse(Corpse* corpse)
 
 void Map::RemoveCorpse(Corpse* corpse)
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+
     ASSERT(corpse);
 
     corpse->DestroyForNearbyPlayers();
@@ -4788,6 +5231,7 @@ void Map::RemoveOldCorpses()
 
 void Map::SendZoneDynamicInfo(uint32 zoneId, Player* player) const
 {
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
     auto itr = _zoneDynamicInfo.find(zoneId);
     if (itr == _zoneDynamicInfo.end())
         return;
@@ -4853,6 +5297,7 @@ Weather* Map::GetOrGenerateZoneDefaultWeather(uint32 zoneId)
     if (!weatherData)
         return nullptr;
 
+    std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
     ZoneDynamicInfo& info = _zoneDynamicInfo[zoneId];
     if (!info.DefaultWeather)
     {
@@ -29,15 +29,19 @@
 #include "MPSCQueue.h"
 #include "ObjectGuid.h"
 #include "Optional.h"
+#include "ParallelRegionUpdate.h"
 #include "SharedDefines.h"
 #include "SpawnData.h"
 #include "Timer.h"
 #include "Transaction.h"
 #include "UniqueTrackablePtr.h"
+#include "UpdateFieldFragments.h"
 #include <bitset>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 #ifdef ELUNA
 #include "LuaValue.h"
 #endif
@@ -49,6 +53,7 @@ class CreatureGroup;
 class Eluna;
 #endif
 class GameObjectModel;
+class GridPrefetcher;
 class Group;
 class InstanceMap;
 class InstanceSave;
@@ -57,6 +62,7 @@ class MapInstanced;
 class Object;
 class Player;
 class TempSummon;
+class TerrainFile;
 class Transport;
 class Unit;
 class Weather;
@@ -66,12 +72,14 @@ class WorldSession;
 struct MapDifficulty;
 struct MapEntry;
 struct Position;
+struct PrefetchedGridTerrain;
 struct ScriptAction;
 struct ScriptInfo;
 struct SummonPropertiesEntry;
 enum Difficulty : uint8;
 enum WeatherState : uint32;
 
+namespace MMAP { struct MMapTileData; }
 namespace Trinity { struct ObjectUpdater; }
 namespace VMAP { enum class ModelIgnoreFlags : uint32; }
 namespace G3D { class Plane; }
@@ -161,14 +169,14 @@ class TC_GAME_API GridMap
 {
     uint32  _flags;
     union{
-        float* m_V9;
-        uint16* m_uint16_V9;
-        uint8* m_uint8_V9;
+        float const* m_V9;
+        uint16 const* m_uint16_V9;
+        uint8 const* m_uint8_V9;
     };
     union{
-        float* m_V8;
-        uint16* m_uint16_V8;
-        uint8* m_uint8_V8;
+        float const* m_V8;
+        uint16 const* m_uint16_V8;
+        uint8 const* m_uint8_V8;
     };
     G3D::Plane* _minHeightPlanes;
     // Height level data
@@ -176,13 +184,13 @@ class TC_GAME_API GridMap
     float _gridIntHeightMultiplier;
 
     // Area data
-    uint16* _areaMap;
+    uint16 const* _areaMap;
 
     // Liquid data
     float _liquidLevel;
-    uint16* _liquidEntry;
-    uint8* _liquidFlags;
-    float* _liquidMap;
+    uint16 const* _liquidEntry;
+    uint8 const* _liquidFlags;
+    float const* _liquidMap;
     uint16 _gridArea;
     uint16 _liquidGlobalEntry;
     uint8 _liquidGlobalFlags;
@@ -191,12 +199,19 @@ class TC_GAME_API GridMap
     uint8 _liquidWidth;
     uint8 _liquidHeight;
 
-    uint16* _holes;
+    uint16 const* _holes;
 
-    bool loadAreaData(FILE* in, uint32 offset, uint32 size);
-    bool loadHeightData(FILE* in, uint32 offset, uint32 size);
-    bool loadLiquidData(FILE* in, uint32 offset, uint32 size);
-    bool loadHolesData(FILE* in, uint32 offset, uint32 size);
+    // the arrays above point into the file shared by all grids loading it,
+    // sections that are not aligned for their type are copied
+    std::shared_ptr<TerrainFile const> _file;
+    std::vector<std::unique_ptr<uint8[]>> _unalignedCopies;
+
+    template<class T> bool readFromFile(uint32& offset, T& value) const;
+    template<class T> bool mapFromFile(uint32& offset, uint32 count, T const*& array);
+    bool loadAreaData(uint32 offset, uint32 size);
+    bool loadHeightData(uint32 offset, uint32 size);
+    bool loadLiquidData(uint32 offset, uint32 size);
+    bool loadHolesData(uint32 offset, uint32 size);
     bool isHole(int row, int col) const;
 
     // Get height functions and pointers
@@ -286,6 +301,7 @@ typedef TypeUnorderedMapContainer<AllMapStoredObjectTypes, ObjectGuid> MapStored
 class TC_GAME_API Map : public GridRefManager<NGridType>
 {
     friend class MapReference;
+    friend class GridPrefetcher;
     public:
         Map(uint32 id, time_t, uint32 InstanceId, uint8 SpawnMode, Map* _parent = nullptr);
         virtual ~Map();
@@ -538,11 +554,24 @@ class TC_GAME_API Map : public GridRefManager<NGridType>
         float GetHeight(uint32 phasemask, Position const& pos, bool vmap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const { return GetHeight(phasemask, pos.GetPositionX(), pos.GetPositionY(), pos.GetPositionZ(), vmap, maxSearchDist); }
         bool isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask, LineOfSightChecks checks, VMAP::ModelIgnoreFlags ignoreFlags) const;
         void Balance() { _dynamicTree.balance(); }
-        void RemoveGameObjectModel(GameObjectModel const& model) { _dynamicTree.remove(model); }
-        void InsertGameObjectModel(GameObjectModel const& model) { _dynamicTree.insert(model); }
-        bool ContainsGameObjectModel(GameObjectModel const& model) const { return _dynamicTree.contains(model);}
+        void RemoveGameObjectModel(GameObjectModel const& model)
+        {
+            std::unique_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeWriteLock();
+            _dynamicTree.remove(model);
+        }
+        void InsertGameObjectModel(GameObjectModel const& model)
+        {
+            std::unique_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeWriteLock();
+            _dynamicTree.insert(model);
+        }
+        bool ContainsGameObjectModel(GameObjectModel const& model) const
+        {
+            std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
+            return _dynamicTree.contains(model);
+        }
         float GetGameObjectFloor(uint32 phasemask, float x, float y, float z, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const
         {
+            std::shared_lock<std::shared_mutex> dynamicTreeLock = AcquireDynamicTreeReadLock();
             return _dynamicTree.getHeight(x, y, z, maxSearchDist, phasemask);
         }
         bool getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float &ry, float& rz, float modifyDist);
@@ -605,14 +634,32 @@ class TC_GAME_API Map : public GridRefManager<NGridType>
 
         void AddUpdateObject(Object* obj)
         {
+            std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
             _updateObjects.insert(obj);
         }
 
         void RemoveUpdateObject(Object* obj)
         {
+            std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
             _updateObjects.erase(obj);
         }
 
+        // only used by the thread sending object updates, see WorldObject::BuildUpdate
+        UpdateFieldFragments& GetUpdateFieldFragments() { return _updateFieldFragments; }
+
+        // MapUpdate.ParallelRegions: true while independent regions of this map are updated on several threads
+        bool IsUpdatingRegionsInParallel() const { return _parallelRegionUpdate.IsActive(); }
+
+        // map wide containers must only be accessed while holding this lock during a parallel region update
+        std::unique_lock<std::recursive_mutex> AcquireParallelUpdateLock() const { return _parallelRegionUpdate.AcquireLock(); }
+
+        // broadcasts that can reach into another region are delayed until all regions are updated
+        bool ShouldDeferBroadcast(float dist) const { return _parallelRegionUpdate.IsActive() && dist > _parallelRegionGuardBand; }
+        void DeferBroadcast(std::function<void()>&& broadcast) { _parallelRegionUpdate.DeferBroadcast(std::move(broadcast)); }
+
+        // work on state shared with other maps or regions (outdoor pvp, battlefields) runs in the serial merge phase
+        void DeferToMergePhase(std::function<void()>&& task) { _parallelRegionUpdate.Defer(std::move(task)); }
+
         size_t GetActiveNonPlayersCount() const
         {
             return m_activeNonPlayers.size();
@@ -623,8 +670,8 @@ class TC_GAME_API Map : public GridRefManager<NGridType>
     private:
         void LoadMapAndVMap(int gx, int gy);
         void LoadVMap(int gx, int gy);
-        void LoadMap(int gx, int gy, bool reload = false);
-        void LoadMMap(int gx, int gy);
+        void LoadMap(int gx, int gy, bool reload = false, PrefetchedGridTerrain* prefetched = nullptr);
+        void LoadMMap(int gx, int gy, MMAP::MMapTileData* preloaded = nullptr);
         GridMap* GetGrid(float x, float y);
 
         void SetTimer(uint32 t) { i_gridExpiry = t < MIN_GRID_DELAY ? MIN_GRID_DELAY : t; }
@@ -671,6 +718,38 @@ class TC_GAME_API Map : public GridRefManager<NGridType>
 
         void SendObjectUpdates();
 
+        void CollectDistantUnitsToUpdate(Player* player, std::vector<Unit*>& units);
+
+        struct RegionUpdateContext;
+        bool UpdateRegionsInParallel(uint32 diff);
+        void UpdateRegion(RegionUpdateContext& region, uint32 diff);
+        template<class CellMarker>
+        void VisitNearbyCellsOf(WorldObject* obj, TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer>& gridVisitor, TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer>& worldVisitor, CellMarker&& markCell);
+
+        // the dynamic tree is queried by every line of sight check, regions only serialize on gameobject model changes
+        std::shared_lock<std::shared_mutex> AcquireDynamicTreeReadLock() const
+        {
+            if (!_parallelRegionUpdate.IsActive())
+                return {};
+
+            return std::shared_lock<std::shared_mutex>(_dynamicTreeLock);
+        }
+
+        std::unique_lock<std::shared_mutex> AcquireDynamicTreeWriteLock() const
+        {
+            if (!_parallelRegionUpdate.IsActive())
+                return {};
+
+            return std::unique_lock<std::shared_mutex>(_dynamicTreeLock);
+        }
+
+        ParallelRegionUpdate _parallelRegionUpdate;
+        float _parallelRegionGuardBand;
+        mutable std::shared_mutex _dynamicTreeLock;
+
+        // GridPrefetch.Enable, continents only
+        std::unique_ptr<GridPrefetcher> _gridPrefetcher;
+
     protected:
         void SetUnloadReferenceLock(GridCoord const& p, bool on) { getNGrid(p.x_coord, p.y_coord)->setUnloadReferenceLock(on); }
 
@@ -869,6 +948,7 @@ class TC_GAME_API Map : public GridRefManager<NGridType>
         std::unordered_set<Corpse*> _corpseBones;
 
         std::unordered_set<Object*> _updateObjects;
+        UpdateFieldFragments _updateFieldFragments;
 
         MPSCQueue<FarSpellCallback> _farSpellCallbacks;
 #ifdef ELUNA
@@ -33,7 +33,9 @@
 #include "Player.h"
 #include "WorldSession.h"
 #include "Opcodes.h"
+#include "PathfindingService.h"
 #include "ScriptMgr.h"
+#include "ThreadPool.h"
 #include <numeric>
 #ifdef ELUNA
 #include "LuaEngine.h"
@@ -62,6 +64,18 @@ void MapManager::Initialize()
     if (num_threads > 0)
         m_updater.activate(num_threads);
 
+    if (sWorld->getBoolConfig(CONFIG_MAPUPDATE_PARALLEL_REGIONS) && sWorld->getIntConfig(CONFIG_MAPUPDATE_PARALLEL_REGIONS_THREADS) > 0)
+        _regionUpdatePool = std::make_unique<Trinity::ThreadPool>(sWorld->getIntConfig(CONFIG_MAPUPDATE_PARALLEL_REGIONS_THREADS));
+
+    if (sWorld->getBoolConfig(CONFIG_GRID_PREFETCH))
+        _gridPrefetchPool = std::make_unique<Trinity::ThreadPool>(sWorld->getIntConfig(CONFIG_GRID_PREFETCH_THREADS));
+
+    if (sWorld->getBoolConfig(CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD))
+        _packetBuildPool = std::make_unique<Trinity::ThreadPool>(sWorld->getIntConfig(CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS));
+
+    sPathfindingService->Initialize(sWorld->getBoolConfig(CONFIG_PATHFINDING_ASYNC) ? sWorld->getIntConfig(CONFIG_PATHFINDING_ASYNC_THREADS) : 0,
+        sWorld->getIntConfig(CONFIG_PATHFINDING_CACHE_SIZE), Milliseconds(sWorld->getIntConfig(CONFIG_PATHFINDING_CACHE_TIMEOUT)));
+
     //npcbot: load bots
     BotMgr::Initialize();
     //end npcbot
@@ -298,6 +312,26 @@ void MapManager::UnloadAll()
     if (m_updater.activated())
         m_updater.deactivate();
 
+    if (_regionUpdatePool)
+    {
+        _regionUpdatePool->Join();
+        _regionUpdatePool.reset();
+    }
+
+    if (_gridPrefetchPool)
+    {
+        _gridPrefetchPool->Join();
+        _gridPrefetchPool.reset();
+    }
+
+    if (_packetBuildPool)
+    {
+        _packetBuildPool->Join();
+        _packetBuildPool.reset();
+    }
+
+    sPathfindingService->Unload();
+
     Map::DeleteStateMachine();
 }
 
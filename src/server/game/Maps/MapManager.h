@@ -29,6 +29,11 @@
 class Transport;
 struct TransportCreatureProto;
 
+namespace Trinity
+{
+    class ThreadPool;
+}
+
 class TC_GAME_API MapManager
 {
     public:
@@ -64,6 +69,13 @@ class TC_GAME_API MapManager
         void Initialize(void);
         void Update(uint32);
 
+        // thread pool for MapUpdate.ParallelRegions, nullptr when disabled
+        Trinity::ThreadPool* GetRegionUpdatePool() const { return _regionUpdatePool.get(); }
+        // thread pool reading terrain for GridPrefetch, nullptr when disabled
+        Trinity::ThreadPool* GetGridPrefetchPool() const { return _gridPrefetchPool.get(); }
+        // thread pool building object update packets for MapUpdate.ParallelPacketBuild, nullptr when disabled
+        Trinity::ThreadPool* GetPacketBuildPool() const { return _packetBuildPool.get(); }
+
         void SetGridCleanUpDelay(uint32 t)
         {
             if (t < MIN_GRID_DELAY)
@@ -164,6 +176,9 @@ class TC_GAME_API MapManager
         InstanceIds _freeInstanceIds;
         uint32 _nextInstanceId;
         MapUpdater m_updater;
+        std::unique_ptr<Trinity::ThreadPool> _regionUpdatePool;
+        std::unique_ptr<Trinity::ThreadPool> _gridPrefetchPool;
+        std::unique_ptr<Trinity::ThreadPool> _packetBuildPool;
 
         // atomic op counter for active scripts amount
         std::atomic<std::size_t> _scheduledScripts;
@@ -0,0 +1,121 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapRegionPartitioner.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+    class DisjointSet
+    {
+    public:
+        explicit DisjointSet(std::size_t size) : _parents(size)
+        {
+            std::iota(_parents.begin(), _parents.end(), std::size_t(0));
+        }
+
+        std::size_t Find(std::size_t index)
+        {
+            while (_parents[index] != index)
+            {
+                _parents[index] = _parents[_parents[index]];
+                index = _parents[index];
+            }
+            return index;
+        }
+
+        // the lowest index always becomes the root, keeps the result independent of union order
+        void Union(std::size_t left, std::size_t right)
+        {
+            left = Find(left);
+            right = Find(right);
+            if (left < right)
+                _parents[right] = left;
+            else if (right < left)
+                _parents[left] = right;
+        }
+
+    private:
+        std::vector<std::size_t> _parents;
+    };
+
+    uint32 Distance(uint32 left, uint32 right)
+    {
+        return left > right ? left - right : right - left;
+    }
+}
+
+std::vector<MapRegionPartitioner::Region> MapRegionPartitioner::Partition(std::vector<CellCoord> const& anchors, std::vector<std::pair<std::size_t, std::size_t>> const& links, uint32 separation)
+{
+    separation = std::max(separation, 1u);
+
+    DisjointSet regions(anchors.size());
+
+    // anchors closer than `separation` can only be in the same or in a neighbouring bucket
+    std::unordered_map<uint64, std::vector<std::size_t>> buckets;
+    for (std::size_t i = 0; i < anchors.size(); ++i)
+        buckets[(uint64(anchors[i].x_coord / separation) << 32) | (anchors[i].y_coord / separation)].push_back(i);
+
+    for (std::size_t i = 0; i < anchors.size(); ++i)
+    {
+        uint32 bucketX = anchors[i].x_coord / separation;
+        uint32 bucketY = anchors[i].y_coord / separation;
+        for (uint32 x = bucketX > 0 ? bucketX - 1 : 0; x <= bucketX + 1; ++x)
+        {
+            for (uint32 y = bucketY > 0 ? bucketY - 1 : 0; y <= bucketY + 1; ++y)
+            {
+                auto itr = buckets.find((uint64(x) << 32) | y);
+                if (itr == buckets.end())
+                    continue;
+
+                for (std::size_t other : itr->second)
+                    if (other > i && Distance(anchors[i].x_coord, anchors[other].x_coord) < separation && Distance(anchors[i].y_coord, anchors[other].y_coord) < separation)
+                        regions.Union(i, other);
+            }
+        }
+    }
+
+    for (std::pair<std::size_t, std::size_t> const& link : links)
+        if (link.first < anchors.size() && link.second < anchors.size())
+            regions.Union(link.first, link.second);
+
+    std::vector<Region> result;
+    std::vector<std::size_t> regionIndexByRoot(anchors.size(), anchors.size());
+    for (std::size_t i = 0; i < anchors.size(); ++i)
+    {
+        std::size_t root = regions.Find(i);
+        if (regionIndexByRoot[root] == anchors.size())
+        {
+            regionIndexByRoot[root] = result.size();
+            result.emplace_back();
+        }
+
+        result[regionIndexByRoot[root]].push_back(i);
+    }
+
+    return result;
+}
+
+uint32 MapRegionPartitioner::GetRequiredSeparation(float activationRange, float guardBand)
+{
+    // both anchors update everything within activationRange and may reach guardBand further out,
+    // CellArea rounding can add another cell on each side
+    return uint32(std::ceil(2.0f * (activationRange + guardBand) / SIZE_OF_GRID_CELL)) + 2;
+}
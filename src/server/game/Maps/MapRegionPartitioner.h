@@ -0,0 +1,44 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_MAP_REGION_PARTITIONER_H
+#define TRINITY_MAP_REGION_PARTITIONER_H
+
+#include "Define.h"
+#include "GridDefines.h"
+#include <utility>
+#include <vector>
+
+/*
+ * Splits the update anchors of a map (players, their viewpoints, far combat targets...) into regions
+ * that can be updated independently of each other.
+ * Two anchors end up in the same region when they are closer than `separation` cells on either axis
+ * or when they are explicitly linked. The result only depends on the input order: regions are sorted
+ * by their first anchor and every region lists its anchors in ascending order.
+ */
+class TC_GAME_API MapRegionPartitioner
+{
+public:
+    typedef std::vector<std::size_t> Region;
+
+    static std::vector<Region> Partition(std::vector<CellCoord> const& anchors, std::vector<std::pair<std::size_t, std::size_t>> const& links, uint32 separation);
+
+    /// Number of cells two anchors must be apart so that the areas updated and touched around them never overlap
+    static uint32 GetRequiredSeparation(float activationRange, float guardBand);
+};
+
+#endif // TRINITY_MAP_REGION_PARTITIONER_H
@@ -55,14 +55,18 @@ void Map::ScriptsStart(std::map<uint32, std::multimap<uint32, ScriptInfo>> const
         sa.ownerGUID  = ownerGUID;
 
         sa.script = &iter->second;
-        m_scriptSchedule.insert(ScriptScheduleMap::value_type(time_t(GameTime::GetGameTime() + iter->first), sa));
+        {
+            std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+            m_scriptSchedule.insert(ScriptScheduleMap::value_type(time_t(GameTime::GetGameTime() + iter->first), sa));
+        }
         if (iter->first == 0)
             immedScript = true;
 
         sMapMgr->IncreaseScheduledScriptsCount();
     }
     ///- If one of the effects should be immediate, launch the script execution
-    if (/*start &&*/ immedScript && !i_scriptLock)
+    ///- Scripts may act on objects of other regions, while regions are updated in parallel Map::Update runs them after the regions joined
+    if (/*start &&*/ immedScript && !i_scriptLock && !IsUpdatingRegionsInParallel())
     {
         i_scriptLock = true;
         ScriptsProcess();
@@ -85,12 +89,15 @@ void Map::ScriptCommandStart(ScriptInfo const& script, uint32 delay, Object* sou
     sa.ownerGUID  = ownerGUID;
 
     sa.script = &script;
-    m_scriptSchedule.insert(ScriptScheduleMap::value_type(time_t(GameTime::GetGameTime() + delay), sa));
+    {
+        std::unique_lock<std::recursive_mutex> parallelUpdateLock = AcquireParallelUpdateLock();
+        m_scriptSchedule.insert(ScriptScheduleMap::value_type(time_t(GameTime::GetGameTime() + delay), sa));
+    }
 
     sMapMgr->IncreaseScheduledScriptsCount();
 
     ///- If effects should be immediate, launch the script execution
-    if (delay == 0 && !i_scriptLock)
+    if (delay == 0 && !i_scriptLock && !IsUpdatingRegionsInParallel())
     {
         i_scriptLock = true;
         ScriptsProcess();
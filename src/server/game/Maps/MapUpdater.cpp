@@ -19,7 +19,9 @@
 #include "DatabaseEnv.h"
 #include "Map.h"
 #include "Metric.h"
+#include "ObjectDefines.h"
 
+#include <algorithm>
 #include <mutex>
 
 class MapUpdateRequest
@@ -29,37 +31,68 @@ class MapUpdateRequest
         Map& m_map;
         MapUpdater& m_updater;
         uint32 m_diff;
+        std::chrono::microseconds m_expectedCost;
 
     public:
 
         MapUpdateRequest(Map& m, MapUpdater& u, uint32 d)
-            : m_map(m), m_updater(u), m_diff(d)
+            : m_map(m), m_updater(u), m_diff(d), m_expectedCost(0)
         {
         }
 
-        void call()
+        Map const& GetMap() const { return m_map; }
+
+        std::chrono::microseconds GetExpectedCost() const { return m_expectedCost; }
+        void SetExpectedCost(std::chrono::microseconds cost) { m_expectedCost = cost; }
+
+        void call(std::atomic<int64>& busyTime)
         {
-            TC_METRIC_TIMER("map_update_time_diff", TC_METRIC_TAG("map_id", std::to_string(m_map.GetId())));
-            m_map.Update (m_diff);
-            m_updater.update_finished();
+            TimePoint startTime = std::chrono::steady_clock::now();
+            TC_METRIC_VALUE("map_update_queue_wait", startTime - m_updater._dispatchTime, TC_METRIC_TAG("map_id", std::to_string(m_map.GetId())));
+
+            {
+                TC_METRIC_TIMER("map_update_time_diff", TC_METRIC_TAG("map_id", std::to_string(m_map.GetId())));
+                m_map.Update(m_diff);
+            }
+
+            // accounted before update_finished, the world thread reads the totals as soon as the last map finished
+            std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - startTime;
+            busyTime += elapsed.count();
+            m_updater.update_finished(m_map, std::chrono::duration_cast<std::chrono::microseconds>(elapsed));
         }
 };
 
+MapUpdater::~MapUpdater()
+{
+    for (MapUpdateRequest* request : _scheduledRequests)
+        delete request;
+
+    for (std::unique_ptr<WorkerQueue> const& queue : _workerQueues)
+        for (MapUpdateRequest* request : queue->Requests)
+            delete request;
+}
+
 void MapUpdater::activate(size_t num_threads)
 {
+    for (size_t i = 0; i < num_threads; ++i)
+        _workerQueues.push_back(std::make_unique<WorkerQueue>());
+
     for (size_t i = 0; i < num_threads; ++i)
     {
-        _workerThreads.push_back(std::thread(&MapUpdater::WorkerThread, this));
+        _workerThreads.push_back(std::thread(&MapUpdater::WorkerThread, this, i));
     }
 }
 
 void MapUpdater::deactivate()
 {
-    _cancelationToken = true;
-
     wait();
 
-    _queue.Cancel();
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _cancelationToken = true;
+    }
+
+    _workAvailable.notify_all();
 
     for (auto& thread : _workerThreads)
     {
@@ -69,12 +102,16 @@ void MapUpdater::deactivate()
 
 void MapUpdater::wait()
 {
+    dispatch();
+
     std::unique_lock<std::mutex> lock(_lock);
 
     while (pending_requests > 0)
         _condition.wait(lock);
 
     lock.unlock();
+
+    ReportTickStatistics();
 }
 
 void MapUpdater::schedule_update(Map& map, uint32 diff)
@@ -83,7 +120,7 @@ void MapUpdater::schedule_update(Map& map, uint32 diff)
 
     ++pending_requests;
 
-    _queue.Push(new MapUpdateRequest(map, *this, diff));
+    _scheduledRequests.push_back(new MapUpdateRequest(map, *this, diff));
 }
 
 bool MapUpdater::activated()
@@ -91,16 +128,127 @@ bool MapUpdater::activated()
     return _workerThreads.size() > 0;
 }
 
-void MapUpdater::update_finished()
+void MapUpdater::dispatch()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    if (_scheduledRequests.empty())
+        return;
+
+    // only keep the cost of maps that are still being updated, unloaded instances would pile up otherwise
+    std::unordered_map<uint64, std::chrono::microseconds> updateCosts;
+    updateCosts.reserve(_scheduledRequests.size());
+    for (MapUpdateRequest* request : _scheduledRequests)
+    {
+        auto itr = _updateCosts.find(GetCostKey(request->GetMap()));
+        if (itr != _updateCosts.end())
+        {
+            request->SetExpectedCost(itr->second);
+            updateCosts.insert(*itr);
+        }
+    }
+    _updateCosts = std::move(updateCosts);
+
+    // longest processing time first: the most expensive maps are started as early as possible
+    // and each one goes to the queue with the least expected work
+    std::stable_sort(_scheduledRequests.begin(), _scheduledRequests.end(), [](MapUpdateRequest const* left, MapUpdateRequest const* right)
+    {
+        return left->GetExpectedCost() > right->GetExpectedCost();
+    });
+
+    std::vector<std::chrono::microseconds> expectedLoad(_workerQueues.size(), std::chrono::microseconds::zero());
+    std::vector<std::vector<MapUpdateRequest*>> assignments(_workerQueues.size());
+    for (MapUpdateRequest* request : _scheduledRequests)
+    {
+        size_t workerIndex = std::distance(expectedLoad.begin(), std::min_element(expectedLoad.begin(), expectedLoad.end()));
+        // maps that were never measured still count for something, otherwise they would all end up on the same thread
+        expectedLoad[workerIndex] += std::max(request->GetExpectedCost(), std::chrono::microseconds(1));
+        assignments[workerIndex].push_back(request);
+    }
+
+    _queuedRequests += _scheduledRequests.size();
+    _scheduledRequests.clear();
+    _dispatchTime = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < _workerQueues.size(); ++i)
+    {
+        std::lock_guard<std::mutex> queueLock(_workerQueues[i]->Lock);
+        _workerQueues[i]->Requests.insert(_workerQueues[i]->Requests.end(), assignments[i].begin(), assignments[i].end());
+    }
+
+    lock.unlock();
+
+    _workAvailable.notify_all();
+}
+
+void MapUpdater::update_finished(Map const& map, std::chrono::microseconds cost)
 {
     std::lock_guard<std::mutex> lock(_lock);
 
+    _updateCosts[GetCostKey(map)] = cost;
+
     --pending_requests;
 
     _condition.notify_all();
 }
 
-void MapUpdater::WorkerThread()
+uint64 MapUpdater::GetCostKey(Map const& map)
+{
+    // not the address, a map created where an unloaded one was freed would inherit its cost
+    return MAKE_PAIR64(map.GetId(), map.GetInstanceId());
+}
+
+void MapUpdater::ReportTickStatistics()
+{
+    std::chrono::nanoseconds tickTime = std::chrono::steady_clock::now() - _dispatchTime;
+
+    for (size_t i = 0; i < _workerQueues.size(); ++i)
+    {
+        WorkerQueue& queue = *_workerQueues[i];
+        int64 busyTime = queue.BusyTime.exchange(0);
+        uint32 steals = queue.Steals.exchange(0);
+
+        if (tickTime.count() <= 0)
+            continue;
+
+        TC_METRIC_VALUE("map_updater_thread_utilization", double(busyTime) * 100.0 / double(tickTime.count()), TC_METRIC_TAG("thread", std::to_string(i)));
+        TC_METRIC_VALUE("map_updater_steals", steals, TC_METRIC_TAG("thread", std::to_string(i)));
+    }
+}
+
+MapUpdateRequest* MapUpdater::PopRequest(size_t workerIndex)
+{
+    {
+        WorkerQueue& queue = *_workerQueues[workerIndex];
+        std::lock_guard<std::mutex> lock(queue.Lock);
+        if (!queue.Requests.empty())
+        {
+            MapUpdateRequest* request = queue.Requests.front();
+            queue.Requests.pop_front();
+            --_queuedRequests;
+            return request;
+        }
+    }
+
+    // own queue is drained, steal the cheapest remaining request of another worker
+    for (size_t i = 1; i < _workerQueues.size(); ++i)
+    {
+        WorkerQueue& victim = *_workerQueues[(workerIndex + i) % _workerQueues.size()];
+        std::lock_guard<std::mutex> lock(victim.Lock);
+        if (!victim.Requests.empty())
+        {
+            MapUpdateRequest* request = victim.Requests.back();
+            victim.Requests.pop_back();
+            --_queuedRequests;
+            ++_workerQueues[workerIndex]->Steals;
+            return request;
+        }
+    }
+
+    return nullptr;
+}
+
+void MapUpdater::WorkerThread(size_t workerIndex)
 {
     LoginDatabase.WarnAboutSyncQueries(true);
     CharacterDatabase.WarnAboutSyncQueries(true);
@@ -108,14 +256,21 @@ void MapUpdater::WorkerThread()
 
     while (true)
     {
-        MapUpdateRequest* request = nullptr;
+        MapUpdateRequest* request = PopRequest(workerIndex);
 
-        _queue.WaitAndPop(request);
+        if (!request)
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+
+            _workAvailable.wait(lock, [this]() { return _cancelationToken || _queuedRequests > 0; });
 
-        if (_cancelationToken)
-            return;
+            if (_cancelationToken)
+                return;
+
+            continue;
+        }
 
-        request->call();
+        request->call(_workerQueues[workerIndex]->BusyTime);
 
         delete request;
     }
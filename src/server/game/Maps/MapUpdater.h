@@ -19,20 +19,33 @@
 #define _MAP_UPDATER_H_INCLUDED
 
 #include "Define.h"
+#include "Duration.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <condition_variable>
-#include "ProducerConsumerQueue.h"
+#include <unordered_map>
+#include <vector>
 
 class MapUpdateRequest;
 class Map;
 
+/*
+ * Updates maps on a pool of worker threads.
+ * Requests are collected by schedule_update and handed out to the workers once wait() is called:
+ * maps are sorted by their last measured update time (longest first) and spread over per-thread
+ * queues so that every worker starts with roughly the same amount of work. A worker that runs out
+ * of requests steals from the back of the other queues, so a single heavy instance cannot leave
+ * the remaining threads idle until the end of the tick.
+ */
 class TC_GAME_API MapUpdater
 {
     public:
 
-        MapUpdater() : _cancelationToken(false), pending_requests(0) {}
-        ~MapUpdater() { };
+        MapUpdater() : _cancelationToken(false), pending_requests(0), _queuedRequests(0) {}
+        ~MapUpdater();
 
         friend class MapUpdateRequest;
 
@@ -48,18 +61,41 @@ class TC_GAME_API MapUpdater
 
     private:
 
-        ProducerConsumerQueue<MapUpdateRequest*> _queue;
+        struct WorkerQueue
+        {
+            std::mutex Lock;
+            std::deque<MapUpdateRequest*> Requests;
+
+            // statistics of the current tick, reset by wait()
+            std::atomic<int64> BusyTime{ 0 };
+            std::atomic<uint32> Steals{ 0 };
+        };
+
+        std::vector<MapUpdateRequest*> _scheduledRequests;
+        std::vector<std::unique_ptr<WorkerQueue>> _workerQueues;
+        std::unordered_map<uint64, std::chrono::microseconds> _updateCosts;     ///< last update time by map id and instance id
 
         std::vector<std::thread> _workerThreads;
         std::atomic<bool> _cancelationToken;
 
         std::mutex _lock;
         std::condition_variable _condition;
+        std::condition_variable _workAvailable;
         size_t pending_requests;
+        std::atomic<size_t> _queuedRequests;
+        TimePoint _dispatchTime;
+
+        void dispatch();
+
+        void update_finished(Map const& map, std::chrono::microseconds cost);
+
+        static uint64 GetCostKey(Map const& map);
+
+        void ReportTickStatistics();
 
-        void update_finished();
+        MapUpdateRequest* PopRequest(size_t workerIndex);
 
-        void WorkerThread();
+        void WorkerThread(size_t workerIndex);
 };
 
 #endif //_MAP_UPDATER_H_INCLUDED
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelRegionUpdate.h"
+#include "ThreadPool.h"
+#include <exception>
+#include <future>
+#include <memory>
+
+ParallelRegionUpdate::ParallelRegionUpdate() : _active(false)
+{
+}
+
+std::unique_lock<std::recursive_mutex> ParallelRegionUpdate::AcquireLock() const
+{
+    if (!_active)
+        return {};
+
+    return std::unique_lock<std::recursive_mutex>(_lock);
+}
+
+void ParallelRegionUpdate::Defer(std::function<void()>&& task)
+{
+    std::unique_lock<std::recursive_mutex> lock = AcquireLock();
+
+    _deferredTasks.push_back(std::move(task));
+}
+
+void ParallelRegionUpdate::DeferBroadcast(std::function<void()>&& broadcast)
+{
+    std::unique_lock<std::recursive_mutex> lock = AcquireLock();
+
+    _deferredBroadcasts.push_back(std::move(broadcast));
+}
+
+void ParallelRegionUpdate::Run(Trinity::ThreadPool& pool, std::size_t regionCount, std::function<void(std::size_t)> const& updateRegion)
+{
+    if (!regionCount)
+        return;
+
+    _active = true;
+
+    std::vector<std::future<void>> pendingRegions;
+    pendingRegions.reserve(regionCount - 1);
+    for (std::size_t i = 1; i < regionCount; ++i)
+    {
+        std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<std::packaged_task<void()>>([&updateRegion, i]()
+        {
+            updateRegion(i);
+        });
+
+        pendingRegions.push_back(task->get_future());
+        pool.PostWork([task]() { (*task)(); });
+    }
+
+    // the calling thread takes the first region itself
+    std::exception_ptr error;
+    try
+    {
+        updateRegion(0);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // every region has to be done before the shared state may be used without the lock again
+    for (std::future<void>& pendingRegion : pendingRegions)
+    {
+        try
+        {
+            pendingRegion.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    _active = false;
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+ParallelRegionUpdate::DeferredCounts ParallelRegionUpdate::RunDeferred()
+{
+    DeferredCounts counts;
+
+    std::vector<std::function<void()>> deferredTasks;
+    std::swap(deferredTasks, _deferredTasks);
+    for (std::function<void()> const& task : deferredTasks)
+        task();
+
+    // tasks may broadcast themselves, those are sent right away as no region is running anymore
+    std::vector<std::function<void()>> deferredBroadcasts;
+    std::swap(deferredBroadcasts, _deferredBroadcasts);
+    for (std::function<void()> const& broadcast : deferredBroadcasts)
+        broadcast();
+
+    counts.Tasks = deferredTasks.size();
+    counts.Broadcasts = deferredBroadcasts.size();
+    return counts;
+}
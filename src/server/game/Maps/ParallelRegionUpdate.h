@@ -0,0 +1,69 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PARALLEL_REGION_UPDATE_H
+#define TRINITY_PARALLEL_REGION_UPDATE_H
+
+#include "Define.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Trinity
+{
+    class ThreadPool;
+}
+
+/*
+ * Runs the update of independent regions of a map (see MapRegionPartitioner) on several threads.
+ * While the regions run, state shared between them must either be accessed while holding AcquireLock
+ * or be changed by a deferred task. Deferred tasks and broadcasts run in RunDeferred on the calling
+ * thread once all regions are done, tasks in the order they were queued and before the broadcasts.
+ */
+class TC_GAME_API ParallelRegionUpdate
+{
+public:
+    struct DeferredCounts
+    {
+        std::size_t Tasks = 0;
+        std::size_t Broadcasts = 0;
+    };
+
+    ParallelRegionUpdate();
+
+    bool IsActive() const { return _active; }
+
+    /// Only locks while regions are updated in parallel
+    std::unique_lock<std::recursive_mutex> AcquireLock() const;
+
+    void Defer(std::function<void()>&& task);
+    void DeferBroadcast(std::function<void()>&& broadcast);
+
+    /// Updates every region once, the first one on the calling thread and the others on the pool, returns when all are done
+    void Run(Trinity::ThreadPool& pool, std::size_t regionCount, std::function<void(std::size_t)> const& updateRegion);
+
+    DeferredCounts RunDeferred();
+
+private:
+    std::atomic<bool> _active;
+    mutable std::recursive_mutex _lock;
+    std::vector<std::function<void()>> _deferredTasks;
+    std::vector<std::function<void()>> _deferredBroadcasts;
+};
+
+#endif // TRINITY_PARALLEL_REGION_UPDATE_H
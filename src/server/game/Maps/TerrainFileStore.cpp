@@ -0,0 +1,141 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TerrainFileStore.h"
+#include "Log.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdio>
+#include <vector>
+
+struct TerrainFile::Storage
+{
+    boost::interprocess::file_mapping Mapping;
+    boost::interprocess::mapped_region Region;
+    std::vector<uint8> Buffer;
+};
+
+TerrainFile::TerrainFile() : _data(nullptr), _size(0), _mapped(false), _storage(std::make_unique<Storage>()) { }
+
+TerrainFile::~TerrainFile() = default;
+
+TerrainFileStore* TerrainFileStore::instance()
+{
+    static TerrainFileStore instance;
+    return &instance;
+}
+
+std::shared_ptr<TerrainFile const> TerrainFileStore::Acquire(std::string const& fileName)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    std::weak_ptr<TerrainFile const>& cached = _files[fileName];
+    if (std::shared_ptr<TerrainFile const> file = cached.lock())
+        return file;
+
+    FILE* in = fopen(fileName.c_str(), "rb");
+    if (!in)
+    {
+        _files.erase(fileName);
+        return nullptr;
+    }
+
+    std::unique_ptr<TerrainFile> file(new TerrainFile());
+    try
+    {
+        file->_storage->Mapping = boost::interprocess::file_mapping(fileName.c_str(), boost::interprocess::read_only);
+        file->_storage->Region = boost::interprocess::mapped_region(file->_storage->Mapping, boost::interprocess::read_only);
+        file->_data = static_cast<uint8 const*>(file->_storage->Region.get_address());
+        file->_size = file->_storage->Region.get_size();
+        file->_mapped = true;
+    }
+    catch (boost::interprocess::interprocess_exception const& e)
+    {
+        // empty files cannot be mapped, other failures are unexpected but reading still works
+        TC_LOG_DEBUG("maps", "TerrainFileStore: could not map '{}' ({}), reading it instead", fileName, e.what());
+
+        std::vector<uint8>& buffer = file->_storage->Buffer;
+        if (fseek(in, 0, SEEK_END) == 0)
+        {
+            long size = ftell(in);
+            if (size > 0 && fseek(in, 0, SEEK_SET) == 0)
+            {
+                buffer.resize(std::size_t(size));
+                if (fread(buffer.data(), 1, buffer.size(), in) != buffer.size())
+                    buffer.clear();
+            }
+        }
+
+        file->_data = buffer.data();
+        file->_size = buffer.size();
+    }
+
+    fclose(in);
+
+    // the entry is dropped together with the last reference
+    std::shared_ptr<TerrainFile const> result(file.release(), [this, fileName](TerrainFile const* released)
+    {
+        Release(fileName, released);
+    });
+    cached = result;
+    return result;
+}
+
+void TerrainFileStore::Release(std::string const& fileName, TerrainFile const* file)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        // Acquire may have opened the file again meanwhile
+        auto itr = _files.find(fileName);
+        if (itr != _files.end() && itr->second.expired())
+            _files.erase(itr);
+    }
+
+    delete file;
+}
+
+std::size_t TerrainFileStore::GetOpenFileCount() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    std::size_t count = 0;
+    for (std::pair<std::string const, std::weak_ptr<TerrainFile const>> const& file : _files)
+        if (!file.second.expired())
+            ++count;
+
+    return count;
+}
+
+std::size_t TerrainFileStore::GetOpenFileBytes() const
+{
+    // the references taken here may be the last ones, they must be dropped outside of the lock
+    std::vector<std::shared_ptr<TerrainFile const>> files;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        files.reserve(_files.size());
+        for (std::pair<std::string const, std::weak_ptr<TerrainFile const>> const& file : _files)
+            if (std::shared_ptr<TerrainFile const> terrain = file.second.lock())
+                files.push_back(std::move(terrain));
+    }
+
+    std::size_t bytes = 0;
+    for (std::shared_ptr<TerrainFile const> const& file : files)
+        bytes += file->GetSize();
+
+    return bytes;
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_TERRAIN_FILE_STORE_H
+#define TRINITY_TERRAIN_FILE_STORE_H
+
+#include "Define.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Read-only contents of one terrain file, memory mapped when the platform allows it
+class TC_GAME_API TerrainFile
+{
+public:
+    ~TerrainFile();
+
+    TerrainFile(TerrainFile const&) = delete;
+    TerrainFile& operator=(TerrainFile const&) = delete;
+
+    uint8 const* GetData() const { return _data; }
+    std::size_t GetSize() const { return _size; }
+    bool IsMapped() const { return _mapped; }
+
+private:
+    friend class TerrainFileStore;
+
+    struct Storage;
+
+    TerrainFile();
+
+    uint8 const* _data;
+    std::size_t _size;
+    bool _mapped;
+    std::unique_ptr<Storage> _storage;
+};
+
+/*
+ * Opens every terrain (.map) file once, grids of all maps and threads loading the same
+ * file share its read-only pages. Files are closed when the last grid using them is unloaded.
+ */
+class TC_GAME_API TerrainFileStore
+{
+public:
+    static TerrainFileStore* instance();
+
+    TerrainFileStore(TerrainFileStore const&) = delete;
+    TerrainFileStore& operator=(TerrainFileStore const&) = delete;
+
+    // Thread safe, nullptr when the file does not exist or cannot be read
+    std::shared_ptr<TerrainFile const> Acquire(std::string const& fileName);
+
+    std::size_t GetOpenFileCount() const;
+    std::size_t GetOpenFileBytes() const;
+
+private:
+    TerrainFileStore() = default;
+
+    void Release(std::string const& fileName, TerrainFile const* file);
+
+    mutable std::mutex _lock;
+    std::unordered_map<std::string, std::weak_ptr<TerrainFile const>> _files;
+};
+
+#define sTerrainFileStore TerrainFileStore::instance()
+
+#endif // TRINITY_TERRAIN_FILE_STORE_H
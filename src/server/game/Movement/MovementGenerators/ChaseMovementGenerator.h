@@ -46,6 +46,8 @@ class ChaseMovementGenerator : public MovementGenerator, public AbstractFollower
     private:
         static constexpr uint32 RANGE_CHECK_INTERVAL = 100; // time (ms) until we attempt to recalculate
 
+        void LaunchMovement(Unit* owner, Unit* target, bool success, bool shortenPath, float maxTarget);
+
         Optional<ChaseRange> const _range;
         Optional<ChaseAngle> const _angle;
 
@@ -54,6 +56,7 @@ class ChaseMovementGenerator : public MovementGenerator, public AbstractFollower
         TimeTracker _rangeCheckTimer;
         bool _movingTowards = true;
         bool _mutualChase = true;
+        bool _shortenPath = false;          // of the path still being calculated
 };
 
 #endif
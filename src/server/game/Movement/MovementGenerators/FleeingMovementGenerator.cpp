@@ -84,6 +84,14 @@ bool FleeingMovementGenerator<T>::DoUpdate(T* owner, uint32 diff)
     else
         MovementGenerator::RemoveFlag(MOVEMENTGENERATOR_FLAG_INTERRUPTED);
 
+    // the path requested on an earlier update is still being searched
+    if (_path && _path->IsPathPending())
+    {
+        if (_path->UpdatePendingPath())
+            LaunchMovement(owner, true);
+        return true;
+    }
+
     _timer.Update(diff);
     if ((MovementGenerator::HasFlag(MOVEMENTGENERATOR_FLAG_SPEED_UPDATE_PENDING) && !owner->movespline->Finalized()) || (_timer.Passed() && owner->movespline->Finalized()))
     {
@@ -163,8 +171,17 @@ void FleeingMovementGenerator<T>::SetTargetLocation(T* owner)
         _path->SetPathLengthLimit(30.0f);
     }
 
-    bool result = _path->CalculatePath(destination.GetPositionX(), destination.GetPositionY(), destination.GetPositionZ());
-    if (!result || (_path->GetPathType() & PATHFIND_NOPATH)
+    bool result = _path->CalculatePathAsync(destination.GetPositionX(), destination.GetPositionY(), destination.GetPositionZ());
+    if (result && _path->IsPathPending())
+        return;
+
+    LaunchMovement(owner, result);
+}
+
+template<class T>
+void FleeingMovementGenerator<T>::LaunchMovement(T* owner, bool pathCalculated)
+{
+    if (!pathCalculated || (_path->GetPathType() & PATHFIND_NOPATH)
                 || (_path->GetPathType() & PATHFIND_SHORTCUT)
                 || (_path->GetPathType() & PATHFIND_FARFROMPOLY))
     {
@@ -233,6 +250,8 @@ template void FleeingMovementGenerator<Player>::DoDeactivate(Player*);
 template void FleeingMovementGenerator<Creature>::DoDeactivate(Creature*);
 template void FleeingMovementGenerator<Player>::SetTargetLocation(Player*);
 template void FleeingMovementGenerator<Creature>::SetTargetLocation(Creature*);
+template void FleeingMovementGenerator<Player>::LaunchMovement(Player*, bool);
+template void FleeingMovementGenerator<Creature>::LaunchMovement(Creature*, bool);
 template void FleeingMovementGenerator<Player>::GetPoint(Player*, Position &);
 template void FleeingMovementGenerator<Creature>::GetPoint(Creature*, Position &);
 
@@ -44,6 +44,7 @@ class FleeingMovementGenerator : public MovementGeneratorMedium<T, FleeingMoveme
 
     private:
         void SetTargetLocation(T*);
+        void LaunchMovement(T*, bool pathCalculated);
         void GetPoint(T*, Position& position);
 
         std::unique_ptr<PathGenerator> _path;
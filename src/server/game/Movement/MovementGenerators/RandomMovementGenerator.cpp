@@ -105,44 +105,13 @@ void RandomMovementGenerator<Creature>::DoReset(Creature* owner)
 }
 
 template<class T>
-void RandomMovementGenerator<T>::SetRandomLocation(T*) { }
+void RandomMovementGenerator<T>::LaunchMovement(T*, bool) { }
 
 template<>
-void RandomMovementGenerator<Creature>::SetRandomLocation(Creature* owner)
+void RandomMovementGenerator<Creature>::LaunchMovement(Creature* owner, bool pathCalculated)
 {
-    if (!owner)
-        return;
-
-    if (owner->HasUnitState(UNIT_STATE_NOT_MOVE | UNIT_STATE_LOST_CONTROL) || owner->IsMovementPreventedByCasting())
-    {
-        AddFlag(MOVEMENTGENERATOR_FLAG_INTERRUPTED);
-        owner->StopMoving();
-        _path = nullptr;
-        return;
-    }
-
-    Position position(_reference);
-    float distance = frand(0.f, _wanderDistance);
-    float angle = frand(0.f, float(M_PI * 2));
-    owner->MovePositionToFirstCollision(position, distance, angle);
-
-    // Check if the destination is in LOS
-    if (!owner->IsWithinLOS(position.GetPositionX(), position.GetPositionY(), position.GetPositionZ()))
-    {
-        // Retry later on
-        _timer.Reset(200);
-        return;
-    }
-
-    if (!_path)
-    {
-        _path = std::make_unique<PathGenerator>(owner);
-        _path->SetPathLengthLimit(30.0f);
-    }
-
-    bool result = _path->CalculatePath(position.GetPositionX(), position.GetPositionY(), position.GetPositionZ());
     // PATHFIND_FARFROMPOLY shouldn't be checked as creatures in water are most likely far from poly
-    if (!result || (_path->GetPathType() & PATHFIND_NOPATH)
+    if (!pathCalculated || (_path->GetPathType() & PATHFIND_NOPATH)
                 || (_path->GetPathType() & PATHFIND_SHORTCUT)
                 /*|| (_path->GetPathType() & PATHFIND_FARFROMPOLY)*/)
     {
@@ -186,6 +155,49 @@ void RandomMovementGenerator<Creature>::SetRandomLocation(Creature* owner)
     owner->SignalFormationMovement();
 }
 
+template<class T>
+void RandomMovementGenerator<T>::SetRandomLocation(T*) { }
+
+template<>
+void RandomMovementGenerator<Creature>::SetRandomLocation(Creature* owner)
+{
+    if (!owner)
+        return;
+
+    if (owner->HasUnitState(UNIT_STATE_NOT_MOVE | UNIT_STATE_LOST_CONTROL) || owner->IsMovementPreventedByCasting())
+    {
+        AddFlag(MOVEMENTGENERATOR_FLAG_INTERRUPTED);
+        owner->StopMoving();
+        _path = nullptr;
+        return;
+    }
+
+    Position position(_reference);
+    float distance = frand(0.f, _wanderDistance);
+    float angle = frand(0.f, float(M_PI * 2));
+    owner->MovePositionToFirstCollision(position, distance, angle);
+
+    // Check if the destination is in LOS
+    if (!owner->IsWithinLOS(position.GetPositionX(), position.GetPositionY(), position.GetPositionZ()))
+    {
+        // Retry later on
+        _timer.Reset(200);
+        return;
+    }
+
+    if (!_path)
+    {
+        _path = std::make_unique<PathGenerator>(owner);
+        _path->SetPathLengthLimit(30.0f);
+    }
+
+    bool result = _path->CalculatePathAsync(position.GetPositionX(), position.GetPositionY(), position.GetPositionZ());
+    if (result && _path->IsPathPending())
+        return;
+
+    LaunchMovement(owner, result);
+}
+
 template<class T>
 bool RandomMovementGenerator<T>::DoUpdate(T*, uint32)
 {
@@ -211,6 +223,14 @@ bool RandomMovementGenerator<Creature>::DoUpdate(Creature* owner, uint32 diff)
     else
         RemoveFlag(MOVEMENTGENERATOR_FLAG_INTERRUPTED);
 
+    // the path requested on an earlier update is still being searched
+    if (_path && _path->IsPathPending())
+    {
+        if (_path->UpdatePendingPath())
+            LaunchMovement(owner, true);
+        return true;
+    }
+
     _timer.Update(diff);
     if ((HasFlag(MOVEMENTGENERATOR_FLAG_SPEED_UPDATE_PENDING) && !owner->movespline->Finalized()) || (_timer.Passed() && owner->movespline->Finalized()))
         SetRandomLocation(owner);
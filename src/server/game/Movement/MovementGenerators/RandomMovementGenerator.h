@@ -45,6 +45,7 @@ class RandomMovementGenerator : public MovementGeneratorMedium<T, RandomMovement
 
     private:
         void SetRandomLocation(T*);
+        void LaunchMovement(T*, bool pathCalculated);
 
         std::unique_ptr<PathGenerator> _path;
         TimeTracker _timer;
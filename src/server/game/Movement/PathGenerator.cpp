@@ -25,13 +25,63 @@
 #include "DetourCommon.h"
 #include "DetourNavMeshQuery.h"
 #include "Metric.h"
+#include "PathfindingService.h"
+#include <algorithm>
+
+namespace
+{
+    // map terrain queries can create grids and load their navmesh tiles, which needs the navmesh lock exclusively
+    class NavMeshUnlockScope
+    {
+    public:
+        explicit NavMeshUnlockScope(std::shared_lock<std::shared_mutex>& lock) : _lock(lock), _locked(lock.owns_lock())
+        {
+            if (_locked)
+                _lock.unlock();
+        }
+
+        ~NavMeshUnlockScope()
+        {
+            if (_locked)
+                _lock.lock();
+        }
+
+        NavMeshUnlockScope(NavMeshUnlockScope const&) = delete;
+        NavMeshUnlockScope& operator=(NavMeshUnlockScope const&) = delete;
+
+    private:
+        std::shared_lock<std::shared_mutex>& _lock;
+        bool _locked;
+    };
+
+    // holds the navmesh read lock of a generator while it runs detour queries
+    class NavMeshReadScope
+    {
+    public:
+        NavMeshReadScope(std::shared_lock<std::shared_mutex>& lock, std::shared_lock<std::shared_mutex>&& acquired) : _lock(lock)
+        {
+            _lock = std::move(acquired);
+        }
+
+        ~NavMeshReadScope()
+        {
+            _lock = std::shared_lock<std::shared_mutex>();
+        }
+
+        NavMeshReadScope(NavMeshReadScope const&) = delete;
+        NavMeshReadScope& operator=(NavMeshReadScope const&) = delete;
+
+    private:
+        std::shared_lock<std::shared_mutex>& _lock;
+    };
+}
 
 ////////////////// PathGenerator //////////////////
 PathGenerator::PathGenerator(WorldObject const* owner) :
     _polyLength(0), _type(PATHFIND_BLANK), _useStraightPath(false),
     _forceDestination(false), _pointPathLimit(MAX_POINT_PATH_LENGTH), _useRaycast(false),
     _endPosition(G3D::Vector3::zero()), _source(owner), _navMesh(nullptr),
-    _navMeshQuery(nullptr)
+    _navMeshQuery(nullptr), _async(false), _search()
 {
     memset(_pathPolyRefs, 0, sizeof(_pathPolyRefs));
 
@@ -39,11 +89,7 @@ PathGenerator::PathGenerator(WorldObject const* owner) :
 
     uint32 mapId = _source->GetMapId();
     if (DisableMgr::IsPathfindingEnabled(mapId))
-    {
-        MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-        _navMeshQuery = mmap->GetNavMeshQuery(mapId, _source->GetInstanceId());
-        _navMesh = _navMeshQuery ? _navMeshQuery->getAttachedNavMesh() : mmap->GetNavMesh(mapId);
-    }
+        _navMesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(mapId);
 
     CreateFilter();
 }
@@ -55,6 +101,66 @@ PathGenerator::~PathGenerator()
 
 bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool forceDest)
 {
+    return BuildPath(destX, destY, destZ, forceDest, false);
+}
+
+bool PathGenerator::CalculatePathAsync(float destX, float destY, float destZ, bool forceDest)
+{
+    return BuildPath(destX, destY, destZ, forceDest, sPathfindingService->IsAsyncEnabled());
+}
+
+bool PathGenerator::UpdatePendingPath()
+{
+    if (!_pendingSearch)
+        return true;
+
+    if (!_pendingSearch->IsDone())
+        return false;
+
+    std::shared_ptr<NavMeshSearch const> search = std::move(_pendingSearch);
+
+    // the source may have been teleported while the search was running
+    uint32 mapId = _source->GetMapId();
+    if (search->GetMapId() != mapId)
+    {
+        BuildShortcut();
+        _type = PATHFIND_NOPATH;
+        return true;
+    }
+
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    NavMeshReadScope navMeshLock(_navMeshLock, mmap->AcquireNavMeshReadLock(mapId));
+    _navMeshQuery = _navMeshLock.owns_lock() ? mmap->GetNavMeshQuery(mapId) : nullptr;
+    if (!_navMeshQuery)
+    {
+        BuildShortcut();
+        _type = PATHFIND_NOPATH;
+        return true;
+    }
+
+    // tiles along the corridor may have been unloaded meanwhile
+    std::vector<dtPolyRef> const& path = search->GetPath();
+    uint32 length = std::min(uint32(path.size()), MAX_PATH_LENGTH - _search.PrefixLength);
+    dtStatus result = search->GetStatus();
+    if (!std::all_of(path.begin(), path.begin() + length, [this](dtPolyRef ref) { return _navMesh->isValidPolyRef(ref); }))
+    {
+        length = 0;
+        result = DT_FAILURE;
+    }
+
+    std::copy_n(path.begin(), length, _pathPolyRefs + (_search.PrefixLength ? _search.PrefixLength - 1 : 0));
+    if (SetSearchedPolyPath(result, length))
+        BuildPointPathFromPolyPath();
+
+    return true;
+}
+
+bool PathGenerator::BuildPath(float destX, float destY, float destZ, bool forceDest, bool async)
+{
+    // a new path replaces the one still being searched
+    _pendingSearch = nullptr;
+    _async = async;
+
     float x, y, z;
     _source->GetPosition(x, y, z);
 
@@ -62,6 +168,7 @@ bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool fo
         return false;
 
     TC_METRIC_DETAILED_EVENT("mmap_events", "CalculatePath", "");
+    TC_METRIC_DETAILED_NO_THRESHOLD_TIMER("mmap_calculate_path_time", TC_METRIC_TAG("map_id", std::to_string(_source->GetMapId())));
 
     G3D::Vector3 dest(destX, destY, destZ);
     SetEndPosition(dest);
@@ -73,6 +180,14 @@ bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool fo
 
     TC_LOG_DEBUG("maps.mmaps", "++ PathGenerator::CalculatePath() for {}", _source->GetGUID().ToString());
 
+    // only tile loading writes the navmesh, queries are per thread and the map state used below has its own locks
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    NavMeshReadScope navMeshLock(_navMeshLock, mmap->AcquireNavMeshReadLock(_source->GetMapId()));
+
+    // queries are per thread, the generator may be used by another thread next time
+    if (_navMesh)
+        _navMeshQuery = mmap->GetNavMeshQuery(_source->GetMapId());
+
     // make sure navMesh works - we can run on map w/o mmap
     // check if the start and end point have a .mmtile loaded (can we pass via not loaded tile on the way?)
     Unit const* _sourceUnit = _source->ToUnit();
@@ -182,6 +297,7 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         if (waterPath)
         {
             // Check both start and end points, if they're both in water, then we can *safely* let the creature move
+            NavMeshUnlockScope navMeshUnlock(_navMeshLock);
             for (uint32 i = 0; i < _pathPoints.size(); ++i)
             {
                 ZLiquidStatus status = _source->GetMap()->GetLiquidStatus(_source->GetPhaseMask(), _pathPoints[i].x, _pathPoints[i].y, _pathPoints[i].z, {}, nullptr, _source->GetCollisionHeight());
@@ -218,7 +334,13 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         bool buildShotrcut = false;
 
         G3D::Vector3 const& p = (distToStartPoly > 7.0f) ? startPos : endPos;
-        if (_source->GetMap()->IsUnderWater(_source->GetPhaseMask(), p.x, p.y, p.z))
+        bool underWater;
+        {
+            NavMeshUnlockScope navMeshUnlock(_navMeshLock);
+            underWater = _source->GetMap()->IsUnderWater(_source->GetPhaseMask(), p.x, p.y, p.z);
+        }
+
+        if (underWater)
         {
             TC_LOG_DEBUG("maps.mmaps", "++ BuildPolyPath :: underWater case");
             if (Unit const* _sourceUnit = _source->ToUnit())
@@ -265,6 +387,13 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
 
     // *** poly path generating logic ***
 
+    // the corridor search may finish on a later update, keep what is needed to continue
+    dtVcopy(_search.StartPoint, startPoint);
+    dtVcopy(_search.EndPoint, endPoint);
+    _search.EndPoly = endPoly;
+    _search.StartFarFromPoly = startFarFromPoly;
+    _search.EndFarFromPoly = endFarFromPoly;
+
     // start and end are on same polygon
     // handle this case as if they were 2 different polygons, building a line path split in some few points
     if (startPoly == endPoly && !_useRaycast)
@@ -386,29 +515,12 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         }
         else
         {
-            dtResult = _navMeshQuery->findPath(
-                            suffixStartPoly,    // start polygon
-                            endPoly,            // end polygon
-                            suffixEndPoint,     // start position
-                            endPoint,           // end position
-                            &_filter,            // polygon search filter
-                            _pathPolyRefs + prefixPolyLength - 1,    // [out] path
-                            (int*)&suffixPolyLength,
-                            MAX_PATH_LENGTH - prefixPolyLength);   // max number of polygons in output path
-        }
-
-        if (!suffixPolyLength || dtStatusFailed(dtResult))
-        {
-            // this is probably an error state, but we'll leave it
-            // and hopefully recover on the next Update
-            // we still need to copy our preffix
-            TC_LOG_ERROR("maps.mmaps", "Path Build failed\n{}", _source->GetDebugInfo());
+            _search.PrefixLength = prefixPolyLength;
+            if (!SearchPolyPath(suffixStartPoly, endPoly, suffixEndPoint, endPoint, dtResult, suffixPolyLength))
+                return;
         }
 
-        TC_LOG_DEBUG("maps.mmaps", "++  m_polyLength={} prefixPolyLength={} suffixPolyLength={}", _polyLength, prefixPolyLength, suffixPolyLength);
-
-        // new path = prefix + suffix - overlap
-        _polyLength = prefixPolyLength + suffixPolyLength - 1;
+        SetSearchedPolyPath(dtResult, suffixPolyLength);
     }
     else
     {
@@ -493,37 +605,102 @@ void PathGenerator::BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 con
         }
         else
         {
-            dtResult = _navMeshQuery->findPath(
-                            startPoly,          // start polygon
-                            endPoly,            // end polygon
-                            startPoint,         // start position
-                            endPoint,           // end position
-                            &_filter,           // polygon search filter
-                            _pathPolyRefs,     // [out] path
-                            (int*)&_polyLength,
-                            MAX_PATH_LENGTH);   // max number of polygons in output path
+            uint32 pathLength = 0;
+            _search.PrefixLength = 0;
+            if (!SearchPolyPath(startPoly, endPoly, startPoint, endPoint, dtResult, pathLength))
+                return;
+
+            if (!SetSearchedPolyPath(dtResult, pathLength))
+                return;
         }
+    }
+
+    BuildPointPathFromPolyPath();
+}
+
+bool PathGenerator::SearchPolyPath(dtPolyRef startPoly, dtPolyRef endPoly, float const* startPoint, float const* endPoint, dtStatus& result, uint32& length)
+{
+    // a suffix overlaps the last polygon of the prefix
+    dtPolyRef* path = _pathPolyRefs + (_search.PrefixLength ? _search.PrefixLength - 1 : 0);
+    uint32 maxLength = MAX_PATH_LENGTH - _search.PrefixLength;
+    uint32 mapId = _source->GetMapId();
+
+    // corridors found recently stay usable until one of their tiles is unloaded
+    length = sPathfindingService->FindCachedPath(mapId, startPoly, endPoly, _filter, path, maxLength);
+    if (length && std::all_of(path, path + length, [this](dtPolyRef ref) { return _navMesh->isValidPolyRef(ref); }))
+    {
+        result = DT_SUCCESS;
+        return true;
+    }
+
+    if (_async)
+    {
+        _pendingSearch = sPathfindingService->RequestSearch(mapId, startPoly, endPoly, startPoint, endPoint, _filter, maxLength);
+        if (_pendingSearch)
+            return false;
+    }
+
+    length = 0;
+    result = _navMeshQuery->findPath(
+                    startPoly,          // start polygon
+                    endPoly,            // end polygon
+                    startPoint,         // start position
+                    endPoint,           // end position
+                    &_filter,           // polygon search filter
+                    path,               // [out] path
+                    (int*)&length,
+                    maxLength);         // max number of polygons in output path
+
+    if (length && dtStatusSucceed(result))
+        sPathfindingService->CachePath(mapId, startPoly, endPoly, _filter, path, length);
+
+    return true;
+}
 
-        if (!_polyLength || dtStatusFailed(dtResult))
+bool PathGenerator::SetSearchedPolyPath(dtStatus result, uint32 length)
+{
+    if (_search.PrefixLength)
+    {
+        if (!length || dtStatusFailed(result))
         {
-            // only happens if we passed bad data to findPath(), or navmesh is messed up
-            TC_LOG_ERROR("maps.mmaps", "{} Path Build failed: 0 length path", _source->GetGUID().ToString());
-            BuildShortcut();
-            _type = PATHFIND_NOPATH;
-            return;
+            // this is probably an error state, but we'll leave it
+            // and hopefully recover on the next Update
+            // we still need to copy our preffix
+            TC_LOG_ERROR("maps.mmaps", "Path Build failed\n{}", _source->GetDebugInfo());
         }
+
+        TC_LOG_DEBUG("maps.mmaps", "++  m_polyLength={} prefixPolyLength={} suffixPolyLength={}", _polyLength, _search.PrefixLength, length);
+
+        // new path = prefix + suffix - overlap
+        _polyLength = _search.PrefixLength + length - 1;
+        return true;
+    }
+
+    _polyLength = length;
+    if (!_polyLength || dtStatusFailed(result))
+    {
+        // only happens if we passed bad data to findPath(), or navmesh is messed up
+        TC_LOG_ERROR("maps.mmaps", "{} Path Build failed: 0 length path", _source->GetGUID().ToString());
+        BuildShortcut();
+        _type = PATHFIND_NOPATH;
+        return false;
     }
 
+    return true;
+}
+
+void PathGenerator::BuildPointPathFromPolyPath()
+{
     // by now we know what type of path we can get
-    if (_pathPolyRefs[_polyLength - 1] == endPoly && !(_type & PATHFIND_INCOMPLETE))
+    if (_pathPolyRefs[_polyLength - 1] == _search.EndPoly && !(_type & PATHFIND_INCOMPLETE))
         _type = PATHFIND_NORMAL;
     else
         _type = PATHFIND_INCOMPLETE;
 
-    AddFarFromPolyFlags(startFarFromPoly, endFarFromPoly);
+    AddFarFromPolyFlags(_search.StartFarFromPoly, _search.EndFarFromPoly);
 
     // generate the point-path out of our up-to-date poly-path
-    BuildPointPath(startPoint, endPoint);
+    BuildPointPath(_search.StartPoint, _search.EndPoint);
 }
 
 void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoint)
@@ -622,6 +799,7 @@ void PathGenerator::BuildPointPath(const float *startPoint, const float *endPoin
 
 void PathGenerator::NormalizePath()
 {
+    NavMeshUnlockScope navMeshUnlock(_navMeshLock);
     for (uint32 i = 0; i < _pathPoints.size(); ++i)
         _source->UpdateAllowedPositionZ(_pathPoints[i].x, _pathPoints[i].y, _pathPoints[i].z);
 }
@@ -696,6 +874,7 @@ void PathGenerator::UpdateFilter()
 NavTerrainFlag PathGenerator::GetNavTerrain(float x, float y, float z)
 {
     LiquidData data;
+    NavMeshUnlockScope navMeshUnlock(_navMeshLock);
     ZLiquidStatus liquidStatus = _source->GetMap()->GetLiquidStatus(_source->GetPhaseMask(), x, y, z, {}, &data, _source->GetCollisionHeight());
     if (liquidStatus == LIQUID_MAP_NO_WATER)
         return NAV_GROUND;
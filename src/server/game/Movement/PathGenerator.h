@@ -23,7 +23,10 @@
 #include "DetourNavMeshQuery.h"
 #include "MoveSplineInitArgs.h"
 #include <G3D/Vector3.h>
+#include <memory>
+#include <shared_mutex>
 
+class NavMeshSearch;
 class Unit;
 class WorldObject;
 
@@ -64,6 +67,14 @@ class TC_GAME_API PathGenerator
         bool CalculatePath(float destX, float destY, float destZ, bool forceDest = false);
         bool IsInvalidDestinationZ(Unit const* target) const;
 
+        // Same as CalculatePath, but a navmesh search that is not cached runs on the pathfinding threads
+        // (when enabled). The path is ready once IsPathPending() is false, UpdatePendingPath() finishes it
+        bool CalculatePathAsync(float destX, float destY, float destZ, bool forceDest = false);
+        bool IsPathPending() const { return _pendingSearch != nullptr; }
+        // return: false while the search is still running
+        bool UpdatePendingPath();
+        void CancelPendingPath() { _pendingSearch = nullptr; }
+
         // option setters - use optional
         void SetUseStraightPath(bool useStraightPath) { _useStraightPath = useStraightPath; }
         void SetPathLengthLimit(float distance) { _pointPathLimit = std::min<uint32>(uint32(distance/SMOOTH_PATH_STEP_SIZE), MAX_POINT_PATH_LENGTH); }
@@ -101,9 +112,25 @@ class TC_GAME_API PathGenerator
         WorldObject const* const _source;       // the object that is moving
         dtNavMesh const* _navMesh;              // the nav mesh
         dtNavMeshQuery const* _navMeshQuery;    // the nav mesh query used to find the path
+        std::shared_lock<std::shared_mutex> _navMeshLock;   // held during detour queries, released for map queries
 
         dtQueryFilter _filter;  // use single filter for all movements, update it when needed
 
+        // what BuildPolyPath continues with once the corridor was searched
+        struct PolyPathSearch
+        {
+            float StartPoint[VERTEX_SIZE];
+            float EndPoint[VERTEX_SIZE];
+            dtPolyRef EndPoly;
+            uint32 PrefixLength;        // polygons kept from the previous path, the searched suffix overlaps the last one
+            bool StartFarFromPoly;
+            bool EndFarFromPoly;
+        };
+
+        bool _async;                                            // corridor searches may run on the pathfinding threads
+        PolyPathSearch _search;
+        std::shared_ptr<NavMeshSearch const> _pendingSearch;
+
         void SetStartPosition(G3D::Vector3 const& point) { _startPosition = point; }
         void SetEndPosition(G3D::Vector3 const& point) { _actualEndPosition = point; _endPosition = point; }
         void SetActualEndPosition(G3D::Vector3 const& point) { _actualEndPosition = point; }
@@ -123,7 +150,11 @@ class TC_GAME_API PathGenerator
         dtPolyRef GetPolyByLocation(float const* Point, float* Distance) const;
         bool HaveTile(G3D::Vector3 const& p) const;
 
+        bool BuildPath(float destX, float destY, float destZ, bool forceDest, bool async);
         void BuildPolyPath(G3D::Vector3 const& startPos, G3D::Vector3 const& endPos);
+        bool SearchPolyPath(dtPolyRef startPoly, dtPolyRef endPoly, float const* startPoint, float const* endPoint, dtStatus& result, uint32& length);
+        bool SetSearchedPolyPath(dtStatus result, uint32 length);
+        void BuildPointPathFromPolyPath();
         void BuildPointPath(float const* startPoint, float const* endPoint);
         void BuildShortcut();
 
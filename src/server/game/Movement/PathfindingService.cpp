@@ -0,0 +1,218 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PathfindingService.h"
+#include "Hash.h"
+#include "MMapFactory.h"
+#include "MMapManager.h"
+#include "Metric.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+NavMeshSearch::NavMeshSearch(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, float const* startPoint, float const* endPoint, dtQueryFilter const& filter, uint32 maxLength)
+    : _mapId(mapId), _startPoly(startPoly), _endPoly(endPoly), _filter(filter), _maxLength(maxLength), _status(DT_FAILURE), _done(false)
+{
+    std::copy_n(startPoint, 3, _startPoint);
+    std::copy_n(endPoint, 3, _endPoint);
+}
+
+void NavMeshSearch::Run(dtNavMeshQuery const* query)
+{
+    _path.resize(_maxLength);
+
+    int32 length = 0;
+    if (query)
+        _status = query->findPath(_startPoly, _endPoly, _startPoint, _endPoint, &_filter, _path.data(), &length, int32(_maxLength));
+
+    _path.resize(dtStatusFailed(_status) ? 0 : length);
+    _done.store(true, std::memory_order_release);
+}
+
+std::size_t PathfindingService::SearchKeyHash::operator()(SearchKey const& key) const
+{
+    std::size_t hash = 0;
+    Trinity::hash_combine(hash, key.MapId);
+    Trinity::hash_combine(hash, key.StartPoly);
+    Trinity::hash_combine(hash, key.EndPoly);
+    Trinity::hash_combine(hash, uint32(key.IncludeFlags) << 16 | key.ExcludeFlags);
+    return hash;
+}
+
+PathfindingService::PathfindingService() : _cacheSize(0), _cacheTimeout(0), _cacheHits(0), _cacheMisses(0), _coalescedRequests(0) { }
+
+PathfindingService::~PathfindingService() = default;
+
+PathfindingService* PathfindingService::instance()
+{
+    static PathfindingService instance;
+    return &instance;
+}
+
+void PathfindingService::Initialize(uint32 threads, uint32 cacheSize, Milliseconds cacheTimeout)
+{
+    Unload();
+
+    if (threads)
+        _pool = std::make_unique<Trinity::ThreadPool>(threads);
+
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    _cacheSize = cacheSize;
+    _cacheTimeout = cacheTimeout;
+}
+
+void PathfindingService::Unload()
+{
+    if (_pool)
+    {
+        _pool->Join();
+        _pool.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_pendingLock);
+        _pending.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    _cache.clear();
+    _cacheAge.clear();
+}
+
+PathfindingService::SearchKey PathfindingService::MakeKey(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter)
+{
+    return { mapId, startPoly, endPoly, filter.getIncludeFlags(), filter.getExcludeFlags() };
+}
+
+std::shared_ptr<NavMeshSearch const> PathfindingService::RequestSearch(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly,
+    float const* startPoint, float const* endPoint, dtQueryFilter const& filter, uint32 maxLength)
+{
+    if (!_pool)
+        return nullptr;
+
+    SearchKey key = MakeKey(mapId, startPoly, endPoly, filter);
+
+    std::shared_ptr<NavMeshSearch> search;
+    {
+        std::lock_guard<std::mutex> lock(_pendingLock);
+
+        // a shorter corridor than requested would make the path incomplete, such searches are not shared
+        std::weak_ptr<NavMeshSearch>& pending = _pending[key];
+        search = pending.lock();
+        if (search && !search->IsDone() && search->_maxLength >= maxLength)
+        {
+            ++_coalescedRequests;
+            return search;
+        }
+
+        search = std::make_shared<NavMeshSearch>(mapId, startPoly, endPoly, startPoint, endPoint, filter, maxLength);
+        pending = search;
+    }
+
+    _pool->PostWork([this, search]() { RunSearch(search); });
+    return search;
+}
+
+void PathfindingService::RunSearch(std::shared_ptr<NavMeshSearch> search)
+{
+    {
+        TC_METRIC_DETAILED_NO_THRESHOLD_TIMER("pathfinding_search_time", TC_METRIC_TAG("map_id", std::to_string(search->GetMapId())));
+
+        std::shared_lock<std::shared_mutex> searchLock(_searchLock);
+        MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+        std::shared_lock<std::shared_mutex> navMeshLock = mmap->AcquireNavMeshReadLock(search->GetMapId());
+        search->Run(navMeshLock.owns_lock() ? mmap->GetNavMeshQuery(search->GetMapId()) : nullptr);
+    }
+
+    if (!search->GetPath().empty())
+        CachePath(search->GetMapId(), search->_startPoly, search->_endPoly, search->_filter, search->GetPath().data(), uint32(search->GetPath().size()));
+
+    std::lock_guard<std::mutex> lock(_pendingLock);
+    auto itr = _pending.find(MakeKey(search->GetMapId(), search->_startPoly, search->_endPoly, search->_filter));
+    if (itr != _pending.end() && (itr->second.expired() || itr->second.lock() == search))
+        _pending.erase(itr);
+}
+
+uint32 PathfindingService::FindCachedPath(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef* path, uint32 maxLength)
+{
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    if (!_cacheSize)
+        return 0;
+
+    auto itr = _cache.find(MakeKey(mapId, startPoly, endPoly, filter));
+    if (itr == _cache.end() || std::chrono::steady_clock::now() - itr->second.Time > _cacheTimeout)
+    {
+        ++_cacheMisses;
+        return 0;
+    }
+
+    ++_cacheHits;
+    uint32 length = std::min(uint32(itr->second.Path.size()), maxLength);
+    std::copy_n(itr->second.Path.begin(), length, path);
+    return length;
+}
+
+void PathfindingService::CachePath(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef const* path, uint32 length)
+{
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    if (!_cacheSize || !length)
+        return;
+
+    SearchKey key = MakeKey(mapId, startPoly, endPoly, filter);
+    auto itr = _cache.find(key);
+    if (itr != _cache.end())
+        _cacheAge.erase(itr->second.Age);
+    else
+    {
+        if (_cache.size() >= _cacheSize)
+        {
+            _cache.erase(_cacheAge.front());
+            _cacheAge.pop_front();
+        }
+
+        itr = _cache.emplace(key, CachedPath()).first;
+    }
+
+    itr->second.Path.assign(path, path + length);
+    itr->second.Time = std::chrono::steady_clock::now();
+    itr->second.Age = _cacheAge.insert(_cacheAge.end(), key);
+}
+
+void PathfindingService::UnloadMap(uint32 mapId)
+{
+    {
+        std::unique_lock<std::shared_mutex> searchLock(_searchLock);
+        MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(mapId);
+    }
+
+    std::lock_guard<std::mutex> lock(_cacheLock);
+    for (auto itr = _cacheAge.begin(); itr != _cacheAge.end();)
+    {
+        if (itr->MapId == mapId)
+        {
+            _cache.erase(*itr);
+            itr = _cacheAge.erase(itr);
+        }
+        else
+            ++itr;
+    }
+}
+
+std::size_t PathfindingService::GetPendingSearchCount() const
+{
+    std::lock_guard<std::mutex> lock(_pendingLock);
+    return _pending.size();
+}
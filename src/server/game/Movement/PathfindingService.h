@@ -0,0 +1,165 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PATHFINDING_SERVICE_H
+#define TRINITY_PATHFINDING_SERVICE_H
+
+#include "Define.h"
+#include "Duration.h"
+#include "DetourNavMeshQuery.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Trinity
+{
+    class ThreadPool;
+}
+
+// Polygon corridor between two navmesh polygons, searched once for every requester of the same polygons and filter
+class TC_GAME_API NavMeshSearch
+{
+public:
+    NavMeshSearch(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, float const* startPoint, float const* endPoint, dtQueryFilter const& filter, uint32 maxLength);
+
+    NavMeshSearch(NavMeshSearch const&) = delete;
+    NavMeshSearch& operator=(NavMeshSearch const&) = delete;
+
+    bool IsDone() const { return _done.load(std::memory_order_acquire); }
+
+    // only valid once IsDone() returned true
+    dtStatus GetStatus() const { return _status; }
+    std::vector<dtPolyRef> const& GetPath() const { return _path; }
+
+    uint32 GetMapId() const { return _mapId; }
+
+private:
+    friend class PathfindingService;
+
+    void Run(dtNavMeshQuery const* query);
+
+    uint32 _mapId;
+    dtPolyRef _startPoly;
+    dtPolyRef _endPoly;
+    float _startPoint[3];
+    float _endPoint[3];
+    dtQueryFilter _filter;
+    uint32 _maxLength;
+
+    dtStatus _status;
+    std::vector<dtPolyRef> _path;
+    std::atomic<bool> _done;
+};
+
+/*
+ * Runs navmesh searches of PathGenerator::CalculatePathAsync on worker threads and keeps
+ * the corridors found recently (by any thread) so units moving between the same polygons
+ * skip the search. Requests for a search that is already running share its result.
+ * Only the polygon corridor is searched here, everything that needs the map or the unit
+ * (point path, height normalization) happens on the map thread when the path is finished.
+ */
+class TC_GAME_API PathfindingService
+{
+public:
+    static PathfindingService* instance();
+
+    PathfindingService(PathfindingService const&) = delete;
+    PathfindingService& operator=(PathfindingService const&) = delete;
+
+    // threads == 0 only enables the corridor cache, a cacheSize of 0 disables it
+    void Initialize(uint32 threads, uint32 cacheSize, Milliseconds cacheTimeout);
+    void Unload();
+
+    bool IsAsyncEnabled() const { return _pool != nullptr; }
+
+    // Shares a running search for the same polygons and filter or starts a new one
+    std::shared_ptr<NavMeshSearch const> RequestSearch(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly,
+        float const* startPoint, float const* endPoint, dtQueryFilter const& filter, uint32 maxLength);
+
+    // Copies a recently found corridor into path, returns its length or 0 when none is cached
+    uint32 FindCachedPath(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef* path, uint32 maxLength);
+    void CachePath(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef const* path, uint32 length);
+
+    // Waits for the running searches and unloads the navmesh of the map, cached corridors of the map are dropped
+    void UnloadMap(uint32 mapId);
+
+    std::size_t GetPendingSearchCount() const;
+    uint64 GetCacheHits() const { return _cacheHits; }
+    uint64 GetCacheMisses() const { return _cacheMisses; }
+    uint64 GetCoalescedRequests() const { return _coalescedRequests; }
+
+private:
+    struct SearchKey
+    {
+        uint32 MapId;
+        dtPolyRef StartPoly;
+        dtPolyRef EndPoly;
+        uint16 IncludeFlags;
+        uint16 ExcludeFlags;
+
+        bool operator==(SearchKey const& right) const
+        {
+            return MapId == right.MapId && StartPoly == right.StartPoly && EndPoly == right.EndPoly
+                && IncludeFlags == right.IncludeFlags && ExcludeFlags == right.ExcludeFlags;
+        }
+    };
+
+    struct SearchKeyHash
+    {
+        std::size_t operator()(SearchKey const& key) const;
+    };
+
+    struct CachedPath
+    {
+        std::vector<dtPolyRef> Path;
+        TimePoint Time;
+        std::list<SearchKey>::iterator Age;
+    };
+
+    PathfindingService();
+    ~PathfindingService();
+
+    static SearchKey MakeKey(uint32 mapId, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter);
+
+    void RunSearch(std::shared_ptr<NavMeshSearch> search);
+
+    std::unique_ptr<Trinity::ThreadPool> _pool;
+
+    // held shared by searching workers, exclusively while a navmesh is unloaded
+    std::shared_mutex _searchLock;
+
+    mutable std::mutex _pendingLock;
+    std::unordered_map<SearchKey, std::weak_ptr<NavMeshSearch>, SearchKeyHash> _pending;
+
+    std::mutex _cacheLock;
+    std::unordered_map<SearchKey, CachedPath, SearchKeyHash> _cache;
+    std::list<SearchKey> _cacheAge;                  // oldest first
+    uint32 _cacheSize;
+    Milliseconds _cacheTimeout;
+
+    std::atomic<uint64> _cacheHits;
+    std::atomic<uint64> _cacheMisses;
+    std::atomic<uint64> _coalescedRequests;
+};
+
+#define sPathfindingService PathfindingService::instance()
+
+#endif // TRINITY_PATHFINDING_SERVICE_H
@@ -31,6 +31,7 @@
 #include "ObjectMgr.h"
 #include "OutdoorPvPMgr.h"
 #include "Player.h"
+#include "ScopeProfiler.h"
 #include "ScriptReloadMgr.h"
 #include "ScriptSystem.h"
 #include "SmartAI.h"
@@ -975,12 +976,17 @@ private:
 #define SCR_REG_LST(T) ScriptRegistry<T>::Instance()->GetScripts()
 
 // Utility macros for looping over scripts.
+// every hook is a nested scope of the profiler, named after the script type and the hook
+#define PROFILE_SCRIPTS(T) \
+    ScopeProfiler::Scope _profileScope(ScopeProfiler::SCOPE_NESTED, #T, __func__)
+
 #define FOR_SCRIPTS(T, C, E) \
-    if (!SCR_REG_LST(T).empty()) \
+    if (PROFILE_SCRIPTS(T); !SCR_REG_LST(T).empty()) \
         for (SCR_REG_ITR(T) C = SCR_REG_LST(T).begin(); \
             C != SCR_REG_LST(T).end(); ++C)
 
 #define FOR_SCRIPTS_RET(T, C, E, R) \
+    PROFILE_SCRIPTS(T); \
     if (SCR_REG_LST(T).empty()) \
         return R; \
     \
@@ -993,11 +999,13 @@ private:
 
 // Utility macros for finding specific scripts.
 #define GET_SCRIPT(T, I, V) \
+    PROFILE_SCRIPTS(T); \
     T* V = ScriptRegistry<T>::Instance()->GetScriptById(I); \
     if (!V) \
         return;
 
 #define GET_SCRIPT_RET(T, I, V, R) \
+    PROFILE_SCRIPTS(T); \
     T* V = ScriptRegistry<T>::Instance()->GetScriptById(I); \
     if (!V) \
         return R;
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OpcodeStatistics.h"
+#include <algorithm>
+
+// gives the counters of a thread back for reuse by threads started later, what they counted is kept
+struct OpcodeStatistics::ThreadCountersHolder
+{
+    ~ThreadCountersHolder()
+    {
+        if (Counters)
+            Counters->InUse.store(false, std::memory_order_release);
+    }
+
+    ThreadCounters* Counters = nullptr;
+};
+
+OpcodeStatistics::ThreadCounters::ThreadCounters() : Generation(0), InUse(true)
+{
+    for (Counter(&contextCounters)[NUM_OPCODE_HANDLERS] : Counters)
+    {
+        for (Counter& counter : contextCounters)
+        {
+            counter.Count.store(0, std::memory_order_relaxed);
+            counter.TotalTime.store(0, std::memory_order_relaxed);
+            counter.MaxTime.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+OpcodeStatistics::OpcodeStatistics() : _generation(0)
+{
+}
+
+OpcodeStatistics::~OpcodeStatistics() = default;
+
+OpcodeStatistics* OpcodeStatistics::instance()
+{
+    static OpcodeStatistics instance;
+    return &instance;
+}
+
+OpcodeStatistics::ThreadCounters& OpcodeStatistics::GetThreadCounters()
+{
+    thread_local ThreadCountersHolder holder;
+    if (holder.Counters)
+        return *holder.Counters;
+
+    std::lock_guard<std::mutex> lock(_threadCountersLock);
+    for (std::unique_ptr<ThreadCounters>& counters : _threadCounters)
+    {
+        bool inUse = false;
+        if (counters->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+        {
+            holder.Counters = counters.get();
+            return *holder.Counters;
+        }
+    }
+
+    holder.Counters = _threadCounters.emplace_back(std::make_unique<ThreadCounters>()).get();
+    holder.Counters->Generation.store(_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *holder.Counters;
+}
+
+void OpcodeStatistics::Record(OpcodeClient opcode, OpcodeStatisticsContext context, std::chrono::nanoseconds time)
+{
+    if (uint32(opcode) >= NUM_OPCODE_HANDLERS || context >= MAX_OPCODE_STATISTICS_CONTEXT)
+        return;
+
+    ThreadCounters& threadCounters = GetThreadCounters();
+
+    // counters are only written by their own thread, Reset only tells it to start over
+    uint32 generation = _generation.load(std::memory_order_relaxed);
+    if (threadCounters.Generation.load(std::memory_order_relaxed) != generation)
+    {
+        for (Counter(&contextCounters)[NUM_OPCODE_HANDLERS] : threadCounters.Counters)
+        {
+            for (Counter& counter : contextCounters)
+            {
+                counter.Count.store(0, std::memory_order_relaxed);
+                counter.TotalTime.store(0, std::memory_order_relaxed);
+                counter.MaxTime.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        threadCounters.Generation.store(generation, std::memory_order_release);
+    }
+
+    uint64 nanoseconds = uint64(std::max(time.count(), decltype(time.count())(0)));
+    Counter& counter = threadCounters.Counters[context][opcode];
+    counter.Count.store(counter.Count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counter.TotalTime.store(counter.TotalTime.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > counter.MaxTime.load(std::memory_order_relaxed))
+        counter.MaxTime.store(nanoseconds, std::memory_order_relaxed);
+}
+
+std::vector<OpcodeHandlerStatistics> OpcodeStatistics::Collect() const
+{
+    std::vector<OpcodeHandlerStatistics> statistics;
+    uint32 generation = _generation.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_threadCountersLock);
+    for (uint8 context = 0; context < MAX_OPCODE_STATISTICS_CONTEXT; ++context)
+    {
+        for (uint32 opcode = 0; opcode < NUM_OPCODE_HANDLERS; ++opcode)
+        {
+            OpcodeHandlerStatistics opcodeStatistics = { OpcodeClient(opcode), OpcodeStatisticsContext(context), 0, {}, {} };
+            for (std::unique_ptr<ThreadCounters> const& threadCounters : _threadCounters)
+            {
+                // not reset yet by its thread
+                if (threadCounters->Generation.load(std::memory_order_acquire) != generation)
+                    continue;
+
+                Counter const& counter = threadCounters->Counters[context][opcode];
+                opcodeStatistics.Count += counter.Count.load(std::memory_order_relaxed);
+                opcodeStatistics.TotalTime += std::chrono::nanoseconds(counter.TotalTime.load(std::memory_order_relaxed));
+                opcodeStatistics.MaxTime = std::max(opcodeStatistics.MaxTime, std::chrono::nanoseconds(counter.MaxTime.load(std::memory_order_relaxed)));
+            }
+
+            if (opcodeStatistics.Count)
+                statistics.push_back(opcodeStatistics);
+        }
+    }
+
+    return statistics;
+}
+
+void OpcodeStatistics::Reset()
+{
+    _generation.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_OPCODE_STATISTICS_H
+#define TRINITY_OPCODE_STATISTICS_H
+
+#include "Define.h"
+#include "Opcodes.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum OpcodeStatisticsContext : uint8
+{
+    OPCODE_STATISTICS_WORLD,                                // handled in World::UpdateSessions
+    OPCODE_STATISTICS_MAP,                                  // handled in Map::Update
+
+    MAX_OPCODE_STATISTICS_CONTEXT
+};
+
+struct OpcodeHandlerStatistics
+{
+    OpcodeClient Opcode;
+    OpcodeStatisticsContext Context;
+    uint64 Count;
+    std::chrono::nanoseconds TotalTime;
+    std::chrono::nanoseconds MaxTime;
+};
+
+/*
+ * Number of handled packets and time spent handling them, for every client opcode.
+ * Every thread handling packets writes to its own counters, they are only summed up when queried.
+ */
+class TC_GAME_API OpcodeStatistics
+{
+    OpcodeStatistics();
+    ~OpcodeStatistics();
+
+public:
+    OpcodeStatistics(OpcodeStatistics const&) = delete;
+    OpcodeStatistics& operator=(OpcodeStatistics const&) = delete;
+
+    static OpcodeStatistics* instance();
+
+    void Record(OpcodeClient opcode, OpcodeStatisticsContext context, std::chrono::nanoseconds time);
+
+    /// Opcodes handled at least once since the last Reset, in no particular order
+    std::vector<OpcodeHandlerStatistics> Collect() const;
+
+    void Reset();
+
+private:
+    struct Counter
+    {
+        std::atomic<uint64> Count;
+        std::atomic<uint64> TotalTime;
+        std::atomic<uint64> MaxTime;
+    };
+
+    struct ThreadCounters
+    {
+        ThreadCounters();
+
+        Counter Counters[MAX_OPCODE_STATISTICS_CONTEXT][NUM_OPCODE_HANDLERS];
+        std::atomic<uint32> Generation;
+        std::atomic<bool> InUse;
+    };
+
+    struct ThreadCountersHolder;
+
+    ThreadCounters& GetThreadCounters();
+
+    std::atomic<uint32> _generation;
+
+    // only locked when a thread records its first packet and when counters are collected
+    mutable std::mutex _threadCountersLock;
+    std::vector<std::unique_ptr<ThreadCounters>> _threadCounters;
+};
+
+#define sOpcodeStatistics OpcodeStatistics::instance()
+
+#endif
@@ -18,8 +18,13 @@
 #include "PacketLog.h"
 #include "Config.h"
 #include "IpAddress.h"
+#include "Log.h"
+#include "Opcodes.h"
+#include "StringConvert.h"
 #include "Timer.h"
+#include "Util.h"
 #include "WorldPacket.h"
+#include <zlib.h>
 
 #pragma pack(push, 1)
 
@@ -57,17 +62,57 @@ struct PacketHeader
 
 #pragma pack(pop)
 
-PacketLog::PacketLog() : _file(nullptr)
+namespace
 {
+    // a block that is not full is still written after this long so the log stays close to real time
+    constexpr uint32 BlockFlushInterval = 1000;
+    constexpr std::chrono::milliseconds WriterIdleSleep = std::chrono::milliseconds(10);
+
+    template<typename T>
+    void AppendBytes(std::vector<uint8>& buffer, T const& value)
+    {
+        uint8 const* bytes = reinterpret_cast<uint8 const*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void ParseIds(std::string const& option, std::unordered_set<uint32>& ids)
+    {
+        std::string list = sConfigMgr->GetStringDefault(option, "");
+        for (std::string_view token : Trinity::Tokenize(list, ' ', false))
+        {
+            if (Optional<uint32> id = Trinity::StringTo<uint32>(token))
+                ids.insert(*id);
+            else
+                TC_LOG_ERROR("server.loading", "{} contains invalid id '{}', ignored.", option, token);
+        }
+    }
+}
+
+bool PacketLogFilter::Matches(uint32 accountId, uint32 opcode, uint32 mapId) const
+{
+    return (Accounts.empty() || Accounts.count(accountId))
+        && (Opcodes.empty() || Opcodes.count(opcode))
+        && (Maps.empty() || Maps.count(mapId));
+}
+
+PacketLog::Record::Record(PacketLogRecordType type, uint32 connectionId, std::size_t size) : Type(type), Ticks(getMSTime()), ConnectionId(connectionId),
+    AccountId(0), MapId(0), Opcode(0), Data(size)
+{
+}
+
+PacketLog::PacketLog() : _enabled(false), _stopping(false), _queuedBytes(0), _maxQueuedBytes(0), _nextConnectionId(0),
+    _loggedPackets(0), _droppedPackets(0), _writtenBytes(0), _writtenBlocks(0), _file(nullptr), _format(PACKET_LOG_FORMAT_PKT),
+    _compression(PACKET_LOG_COMPRESSION_NONE), _blockSize(0), _blockRecords(0), _blockFirstTicks(0), _blockLastTicks(0), _blockStartTime(0), _fileOffset(0)
+{
+    _filters.push_back(std::make_unique<PacketLogFilter>());
+    _filter.store(_filters.back().get(), std::memory_order_relaxed);
+
     std::call_once(_initializeFlag, &PacketLog::Initialize, this);
 }
 
 PacketLog::~PacketLog()
 {
-    if (_file)
-        fclose(_file);
-
-    _file = nullptr;
+    Close();
 }
 
 PacketLog* PacketLog::instance()
@@ -85,10 +130,49 @@ void PacketLog::Initialize()
             logsDir.push_back('/');
 
     std::string logname = sConfigMgr->GetStringDefault("PacketLogFile", "");
-    if (!logname.empty())
+    if (logname.empty())
+        return;
+
+    _file = fopen((logsDir + logname).c_str(), "wb");
+    if (!_file)
+    {
+        TC_LOG_ERROR("network", "PacketLog: could not open {}{}, packets are not logged.", logsDir, logname);
+        return;
+    }
+
+    _format = sConfigMgr->GetIntDefault("PacketLog.Format", PACKET_LOG_FORMAT_PKT) == PACKET_LOG_FORMAT_INDEXED ? PACKET_LOG_FORMAT_INDEXED : PACKET_LOG_FORMAT_PKT;
+    _compression = sConfigMgr->GetIntDefault("PacketLog.Compression", PACKET_LOG_COMPRESSION_NONE) == PACKET_LOG_COMPRESSION_ZLIB ? PACKET_LOG_COMPRESSION_ZLIB : PACKET_LOG_COMPRESSION_NONE;
+    _blockSize = std::max(sConfigMgr->GetIntDefault("PacketLog.BlockSize", 64), 1) * 1024;
+    _maxQueuedBytes = std::size_t(std::max(sConfigMgr->GetIntDefault("PacketLog.MaxQueueSize", 16), 1)) * 1024 * 1024;
+    _block.reserve(_blockSize + 0x1000);
+
+    PacketLogFilter filter;
+    ParseIds("PacketLog.Filter.Accounts", filter.Accounts);
+    ParseIds("PacketLog.Filter.Maps", filter.Maps);
+    std::string opcodes = sConfigMgr->GetStringDefault("PacketLog.Filter.Opcodes", "");
+    for (std::string_view token : Trinity::Tokenize(opcodes, ' ', false))
     {
-        _file = fopen((logsDir + logname).c_str(), "wb");
+        if (Optional<uint32> opcode = ParseOpcode(token))
+            filter.Opcodes.insert(*opcode);
+        else
+            TC_LOG_ERROR("server.loading", "PacketLog.Filter.Opcodes contains unknown opcode '{}', ignored.", token);
+    }
 
+    SetFilter(std::move(filter));
+
+    if (_format == PACKET_LOG_FORMAT_INDEXED)
+    {
+        PacketLogFormat::FileHeader header;
+        header.Magic = PacketLogFormat::FileMagic;
+        header.Version = PacketLogFormat::Version;
+        header.Build = 12340;
+        header.StartUnixTime = time(nullptr);
+        header.StartTicks = getMSTime();
+        fwrite(&header, sizeof(header), 1, _file);
+        _fileOffset = sizeof(header);
+    }
+    else
+    {
         LogHeader header;
         header.Signature[0] = 'P'; header.Signature[1] = 'K'; header.Signature[2] = 'T';
         header.FormatVersion = 0x0301;
@@ -99,41 +183,314 @@ void PacketLog::Initialize()
         header.SniffStartUnixtime = time(nullptr);
         header.SniffStartTicks = getMSTime();
         header.OptionalDataSize = 0;
-
-        if (CanLogPacket())
-            fwrite(&header, sizeof(header), 1, _file);
+        fwrite(&header, sizeof(header), 1, _file);
+        _fileOffset = sizeof(header);
     }
+
+    fflush(_file);
+
+    _writerThread = std::make_unique<std::thread>(&PacketLog::WriterThread, this);
+    _enabled.store(true, std::memory_order_release);
 }
 
-void PacketLog::LogPacket(WorldPacket const& packet, Direction direction, boost::asio::ip::address const& addr, uint16 port)
+void PacketLog::Close()
 {
-    std::lock_guard<std::mutex> lock(_logPacketLock);
+    std::lock_guard<std::mutex> lock(_closeLock);
+    if (!_writerThread)
+        return;
 
-    PacketHeader header;
-    header.Direction = direction == CLIENT_TO_SERVER ? 0x47534d43 : 0x47534d53;
-    header.ConnectionId = 0;
-    header.ArrivalTicks = getMSTime();
+    _enabled.store(false, std::memory_order_relaxed);
+    _stopping.store(true, std::memory_order_release);
+    _writerThread->join();
+    _writerThread.reset();
+}
+
+uint32 PacketLog::LogConnect(boost::asio::ip::address const& addr, uint16 port)
+{
+    uint32 connectionId = ++_nextConnectionId;
+    if (!CanLogPacket())
+        return connectionId;
 
-    header.OptionalDataSize = sizeof(header.OptionalData);
-    memset(header.OptionalData.SocketIPBytes, 0, sizeof(header.OptionalData.SocketIPBytes));
+    PacketLogFormat::ConnectionData connection;
+    memset(connection.Address, 0, sizeof(connection.Address));
+    connection.IsV6 = addr.is_v6();
+    connection.Port = port;
     if (addr.is_v4())
     {
         auto bytes = addr.to_v4().to_bytes();
-        memcpy(header.OptionalData.SocketIPBytes, bytes.data(), bytes.size());
+        memcpy(connection.Address, bytes.data(), bytes.size());
     }
     else if (addr.is_v6())
     {
         auto bytes = addr.to_v6().to_bytes();
-        memcpy(header.OptionalData.SocketIPBytes, bytes.data(), bytes.size());
+        memcpy(connection.Address, bytes.data(), bytes.size());
     }
 
-    header.OptionalData.SocketPort = port;
-    header.Length = packet.size() + sizeof(header.Opcode);
-    header.Opcode = packet.GetOpcode();
+    Record* record = new Record(PACKET_LOG_RECORD_CONNECT, connectionId, sizeof(connection));
+    record->Data.append(reinterpret_cast<uint8 const*>(&connection), sizeof(connection));
+    _queuedBytes.fetch_add(sizeof(Record) + record->Data.size(), std::memory_order_relaxed);
+    Enqueue(record);
+    return connectionId;
+}
 
-    fwrite(&header, sizeof(header), 1, _file);
+void PacketLog::LogDisconnect(uint32 connectionId)
+{
+    if (!CanLogPacket())
+        return;
+
+    _queuedBytes.fetch_add(sizeof(Record), std::memory_order_relaxed);
+    Enqueue(new Record(PACKET_LOG_RECORD_DISCONNECT, connectionId, 0));
+}
+
+void PacketLog::LogPacket(WorldPacket const& packet, Direction direction, uint32 connectionId, uint32 accountId, uint32 mapId)
+{
+    if (!_filter.load(std::memory_order_acquire)->Matches(accountId, packet.GetOpcode(), mapId))
+        return;
+
+    std::size_t size = sizeof(Record) + packet.size();
+    if (_queuedBytes.fetch_add(size, std::memory_order_relaxed) + size > _maxQueuedBytes)
+    {
+        _queuedBytes.fetch_sub(size, std::memory_order_relaxed);
+        ++_droppedPackets;
+        return;
+    }
+
+    Record* record = new Record(direction == CLIENT_TO_SERVER ? PACKET_LOG_RECORD_CLIENT_PACKET : PACKET_LOG_RECORD_SERVER_PACKET, connectionId, packet.size());
+    record->AccountId = accountId;
+    record->MapId = mapId;
+    record->Opcode = packet.GetOpcode();
     if (!packet.empty())
-        fwrite(packet.contents(), 1, packet.size(), _file);
+        record->Data.append(packet.contents(), packet.size());
+
+    ++_loggedPackets;
+    Enqueue(record);
+}
+
+void PacketLog::Enqueue(Record* record)
+{
+    _queue.Enqueue(record);
+}
+
+PacketLogFilter PacketLog::GetFilter() const
+{
+    std::lock_guard<std::mutex> lock(_filterLock);
+    return *_filter.load(std::memory_order_relaxed);
+}
+
+void PacketLog::SetFilter(PacketLogFilter filter)
+{
+    std::lock_guard<std::mutex> lock(_filterLock);
+    _filters.push_back(std::make_unique<PacketLogFilter>(std::move(filter)));
+    _filter.store(_filters.back().get(), std::memory_order_release);
+}
 
+PacketLogStatistics PacketLog::GetStatistics() const
+{
+    PacketLogStatistics statistics;
+    statistics.LoggedPackets = _loggedPackets.load(std::memory_order_relaxed);
+    statistics.DroppedPackets = _droppedPackets.load(std::memory_order_relaxed);
+    statistics.WrittenBytes = _writtenBytes.load(std::memory_order_relaxed);
+    statistics.WrittenBlocks = _writtenBlocks.load(std::memory_order_relaxed);
+    statistics.QueuedBytes = _queuedBytes.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+Optional<uint32> PacketLog::ParseOpcode(std::string_view text)
+{
+    if (Optional<uint32> opcode = Trinity::StringTo<uint32>(text, 0))
+    {
+        if (*opcode < NUM_MSG_TYPES)
+            return opcode;
+
+        return {};
+    }
+
+    for (uint32 opcode = 0; opcode < NUM_MSG_TYPES; ++opcode)
+        if (ClientOpcodeHandler const* handler = opcodeTable[Opcodes(opcode)])
+            if (StringEqualI(handler->Name, text))
+                return opcode;
+
+    return {};
+}
+
+void PacketLog::WriterThread()
+{
+    while (!_stopping.load(std::memory_order_acquire))
+    {
+        bool wrote = WriteQueuedRecords();
+        if (!_block.empty() && GetMSTimeDiffToNow(_blockStartTime) >= BlockFlushInterval)
+            WriteBlock();
+
+        if (!wrote)
+            std::this_thread::sleep_for(WriterIdleSleep);
+    }
+
+    WriteQueuedRecords();
+    WriteBlock();
+    if (_format == PACKET_LOG_FORMAT_INDEXED)
+        WriteIndex();
+
+    fclose(_file);
+    _file = nullptr;
+}
+
+bool PacketLog::WriteQueuedRecords()
+{
+    bool wrote = false;
+    Record* record;
+    while (_queue.Dequeue(record))
+    {
+        WriteRecord(*record);
+        _queuedBytes.fetch_sub(sizeof(Record) + record->Data.size(), std::memory_order_relaxed);
+        delete record;
+        wrote = true;
+
+        if (_block.size() >= _blockSize)
+            WriteBlock();
+    }
+
+    return wrote;
+}
+
+void PacketLog::WriteRecord(Record const& record)
+{
+    if (_format == PACKET_LOG_FORMAT_PKT)
+    {
+        switch (record.Type)
+        {
+            case PACKET_LOG_RECORD_CONNECT:
+            {
+                PacketLogFormat::ConnectionData connection;
+                memcpy(&connection, record.Data.contents(), sizeof(connection));
+                ConnectionInfo& info = _connections[record.ConnectionId];
+                memcpy(info.Address, connection.Address, sizeof(info.Address));
+                info.Port = connection.Port;
+                return;
+            }
+            case PACKET_LOG_RECORD_DISCONNECT:
+                _connections.erase(record.ConnectionId);
+                return;
+            default:
+                break;
+        }
+
+        PacketHeader header;
+        header.Direction = record.Type == PACKET_LOG_RECORD_CLIENT_PACKET ? 0x47534d43 : 0x47534d53;
+        header.ConnectionId = record.ConnectionId;
+        header.ArrivalTicks = record.Ticks;
+        header.OptionalDataSize = sizeof(header.OptionalData);
+        memset(header.OptionalData.SocketIPBytes, 0, sizeof(header.OptionalData.SocketIPBytes));
+        header.OptionalData.SocketPort = 0;
+        auto itr = _connections.find(record.ConnectionId);
+        if (itr != _connections.end())
+        {
+            memcpy(header.OptionalData.SocketIPBytes, itr->second.Address, sizeof(header.OptionalData.SocketIPBytes));
+            header.OptionalData.SocketPort = itr->second.Port;
+        }
+
+        header.Length = record.Data.size() + sizeof(header.Opcode);
+        header.Opcode = record.Opcode;
+        AppendBytes(_block, header);
+    }
+    else
+    {
+        PacketLogFormat::RecordHeader header;
+        header.Type = record.Type;
+        header.Ticks = record.Ticks;
+        header.ConnectionId = record.ConnectionId;
+        header.Size = record.Data.size();
+        if (record.Type == PACKET_LOG_RECORD_CLIENT_PACKET || record.Type == PACKET_LOG_RECORD_SERVER_PACKET)
+        {
+            PacketLogFormat::PacketData packet;
+            packet.AccountId = record.AccountId;
+            packet.MapId = record.MapId < PacketLogFormat::NoMap ? record.MapId : PacketLogFormat::NoMap;
+            packet.Opcode = record.Opcode;
+            header.Size += sizeof(packet);
+            AppendBytes(_block, header);
+            AppendBytes(_block, packet);
+        }
+        else
+            AppendBytes(_block, header);
+    }
+
+    if (!record.Data.empty())
+        _block.insert(_block.end(), record.Data.contents(), record.Data.contents() + record.Data.size());
+
+    if (!_blockRecords++)
+    {
+        _blockFirstTicks = record.Ticks;
+        _blockStartTime = getMSTime();
+    }
+
+    _blockLastTicks = record.Ticks;
+}
+
+void PacketLog::WriteBlock()
+{
+    if (_block.empty())
+        return;
+
+    std::size_t written = _block.size();
+    if (_format == PACKET_LOG_FORMAT_PKT)
+        fwrite(_block.data(), 1, _block.size(), _file);
+    else
+    {
+        PacketLogFormat::BlockHeader header;
+        header.Magic = PacketLogFormat::BlockMagic;
+        header.Compression = PACKET_LOG_COMPRESSION_NONE;
+        header.Size = _block.size();
+        header.StoredSize = _block.size();
+        header.Records = _blockRecords;
+        header.FirstTicks = _blockFirstTicks;
+        header.LastTicks = _blockLastTicks;
+
+        uint8 const* data = _block.data();
+        if (_compression == PACKET_LOG_COMPRESSION_ZLIB)
+        {
+            uLongf compressedSize = compressBound(_block.size());
+            _compressedBlock.resize(compressedSize);
+            // blocks that do not get smaller are stored as they are
+            if (compress2(_compressedBlock.data(), &compressedSize, _block.data(), _block.size(), Z_BEST_SPEED) == Z_OK && compressedSize < _block.size())
+            {
+                header.Compression = PACKET_LOG_COMPRESSION_ZLIB;
+                header.StoredSize = compressedSize;
+                data = _compressedBlock.data();
+            }
+        }
+
+        PacketLogFormat::IndexEntry& entry = _index.emplace_back();
+        entry.Offset = _fileOffset;
+        entry.FirstTicks = _blockFirstTicks;
+        entry.LastTicks = _blockLastTicks;
+        entry.Records = _blockRecords;
+
+        fwrite(&header, sizeof(header), 1, _file);
+        fwrite(data, 1, header.StoredSize, _file);
+        written = sizeof(header) + header.StoredSize;
+    }
+
+    fflush(_file);
+    _fileOffset += written;
+    _writtenBytes += written;
+    ++_writtenBlocks;
+
+    _block.clear();
+    _blockRecords = 0;
+}
+
+void PacketLog::WriteIndex()
+{
+    PacketLogFormat::IndexHeader header;
+    header.Magic = PacketLogFormat::IndexMagic;
+    header.Entries = _index.size();
+
+    PacketLogFormat::Footer footer;
+    footer.IndexOffset = _fileOffset;
+    footer.Magic = PacketLogFormat::FooterMagic;
+
+    fwrite(&header, sizeof(header), 1, _file);
+    if (!_index.empty())
+        fwrite(_index.data(), sizeof(PacketLogFormat::IndexEntry), _index.size(), _file);
+    fwrite(&footer, sizeof(footer), 1, _file);
     fflush(_file);
 }
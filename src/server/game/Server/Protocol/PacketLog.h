@@ -19,9 +19,18 @@
 #define TRINITY_PACKETLOG_H
 
 #include "Common.h"
+#include "ByteBuffer.h"
+#include "MPSCQueue.h"
+#include "Optional.h"
+#include "PacketLogFormat.h"
 
 #include <boost/asio/ip/address.hpp>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 enum Direction
 {
@@ -29,25 +38,132 @@ enum Direction
     SERVER_TO_CLIENT
 };
 
+enum PacketLogFileFormat
+{
+    PACKET_LOG_FORMAT_PKT       = 0,                        // PKT 3.1, read by WowPacketParser
+    PACKET_LOG_FORMAT_INDEXED   = 1                         // PacketLogFormat.h
+};
+
 class WorldPacket;
 
+/// Packets are only logged when they match every non empty set
+struct PacketLogFilter
+{
+    std::unordered_set<uint32> Accounts;
+    std::unordered_set<uint32> Opcodes;
+    std::unordered_set<uint32> Maps;
+
+    bool IsEmpty() const { return Accounts.empty() && Opcodes.empty() && Maps.empty(); }
+    bool Matches(uint32 accountId, uint32 opcode, uint32 mapId) const;
+};
+
+struct PacketLogStatistics
+{
+    uint64 LoggedPackets;
+    uint64 DroppedPackets;
+    uint64 WrittenBytes;
+    uint64 WrittenBlocks;
+    std::size_t QueuedBytes;
+};
+
+/**
+ * Network threads copy logged packets into a lock free queue, a writer thread formats them
+ * and writes them to PacketLogFile so sending and receiving never wait for the disk.
+ * When the writer falls behind by more than PacketLog.MaxQueueSize the packets are dropped and counted instead.
+ */
 class TC_GAME_API PacketLog
 {
     private:
         PacketLog();
         ~PacketLog();
-        std::mutex _logPacketLock;
         std::once_flag _initializeFlag;
 
     public:
         static PacketLog* instance();
 
         void Initialize();
-        bool CanLogPacket() const { return (_file != nullptr); }
-        void LogPacket(WorldPacket const& packet, Direction direction, boost::asio::ip::address const& addr, uint16 port);
+        /// Writes what is queued and the index, packets logged afterwards are ignored
+        void Close();
+
+        bool CanLogPacket() const { return _enabled.load(std::memory_order_relaxed); }
+
+        /// Connections are numbered by the log, packets refer to their connection by this id
+        uint32 LogConnect(boost::asio::ip::address const& addr, uint16 port);
+        void LogDisconnect(uint32 connectionId);
+        void LogPacket(WorldPacket const& packet, Direction direction, uint32 connectionId, uint32 accountId, uint32 mapId);
+
+        PacketLogFilter GetFilter() const;
+        /// Replaces the filter used by the network threads from now on
+        void SetFilter(PacketLogFilter filter);
+
+        PacketLogStatistics GetStatistics() const;
+        PacketLogFileFormat GetFormat() const { return _format; }
+
+        /// Accepts opcode numbers and names
+        static Optional<uint32> ParseOpcode(std::string_view text);
 
     private:
+        struct Record
+        {
+            Record(PacketLogRecordType type, uint32 connectionId, std::size_t size);
+
+            PacketLogRecordType Type;
+            uint32 Ticks;
+            uint32 ConnectionId;
+            uint32 AccountId;
+            uint32 MapId;
+            uint32 Opcode;
+            ByteBuffer Data;                                // packet contents, or ConnectionData
+            std::atomic<Record*> QueueLink;
+        };
+
+        struct ConnectionInfo
+        {
+            uint8 Address[16];
+            uint16 Port;
+        };
+
+        void Enqueue(Record* record);
+        void WriterThread();
+        bool WriteQueuedRecords();
+        void WriteRecord(Record const& record);
+        void WriteBlock();
+        void WriteIndex();
+
+        std::atomic<bool> _enabled;
+        std::atomic<bool> _stopping;
+        std::mutex _closeLock;
+        std::unique_ptr<std::thread> _writerThread;
+
+        MPSCQueue<Record, &Record::QueueLink> _queue;
+        std::atomic<std::size_t> _queuedBytes;
+        std::size_t _maxQueuedBytes;
+        std::atomic<uint32> _nextConnectionId;
+
+        // published filter, replaced filters stay alive until shutdown because network threads may still read them
+        std::atomic<PacketLogFilter const*> _filter;
+        mutable std::mutex _filterLock;
+        std::vector<std::unique_ptr<PacketLogFilter>> _filters;
+
+        std::atomic<uint64> _loggedPackets;
+        std::atomic<uint64> _droppedPackets;
+        std::atomic<uint64> _writtenBytes;
+        std::atomic<uint64> _writtenBlocks;
+
+        // writer thread only
         FILE* _file;
+        PacketLogFileFormat _format;
+        PacketLogCompression _compression;
+        std::size_t _blockSize;
+        std::vector<uint8> _block;
+        std::vector<uint8> _compressedBlock;
+        uint32 _blockRecords;
+        uint32 _blockFirstTicks;
+        uint32 _blockLastTicks;
+        uint32 _blockStartTime;
+        uint64 _fileOffset;
+        std::vector<PacketLogFormat::IndexEntry> _index;
+        std::unordered_map<uint32, ConnectionInfo> _connections;
 };
 
 #define sPacketLog PacketLog::instance()
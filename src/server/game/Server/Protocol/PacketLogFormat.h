@@ -0,0 +1,132 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PACKETLOGFORMAT_H
+#define TRINITY_PACKETLOGFORMAT_H
+
+#include "Define.h"
+
+/*
+ * Indexed packet log (PacketLog.Format = 1)
+ *
+ * FileHeader
+ * BlockHeader, StoredSize bytes of records (zlib stream when Compression is PACKET_LOG_COMPRESSION_ZLIB)
+ * ...
+ * IndexHeader, IndexHeader::Entries x IndexEntry, Footer     - written when the log is closed
+ *
+ * Records inside a block: RecordHeader followed by RecordHeader::Size bytes of
+ *   PACKET_LOG_RECORD_CONNECT:               ConnectionData
+ *   PACKET_LOG_RECORD_DISCONNECT:            nothing
+ *   PACKET_LOG_RECORD_CLIENT/SERVER_PACKET:  PacketData followed by the packet contents
+ * A file without footer (crash) can still be read by walking the blocks until the end of the file.
+ */
+
+namespace PacketLogFormat
+{
+    constexpr uint32 FileMagic = 0x4C504354;                // "TCPL"
+    constexpr uint32 BlockMagic = 0x42504354;               // "TCPB"
+    constexpr uint32 IndexMagic = 0x49504354;               // "TCPI"
+    constexpr uint32 FooterMagic = 0x46504354;              // "TCPF"
+    constexpr uint16 Version = 1;
+
+    constexpr uint16 NoMap = 0xFFFF;                        // packet of a session without player in world
+}
+
+enum PacketLogCompression : uint8
+{
+    PACKET_LOG_COMPRESSION_NONE = 0,
+    PACKET_LOG_COMPRESSION_ZLIB = 1
+};
+
+enum PacketLogRecordType : uint8
+{
+    PACKET_LOG_RECORD_CONNECT       = 0,
+    PACKET_LOG_RECORD_DISCONNECT    = 1,
+    PACKET_LOG_RECORD_CLIENT_PACKET = 2,
+    PACKET_LOG_RECORD_SERVER_PACKET = 3
+};
+
+#pragma pack(push, 1)
+
+namespace PacketLogFormat
+{
+    struct FileHeader
+    {
+        uint32 Magic;
+        uint16 Version;
+        uint32 Build;
+        uint32 StartUnixTime;
+        uint32 StartTicks;                                  // getMSTime() at StartUnixTime, records carry ticks
+    };
+
+    struct BlockHeader
+    {
+        uint32 Magic;
+        uint8 Compression;
+        uint32 StoredSize;                                  // bytes following the header
+        uint32 Size;                                        // bytes of records after decompression
+        uint32 Records;
+        uint32 FirstTicks;
+        uint32 LastTicks;
+    };
+
+    struct RecordHeader
+    {
+        uint8 Type;
+        uint32 Ticks;
+        uint32 ConnectionId;
+        uint32 Size;
+    };
+
+    struct ConnectionData
+    {
+        uint8 Address[16];                                  // network byte order, IPv4 in the first 4 bytes
+        uint8 IsV6;
+        uint16 Port;
+    };
+
+    struct PacketData
+    {
+        uint32 AccountId;                                   // 0 until the session is authenticated
+        uint16 MapId;
+        uint16 Opcode;
+    };
+
+    struct IndexHeader
+    {
+        uint32 Magic;
+        uint32 Entries;
+    };
+
+    struct IndexEntry
+    {
+        uint64 Offset;                                      // of the BlockHeader from the start of the file
+        uint32 FirstTicks;
+        uint32 LastTicks;
+        uint32 Records;
+    };
+
+    struct Footer
+    {
+        uint64 IndexOffset;
+        uint32 Magic;
+    };
+}
+
+#pragma pack(pop)
+
+#endif
@@ -22,6 +22,8 @@
 #include "Opcodes.h"
 #include "ByteBuffer.h"
 #include "Duration.h"
+#include <atomic>
+#include <memory>
 
 class WorldPacket : public ByteBuffer
 {
@@ -82,9 +84,22 @@ class WorldPacket : public ByteBuffer
 
         TimePoint GetReceivedTime() const { return m_receivedTime; }
 
+        // link of the session receive queue (MPSCQueue), not copied with the packet
+        std::atomic<WorldPacket*> QueueLink;
+
+        static void* operator new(std::size_t size) { return PacketPool::AllocateObject(size); }
+        static void operator delete(void* packet, std::size_t size) { PacketPool::DeallocateObject(packet, size); }
+
     protected:
         uint16 m_opcode;
         TimePoint m_receivedTime; // only set for a specific set of opcodes, for performance reasons.
 };
 
+/// Immutable packet that can be queued to several sockets, allocated from PacketPool
+template<typename... Args>
+inline std::shared_ptr<WorldPacket const> MakeSharedWorldPacket(Args&&... args)
+{
+    return std::allocate_shared<WorldPacket const>(PacketPoolAllocator<WorldPacket>(), std::forward<Args>(args)...);
+}
+
 #endif
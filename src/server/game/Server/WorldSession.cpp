@@ -41,11 +41,13 @@
 #include "MoveSpline.h"
 #include "ObjectAccessor.h"
 #include "ObjectMgr.h"
+#include "OpcodeStatistics.h"
 #include "Opcodes.h"
 #include "OutdoorPvPMgr.h"
 #include "PacketUtilities.h"
 #include "Player.h"
 #include "Realm.h"
+#include "ScopeProfiler.h"
 #include "ScriptMgr.h"
 #ifdef ELUNA
 #include "LuaEngine.h"
@@ -185,8 +187,8 @@ WorldSession::~WorldSession()
     delete _gameClient;
 
     ///- empty incoming packet queue
-    WorldPacket* packet = nullptr;
-    while (_recvQueue.next(packet))
+    DrainRecvQueue();
+    for (WorldPacket* packet : _recvBatch)
         delete packet;
 
     LoginDatabase.PExecute("UPDATE account SET online = 0 WHERE id = {};", GetAccountId());     // One-time query
@@ -217,17 +219,31 @@ ObjectGuid::LowType WorldSession::GetGUIDLow() const
 /// Send a packet to the client
 void WorldSession::SendPacket(WorldPacket const* packet)
 {
-    ASSERT(packet->GetOpcode() != NULL_OPCODE);
+    if (BeforeSendPacket(*packet))
+        m_Socket->SendPacket(*packet);
+}
+
+/// Send a packet to the client without copying it, the packet may be sent to other clients too
+void WorldSession::SendPacket(std::shared_ptr<WorldPacket const> const& packet)
+{
+    if (BeforeSendPacket(*packet))
+        m_Socket->SendPacket(packet);
+}
+
+/// Runs the hooks of a packet sent to the client, returns false when it must not be sent
+bool WorldSession::BeforeSendPacket(WorldPacket const& packet)
+{
+    ASSERT(packet.GetOpcode() != NULL_OPCODE);
      // Playerbot mod: send packet to bot AI
      if (GetPlayer()) {
          if (GetPlayer()->GetPlayerbotAI())
-             GetPlayer()->GetPlayerbotAI()->HandleBotOutgoingPacket(*packet);
+             GetPlayer()->GetPlayerbotAI()->HandleBotOutgoingPacket(packet);
          else if (GetPlayer()->GetPlayerbotMgr())
-             GetPlayer()->GetPlayerbotMgr()->HandleMasterOutgoingPacket(*packet);
+             GetPlayer()->GetPlayerbotMgr()->HandleMasterOutgoingPacket(packet);
      }
 
     if (!m_Socket)
-        return;
+        return false;
 
 #ifdef TRINITY_DEBUG
     // Code for network use statistic
@@ -245,10 +261,10 @@ void WorldSession::SendPacket(WorldPacket const* packet)
     if ((cur_time - lastTime) < 60)
     {
         sendPacketCount += 1;
-        sendPacketBytes += packet->size();
+        sendPacketBytes += packet.size();
 
         sendLastPacketCount += 1;
-        sendLastPacketBytes += packet->size();
+        sendLastPacketBytes += packet.size();
     }
     else
     {
@@ -259,31 +275,39 @@ void WorldSession::SendPacket(WorldPacket const* packet)
 
         lastTime = cur_time;
         sendLastPacketCount = 1;
-        sendLastPacketBytes = packet->wpos();               // wpos is real written size
+        sendLastPacketBytes = packet.wpos();               // wpos is real written size
     }
 #endif                                                      // !TRINITY_DEBUG
 
-    sScriptMgr->OnPacketSend(this, *packet);
+    sScriptMgr->OnPacketSend(this, packet);
 
 #ifdef ELUNA
     if (Player* plr = GetPlayer())
     {
         if (Eluna* e = plr->GetEluna())
         {
-            if (!e->OnPacketSend(this, *packet))
-                return;
+            if (!e->OnPacketSend(this, packet))
+                return false;
         }
     }
 #endif
 
-    TC_LOG_TRACE("network.opcode", "S->C: {} {}", GetPlayerInfo(), GetOpcodeNameForLogging(static_cast<OpcodeServer>(packet->GetOpcode())));
-    m_Socket->SendPacket(*packet);
+    TC_LOG_TRACE("network.opcode", "S->C: {} {}", GetPlayerInfo(), GetOpcodeNameForLogging(static_cast<OpcodeServer>(packet.GetOpcode())));
+    return true;
 }
 
 /// Add an incoming packet to the queue
 void WorldSession::QueuePacket(WorldPacket* new_packet)
 {
-    _recvQueue.add(new_packet);
+    _recvQueue.Enqueue(new_packet);
+}
+
+/// Moves all packets received since the last call to the batch handled by the updating thread
+void WorldSession::DrainRecvQueue()
+{
+    WorldPacket* packet = nullptr;
+    while (_recvQueue.Dequeue(packet))
+        _recvBatch.push_back(packet);
 }
 
 /// Logging helper for unexpected opcodes
@@ -304,11 +328,19 @@ void WorldSession::LogUnprocessedTail(WorldPacket* packet)
     packet->print_storage();
 }
 
+void WorldSession::FlushPackets()
+{
+    if (m_Socket)
+        m_Socket->FlushPackets();
+}
+
 /// Update the WorldSession (triggered by World update)
 bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 {
     if (GetPlayer() && GetPlayer()->GetPlayerbotAI()) return true;
 
+    ScopeProfiler::Scope profileScope(ScopeProfiler::SCOPE_ROOT, nullptr, "WorldSession::Update");
+
     ///- Before we process anything:
     /// If necessary, kick the player because the client didn't send anything for too long
     /// (or they've been idling in character select)
@@ -326,11 +358,22 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 
     constexpr uint32 MAX_PROCESSED_PACKETS_IN_SAME_WORLDSESSION_UPDATE = 100;
 
-    while (m_Socket && _recvQueue.next(packet, updater))
+    bool const recordOpcodeStatistics = sWorld->getBoolConfig(CONFIG_OPCODE_STATISTICS);
+    OpcodeStatisticsContext const opcodeStatisticsContext = updater.ProcessUnsafe() ? OPCODE_STATISTICS_WORLD : OPCODE_STATISTICS_MAP;
+
+    DrainRecvQueue();
+
+    // packets stay in the batch in order, a packet the filter does not allow here stops processing until the other filter handled it
+    while (m_Socket && !_recvBatch.empty() && updater.Process(_recvBatch.front()))
     {
+        packet = _recvBatch.front();
+        _recvBatch.pop_front();
+
         OpcodeClient opcode = static_cast<OpcodeClient>(packet->GetOpcode());
         ClientOpcodeHandler const* opHandle = opcodeTable[opcode];
         TC_METRIC_DETAILED_TIMER("worldsession_update_opcode_time", TC_METRIC_TAG("opcode", opHandle->Name));
+        ScopeProfiler::Scope profileOpcodeScope(ScopeProfiler::SCOPE_NESTED, nullptr, opHandle->Name);
+        TimePoint handlerStart = recordOpcodeStatistics ? std::chrono::steady_clock::now() : TimePoint();
 
         try
         {
@@ -476,6 +519,9 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
             packet->hexlike();
         }
 
+        if (recordOpcodeStatistics && deletePacket)
+            sOpcodeStatistics->Record(opcode, opcodeStatisticsContext, std::chrono::steady_clock::now() - handlerStart);
+
         if (deletePacket)
             delete packet;
 
@@ -491,7 +537,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 
     TC_METRIC_VALUE("processed_packets", processedPackets);
 
-    _recvQueue.readd(requeuePackets.begin(), requeuePackets.end());
+    _recvBatch.insert(_recvBatch.begin(), requeuePackets.begin(), requeuePackets.end());
     // playerbot mod
     if (GetPlayer() && GetPlayer()->GetPlayerbotMgr())
         GetPlayer()->GetPlayerbotMgr()->UpdateSessions(0);
@@ -519,6 +565,9 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
         if (m_Socket && m_Socket->IsOpen() && _warden)
             _warden->Update(diff);
 
+        if (m_Socket)
+            m_Socket->SetPacketLogMap(_player && _player->IsInWorld() ? _player->GetMapId() : MAPID_INVALID);
+
         ///- If necessary, log the player out
         if (ShouldLogOut(currentTime) && !m_playerLoading)
             LogoutPlayer(true);
@@ -1860,9 +1909,11 @@ bool WorldSession::IsRightUnitBeingMoved(ObjectGuid guid)
 
 void WorldSession::HandleBotPackets()
 {
-    WorldPacket* packet;
-    while (_recvQueue.next(packet))
+    DrainRecvQueue();
+    while (!_recvBatch.empty())
     {
+        WorldPacket* packet = _recvBatch.front();
+        _recvBatch.pop_front();
         ClientOpcodeHandler const* opHandle = opcodeTable[static_cast<OpcodeClient>(packet->GetOpcode())];
         //OpcodeHandler& opHandle = opcodeTable[packet->GetOpcode()];
         //(this->*opHandle->handler)(*packet);
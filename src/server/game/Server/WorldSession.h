@@ -27,11 +27,12 @@
 #include "AuthDefines.h"
 #include "DatabaseEnvFwd.h"
 #include "Duration.h"
-#include "LockedQueue.h"
+#include "MPSCQueue.h"
 #include "ObjectGuid.h"
 #include "Packet.h"
 #include "SharedDefines.h"
 #include <boost/circular_buffer_fwd.hpp>
+#include <deque>
 #include <string>
 #include <map>
 #include <memory>
@@ -473,6 +474,7 @@ class TC_GAME_API WorldSession
         void static WriteMovementInfo(WorldPacket* data, MovementInfo* mi);
 
         void SendPacket(WorldPacket const* packet);
+        void SendPacket(std::shared_ptr<WorldPacket const> const& packet);
         void SendNotification(const char *format, ...) ATTR_PRINTF(2, 3);
         void SendNotification(uint32 string_id, ...);
         void SendPetNameInvalid(uint32 error, std::string const& name, DeclinedName *declinedName);
@@ -542,6 +544,9 @@ class TC_GAME_API WorldSession
         void QueuePacket(WorldPacket* new_packet);
         bool Update(uint32 diff, PacketFilter& updater);
 
+        /// Lets the socket write the packets held since the previous world update (Network.CoalescePackets)
+        void FlushPackets();
+
         /// Handle the authentication waiting queue (to be completed)
         void SendAuthWaitQueue(uint32 position);
 
@@ -1202,12 +1207,14 @@ class TC_GAME_API WorldSession
 
     private:
         void ProcessQueryCallbacks();
+        bool BeforeSendPacket(WorldPacket const& packet);
 
         QueryCallbackProcessor _queryProcessor;
         AsyncCallbackProcessor<TransactionCallback> _transactionCallbacks;
         AsyncCallbackProcessor<SQLQueryHolderCallback> _queryHolderProcessor;
 
     friend class World;
+    friend class UnitTestDataLoader;
     protected:
         class DosProtection
         {
@@ -1246,6 +1253,7 @@ class TC_GAME_API WorldSession
         // logging helper
         void LogUnexpectedOpcode(WorldPacket* packet, char const* status, const char *reason);
         void LogUnprocessedTail(WorldPacket* packet);
+        void DrainRecvQueue();
 
         // EnumData helpers
         bool IsLegitCharacterForAccount(ObjectGuid lowGUID)
@@ -1313,7 +1321,8 @@ class TC_GAME_API WorldSession
         } _addons;
         uint32 recruiterId;
         bool isRecruiter;
-        LockedQueue<WorldPacket*> _recvQueue;
+        MPSCQueue<WorldPacket, &WorldPacket::QueueLink> _recvQueue;   // filled by network threads
+        std::deque<WorldPacket*> _recvBatch;                            // packets taken from _recvQueue, only used by the updating thread
         rbac::RBACData* _RBACData;
         uint32 expireTime;
         bool forceExit;
@@ -25,6 +25,8 @@
 #include "IPLocation.h"
 #include "Opcodes.h"
 #include "PacketLog.h"
+#include "PacketPool.h"
+#include "Position.h"
 #include "Random.h"
 #include "RBAC.h"
 #include "Realm.h"
@@ -36,7 +38,8 @@
 using boost::asio::ip::tcp;
 
 WorldSocket::WorldSocket(tcp::socket&& socket)
-    : Socket(std::move(socket)), _OverSpeedPings(0), _worldSession(nullptr), _authed(false), _sendBufferSize(4096)
+    : Socket(std::move(socket)), _OverSpeedPings(0), _worldSession(nullptr), _authed(false), _sendBufferSize(4096), _coalescePackets(false),
+    _waitForFlush(false), _flushRequested(false), _packetLogConnectionId(0), _packetLogAccountId(0), _packetLogMapId(MAPID_INVALID)
 {
     Trinity::Crypto::GetRandomBytes(_authSeed);
     _headerBuffer.Resize(sizeof(ClientPktHeader));
@@ -46,6 +49,9 @@ WorldSocket::~WorldSocket() = default;
 
 void WorldSocket::Start()
 {
+    if (sPacketLog->CanLogPacket())
+        _packetLogConnectionId = sPacketLog->LogConnect(GetRemoteIpAddress(), GetRemotePort());
+
     std::string ip_address = GetRemoteIpAddress().to_string();
     LoginDatabasePreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_IP_INFO);
     stmt->setString(0, ip_address);
@@ -81,45 +87,9 @@ void WorldSocket::CheckIpCallback(PreparedQueryResult result)
 
 bool WorldSocket::Update()
 {
-    EncryptablePacket* queued;
-    if (_bufferQueue.Dequeue(queued))
-    {
-        // Allocate buffer only when it's needed but not on every Update() call.
-        MessageBuffer buffer(_sendBufferSize);
-        do
-        {
-            ServerPktHeader header(queued->size() + 2, queued->GetOpcode());
-            if (queued->NeedsEncryption())
-                _authCrypt.EncryptSend(header.header, header.getHeaderLength());
-
-            if (buffer.GetRemainingSpace() < queued->size() + header.getHeaderLength())
-            {
-                QueuePacket(std::move(buffer));
-                buffer.Resize(_sendBufferSize);
-            }
-
-            if (buffer.GetRemainingSpace() >= queued->size() + header.getHeaderLength())
-            {
-                buffer.Write(header.header, header.getHeaderLength());
-                if (!queued->empty())
-                    buffer.Write(queued->contents(), queued->size());
-            }
-            else    // single packet larger than buffer size
-            {
-                MessageBuffer packetBuffer(queued->size() + header.getHeaderLength());
-                packetBuffer.Write(header.header, header.getHeaderLength());
-                if (!queued->empty())
-                    packetBuffer.Write(queued->contents(), queued->size());
-
-                QueuePacket(std::move(packetBuffer));
-            }
-
-            delete queued;
-        } while (_bufferQueue.Dequeue(queued));
-
-        if (buffer.GetActiveSize() > 0)
-            QueuePacket(std::move(buffer));
-    }
+    // in coalescing mode everything sent during a world update is written together once the session flushed it
+    if (!_waitForFlush || !IsOpen() || _flushRequested.exchange(false, std::memory_order_acquire))
+        QueueSentPackets();
 
     if (!BaseSocket::Update())
         return false;
@@ -129,6 +99,46 @@ bool WorldSocket::Update()
     return true;
 }
 
+void WorldSocket::QueueSentPackets()
+{
+    // everything queued from the header buffer was written, start over
+    if (_sendHeaders && _sendHeaders.use_count() == 1)
+        _sendHeaders->Reset();
+
+    uint64 sentPackets = 0;
+    EncryptablePacket* queued;
+    while (_bufferQueue.Dequeue(queued))
+    {
+        WorldPacket const& packet = queued->GetPacket();
+        ServerPktHeader header(packet.size() + 2, packet.GetOpcode());
+        if (queued->NeedsEncryption())
+            _authCrypt.EncryptSend(header.header, header.getHeaderLength());
+
+        // payloads are written straight from the packet, which can be shared with other sockets
+        // except for tiny ones, they are cheaper to copy next to their header than to write separately
+        std::size_t inlinedSize = packet.size() <= SendInlinePayloadSize ? packet.size() : 0;
+
+        // headers still waiting to be written keep the full buffer alive
+        if (!_sendHeaders || _sendHeaders->GetRemainingSpace() < header.getHeaderLength() + inlinedSize)
+            _sendHeaders = std::make_shared<MessageBuffer>(_sendBufferSize);
+
+        uint8 const* start = _sendHeaders->GetWritePointer();
+        _sendHeaders->Write(header.header, header.getHeaderLength());
+        if (inlinedSize)
+            _sendHeaders->Write(packet.contents(), inlinedSize);
+
+        QueueBuffer(_sendHeaders, start, header.getHeaderLength() + inlinedSize);
+        if (!inlinedSize && !packet.empty())
+            QueueBuffer(queued->GetSharedPacket(), packet.contents(), packet.size());
+
+        delete queued;
+        ++sentPackets;
+    }
+
+    if (sentPackets)
+        CountSentPackets(sentPackets);
+}
+
 void WorldSocket::HandleSendAuthSession()
 {
     WorldPacket packet(SMSG_AUTH_CHALLENGE, 40);
@@ -146,6 +156,13 @@ void WorldSocket::OnClose()
         std::lock_guard<std::mutex> sessionGuard(_worldSessionLock);
         _worldSession = nullptr;
     }
+
+    if (_packetLogConnectionId)
+        sPacketLog->LogDisconnect(_packetLogConnectionId);
+
+    SocketStatistics statistics = GetStatistics();
+    TC_LOG_DEBUG("network", "WorldSocket::OnClose: {} received {} packets ({} bytes), sent {} packets ({} bytes) in {} writes.", GetRemoteIpAddress().to_string(),
+        statistics.PacketsReceived, statistics.BytesReceived, statistics.PacketsSent, statistics.BytesSent, statistics.WriteCalls);
 }
 
 void WorldSocket::ReadHandler()
@@ -228,6 +245,8 @@ bool WorldSocket::ReadHeaderHandler()
     }
 
     header->size -= sizeof(header->cmd);
+    // storage is moved to the received WorldPacket, take the next one from the pool
+    _packetBuffer = MessageBuffer(PacketPool::AcquireStorage(header->size));
     _packetBuffer.Resize(header->size);
     return true;
 }
@@ -306,9 +325,10 @@ WorldSocket::ReadDataHandlerResult WorldSocket::ReadDataHandler()
 
     WorldPacket packet(opcode, std::move(_packetBuffer));
     WorldPacket* packetToQueue;
+    CountReceivedPacket();
 
     if (sPacketLog->CanLogPacket())
-        sPacketLog->LogPacket(packet, CLIENT_TO_SERVER, GetRemoteIpAddress(), GetRemotePort());
+        sPacketLog->LogPacket(packet, CLIENT_TO_SERVER, _packetLogConnectionId, _packetLogAccountId.load(std::memory_order_relaxed), _packetLogMapId.load(std::memory_order_relaxed));
 
     std::unique_lock<std::mutex> sessionGuard(_worldSessionLock, std::defer_lock);
 
@@ -416,14 +436,22 @@ void WorldSocket::SendPacketAndLogOpcode(WorldPacket const& packet)
 }
 
 void WorldSocket::SendPacket(WorldPacket const& packet)
+{
+    if (!IsOpen())
+        return;
+
+    SendPacket(MakeSharedWorldPacket(packet));
+}
+
+void WorldSocket::SendPacket(std::shared_ptr<WorldPacket const> packet)
 {
     if (!IsOpen())
         return;
 
     if (sPacketLog->CanLogPacket())
-        sPacketLog->LogPacket(packet, SERVER_TO_CLIENT, GetRemoteIpAddress(), GetRemotePort());
+        sPacketLog->LogPacket(*packet, SERVER_TO_CLIENT, _packetLogConnectionId, _packetLogAccountId.load(std::memory_order_relaxed), _packetLogMapId.load(std::memory_order_relaxed));
 
-    _bufferQueue.Enqueue(new EncryptablePacket(packet, _authCrypt.IsInitialized()));
+    _bufferQueue.Enqueue(new EncryptablePacket(std::move(packet), _authCrypt.IsInitialized()));
 }
 
 void WorldSocket::HandleAuthSession(WorldPacket& recvPacket)
@@ -613,6 +641,7 @@ void WorldSocket::HandleAuthSessionCallback(std::shared_ptr<AuthSession> authSes
     sScriptMgr->OnAccountLogin(account.Id);
 
     _authed = true;
+    _packetLogAccountId.store(account.Id, std::memory_order_relaxed);
     _worldSession = new WorldSession(account.Id, std::move(authSession->Account), shared_from_this(), account.Security,
         account.Expansion, mutetime, account.TimezoneOffset, account.Locale, account.Recruiter, account.IsRectuiter);
     _worldSession->ReadAddonsInfo(authSession->AddonInfo);
@@ -630,6 +659,9 @@ void WorldSocket::LoadSessionPermissionsCallback(PreparedQueryResult result)
     // RBAC must be loaded before adding session to check for skip queue permission
     _worldSession->GetRBACData()->LoadFromDBCallback(result);
 
+    // from now on the session is updated by the world and flushes its packets every update
+    _waitForFlush = _coalescePackets;
+
     sWorld->AddSession(_worldSession);
 }
 
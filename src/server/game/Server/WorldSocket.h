@@ -29,19 +29,27 @@
 #include <boost/asio/ip/tcp.hpp>
 
 using boost::asio::ip::tcp;
-class EncryptablePacket : public WorldPacket
+// Packet waiting in the send queue of a socket, its payload may be shared with other sockets and is never modified
+class EncryptablePacket
 {
 public:
-    EncryptablePacket(WorldPacket const& packet, bool encrypt) : WorldPacket(packet), _encrypt(encrypt)
+    EncryptablePacket(std::shared_ptr<WorldPacket const> packet, bool encrypt) : _packet(std::move(packet)), _encrypt(encrypt)
     {
         SocketQueueLink.store(nullptr, std::memory_order_relaxed);
     }
 
+    WorldPacket const& GetPacket() const { return *_packet; }
+    std::shared_ptr<WorldPacket const> const& GetSharedPacket() const { return _packet; }
+
     bool NeedsEncryption() const { return _encrypt; }
 
     std::atomic<EncryptablePacket*> SocketQueueLink;
 
+    static void* operator new(std::size_t size) { return PacketPool::AllocateObject(size); }
+    static void operator delete(void* packet, std::size_t size) { PacketPool::DeallocateObject(packet, size); }
+
 private:
+    std::shared_ptr<WorldPacket const> _packet;
     bool _encrypt;
 };
 
@@ -68,6 +76,8 @@ class TC_GAME_API WorldSocket : public Socket<WorldSocket>
 {
     typedef Socket<WorldSocket> BaseSocket;
 
+    friend class UnitTestDataLoader;
+
 public:
     WorldSocket(tcp::socket&& socket);
     ~WorldSocket();
@@ -79,8 +89,17 @@ public:
     bool Update() override;
 
     void SendPacket(WorldPacket const& packet);
+    void SendPacket(std::shared_ptr<WorldPacket const> packet);
 
     void SetSendBufferSize(std::size_t sendBufferSize) { _sendBufferSize = sendBufferSize; }
+    void SetCoalescePackets(bool coalescePackets) { _coalescePackets = coalescePackets; }
+
+    /// In coalescing mode packets sent to a session in the world are held until flushed and then written together,
+    /// World flushes all sessions at the end of each world update, after the maps sent their packets
+    void FlushPackets() { _flushRequested.store(true, std::memory_order_release); }
+
+    /// Map of the player for the map filter of PacketLog, updated by WorldSession once per world update
+    void SetPacketLogMap(uint32 mapId) { _packetLogMapId.store(mapId, std::memory_order_relaxed); }
 
 protected:
     void OnClose() override;
@@ -97,6 +116,8 @@ protected:
     ReadDataHandlerResult ReadDataHandler();
 
 private:
+    static constexpr std::size_t SendInlinePayloadSize = 64;
+
     void CheckIpCallback(PreparedQueryResult result);
 
     /// writes network.opcode log
@@ -109,6 +130,8 @@ private:
     void HandleAuthSessionCallback(std::shared_ptr<AuthSession> authSession, PreparedQueryResult result);
     void LoadSessionPermissionsCallback(PreparedQueryResult result);
     void SendAuthResponseError(uint8 code);
+    /// moves packets sent by the game to the write queue of the socket
+    void QueueSentPackets();
 
     bool HandlePing(WorldPacket& recvPacket);
 
@@ -125,7 +148,15 @@ private:
     MessageBuffer _headerBuffer;
     MessageBuffer _packetBuffer;
     MPSCQueue<EncryptablePacket, &EncryptablePacket::SocketQueueLink> _bufferQueue;
+    std::shared_ptr<MessageBuffer> _sendHeaders;            // encrypted headers of this socket (and small payloads), written between the packet payloads
     std::size_t _sendBufferSize;
+    bool _coalescePackets;
+    bool _waitForFlush;                                     // coalescing starts once the session is added to the world
+    std::atomic<bool> _flushRequested;
+
+    uint32 _packetLogConnectionId;                          // 0 when the packet log was disabled at connect
+    std::atomic<uint32> _packetLogAccountId;
+    std::atomic<uint32> _packetLogMapId;
 
     QueryCallbackProcessor _queryProcessor;
     std::string _ipCountry;
@@ -45,6 +45,7 @@ public:
     void OnSocketOpen(tcp::socket&& sock, uint32 threadIndex) override;
 
     std::size_t GetApplicationSendBufferSize() const { return _socketApplicationSendBufferSize; }
+    bool IsCoalescingPackets() const { return _coalescePackets; }
 
 protected:
     WorldSocketMgr();
@@ -55,6 +56,7 @@ private:
     int32 _socketSystemSendBufferSize;
     int32 _socketApplicationSendBufferSize;
     bool _tcpNoDelay;
+    bool _coalescePackets;
 };
 
 #define sWorldSocketMgr WorldSocketMgr::Instance()
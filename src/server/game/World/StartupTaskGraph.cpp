@@ -0,0 +1,217 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StartupTaskGraph.h"
+#include "Errors.h"
+#include "Log.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+void StartupTaskGraph::Add(std::string name, std::initializer_list<std::string_view> dependencies, Task task)
+{
+    Node node;
+    node.Name = std::move(name);
+    node.Work = std::move(task);
+    for (std::string_view dependency : dependencies)
+    {
+        auto itr = std::find_if(_tasks.begin(), _tasks.end(), [dependency](Node const& added) { return added.Name == dependency; });
+        ASSERT(itr != _tasks.end(), "Startup task '%s' depends on '%s' that was not added before it", node.Name.c_str(), std::string(dependency).c_str());
+        node.Dependencies.push_back(std::distance(_tasks.begin(), itr));
+    }
+
+    ASSERT(std::none_of(_tasks.begin(), _tasks.end(), [&node](Node const& added) { return added.Name == node.Name; }),
+        "Startup task '%s' was added twice", node.Name.c_str());
+
+    for (std::size_t dependency : node.Dependencies)
+        _tasks[dependency].Dependents.push_back(_tasks.size());
+
+    _tasks.push_back(std::move(node));
+}
+
+void StartupTaskGraph::Run(uint32 threads)
+{
+    _threads = std::max<uint32>(threads, 1);
+    _start = std::chrono::steady_clock::now();
+
+    if (_threads == 1 || _tasks.size() < 2)
+    {
+        for (std::size_t i = 0; i < _tasks.size(); ++i)
+        {
+            _tasks[i].StartIndex = uint32(i);
+            Execute(i);
+        }
+
+        _end = std::chrono::steady_clock::now();
+        return;
+    }
+
+    std::mutex lock;
+    std::condition_variable allFinished;
+    std::size_t finished = 0;
+    uint32 started = 0;
+    std::vector<std::size_t> remainingDependencies(_tasks.size());
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+        remainingDependencies[i] = _tasks[i].Dependencies.size();
+
+    Trinity::ThreadPool pool(_threads);
+    std::function<void(std::size_t)> post = [&](std::size_t index)
+    {
+        pool.PostWork([&, index]()
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                _tasks[index].StartIndex = started++;
+            }
+
+            Execute(index);
+
+            std::vector<std::size_t> ready;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for (std::size_t dependent : _tasks[index].Dependents)
+                    if (!--remainingDependencies[dependent])
+                        ready.push_back(dependent);
+
+                ++finished;
+            }
+
+            for (std::size_t dependent : ready)
+                post(dependent);
+
+            allFinished.notify_all();
+        });
+    };
+
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+        if (_tasks[i].Dependencies.empty())
+            post(i);
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        allFinished.wait(guard, [&]() { return finished == _tasks.size(); });
+    }
+
+    pool.Join();
+    _end = std::chrono::steady_clock::now();
+}
+
+void StartupTaskGraph::LogReport() const
+{
+    std::vector<std::size_t> criticalPath = FindCriticalPath();
+    Milliseconds work = Milliseconds::zero();
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+        work += GetTaskDuration(i);
+
+    TC_LOG_INFO("server.loading", "Startup tasks: {} tasks in {} ms on {} thread(s), {} ms of work, critical path {} ms",
+        _tasks.size(), GetDuration().count(), _threads, work.count(), GetCriticalPathDuration().count());
+    TC_LOG_INFO("server.loading", "     start   duration  task (* on the critical path)");
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+    {
+        Node const& node = _tasks[i];
+        bool critical = std::find(criticalPath.begin(), criticalPath.end(), i) != criticalPath.end();
+        TC_LOG_INFO("server.loading", "{:>10} {:>10}  {}{}", std::chrono::duration_cast<Milliseconds>(node.Start - _start).count(),
+            GetTaskDuration(i).count(), critical ? "* " : "  ", node.Name);
+    }
+
+    std::string path;
+    for (std::size_t index : criticalPath)
+    {
+        if (!path.empty())
+            path += " -> ";
+        path += _tasks[index].Name;
+    }
+
+    TC_LOG_INFO("server.loading", "Startup critical path: {}", path);
+}
+
+std::vector<std::string> StartupTaskGraph::GetCriticalPath() const
+{
+    std::vector<std::string> names;
+    for (std::size_t index : FindCriticalPath())
+        names.push_back(_tasks[index].Name);
+
+    return names;
+}
+
+Milliseconds StartupTaskGraph::GetCriticalPathDuration() const
+{
+    Milliseconds duration = Milliseconds::zero();
+    for (std::size_t index : FindCriticalPath())
+        duration += GetTaskDuration(index);
+
+    return duration;
+}
+
+std::vector<std::string> StartupTaskGraph::GetStartOrder() const
+{
+    std::vector<std::string> names(_tasks.size());
+    for (Node const& node : _tasks)
+        names[node.StartIndex] = node.Name;
+
+    return names;
+}
+
+void StartupTaskGraph::Execute(std::size_t index)
+{
+    Node& node = _tasks[index];
+    node.Start = std::chrono::steady_clock::now();
+    node.Work();
+    node.End = std::chrono::steady_clock::now();
+}
+
+Milliseconds StartupTaskGraph::GetTaskDuration(std::size_t index) const
+{
+    return std::chrono::duration_cast<Milliseconds>(_tasks[index].End - _tasks[index].Start);
+}
+
+std::vector<std::size_t> StartupTaskGraph::FindCriticalPath() const
+{
+    if (_tasks.empty())
+        return {};
+
+    // dependencies always come first, so a single pass in order sees every dependency before its dependents
+    using Duration = TimePoint::duration;
+    std::vector<Duration> pathDuration(_tasks.size());
+    std::vector<std::size_t> previous(_tasks.size(), _tasks.size());
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < _tasks.size(); ++i)
+    {
+        Duration longest = Duration::zero();
+        for (std::size_t dependency : _tasks[i].Dependencies)
+        {
+            if (previous[i] == _tasks.size() || pathDuration[dependency] > longest)
+            {
+                longest = pathDuration[dependency];
+                previous[i] = dependency;
+            }
+        }
+
+        pathDuration[i] = longest + (_tasks[i].End - _tasks[i].Start);
+        // on a tie the later task wins, it finished the path
+        if (pathDuration[i] >= pathDuration[index])
+            index = i;
+    }
+
+    std::vector<std::size_t> path;
+    for (; index != _tasks.size(); index = previous[index])
+        path.push_back(index);
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_STARTUP_TASK_GRAPH_H
+#define TRINITYCORE_STARTUP_TASK_GRAPH_H
+
+#include "Define.h"
+#include "Duration.h"
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Runs the loaders of the world startup as tasks that name the tasks they depend on.
+ * Tasks whose dependencies have finished run concurrently on a thread pool, everything else
+ * waits. A dependency has to be added before the task that names it, so the order of the
+ * Add calls is always a valid order and a single thread runs the tasks exactly in that order.
+ */
+class TC_GAME_API StartupTaskGraph
+{
+public:
+    using Task = std::function<void()>;
+
+    void Add(std::string name, std::initializer_list<std::string_view> dependencies, Task task);
+
+    /// threads <= 1 runs every task on the calling thread, returns when all tasks finished
+    void Run(uint32 threads);
+
+    /// Logs the duration of every task and the critical path
+    void LogReport() const;
+
+    /// Longest chain of dependencies by measured duration, it bounds how fast the tasks can finish with any number of threads
+    std::vector<std::string> GetCriticalPath() const;
+    Milliseconds GetCriticalPathDuration() const;
+    Milliseconds GetDuration() const { return std::chrono::duration_cast<Milliseconds>(_end - _start); }
+
+    /// Names of the tasks in the order they started
+    std::vector<std::string> GetStartOrder() const;
+
+private:
+    struct Node
+    {
+        std::string Name;
+        Task Work;
+        std::vector<std::size_t> Dependencies;
+        std::vector<std::size_t> Dependents;
+        TimePoint Start;
+        TimePoint End;
+        uint32 StartIndex = 0;
+    };
+
+    void Execute(std::size_t index);
+    Milliseconds GetTaskDuration(std::size_t index) const;
+    std::vector<std::size_t> FindCriticalPath() const;
+
+    std::vector<Node> _tasks;
+    TimePoint _start;
+    TimePoint _end;
+    uint32 _threads = 1;
+};
+
+#endif
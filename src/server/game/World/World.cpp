@@ -40,6 +40,7 @@
 #include "CreatureGroups.h"
 #include "CreatureTextMgr.h"
 #include "DatabaseEnv.h"
+#include "DBUpdater.h"
 #include "DisableMgr.h"
 #include "GameEventMgr.h"
 #include "GameObjectModel.h"
@@ -66,8 +67,10 @@
 #include "PetitionMgr.h"
 #include "Player.h"
 #include "PlayerDump.h"
+#include "PlayerSaveScheduler.h"
 #include "PoolMgr.h"
 #include "QueryCallback.h"
+#include "QueryResultSnapshot.h"
 #include "QuestPools.h"
 #include "Realm.h"
 #include "ScriptMgr.h"
@@ -77,6 +80,7 @@
 #include "SkillExtraItems.h"
 #include "SmartScriptMgr.h"
 #include "SpellMgr.h"
+#include "StartupTaskGraph.h"
 #include "TicketMgr.h"
 #include "TransportMgr.h"
 #include "Unit.h"
@@ -707,9 +711,12 @@ void World::LoadConfigSettings(bool reload)
         TC_LOG_ERROR("server.loading", "InstanceMapLoadAllGrids enabled, but GridUnload also enabled. GridUnload must be disabled to enable instance map pre-loading. Instance map pre-loading disabled");
         m_bool_configs[CONFIG_INSTANCEMAP_LOAD_GRIDS] = false;
     }
+    m_int_configs[CONFIG_STARTUP_LOADING_THREADS] = sConfigMgr->GetIntDefault("Startup.LoadingThreads", 1);
+    m_bool_configs[CONFIG_STARTUP_SNAPSHOT] = sConfigMgr->GetBoolDefault("Startup.Snapshot", false);
     m_int_configs[CONFIG_INTERVAL_SAVE] = sConfigMgr->GetIntDefault("PlayerSaveInterval", 15 * MINUTE * IN_MILLISECONDS);
     m_int_configs[CONFIG_INTERVAL_DISCONNECT_TOLERANCE] = sConfigMgr->GetIntDefault("DisconnectToleranceInterval", 0);
     m_bool_configs[CONFIG_STATS_SAVE_ONLY_ON_LOGOUT] = sConfigMgr->GetBoolDefault("PlayerSave.Stats.SaveOnlyOnLogout", true);
+    m_bool_configs[CONFIG_PLAYER_SAVE_DELTA] = sConfigMgr->GetBoolDefault("PlayerSave.Delta", true);
 
     m_int_configs[CONFIG_MIN_LEVEL_STAT_SAVE] = sConfigMgr->GetIntDefault("PlayerSave.Stats.MinLevel", 0);
     if (m_int_configs[CONFIG_MIN_LEVEL_STAT_SAVE] > MAX_LEVEL)
@@ -718,6 +725,10 @@ void World::LoadConfigSettings(bool reload)
         m_int_configs[CONFIG_MIN_LEVEL_STAT_SAVE] = 0;
     }
 
+    m_int_configs[CONFIG_PLAYER_SAVE_MAX_PER_SECOND] = sConfigMgr->GetIntDefault("PlayerSave.MaxPerSecond", 0);
+    m_int_configs[CONFIG_PLAYER_SAVE_MAX_QUEUE_SIZE] = sConfigMgr->GetIntDefault("PlayerSave.MaxQueueSize", 1000);
+    sPlayerSaveScheduler->SetLimits(m_int_configs[CONFIG_INTERVAL_SAVE], m_int_configs[CONFIG_PLAYER_SAVE_MAX_PER_SECOND], m_int_configs[CONFIG_PLAYER_SAVE_MAX_QUEUE_SIZE]);
+
     m_int_configs[CONFIG_INTERVAL_GRIDCLEAN] = sConfigMgr->GetIntDefault("GridCleanUpDelay", 5 * MINUTE * IN_MILLISECONDS);
     if (m_int_configs[CONFIG_INTERVAL_GRIDCLEAN] < MIN_GRID_DELAY)
     {
@@ -750,6 +761,7 @@ void World::LoadConfigSettings(bool reload)
     // Config values are in "milliseconds" but we handle SocketTimeOut only as "seconds" so divide by 1000
     m_int_configs[CONFIG_SOCKET_TIMEOUTTIME] = sConfigMgr->GetIntDefault("SocketTimeOutTime", 900000) / 1000;
     m_int_configs[CONFIG_SOCKET_TIMEOUTTIME_ACTIVE] = sConfigMgr->GetIntDefault("SocketTimeOutTimeActive", 60000) / 1000;
+    m_bool_configs[CONFIG_OPCODE_STATISTICS] = sConfigMgr->GetBoolDefault("Network.OpcodeStatistics", true);
 
     m_int_configs[CONFIG_SESSION_ADD_DELAY] = sConfigMgr->GetIntDefault("SessionAddDelay", 10000);
 
@@ -1325,6 +1337,11 @@ void World::LoadConfigSettings(bool reload)
     m_visibility_notify_periodInBG         = sConfigMgr->GetIntDefault("Visibility.Notify.Period.InBG",         DEFAULT_VISIBILITY_NOTIFY_PERIOD);
     m_visibility_notify_periodInArenas     = sConfigMgr->GetIntDefault("Visibility.Notify.Period.InArenas",     DEFAULT_VISIBILITY_NOTIFY_PERIOD);
 
+    m_bool_configs[CONFIG_VISIBILITY_INCREMENTAL] = sConfigMgr->GetBoolDefault("Visibility.Incremental.Enable", false);
+    m_bool_configs[CONFIG_VISIBILITY_INCREMENTAL_VERIFY] = sConfigMgr->GetBoolDefault("Visibility.Incremental.Verify", false);
+    m_int_configs[CONFIG_VISIBILITY_INCREMENTAL_FULL_UPDATE_INTERVAL] = sConfigMgr->GetIntDefault("Visibility.Incremental.FullUpdateInterval", 10000);
+    m_int_configs[CONFIG_RELOCATION_BATCH_MIN_CREATURES] = sConfigMgr->GetIntDefault("Visibility.Notify.BatchMinCreatures", 4);
+
     ///- Load the CharDelete related config options
     m_int_configs[CONFIG_CHARDELETE_METHOD] = sConfigMgr->GetIntDefault("CharDelete.Method", 0);
     m_int_configs[CONFIG_CHARDELETE_MIN_LEVEL] = sConfigMgr->GetIntDefault("CharDelete.MinLevel", 0);
@@ -1422,6 +1439,16 @@ void World::LoadConfigSettings(bool reload)
     m_bool_configs[CONFIG_ENABLE_MMAPS] = sConfigMgr->GetBoolDefault("mmap.enablePathFinding", true);
     TC_LOG_INFO("server.loading", "WORLD: MMap data directory is: {}mmaps", m_dataPath);
 
+    m_bool_configs[CONFIG_PATHFINDING_ASYNC] = sConfigMgr->GetBoolDefault("mmap.AsyncPathfinding.Enable", false);
+    m_int_configs[CONFIG_PATHFINDING_ASYNC_THREADS] = sConfigMgr->GetIntDefault("mmap.AsyncPathfinding.Threads", 2);
+    if (m_int_configs[CONFIG_PATHFINDING_ASYNC_THREADS] < 1)
+    {
+        TC_LOG_ERROR("server.loading", "mmap.AsyncPathfinding.Threads ({}) must be > 0. Using 1 instead.", m_int_configs[CONFIG_PATHFINDING_ASYNC_THREADS]);
+        m_int_configs[CONFIG_PATHFINDING_ASYNC_THREADS] = 1;
+    }
+    m_int_configs[CONFIG_PATHFINDING_CACHE_SIZE] = sConfigMgr->GetIntDefault("mmap.PathCache.Size", 4096);
+    m_int_configs[CONFIG_PATHFINDING_CACHE_TIMEOUT] = sConfigMgr->GetIntDefault("mmap.PathCache.Timeout", 2000);
+
     m_bool_configs[CONFIG_VMAP_INDOOR_CHECK] = sConfigMgr->GetBoolDefault("vmap.enableIndoorCheck", false);
     bool enableIndoor = sConfigMgr->GetBoolDefault("vmap.enableIndoorCheck", true);
     bool enableLOS = sConfigMgr->GetBoolDefault("vmap.enableLOS", true);
@@ -1468,6 +1495,32 @@ void World::LoadConfigSettings(bool reload)
     m_bool_configs[CONFIG_SHOW_MUTE_IN_WORLD] = sConfigMgr->GetBoolDefault("ShowMuteInWorld", false);
     m_bool_configs[CONFIG_SHOW_BAN_IN_WORLD] = sConfigMgr->GetBoolDefault("ShowBanInWorld", false);
     m_int_configs[CONFIG_NUMTHREADS] = sConfigMgr->GetIntDefault("MapUpdate.Threads", 1);
+    m_bool_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS] = sConfigMgr->GetBoolDefault("MapUpdate.ParallelRegions.Enable", false);
+    m_int_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS_THREADS] = sConfigMgr->GetIntDefault("MapUpdate.ParallelRegions.Threads", 2);
+    m_float_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND] = sConfigMgr->GetFloatDefault("MapUpdate.ParallelRegions.GuardBand", 150.0f);
+    if (m_float_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND] < 0.0f)
+    {
+        TC_LOG_ERROR("server.loading", "MapUpdate.ParallelRegions.GuardBand ({}) must be >= 0. Using 150 instead.", m_float_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND]);
+        m_float_configs[CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND] = 150.0f;
+    }
+    m_bool_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD] = sConfigMgr->GetBoolDefault("MapUpdate.ParallelPacketBuild.Enable", false);
+    m_int_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS] = sConfigMgr->GetIntDefault("MapUpdate.ParallelPacketBuild.Threads", 2);
+    if (m_int_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS] < 1)
+    {
+        TC_LOG_ERROR("server.loading", "MapUpdate.ParallelPacketBuild.Threads ({}) must be > 0. Using 1 instead.", m_int_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS]);
+        m_int_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS] = 1;
+    }
+    m_int_configs[CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_MIN_PLAYERS] = sConfigMgr->GetIntDefault("MapUpdate.ParallelPacketBuild.MinPlayers", 16);
+    m_bool_configs[CONFIG_GRID_PREFETCH] = sConfigMgr->GetBoolDefault("GridPrefetch.Enable", false);
+    m_int_configs[CONFIG_GRID_PREFETCH_THREADS] = sConfigMgr->GetIntDefault("GridPrefetch.Threads", 2);
+    if (m_int_configs[CONFIG_GRID_PREFETCH_THREADS] < 1)
+    {
+        TC_LOG_ERROR("server.loading", "GridPrefetch.Threads ({}) must be > 0. Using 1 instead.", m_int_configs[CONFIG_GRID_PREFETCH_THREADS]);
+        m_int_configs[CONFIG_GRID_PREFETCH_THREADS] = 1;
+    }
+    m_int_configs[CONFIG_GRID_PREFETCH_LOOKAHEAD_TIME] = sConfigMgr->GetIntDefault("GridPrefetch.LookAheadTime", 15000);
+    m_int_configs[CONFIG_GRID_PREFETCH_MAX_PENDING] = sConfigMgr->GetIntDefault("GridPrefetch.MaxPending", 8);
+    m_int_configs[CONFIG_GRID_PREFETCH_CACHE_TIMEOUT] = sConfigMgr->GetIntDefault("GridPrefetch.CacheTimeout", 60000);
     m_int_configs[CONFIG_MAX_RESULTS_LOOKUP_COMMANDS] = sConfigMgr->GetIntDefault("Command.LookupMaxResults", 0);
 
     // Warden
@@ -1696,441 +1749,702 @@ void World::SetInitialWorldSettings()
     ///- Initialize static helper structures
     AIRegistry::Initialize();
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo store...");
-    sSpellMgr->LoadSpellInfoStore();
+    ///- Load the world data. Every loader names the loaders whose data it reads, with Startup.LoadingThreads > 1
+    ///- loaders that do not depend on each other run concurrently. A loader must not read data of a loader it does not depend on.
+    StartupTaskGraph loaders;
+
+    ///- With Startup.Snapshot the results of the world database queries of the loaders are kept in a file,
+    ///- the next start of the same database revision and core reads them from there instead of the database
+    std::shared_ptr<QueryResultSnapshot> worldSnapshot;
+    std::string const worldSnapshotFile = m_dataPath + "world_snapshot.bin";
+    if (getBoolConfig(CONFIG_STARTUP_SNAPSHOT))
+    {
+        std::string const revision = DBUpdater<WorldDatabaseConnection>::GetRevision(WorldDatabase);
+        if (revision.empty())
+            TC_LOG_ERROR("server.loading", "Startup.Snapshot enabled, but the updates applied to the world database cannot be read. Snapshot disabled");
+        else
+        {
+            worldSnapshot = std::make_shared<QueryResultSnapshot>();
+            worldSnapshot->Open(worldSnapshotFile, Trinity::StringFormat("{} {} {}", revision, m_DBVersion, GitRevision::GetFullVersion()));
+            WorldDatabase.SetResultSnapshot(worldSnapshot);
+        }
+    }
+
+    loaders.Add("SpellInfo", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading SpellInfo store...");
+        sSpellMgr->LoadSpellInfoStore();
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo corrections...");
-    sSpellMgr->LoadSpellInfoCorrections();
+        TC_LOG_INFO("server.loading", "Loading SpellInfo corrections...");
+        sSpellMgr->LoadSpellInfoCorrections();
 
-    TC_LOG_INFO("server.loading", "Loading SkillLineAbilityMultiMap Data...");
-    sSpellMgr->LoadSkillLineAbilityMap();
+        TC_LOG_INFO("server.loading", "Loading SkillLineAbilityMultiMap Data...");
+        sSpellMgr->LoadSkillLineAbilityMap();
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo custom attributes...");
-    sSpellMgr->LoadSpellInfoCustomAttributes();
+        TC_LOG_INFO("server.loading", "Loading SpellInfo custom attributes...");
+        sSpellMgr->LoadSpellInfoCustomAttributes();
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo diminishing infos...");
-    sSpellMgr->LoadSpellInfoDiminishing();
+        TC_LOG_INFO("server.loading", "Loading SpellInfo diminishing infos...");
+        sSpellMgr->LoadSpellInfoDiminishing();
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo immunity infos...");
-    sSpellMgr->LoadSpellInfoImmunities();
+        TC_LOG_INFO("server.loading", "Loading SpellInfo immunity infos...");
+        sSpellMgr->LoadSpellInfoImmunities();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Player Totem models...");
-    sObjectMgr->LoadPlayerTotemModels();
+    loaders.Add("Player totem models", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Player Totem models...");
+        sObjectMgr->LoadPlayerTotemModels();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading GameObject models...");
-    LoadGameObjectModelList(m_dataPath);
+    loaders.Add("GameObject models", {}, [this]()
+    {
+        TC_LOG_INFO("server.loading", "Loading GameObject models...");
+        LoadGameObjectModelList(m_dataPath);
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Script Names...");
-    sObjectMgr->LoadScriptNames();
+    loaders.Add("Script names", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Script Names...");
+        sObjectMgr->LoadScriptNames();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Instance Template...");
-    sObjectMgr->LoadInstanceTemplate();
+    loaders.Add("Instance templates", { "Script names" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Instance Template...");
+        sObjectMgr->LoadInstanceTemplate();
+    });
 
     // Must be called before `respawn` data
-    TC_LOG_INFO("server.loading", "Loading instances...");
-    sInstanceSaveMgr->LoadInstances();
+    loaders.Add("Instances", { "Instance templates" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading instances...");
+        sInstanceSaveMgr->LoadInstances();
+    });
 
     // Load before guilds and arena teams
-    TC_LOG_INFO("server.loading", "Loading character cache store...");
-    sCharacterCache->LoadCharacterCacheStorage();
+    loaders.Add("Character cache", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading character cache store...");
+        sCharacterCache->LoadCharacterCacheStorage();
+    });
+
+    loaders.Add("Broadcast texts", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Broadcast texts...");
+        sObjectMgr->LoadBroadcastTexts();
+        sObjectMgr->LoadBroadcastTextLocales();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Broadcast texts...");
-    sObjectMgr->LoadBroadcastTexts();
-    sObjectMgr->LoadBroadcastTextLocales();
+    loaders.Add("Localization strings", {}, [this]()
+    {
+        TC_LOG_INFO("server.loading", "Loading Localization strings...");
+        uint32 oldMSTime = getMSTime();
+        sObjectMgr->LoadCreatureLocales();
+        sObjectMgr->LoadGameObjectLocales();
+        sObjectMgr->LoadItemLocales();
+        sObjectMgr->LoadItemSetNameLocales();
+        sObjectMgr->LoadQuestLocales();
+        sObjectMgr->LoadQuestOfferRewardLocale();
+        sObjectMgr->LoadQuestRequestItemsLocale();
+        sObjectMgr->LoadNpcTextLocales();
+        sObjectMgr->LoadPageTextLocales();
+        sObjectMgr->LoadGossipMenuItemsLocales();
+        sObjectMgr->LoadPointOfInterestLocales();
+        sObjectMgr->LoadQuestGreetingLocales();
 
-    TC_LOG_INFO("server.loading", "Loading Localization strings...");
-    uint32 oldMSTime = getMSTime();
-    sObjectMgr->LoadCreatureLocales();
-    sObjectMgr->LoadGameObjectLocales();
-    sObjectMgr->LoadItemLocales();
-    sObjectMgr->LoadItemSetNameLocales();
-    sObjectMgr->LoadQuestLocales();
-    sObjectMgr->LoadQuestOfferRewardLocale();
-    sObjectMgr->LoadQuestRequestItemsLocale();
-    sObjectMgr->LoadNpcTextLocales();
-    sObjectMgr->LoadPageTextLocales();
-    sObjectMgr->LoadGossipMenuItemsLocales();
-    sObjectMgr->LoadPointOfInterestLocales();
-    sObjectMgr->LoadQuestGreetingLocales();
+        sObjectMgr->SetDBCLocaleIndex(GetDefaultDbcLocale());        // Get once for all the locale index of DBC language (console/broadcasts)
+        TC_LOG_INFO("server.loading", ">> Localization strings loaded in {} ms", GetMSTimeDiffToNow(oldMSTime));
+    });
 
-    sObjectMgr->SetDBCLocaleIndex(GetDefaultDbcLocale());        // Get once for all the locale index of DBC language (console/broadcasts)
-    TC_LOG_INFO("server.loading", ">> Localization strings loaded in {} ms", GetMSTimeDiffToNow(oldMSTime));
+    loaders.Add("Account roles and permissions", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Account Roles and Permissions...");
+        sAccountMgr->LoadRBAC();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Account Roles and Permissions...");
-    sAccountMgr->LoadRBAC();
+    loaders.Add("Page texts", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Page Texts...");
+        sObjectMgr->LoadPageTexts();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Page Texts...");
-    sObjectMgr->LoadPageTexts();
+    loaders.Add("GameObject templates", { "Page texts", "Script names", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Game Object Templates...");         // must be after LoadPageTexts
+        sObjectMgr->LoadGameObjectTemplate();
 
-    TC_LOG_INFO("server.loading", "Loading Game Object Templates...");         // must be after LoadPageTexts
-    sObjectMgr->LoadGameObjectTemplate();
+        TC_LOG_INFO("server.loading", "Loading Game Object template addons...");
+        sObjectMgr->LoadGameObjectTemplateAddons();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Game Object template addons...");
-    sObjectMgr->LoadGameObjectTemplateAddons();
+    loaders.Add("Transport templates", { "GameObject templates" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Transport templates...");
+        sTransportMgr->LoadTransportTemplates();
 
-    TC_LOG_INFO("server.loading", "Loading Transport templates...");
-    sTransportMgr->LoadTransportTemplates();
+        TC_LOG_INFO("server.loading", "Loading Transport animations and rotations...");
+        sTransportMgr->LoadTransportAnimationAndRotation();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Transport animations and rotations...");
-    sTransportMgr->LoadTransportAnimationAndRotation();
+    loaders.Add("Spell data", { "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Spell Rank Data...");
+        sSpellMgr->LoadSpellRanks();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Rank Data...");
-    sSpellMgr->LoadSpellRanks();
+        TC_LOG_INFO("server.loading", "Loading Spell Required Data...");
+        sSpellMgr->LoadSpellRequired();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Required Data...");
-    sSpellMgr->LoadSpellRequired();
+        TC_LOG_INFO("server.loading", "Loading Spell Group types...");
+        sSpellMgr->LoadSpellGroups();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Group types...");
-    sSpellMgr->LoadSpellGroups();
+        TC_LOG_INFO("server.loading", "Loading Spell Learn Skills...");
+        sSpellMgr->LoadSpellLearnSkills();                           // must be after LoadSpellRanks
 
-    TC_LOG_INFO("server.loading", "Loading Spell Learn Skills...");
-    sSpellMgr->LoadSpellLearnSkills();                           // must be after LoadSpellRanks
+        TC_LOG_INFO("server.loading", "Loading SpellInfo SpellSpecific and AuraState...");
+        sSpellMgr->LoadSpellInfoSpellSpecificAndAuraState();         // must be after LoadSpellRanks
 
-    TC_LOG_INFO("server.loading", "Loading SpellInfo SpellSpecific and AuraState...");
-    sSpellMgr->LoadSpellInfoSpellSpecificAndAuraState();         // must be after LoadSpellRanks
+        TC_LOG_INFO("server.loading", "Loading Spell Learn Spells...");
+        sSpellMgr->LoadSpellLearnSpells();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Learn Spells...");
-    sSpellMgr->LoadSpellLearnSpells();
+        TC_LOG_INFO("server.loading", "Loading Spell Proc conditions and data...");
+        sSpellMgr->LoadSpellProcs();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Proc conditions and data...");
-    sSpellMgr->LoadSpellProcs();
+        TC_LOG_INFO("server.loading", "Loading Spell Bonus Data...");
+        sSpellMgr->LoadSpellBonuses();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Bonus Data...");
-    sSpellMgr->LoadSpellBonuses();
+        TC_LOG_INFO("server.loading", "Loading Aggro Spells Definitions...");
+        sSpellMgr->LoadSpellThreats();
 
-    TC_LOG_INFO("server.loading", "Loading Aggro Spells Definitions...");
-    sSpellMgr->LoadSpellThreats();
+        TC_LOG_INFO("server.loading", "Loading Spell Group Stack Rules...");
+        sSpellMgr->LoadSpellGroupStackRules();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Spell Group Stack Rules...");
-    sSpellMgr->LoadSpellGroupStackRules();
+    loaders.Add("NPC texts", { "Broadcast texts" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading NPC Texts...");
+        sObjectMgr->LoadGossipText();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading NPC Texts...");
-    sObjectMgr->LoadGossipText();
+    loaders.Add("Enchant proc data", { "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Enchant Spells Proc datas...");
+        sSpellMgr->LoadSpellEnchantProcData();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Enchant Spells Proc datas...");
-    sSpellMgr->LoadSpellEnchantProcData();
+    loaders.Add("Item random enchantments", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Item Random Enchantments Table...");
+        LoadRandomEnchantmentsTable();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Item Random Enchantments Table...");
-    LoadRandomEnchantmentsTable();
+    loaders.Add("Disables", { "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Disables");                         // must be before loading quests and items
+        DisableMgr::LoadDisables();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Disables");                         // must be before loading quests and items
-    DisableMgr::LoadDisables();
+    loaders.Add("Items", { "Item random enchantments", "Page texts", "Disables", "Script names", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Items...");                         // must be after LoadRandomEnchantmentsTable and LoadPageTexts
+        sObjectMgr->LoadItemTemplates();
 
-    TC_LOG_INFO("server.loading", "Loading Items...");                         // must be after LoadRandomEnchantmentsTable and LoadPageTexts
-    sObjectMgr->LoadItemTemplates();
+        TC_LOG_INFO("server.loading", "Loading Item set names...");                // must be after LoadItemPrototypes
+        sObjectMgr->LoadItemSetNames();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Item set names...");                // must be after LoadItemPrototypes
-    sObjectMgr->LoadItemSetNames();
+    loaders.Add("Creature templates", { "Script names", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Model Based Info Data...");
+        sObjectMgr->LoadCreatureModelInfo();
 
-    TC_LOG_INFO("server.loading", "Loading Creature Model Based Info Data...");
-    sObjectMgr->LoadCreatureModelInfo();
+        TC_LOG_INFO("server.loading", "Loading Creature templates...");
+        sObjectMgr->LoadCreatureTemplates();
 
-    TC_LOG_INFO("server.loading", "Loading Creature templates...");
-    sObjectMgr->LoadCreatureTemplates();
+        TC_LOG_INFO("server.loading", "Loading Equipment templates...");           // must be after LoadCreatureTemplates
+        sObjectMgr->LoadEquipmentTemplates();
 
-    TC_LOG_INFO("server.loading", "Loading Equipment templates...");           // must be after LoadCreatureTemplates
-    sObjectMgr->LoadEquipmentTemplates();
+        TC_LOG_INFO("server.loading", "Loading Creature template addons...");
+        sObjectMgr->LoadCreatureTemplateAddons();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Creature template addons...");
-    sObjectMgr->LoadCreatureTemplateAddons();
+    loaders.Add("Reputation", { "Creature templates" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Reputation Reward Rates...");
+        sObjectMgr->LoadReputationRewardRate();
 
-    TC_LOG_INFO("server.loading", "Loading Reputation Reward Rates...");
-    sObjectMgr->LoadReputationRewardRate();
+        TC_LOG_INFO("server.loading", "Loading Creature Reputation OnKill Data...");
+        sObjectMgr->LoadReputationOnKill();
 
-    TC_LOG_INFO("server.loading", "Loading Creature Reputation OnKill Data...");
-    sObjectMgr->LoadReputationOnKill();
+        TC_LOG_INFO("server.loading", "Loading Reputation Spillover Data...");
+        sObjectMgr->LoadReputationSpilloverTemplate();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Reputation Spillover Data...");
-    sObjectMgr->LoadReputationSpilloverTemplate();
+    loaders.Add("Points of interest", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Points Of Interest Data...");
+        sObjectMgr->LoadPointsOfInterest();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Points Of Interest Data...");
-    sObjectMgr->LoadPointsOfInterest();
+    loaders.Add("Creature base stats", { "Creature templates" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Base Stats...");
+        sObjectMgr->LoadCreatureClassLevelStats();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Creature Base Stats...");
-    sObjectMgr->LoadCreatureClassLevelStats();
+    loaders.Add("Spawn group templates", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Spawn Group Templates...");
+        sObjectMgr->LoadSpawnGroupTemplates();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Spawn Group Templates...");
-    sObjectMgr->LoadSpawnGroupTemplates();
+    // creatures and gameobjects share the cell lists of the maps, so their spawns are loaded by one task
+    loaders.Add("Spawns", { "Creature templates", "GameObject templates", "Transport templates", "Spawn group templates", "Instance templates" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Data...");
+        sObjectMgr->LoadCreatures();
 
-    TC_LOG_INFO("server.loading", "Loading Creature Data...");
-    sObjectMgr->LoadCreatures();
+        TC_LOG_INFO("server.loading", "Loading Temporary Summon Data...");
+        sObjectMgr->LoadTempSummons();                               // must be after LoadCreatureTemplates() and LoadGameObjectTemplates()
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Temporary Summon Data...");
-    sObjectMgr->LoadTempSummons();                               // must be after LoadCreatureTemplates() and LoadGameObjectTemplates()
+    loaders.Add("Pet spells", { "Creature templates", "Spell data" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading pet levelup spells...");
+        sSpellMgr->LoadPetLevelupSpellMap();
 
-    TC_LOG_INFO("server.loading", "Loading pet levelup spells...");
-    sSpellMgr->LoadPetLevelupSpellMap();
+        TC_LOG_INFO("server.loading", "Loading pet default spells additional to levelup spells...");
+        sSpellMgr->LoadPetDefaultSpells();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading pet default spells additional to levelup spells...");
-    sSpellMgr->LoadPetDefaultSpells();
+    loaders.Add("Spawn data", { "Spawns" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Addon Data...");
+        sObjectMgr->LoadCreatureAddons();                            // must be after LoadCreatureTemplates() and LoadCreatures()
 
-    TC_LOG_INFO("server.loading", "Loading Creature Addon Data...");
-    sObjectMgr->LoadCreatureAddons();                            // must be after LoadCreatureTemplates() and LoadCreatures()
+        TC_LOG_INFO("server.loading", "Loading Creature Movement Overrides...");
+        sObjectMgr->LoadCreatureMovementOverrides();                 // must be after LoadCreatures()
 
-    TC_LOG_INFO("server.loading", "Loading Creature Movement Overrides...");
-    sObjectMgr->LoadCreatureMovementOverrides();                 // must be after LoadCreatures()
+        TC_LOG_INFO("server.loading", "Loading Gameobject Data...");
+        sObjectMgr->LoadGameObjects();
 
-    TC_LOG_INFO("server.loading", "Loading Gameobject Data...");
-    sObjectMgr->LoadGameObjects();
+        TC_LOG_INFO("server.loading", "Loading Spawn Group Data...");
+        sObjectMgr->LoadSpawnGroups();
 
-    TC_LOG_INFO("server.loading", "Loading Spawn Group Data...");
-    sObjectMgr->LoadSpawnGroups();
+        TC_LOG_INFO("server.loading", "Loading instance spawn groups...");
+        sObjectMgr->LoadInstanceSpawnGroups();
 
-    TC_LOG_INFO("server.loading", "Loading instance spawn groups...");
-    sObjectMgr->LoadInstanceSpawnGroups();
+        TC_LOG_INFO("server.loading", "Loading GameObject Addon Data...");
+        sObjectMgr->LoadGameObjectAddons();                          // must be after LoadGameObjects()
 
-    TC_LOG_INFO("server.loading", "Loading GameObject Addon Data...");
-    sObjectMgr->LoadGameObjectAddons();                          // must be after LoadGameObjects()
+        TC_LOG_INFO("server.loading", "Loading GameObject faction and flags overrides...");
+        sObjectMgr->LoadGameObjectOverrides();                       // must be after LoadGameObjects()
 
-    TC_LOG_INFO("server.loading", "Loading GameObject faction and flags overrides...");
-    sObjectMgr->LoadGameObjectOverrides();                       // must be after LoadGameObjects()
+        TC_LOG_INFO("server.loading", "Loading GameObject Quest Items...");
+        sObjectMgr->LoadGameObjectQuestItems();
 
-    TC_LOG_INFO("server.loading", "Loading GameObject Quest Items...");
-    sObjectMgr->LoadGameObjectQuestItems();
+        TC_LOG_INFO("server.loading", "Loading Creature Quest Items...");
+        sObjectMgr->LoadCreatureQuestItems();
 
-    TC_LOG_INFO("server.loading", "Loading Creature Quest Items...");
-    sObjectMgr->LoadCreatureQuestItems();
+        TC_LOG_INFO("server.loading", "Loading Creature Linked Respawn...");
+        sObjectMgr->LoadLinkedRespawn();                             // must be after LoadCreatures(), LoadGameObjects()
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Creature Linked Respawn...");
-    sObjectMgr->LoadLinkedRespawn();                             // must be after LoadCreatures(), LoadGameObjects()
+    loaders.Add("Weather", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Weather Data...");
+        WeatherMgr::LoadWeatherData();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Weather Data...");
-    WeatherMgr::LoadWeatherData();
+    loaders.Add("Quests", { "Creature templates", "GameObject templates", "Items", "Disables", "Spell data" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Quests...");
+        sObjectMgr->LoadQuests();                                    // must be loaded after DBCs, creature_template, item_template, gameobject tables
 
-    TC_LOG_INFO("server.loading", "Loading Quests...");
-    sObjectMgr->LoadQuests();                                    // must be loaded after DBCs, creature_template, item_template, gameobject tables
+        TC_LOG_INFO("server.loading", "Checking Quest Disables");
+        DisableMgr::CheckQuestDisables();                           // must be after loading quests
 
-    TC_LOG_INFO("server.loading", "Checking Quest Disables");
-    DisableMgr::CheckQuestDisables();                           // must be after loading quests
+        TC_LOG_INFO("server.loading", "Loading Quest POI");
+        sObjectMgr->LoadQuestPOI();
 
-    TC_LOG_INFO("server.loading", "Loading Quest POI");
-    sObjectMgr->LoadQuestPOI();
+        TC_LOG_INFO("server.loading", "Loading Quests Starters and Enders...");
+        sObjectMgr->LoadQuestStartersAndEnders();                    // must be after quest load
 
-    TC_LOG_INFO("server.loading", "Loading Quests Starters and Enders...");
-    sObjectMgr->LoadQuestStartersAndEnders();                    // must be after quest load
+        TC_LOG_INFO("server.loading", "Loading Quests Greetings...");
+        sObjectMgr->LoadQuestGreetings();                           // must be loaded after creature_template, gameobject_template tables
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Quests Greetings...");
-    sObjectMgr->LoadQuestGreetings();                           // must be loaded after creature_template, gameobject_template tables
+    loaders.Add("Pools", { "Spawn data" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Objects Pooling Data...");
+        sPoolMgr->LoadFromDB();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Objects Pooling Data...");
-    sPoolMgr->LoadFromDB();
-    TC_LOG_INFO("server.loading", "Loading Quest Pooling Data...");
-    sQuestPoolMgr->LoadFromDB();                                // must be after quest templates
+    loaders.Add("Quest pools", { "Quests" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Quest Pooling Data...");
+        sQuestPoolMgr->LoadFromDB();                                // must be after quest templates
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Game Event Data...");               // must be after loading pools fully
-    sGameEventMgr->LoadHolidayDates();                           // Must be after loading DBC
-    sGameEventMgr->LoadFromDB();                                 // Must be after loading holiday dates
+    loaders.Add("Game events", { "Pools", "Quest pools" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Game Event Data...");               // must be after loading pools fully
+        sGameEventMgr->LoadHolidayDates();                           // Must be after loading DBC
+        sGameEventMgr->LoadFromDB();                                 // Must be after loading holiday dates
+    });
 
-    TC_LOG_INFO("server.loading", "Loading UNIT_NPC_FLAG_SPELLCLICK Data..."); // must be after LoadQuests
-    sObjectMgr->LoadNPCSpellClickSpells();
+    // the loaders from here to the conditions are kept in their old order, each depends on the one before it
+    loaders.Add("Spell click spells", { "Game events" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading UNIT_NPC_FLAG_SPELLCLICK Data..."); // must be after LoadQuests
+        sObjectMgr->LoadNPCSpellClickSpells();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Vehicle Templates...");
-    sObjectMgr->LoadVehicleTemplate();                          // must be after LoadCreatureTemplates()
+    loaders.Add("Vehicles", { "Spell click spells" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Vehicle Templates...");
+        sObjectMgr->LoadVehicleTemplate();                          // must be after LoadCreatureTemplates()
 
-    TC_LOG_INFO("server.loading", "Loading Vehicle Template Accessories...");
-    sObjectMgr->LoadVehicleTemplateAccessories();                // must be after LoadCreatureTemplates() and LoadNPCSpellClickSpells()
+        TC_LOG_INFO("server.loading", "Loading Vehicle Template Accessories...");
+        sObjectMgr->LoadVehicleTemplateAccessories();                // must be after LoadCreatureTemplates() and LoadNPCSpellClickSpells()
 
-    TC_LOG_INFO("server.loading", "Loading Vehicle Accessories...");
-    sObjectMgr->LoadVehicleAccessories();                       // must be after LoadCreatureTemplates() and LoadNPCSpellClickSpells()
+        TC_LOG_INFO("server.loading", "Loading Vehicle Accessories...");
+        sObjectMgr->LoadVehicleAccessories();                       // must be after LoadCreatureTemplates() and LoadNPCSpellClickSpells()
 
-    TC_LOG_INFO("server.loading", "Loading Vehicle Seat Addon Data...");
-    sObjectMgr->LoadVehicleSeatAddon();                         // must be after loading DBC
+        TC_LOG_INFO("server.loading", "Loading Vehicle Seat Addon Data...");
+        sObjectMgr->LoadVehicleSeatAddon();                         // must be after loading DBC
+    });
 
-    TC_LOG_INFO("server.loading", "Loading SpellArea Data...");                // must be after quest load
-    sSpellMgr->LoadSpellAreas();
+    loaders.Add("Spell areas", { "Vehicles" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading SpellArea Data...");                // must be after quest load
+        sSpellMgr->LoadSpellAreas();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Area Trigger Teleports definitions...");
-    sObjectMgr->LoadAreaTriggerTeleports();
+    loaders.Add("Area triggers", { "Spell areas" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Area Trigger Teleports definitions...");
+        sObjectMgr->LoadAreaTriggerTeleports();
 
-    TC_LOG_INFO("server.loading", "Loading Access Requirements...");
-    sObjectMgr->LoadAccessRequirements();                        // must be after item template load
+        TC_LOG_INFO("server.loading", "Loading Access Requirements...");
+        sObjectMgr->LoadAccessRequirements();                        // must be after item template load
 
-    TC_LOG_INFO("server.loading", "Loading Quest Area Triggers...");
-    sObjectMgr->LoadQuestAreaTriggers();                         // must be after LoadQuests
+        TC_LOG_INFO("server.loading", "Loading Quest Area Triggers...");
+        sObjectMgr->LoadQuestAreaTriggers();                         // must be after LoadQuests
 
-    TC_LOG_INFO("server.loading", "Loading Tavern Area Triggers...");
-    sObjectMgr->LoadTavernAreaTriggers();
+        TC_LOG_INFO("server.loading", "Loading Tavern Area Triggers...");
+        sObjectMgr->LoadTavernAreaTriggers();
 
-    TC_LOG_INFO("server.loading", "Loading AreaTrigger script names...");
-    sObjectMgr->LoadAreaTriggerScripts();
+        TC_LOG_INFO("server.loading", "Loading AreaTrigger script names...");
+        sObjectMgr->LoadAreaTriggerScripts();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading LFG entrance positions..."); // Must be after areatriggers
-    sLFGMgr->LoadLFGDungeons();
+    loaders.Add("LFG dungeons", { "Area triggers" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading LFG entrance positions..."); // Must be after areatriggers
+        sLFGMgr->LoadLFGDungeons();
 
-    TC_LOG_INFO("server.loading", "Loading Dungeon boss data...");
-    sObjectMgr->LoadInstanceEncounters();
+        TC_LOG_INFO("server.loading", "Loading Dungeon boss data...");
+        sObjectMgr->LoadInstanceEncounters();
 
-    TC_LOG_INFO("server.loading", "Loading LFG rewards...");
-    sLFGMgr->LoadRewards();
+        TC_LOG_INFO("server.loading", "Loading LFG rewards...");
+        sLFGMgr->LoadRewards();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Graveyard-zone links...");
-    sObjectMgr->LoadGraveyardZones();
+    loaders.Add("Graveyard zones", { "LFG dungeons" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Graveyard-zone links...");
+        sObjectMgr->LoadGraveyardZones();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading spell pet auras...");
-    sSpellMgr->LoadSpellPetAuras();
+    loaders.Add("Spell links", { "Graveyard zones" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading spell pet auras...");
+        sSpellMgr->LoadSpellPetAuras();
 
-    TC_LOG_INFO("server.loading", "Loading Spell target coordinates...");
-    sSpellMgr->LoadSpellTargetPositions();
+        TC_LOG_INFO("server.loading", "Loading Spell target coordinates...");
+        sSpellMgr->LoadSpellTargetPositions();
 
-    TC_LOG_INFO("server.loading", "Loading enchant custom attributes...");
-    sSpellMgr->LoadEnchantCustomAttr();
+        TC_LOG_INFO("server.loading", "Loading enchant custom attributes...");
+        sSpellMgr->LoadEnchantCustomAttr();
 
-    TC_LOG_INFO("server.loading", "Loading linked spells...");
-    sSpellMgr->LoadSpellLinked();
+        TC_LOG_INFO("server.loading", "Loading linked spells...");
+        sSpellMgr->LoadSpellLinked();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Player Create Data...");
-    sObjectMgr->LoadPlayerInfo();
+    loaders.Add("Player create data", { "Items", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Player Create Data...");
+        sObjectMgr->LoadPlayerInfo();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Exploration BaseXP Data...");
-    sObjectMgr->LoadExplorationBaseXP();
+    loaders.Add("Pet names", { "Spell links" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Exploration BaseXP Data...");
+        sObjectMgr->LoadExplorationBaseXP();
 
-    TC_LOG_INFO("server.loading", "Loading Pet Name Parts...");
-    sObjectMgr->LoadPetNames();
+        TC_LOG_INFO("server.loading", "Loading Pet Name Parts...");
+        sObjectMgr->LoadPetNames();
+    });
 
-    CharacterDatabaseCleaner::CleanDatabase();
+    loaders.Add("Character database cleanup", { "Pet names" }, []()
+    {
+        CharacterDatabaseCleaner::CleanDatabase();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading the max pet number...");
-    sObjectMgr->LoadPetNumber();
+    loaders.Add("Pet stats", { "Character database cleanup" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading the max pet number...");
+        sObjectMgr->LoadPetNumber();
 
-    TC_LOG_INFO("server.loading", "Loading pet level stats...");
-    sObjectMgr->LoadPetLevelInfo();
+        TC_LOG_INFO("server.loading", "Loading pet level stats...");
+        sObjectMgr->LoadPetLevelInfo();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Player level dependent mail rewards...");
-    sObjectMgr->LoadMailLevelRewards();
+    loaders.Add("Mail level rewards", { "Pet stats" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Player level dependent mail rewards...");
+        sObjectMgr->LoadMailLevelRewards();
+    });
 
-    // Loot tables
-    LoadLootTables();
+    // Loot tables, every store is independent of the others, references are checked when all of them are loaded
+    loaders.Add("Creature loot", { "Creature templates", "Items" }, []() { LoadLootTemplates_Creature(); });
+    loaders.Add("Fishing loot", { "Items" }, []() { LoadLootTemplates_Fishing(); });
+    loaders.Add("GameObject loot", { "GameObject templates", "Items" }, []() { LoadLootTemplates_Gameobject(); });
+    loaders.Add("Item loot", { "Items" }, []() { LoadLootTemplates_Item(); });
+    loaders.Add("Mail loot", { "Items" }, []() { LoadLootTemplates_Mail(); });
+    loaders.Add("Milling loot", { "Items" }, []() { LoadLootTemplates_Milling(); });
+    loaders.Add("Pickpocketing loot", { "Creature templates", "Items" }, []() { LoadLootTemplates_Pickpocketing(); });
+    loaders.Add("Skinning loot", { "Creature templates", "Items" }, []() { LoadLootTemplates_Skinning(); });
+    loaders.Add("Disenchant loot", { "Items" }, []() { LoadLootTemplates_Disenchant(); });
+    loaders.Add("Prospecting loot", { "Items" }, []() { LoadLootTemplates_Prospecting(); });
+    loaders.Add("Spell loot", { "Items", "Spell data" }, []() { LoadLootTemplates_Spell(); });
+    loaders.Add("Reference loot", { "Creature loot", "Fishing loot", "GameObject loot", "Item loot", "Mail loot", "Milling loot",
+        "Pickpocketing loot", "Skinning loot", "Disenchant loot", "Prospecting loot", "Spell loot" }, []() { LoadLootTemplates_Reference(); });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Discovery Table...");
-    LoadSkillDiscoveryTable();
+    loaders.Add("Skill tables", { "Items", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Skill Discovery Table...");
+        LoadSkillDiscoveryTable();
 
-    TC_LOG_INFO("server.loading", "Loading Skill Extra Item Table...");
-    LoadSkillExtraItemTable();
+        TC_LOG_INFO("server.loading", "Loading Skill Extra Item Table...");
+        LoadSkillExtraItemTable();
 
-    TC_LOG_INFO("server.loading", "Loading Skill Perfection Data Table...");
-    LoadSkillPerfectItemTable();
+        TC_LOG_INFO("server.loading", "Loading Skill Perfection Data Table...");
+        LoadSkillPerfectItemTable();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Fishing base level requirements...");
-    sObjectMgr->LoadFishingBaseSkillLevel();
+    loaders.Add("Fishing skill levels", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Skill Fishing base level requirements...");
+        sObjectMgr->LoadFishingBaseSkillLevel();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Achievements...");
-    sAchievementMgr->LoadAchievementReferenceList();
-    TC_LOG_INFO("server.loading", "Loading Achievement Criteria Lists...");
-    sAchievementMgr->LoadAchievementCriteriaList();
-    TC_LOG_INFO("server.loading", "Loading Achievement Criteria Data...");
-    sAchievementMgr->LoadAchievementCriteriaData();
-    TC_LOG_INFO("server.loading", "Loading Achievement Rewards...");
-    sAchievementMgr->LoadRewards();
-    TC_LOG_INFO("server.loading", "Loading Achievement Reward Locales...");
-    sAchievementMgr->LoadRewardLocales();
-    TC_LOG_INFO("server.loading", "Loading Completed Achievements...");
-    sAchievementMgr->LoadCompletedAchievements();
+    loaders.Add("Achievements", { "Creature templates", "Items", "Disables", "Script names", "SpellInfo" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Achievements...");
+        sAchievementMgr->LoadAchievementReferenceList();
+        TC_LOG_INFO("server.loading", "Loading Achievement Criteria Lists...");
+        sAchievementMgr->LoadAchievementCriteriaList();
+        TC_LOG_INFO("server.loading", "Loading Achievement Criteria Data...");
+        sAchievementMgr->LoadAchievementCriteriaData();
+        TC_LOG_INFO("server.loading", "Loading Achievement Rewards...");
+        sAchievementMgr->LoadRewards();
+        TC_LOG_INFO("server.loading", "Loading Achievement Reward Locales...");
+        sAchievementMgr->LoadRewardLocales();
+        TC_LOG_INFO("server.loading", "Loading Completed Achievements...");
+        sAchievementMgr->LoadCompletedAchievements();
+    });
 
     ///- Load dynamic data tables from the database
-    TC_LOG_INFO("server.loading", "Loading Item Auctions...");
-    sAuctionMgr->LoadAuctionItems();
+    loaders.Add("Auctions", { "Items", "Character cache" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Item Auctions...");
+        sAuctionMgr->LoadAuctionItems();
 
-    TC_LOG_INFO("server.loading", "Loading Auctions...");
-    sAuctionMgr->LoadAuctions();
+        TC_LOG_INFO("server.loading", "Loading Auctions...");
+        sAuctionMgr->LoadAuctions();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Guilds...");
-    sGuildMgr->LoadGuilds();
+    loaders.Add("Guilds", { "Auctions", "Achievements" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Guilds...");
+        sGuildMgr->LoadGuilds();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading ArenaTeams...");
-    sArenaTeamMgr->LoadArenaTeams();
+    loaders.Add("Arena teams", { "Guilds" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading ArenaTeams...");
+        sArenaTeamMgr->LoadArenaTeams();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Groups...");
-    sGroupMgr->LoadGroups();
+    loaders.Add("Groups", { "Arena teams", "Instances" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Groups...");
+        sGroupMgr->LoadGroups();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading ReservedNames...");
-    sObjectMgr->LoadReservedPlayersNames();
+    loaders.Add("Reserved names", { "Mail level rewards" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading ReservedNames...");
+        sObjectMgr->LoadReservedPlayersNames();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading GameObjects for quests...");
-    sObjectMgr->LoadGameObjectForQuests();
+    loaders.Add("GameObjects for quests", { "Reserved names", "Reference loot" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading GameObjects for quests...");
+        sObjectMgr->LoadGameObjectForQuests();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading BattleMasters...");
-    sBattlegroundMgr->LoadBattleMastersEntry();                 // must be after load CreatureTemplate
+    loaders.Add("Battlemasters", { "GameObjects for quests" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading BattleMasters...");
+        sBattlegroundMgr->LoadBattleMastersEntry();                 // must be after load CreatureTemplate
+    });
 
-    TC_LOG_INFO("server.loading", "Loading GameTeleports...");
-    sObjectMgr->LoadGameTele();
+    loaders.Add("Game teleports", { "Battlemasters" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading GameTeleports...");
+        sObjectMgr->LoadGameTele();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Trainers...");       // must be after LoadCreatureTemplates
-    sObjectMgr->LoadTrainers();
+    loaders.Add("Trainers", { "Game teleports" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Trainers...");       // must be after LoadCreatureTemplates
+        sObjectMgr->LoadTrainers();
 
-    TC_LOG_INFO("server.loading", "Loading Creature default trainers...");
-    sObjectMgr->LoadCreatureDefaultTrainers();
+        TC_LOG_INFO("server.loading", "Loading Creature default trainers...");
+        sObjectMgr->LoadCreatureDefaultTrainers();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Gossip menu...");
-    sObjectMgr->LoadGossipMenu();
+    loaders.Add("Gossip menus", { "Trainers" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Gossip menu...");
+        sObjectMgr->LoadGossipMenu();
 
-    TC_LOG_INFO("server.loading", "Loading Gossip menu options...");
-    sObjectMgr->LoadGossipMenuItems();                           // must be after LoadTrainers
+        TC_LOG_INFO("server.loading", "Loading Gossip menu options...");
+        sObjectMgr->LoadGossipMenuItems();                           // must be after LoadTrainers
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Vendors...");
-    sObjectMgr->LoadVendors();                                   // must be after load CreatureTemplate and ItemTemplate
+    loaders.Add("Vendors", { "Gossip menus" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Vendors...");
+        sObjectMgr->LoadVendors();                                   // must be after load CreatureTemplate and ItemTemplate
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Waypoints...");
-    sWaypointMgr->Load();
+    loaders.Add("Waypoints", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Waypoints...");
+        sWaypointMgr->Load();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading SmartAI Waypoints...");
-    sSmartWaypointMgr->LoadFromDB();
+    loaders.Add("SmartAI waypoints", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading SmartAI Waypoints...");
+        sSmartWaypointMgr->LoadFromDB();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Creature Formations...");
-    sFormationMgr->LoadCreatureFormations();
+    loaders.Add("Creature formations", { "Spawn data" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Formations...");
+        sFormationMgr->LoadCreatureFormations();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading World States...");              // must be loaded before battleground, outdoor PvP and conditions
-    LoadWorldStates();
+    loaders.Add("World states", { "Vendors" }, [this]()
+    {
+        TC_LOG_INFO("server.loading", "Loading World States...");              // must be loaded before battleground, outdoor PvP and conditions
+        LoadWorldStates();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Conditions...");
-    sConditionMgr->LoadConditions();
+    // conditions are attached to loot, gossip, vendors and spells, and change implicit spell targets that other loaders read
+    loaders.Add("Conditions", { "World states", "Reference loot", "Skill tables", "Achievements", "Player create data" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Conditions...");
+        sConditionMgr->LoadConditions();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading faction change achievement pairs...");
-    sObjectMgr->LoadFactionChangeAchievements();
+    loaders.Add("Faction change pairs", { "Conditions" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading faction change achievement pairs...");
+        sObjectMgr->LoadFactionChangeAchievements();
 
-    TC_LOG_INFO("server.loading", "Loading faction change spell pairs...");
-    sObjectMgr->LoadFactionChangeSpells();
+        TC_LOG_INFO("server.loading", "Loading faction change spell pairs...");
+        sObjectMgr->LoadFactionChangeSpells();
 
-    TC_LOG_INFO("server.loading", "Loading faction change quest pairs...");
-    sObjectMgr->LoadFactionChangeQuests();
+        TC_LOG_INFO("server.loading", "Loading faction change quest pairs...");
+        sObjectMgr->LoadFactionChangeQuests();
 
-    TC_LOG_INFO("server.loading", "Loading faction change item pairs...");
-    sObjectMgr->LoadFactionChangeItems();
+        TC_LOG_INFO("server.loading", "Loading faction change item pairs...");
+        sObjectMgr->LoadFactionChangeItems();
 
-    TC_LOG_INFO("server.loading", "Loading faction change reputation pairs...");
-    sObjectMgr->LoadFactionChangeReputations();
+        TC_LOG_INFO("server.loading", "Loading faction change reputation pairs...");
+        sObjectMgr->LoadFactionChangeReputations();
 
-    TC_LOG_INFO("server.loading", "Loading faction change title pairs...");
-    sObjectMgr->LoadFactionChangeTitles();
+        TC_LOG_INFO("server.loading", "Loading faction change title pairs...");
+        sObjectMgr->LoadFactionChangeTitles();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading GM tickets...");
-    sTicketMgr->LoadTickets();
+    loaders.Add("GM tickets", { "Character cache" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading GM tickets...");
+        sTicketMgr->LoadTickets();
 
-    TC_LOG_INFO("server.loading", "Loading GM surveys...");
-    sTicketMgr->LoadSurveys();
+        TC_LOG_INFO("server.loading", "Loading GM surveys...");
+        sTicketMgr->LoadSurveys();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading client addons...");
-    AddonMgr::LoadFromDB();
+    loaders.Add("Client addons", {}, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading client addons...");
+        AddonMgr::LoadFromDB();
+    });
 
     ///- Handle outdated emails (delete/return)
-    TC_LOG_INFO("server.loading", "Returning old mails...");
-    sObjectMgr->ReturnOrDeleteOldMails(false);
+    loaders.Add("Old mails", { "Faction change pairs" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Returning old mails...");
+        sObjectMgr->ReturnOrDeleteOldMails(false);
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Autobroadcasts...");
-    LoadAutobroadcasts();
+    loaders.Add("Autobroadcasts", {}, [this]()
+    {
+        TC_LOG_INFO("server.loading", "Loading Autobroadcasts...");
+        LoadAutobroadcasts();
+    });
 
     ///- Load and initialize scripts
-    sObjectMgr->LoadSpellScripts();                              // must be after load Creature/Gameobject(Template/Data)
-    sObjectMgr->LoadEventScripts();                              // must be after load Creature/Gameobject(Template/Data)
-    sObjectMgr->LoadWaypointScripts();
+    loaders.Add("Scripts", { "Old mails" }, []()
+    {
+        sObjectMgr->LoadSpellScripts();                              // must be after load Creature/Gameobject(Template/Data)
+        sObjectMgr->LoadEventScripts();                              // must be after load Creature/Gameobject(Template/Data)
+        sObjectMgr->LoadWaypointScripts();
+    });
+
+    loaders.Add("Spell script names", { "Scripts" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading spell script names...");
+        sObjectMgr->LoadSpellScriptNames();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading spell script names...");
-    sObjectMgr->LoadSpellScriptNames();
+    loaders.Add("Creature texts", { "Broadcast texts" }, []()
+    {
+        TC_LOG_INFO("server.loading", "Loading Creature Texts...");
+        sCreatureTextMgr->LoadCreatureTexts();
+
+        TC_LOG_INFO("server.loading", "Loading Creature Text Locales...");
+        sCreatureTextMgr->LoadCreatureTextLocales();
+    });
 
-    TC_LOG_INFO("server.loading", "Loading Creature Texts...");
-    sCreatureTextMgr->LoadCreatureTexts();
+    loaders.Run(getIntConfig(CONFIG_STARTUP_LOADING_THREADS));
+    loaders.LogReport();
 
-    TC_LOG_INFO("server.loading", "Loading Creature Text Locales...");
-    sCreatureTextMgr->LoadCreatureTextLocales();
+    if (worldSnapshot)
+    {
+        // stays attached to the world database, any later change to it removes the file
+        worldSnapshot->Finish(worldSnapshotFile);
+        QueryResultSnapshot::Statistics const statistics = worldSnapshot->GetStatistics();
+        TC_LOG_INFO("server.loading", "World snapshot: {} results read from {}, {} from the database", statistics.Hits, worldSnapshotFile, statistics.Misses);
+    }
 
 #ifdef ELUNA
     if (sElunaConfig->IsElunaEnabled())
@@ -2296,7 +2610,8 @@ void World::SetInitialWorldSettings()
 
     uint32 startupDuration = GetMSTimeDiffToNow(startupBegin);
 
-    TC_LOG_INFO("server.worldserver", "World initialized in {} minutes {} seconds", (startupDuration / 60000), ((startupDuration % 60000) / 1000));
+    TC_LOG_INFO("server.worldserver", "World initialized in {} minutes {} seconds, peak memory {} MB", (startupDuration / 60000), ((startupDuration % 60000) / 1000),
+        GetPeakResidentMemory() / (1024 * 1024));
 
     TC_METRIC_EVENT("events", "World initialized", "World initialized in " + std::to_string(startupDuration / 60000) + " minutes " + std::to_string((startupDuration % 60000) / 1000) + " seconds");
 }
@@ -2594,6 +2909,11 @@ void World::Update(uint32 diff)
         ProcessQueryCallbacks();
     }
 
+    {
+        TC_METRIC_TIMER("world_update_time", TC_METRIC_TAG("type", "Update player save scheduler"));
+        sPlayerSaveScheduler->Update(diff, GetPlayerCount(), CharacterDatabase.QueueSize());
+    }
+
     ///- Erase corpses once every 20 minutes
     if (m_timers[WUPDATE_CORPSES].Passed())
     {
@@ -2653,6 +2973,12 @@ void World::Update(uint32 diff)
         sScriptMgr->OnWorldUpdate(diff);
     }
 
+    {
+        TC_METRIC_TIMER("world_update_time", TC_METRIC_TAG("type", "Flush session packets"));
+        // after the maps, what they sent this update goes out now instead of after the next one
+        FlushSessionPackets();
+    }
+
     {
         TC_METRIC_TIMER("world_update_time", TC_METRIC_TAG("type", "Update metrics"));
         // Stats logger update
@@ -3177,6 +3503,12 @@ void World::UpdateSessions(uint32 diff)
     }
 }
 
+void World::FlushSessionPackets()
+{
+    for (SessionMap::value_type const& session : m_sessions)
+        session.second->FlushPackets();
+}
+
 // This handles the issued and queued CLI commands
 void World::ProcessCliCommands()
 {
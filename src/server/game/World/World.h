@@ -96,6 +96,7 @@ enum WorldBoolConfigs : uint32
     CONFIG_CLEAN_CHARACTER_DB,
     CONFIG_GRID_UNLOAD,
     CONFIG_STATS_SAVE_ONLY_ON_LOGOUT,
+    CONFIG_PLAYER_SAVE_DELTA,
     CONFIG_ALLOW_TWO_SIDE_INTERACTION_CALENDAR,
     CONFIG_ALLOW_TWO_SIDE_INTERACTION_CHANNEL,
     CONFIG_ALLOW_TWO_SIDE_INTERACTION_GROUP,
@@ -169,6 +170,7 @@ enum WorldBoolConfigs : uint32
     CONFIG_RESET_DUEL_HEALTH_MANA,
     CONFIG_BASEMAP_LOAD_GRIDS,
     CONFIG_INSTANCEMAP_LOAD_GRIDS,
+    CONFIG_STARTUP_SNAPSHOT,
     CONFIG_HOTSWAP_ENABLED,
     CONFIG_HOTSWAP_RECOMPILER_ENABLED,
     CONFIG_HOTSWAP_EARLY_TERMINATION_ENABLED,
@@ -181,6 +183,13 @@ enum WorldBoolConfigs : uint32
     CONFIG_RESPAWN_DYNAMIC_ESCORTNPC,
     CONFIG_REGEN_HP_CANNOT_REACH_TARGET_IN_RAID,
     CONFIG_ALLOW_LOGGING_IP_ADDRESSES_IN_DATABASE,
+    CONFIG_MAPUPDATE_PARALLEL_REGIONS,
+    CONFIG_VISIBILITY_INCREMENTAL,
+    CONFIG_VISIBILITY_INCREMENTAL_VERIFY,
+    CONFIG_GRID_PREFETCH,
+    CONFIG_PATHFINDING_ASYNC,
+    CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD,
+    CONFIG_OPCODE_STATISTICS,
     BOOL_CONFIG_VALUE_COUNT
 };
 
@@ -206,6 +215,7 @@ enum WorldFloatConfigs : uint32
     CONFIG_ARENA_MATCHMAKER_RATING_MODIFIER,
     CONFIG_RESPAWN_DYNAMICRATE_CREATURE,
     CONFIG_RESPAWN_DYNAMICRATE_GAMEOBJECT,
+    CONFIG_MAPUPDATE_PARALLEL_REGIONS_GUARD_BAND,
     FLOAT_CONFIG_VALUE_COUNT
 };
 
@@ -335,12 +345,27 @@ enum WorldIntConfigs : uint32
     CONFIG_ENABLE_SINFO_LOGIN,
     CONFIG_PLAYER_ALLOW_COMMANDS,
     CONFIG_NUMTHREADS,
+    CONFIG_MAPUPDATE_PARALLEL_REGIONS_THREADS,
+    CONFIG_STARTUP_LOADING_THREADS,
+    CONFIG_VISIBILITY_INCREMENTAL_FULL_UPDATE_INTERVAL,
+    CONFIG_RELOCATION_BATCH_MIN_CREATURES,
+    CONFIG_GRID_PREFETCH_THREADS,
+    CONFIG_GRID_PREFETCH_LOOKAHEAD_TIME,
+    CONFIG_GRID_PREFETCH_MAX_PENDING,
+    CONFIG_GRID_PREFETCH_CACHE_TIMEOUT,
+    CONFIG_PATHFINDING_ASYNC_THREADS,
+    CONFIG_PATHFINDING_CACHE_SIZE,
+    CONFIG_PATHFINDING_CACHE_TIMEOUT,
+    CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_THREADS,
+    CONFIG_MAPUPDATE_PARALLEL_PACKET_BUILD_MIN_PLAYERS,
     CONFIG_LOGDB_CLEARINTERVAL,
     CONFIG_LOGDB_CLEARTIME,
     CONFIG_CLIENTCACHE_VERSION,
     CONFIG_GUILD_EVENT_LOG_COUNT,
     CONFIG_GUILD_BANK_EVENT_LOG_COUNT,
     CONFIG_MIN_LEVEL_STAT_SAVE,
+    CONFIG_PLAYER_SAVE_MAX_PER_SECOND,
+    CONFIG_PLAYER_SAVE_MAX_QUEUE_SIZE,
     CONFIG_RANDOM_BG_RESET_HOUR,
     CONFIG_CALENDAR_DELETE_OLD_EVENTS_HOUR,
     CONFIG_GUILD_RESET_HOUR,
@@ -674,6 +699,7 @@ class TC_GAME_API World
         void Update(uint32 diff);
 
         void UpdateSessions(uint32 diff);
+        void FlushSessionPackets();
         /// Set a server rate (see #Rates)
         void setRate(Rates rate, float value) { rate_values[rate]=value; }
         /// Get a server rate (see #Rates)
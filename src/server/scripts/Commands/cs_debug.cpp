@@ -39,13 +39,18 @@ EndScriptData */
 #include "MapManager.h"
 #include "ObjectAccessor.h"
 #include "ObjectMgr.h"
+#include "OpcodeStatistics.h"
+#include "PacketLog.h"
 #include "PoolMgr.h"
 #include "QuestPools.h"
 #include "RBAC.h"
+#include "ScopeProfiler.h"
 #include "SpellMgr.h"
 #include "Transport.h"
+#include "Util.h"
 #include "Warden.h"
 #include "World.h"
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <map>
@@ -81,6 +86,20 @@ public:
             { "setphaseshift",      HandleDebugSendSetPhaseShiftCommand,   rbac::RBAC_PERM_COMMAND_DEBUG,   Console::No },
             { "spellfail",          HandleDebugSendSpellFailCommand,       rbac::RBAC_PERM_COMMAND_DEBUG,   Console::No },
         };
+        static ChatCommandTable debugProfileCommandTable =
+        {
+            { "start",              HandleDebugProfileStartCommand,        rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "stop",               HandleDebugProfileStopCommand,         rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "reset",              HandleDebugProfileResetCommand,        rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "dump",               HandleDebugProfileDumpCommand,         rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+        };
+        static ChatCommandTable debugPacketLogCommandTable =
+        {
+            { "status",             HandleDebugPacketLogStatusCommand,     rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "account",            HandleDebugPacketLogAccountCommand,    rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "opcode",             HandleDebugPacketLogOpcodeCommand,     rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "map",                HandleDebugPacketLogMapCommand,        rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+        };
         static ChatCommandTable debugCommandTable =
         {
             { "setbit",             HandleDebugSet32BitCommand,            rbac::RBAC_PERM_COMMAND_DEBUG,   Console::No },
@@ -119,6 +138,9 @@ public:
             { "asan outofbounds",   HandleDebugOutOfBounds,                rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "guidlimits",         HandleDebugGuidLimitsCommand,          rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "objectcount",        HandleDebugObjectCountCommand,         rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "opcodes",            HandleDebugOpcodesCommand,             rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "packetlog",          debugPacketLogCommandTable },
+            { "profile",            debugProfileCommandTable },
             { "questreset",         HandleDebugQuestResetCommand,          rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "warden force",       HandleDebugWardenForce,                rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes }
         };
@@ -1823,6 +1845,184 @@ public:
             handler->PSendSysMessage("Entry: %u Count: %u", p.first, p.second);
     }
 
+    // handlers taking the most time since the last reset, for the world thread and map threads
+    static bool HandleDebugOpcodesCommand(ChatHandler* handler, Optional<EXACT_SEQUENCE("reset")> reset, Optional<uint32> count)
+    {
+        if (reset)
+        {
+            sOpcodeStatistics->Reset();
+            handler->SendSysMessage("Opcode statistics reset.");
+            return true;
+        }
+
+        if (!sWorld->getBoolConfig(CONFIG_OPCODE_STATISTICS))
+            handler->SendSysMessage("Opcode statistics are disabled (Network.OpcodeStatistics), showing what was collected before.");
+
+        std::vector<OpcodeHandlerStatistics> statistics = sOpcodeStatistics->Collect();
+        std::sort(statistics.begin(), statistics.end(), [](OpcodeHandlerStatistics const& left, OpcodeHandlerStatistics const& right)
+        {
+            return left.TotalTime > right.TotalTime;
+        });
+
+        for (uint8 context = 0; context < MAX_OPCODE_STATISTICS_CONTEXT; ++context)
+        {
+            handler->PSendSysMessage("Top handlers in %s:", context == OPCODE_STATISTICS_WORLD ? "World::UpdateSessions" : "Map::Update");
+
+            uint32 shown = 0;
+            for (OpcodeHandlerStatistics const& opcodeStatistics : statistics)
+            {
+                if (opcodeStatistics.Context != context)
+                    continue;
+
+                if (shown++ >= count.value_or(10))
+                    break;
+
+                handler->PSendSysMessage("%s: " UI64FMTD " packets, total %.3f ms, average %.1f us, max %.3f ms", opcodeTable[opcodeStatistics.Opcode]->Name, opcodeStatistics.Count,
+                    std::chrono::duration<double, std::milli>(opcodeStatistics.TotalTime).count(),
+                    std::chrono::duration<double, std::micro>(opcodeStatistics.TotalTime).count() / double(opcodeStatistics.Count),
+                    std::chrono::duration<double, std::milli>(opcodeStatistics.MaxTime).count());
+            }
+
+            if (!shown)
+                handler->SendSysMessage("No packets handled.");
+        }
+
+        return true;
+    }
+
+    static std::string FormatPacketLogFilterSet(std::unordered_set<uint32> const& ids, bool opcodes)
+    {
+        if (ids.empty())
+            return "all";
+
+        std::vector<uint32> sorted(ids.begin(), ids.end());
+        std::sort(sorted.begin(), sorted.end());
+
+        std::string text;
+        for (uint32 id : sorted)
+        {
+            if (!text.empty())
+                text += ' ';
+
+            text += opcodes ? GetOpcodeNameForLogging(Opcodes(id)) : std::to_string(id);
+        }
+
+        return text;
+    }
+
+    static bool HandleDebugPacketLogStatusCommand(ChatHandler* handler)
+    {
+        if (!sPacketLog->CanLogPacket())
+        {
+            handler->SendSysMessage("Packet logging is disabled (PacketLogFile).");
+            return true;
+        }
+
+        PacketLogStatistics statistics = sPacketLog->GetStatistics();
+        handler->PSendSysMessage("Packet log format %s: " UI64FMTD " packets logged, " UI64FMTD " dropped, " UI64FMTD " bytes in " UI64FMTD " blocks written, " SZFMTD " bytes queued.",
+            sPacketLog->GetFormat() == PACKET_LOG_FORMAT_INDEXED ? "indexed" : "PKT 3.1", statistics.LoggedPackets, statistics.DroppedPackets,
+            statistics.WrittenBytes, statistics.WrittenBlocks, statistics.QueuedBytes);
+
+        PacketLogFilter filter = sPacketLog->GetFilter();
+        handler->PSendSysMessage("Accounts: %s", FormatPacketLogFilterSet(filter.Accounts, false).c_str());
+        handler->PSendSysMessage("Opcodes: %s", FormatPacketLogFilterSet(filter.Opcodes, true).c_str());
+        handler->PSendSysMessage("Maps: %s", FormatPacketLogFilterSet(filter.Maps, false).c_str());
+        return true;
+    }
+
+    static bool HandleDebugPacketLogAccountCommand(ChatHandler* handler, Optional<std::vector<uint32>> accountIds)
+    {
+        PacketLogFilter filter = sPacketLog->GetFilter();
+        filter.Accounts.clear();
+        if (accountIds)
+            filter.Accounts.insert(accountIds->begin(), accountIds->end());
+
+        handler->PSendSysMessage("Logging packets of accounts: %s", FormatPacketLogFilterSet(filter.Accounts, false).c_str());
+        sPacketLog->SetFilter(std::move(filter));
+        return true;
+    }
+
+    static bool HandleDebugPacketLogOpcodeCommand(ChatHandler* handler, Optional<std::vector<std::string_view>> opcodes)
+    {
+        PacketLogFilter filter = sPacketLog->GetFilter();
+        filter.Opcodes.clear();
+        if (opcodes)
+        {
+            for (std::string_view text : *opcodes)
+            {
+                Optional<uint32> opcode = PacketLog::ParseOpcode(text);
+                if (!opcode)
+                {
+                    handler->PSendSysMessage("Unknown opcode %.*s.", int(text.size()), text.data());
+                    handler->SetSentErrorMessage(true);
+                    return false;
+                }
+
+                filter.Opcodes.insert(*opcode);
+            }
+        }
+
+        handler->PSendSysMessage("Logging opcodes: %s", FormatPacketLogFilterSet(filter.Opcodes, true).c_str());
+        sPacketLog->SetFilter(std::move(filter));
+        return true;
+    }
+
+    static bool HandleDebugPacketLogMapCommand(ChatHandler* handler, Optional<std::vector<uint32>> mapIds)
+    {
+        PacketLogFilter filter = sPacketLog->GetFilter();
+        filter.Maps.clear();
+        if (mapIds)
+            filter.Maps.insert(mapIds->begin(), mapIds->end());
+
+        handler->PSendSysMessage("Logging packets on maps: %s", FormatPacketLogFilterSet(filter.Maps, false).c_str());
+        sPacketLog->SetFilter(std::move(filter));
+        return true;
+    }
+
+    static bool HandleDebugProfileStartCommand(ChatHandler* handler, Optional<uint32> sampleRate)
+    {
+        ScopeProfiler::Start(sampleRate.value_or(16));
+        handler->PSendSysMessage("Profiling one in %u map and session updates.", ScopeProfiler::GetSampleRate());
+        return true;
+    }
+
+    static bool HandleDebugProfileStopCommand(ChatHandler* handler)
+    {
+        ScopeProfiler::Stop();
+        handler->SendSysMessage("Profiling stopped, what was recorded can still be dumped.");
+        return true;
+    }
+
+    static bool HandleDebugProfileResetCommand(ChatHandler* handler)
+    {
+        ScopeProfiler::Reset();
+        handler->SendSysMessage("Profile reset.");
+        return true;
+    }
+
+    static bool HandleDebugProfileDumpCommand(ChatHandler* handler, Optional<std::string> fileName)
+    {
+        std::string name = fileName ? *fileName : "profile_" + TimeToTimestampStr(GameTime::GetGameTime()) + ".folded";
+        if (name.find_first_of("/\\") != std::string::npos)
+        {
+            handler->SendSysMessage("The profile is always written to the logs directory, file name expected.");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        std::string path = sLog->GetLogsDir() + name;
+        std::size_t stacks = 0;
+        if (!ScopeProfiler::WriteFoldedStacks(path, stacks))
+        {
+            handler->PSendSysMessage("Could not write %s.", path.c_str());
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        handler->PSendSysMessage("Wrote " SZFMTD " stacks to %s.", stacks, path.c_str());
+        return true;
+    }
+
     static bool HandleDebugDummyCommand(ChatHandler* handler)
     {
         handler->SendSysMessage("This command does nothing right now. Edit your local core (cs_debug.cpp) to make it do whatever you need for testing.");
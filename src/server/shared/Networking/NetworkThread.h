@@ -23,8 +23,10 @@
 #include "Errors.h"
 #include "IoContext.h"
 #include "Log.h"
+#include "Socket.h"
 #include "Timer.h"
 #include <boost/asio/ip/tcp.hpp>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -34,12 +36,80 @@
 
 using boost::asio::ip::tcp;
 
+struct NetworkThreadStatistics
+{
+    int32 Connections;
+    SocketStatistics Traffic;                               // sum of all sockets handled by the thread, closed ones included
+    std::chrono::nanoseconds BusyTime;                      // socket updates and read handlers
+    std::chrono::nanoseconds Load;                          // busy time per second, averaged over the last few seconds
+};
+
+// busy time per second of a network thread, written by the network thread and read by any
+class NetworkThreadLoad
+{
+public:
+    // busy time per second assumed for a new socket until the windows include it, used where no socket was measured yet
+    static constexpr std::chrono::nanoseconds MinSocketLoad = 100us;
+
+    NetworkThreadLoad() : _load(0), _sampled(false), _windowBusyTime(0), _socketsAdded(0) { }
+
+    void Start(std::chrono::steady_clock::time_point now)
+    {
+        _windowStart = now;
+        _windowBusyTime = 0ns;
+    }
+
+    // closes the window once it is a second long, the first window is taken as it is and later ones count for a quarter
+    void Add(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds busyTime)
+    {
+        _windowBusyTime += busyTime;
+
+        std::chrono::duration<double> window = now - _windowStart;
+        if (window < 1s)
+            return;
+
+        uint64 load = uint64(double(_windowBusyTime.count()) / window.count());
+        if (_sampled.load(std::memory_order_relaxed))
+            load = (_load.load(std::memory_order_relaxed) * 3 + load) / 4;
+
+        _load.store(load, std::memory_order_relaxed);
+        _sampled.store(true, std::memory_order_relaxed);
+        _socketsAdded.store(0, std::memory_order_relaxed);
+        Start(now);
+    }
+
+    // called by any thread placing a socket on the thread
+    void SocketAdded() { _socketsAdded.fetch_add(1, std::memory_order_relaxed); }
+
+    std::chrono::nanoseconds Get() const { return std::chrono::nanoseconds(_load.load(std::memory_order_relaxed)); }
+
+    // measured load plus the average load of a measured socket for every socket added since the last window closed,
+    // a burst of accepts within one window does not all go to the thread that was idlest before it
+    std::chrono::nanoseconds GetWithAddedSockets(int32 connections) const
+    {
+        std::chrono::nanoseconds load = Get();
+        int32 added = _socketsAdded.load(std::memory_order_relaxed);
+        std::chrono::nanoseconds socketLoad = std::max(load / std::max(connections - added, 1), MinSocketLoad);
+        return load + added * socketLoad;
+    }
+
+    // false until the first window is closed
+    bool HasSamples() const { return _sampled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64> _load;
+    std::atomic<bool> _sampled;
+    std::chrono::steady_clock::time_point _windowStart;
+    std::chrono::nanoseconds _windowBusyTime;
+    std::atomic<int32> _socketsAdded;
+};
+
 template<class SocketType>
 class NetworkThread
 {
 public:
-    NetworkThread() : _connections(0), _stopped(false), _thread(nullptr), _ioContext(1),
-        _acceptSocket(_ioContext), _updateTimer(_ioContext)
+    NetworkThread() : _connections(0), _stopped(false), _thread(nullptr), _traffic(), _busyTime(0),
+        _ioContext(1), _acceptSocket(_ioContext), _updateTimer(_ioContext)
     {
     }
 
@@ -82,11 +152,32 @@ public:
         return _connections;
     }
 
+    std::chrono::nanoseconds GetLoad() const
+    {
+        return _load.Get();
+    }
+
+    bool HasLoadSamples() const
+    {
+        return _load.HasSamples();
+    }
+
+    std::chrono::nanoseconds GetLoadWithAddedSockets() const
+    {
+        return _load.GetWithAddedSockets(_connections);
+    }
+
+    NetworkThreadStatistics GetStatistics() const
+    {
+        return { _connections, _traffic.Get(), std::chrono::nanoseconds(_busyTime.load(std::memory_order_relaxed)), GetLoad() };
+    }
+
     virtual void AddSocket(std::shared_ptr<SocketType> sock)
     {
         std::lock_guard<std::mutex> lock(_newSocketsLock);
 
         ++_connections;
+        _load.SocketAdded();
         _newSockets.push_back(sock);
         SocketAdded(sock);
     }
@@ -122,6 +213,7 @@ protected:
     {
         TC_LOG_DEBUG("misc", "Network Thread Starting");
 
+        StartLoadWindow(std::chrono::steady_clock::now());
         _updateTimer.expires_after(1ms);
         _updateTimer.async_wait([this](boost::system::error_code const&) { Update(); });
         _ioContext.run();
@@ -139,11 +231,16 @@ protected:
         _updateTimer.expires_after(1ms);
         _updateTimer.async_wait([this](boost::system::error_code const&) { Update(); });
 
+        std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+
         AddNewSockets();
 
-        _sockets.erase(std::remove_if(_sockets.begin(), _sockets.end(), [this](std::shared_ptr<SocketType> sock)
+        SocketStatistics traffic = { };
+        _sockets.erase(std::remove_if(_sockets.begin(), _sockets.end(), [this, &traffic](std::shared_ptr<SocketType> sock)
         {
-            if (!sock->Update())
+            bool keep = sock->Update();
+            traffic += sock->TakeUnreportedStatistics();
+            if (!keep)
             {
                 if (sock->IsOpen())
                     sock->CloseSocket();
@@ -156,8 +253,18 @@ protected:
 
             return false;
         }), _sockets.end());
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds busyTime = std::chrono::nanoseconds(traffic.ReadHandlerTime) + (now - updateStart);
+        _traffic.Add(traffic);
+        SocketStatisticsCounters::Add(_busyTime, busyTime.count());
+        UpdateLoad(now, busyTime);
     }
 
+    // load used to place new sockets, busy time per second smoothed over a few seconds
+    void StartLoadWindow(std::chrono::steady_clock::time_point now) { _load.Start(now); }
+    void UpdateLoad(std::chrono::steady_clock::time_point now, std::chrono::nanoseconds busyTime) { _load.Add(now, busyTime); }
+
 private:
     typedef std::vector<std::shared_ptr<SocketType>> SocketContainer;
 
@@ -168,6 +275,10 @@ private:
 
     SocketContainer _sockets;
 
+    SocketStatisticsCounters _traffic;
+    std::atomic<uint64> _busyTime;
+    NetworkThreadLoad _load;
+
     std::mutex _newSocketsLock;
     SocketContainer _newSockets;
 
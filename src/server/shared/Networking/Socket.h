@@ -21,25 +21,88 @@
 #include "MessageBuffer.h"
 #include "Log.h"
 #include <atomic>
-#include <queue>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <functional>
 #include <type_traits>
+#include <vector>
 #include <boost/asio/ip/tcp.hpp>
 
 using boost::asio::ip::tcp;
 
 #define READ_BLOCK_SIZE 4096
+#define WRITE_MAX_BUFFERS 64
 #ifdef BOOST_ASIO_HAS_IOCP
 #define TC_SOCKET_USE_IOCP
 #endif
 
+struct SocketStatistics
+{
+    uint64 BytesReceived;
+    uint64 BytesSent;
+    uint64 PacketsReceived;
+    uint64 PacketsSent;
+    uint64 WriteCalls;                                      // writes issued to the operating system
+    uint64 ReadHandlerTime;                                 // nanoseconds spent handling received data
+
+    SocketStatistics& operator+=(SocketStatistics const& right)
+    {
+        BytesReceived += right.BytesReceived;
+        BytesSent += right.BytesSent;
+        PacketsReceived += right.PacketsReceived;
+        PacketsSent += right.PacketsSent;
+        WriteCalls += right.WriteCalls;
+        ReadHandlerTime += right.ReadHandlerTime;
+        return *this;
+    }
+
+    SocketStatistics operator-(SocketStatistics const& right) const
+    {
+        return { BytesReceived - right.BytesReceived, BytesSent - right.BytesSent, PacketsReceived - right.PacketsReceived,
+            PacketsSent - right.PacketsSent, WriteCalls - right.WriteCalls, ReadHandlerTime - right.ReadHandlerTime };
+    }
+};
+
+// SocketStatistics written by a single thread and read by any
+struct SocketStatisticsCounters
+{
+    static void Add(std::atomic<uint64>& counter, uint64 value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void Add(SocketStatistics const& statistics)
+    {
+        Add(BytesReceived, statistics.BytesReceived);
+        Add(BytesSent, statistics.BytesSent);
+        Add(PacketsReceived, statistics.PacketsReceived);
+        Add(PacketsSent, statistics.PacketsSent);
+        Add(WriteCalls, statistics.WriteCalls);
+        Add(ReadHandlerTime, statistics.ReadHandlerTime);
+    }
+
+    SocketStatistics Get() const
+    {
+        return { BytesReceived.load(std::memory_order_relaxed), BytesSent.load(std::memory_order_relaxed),
+            PacketsReceived.load(std::memory_order_relaxed), PacketsSent.load(std::memory_order_relaxed),
+            WriteCalls.load(std::memory_order_relaxed), ReadHandlerTime.load(std::memory_order_relaxed) };
+    }
+
+    std::atomic<uint64> BytesReceived;
+    std::atomic<uint64> BytesSent;
+    std::atomic<uint64> PacketsReceived;
+    std::atomic<uint64> PacketsSent;
+    std::atomic<uint64> WriteCalls;
+    std::atomic<uint64> ReadHandlerTime;
+};
+
 template<class T>
 class Socket : public std::enable_shared_from_this<T>
 {
 public:
     explicit Socket(tcp::socket&& socket) : _socket(std::move(socket)), _remoteAddress(_socket.remote_endpoint().address()),
-        _remotePort(_socket.remote_endpoint().port()), _readBuffer(), _closed(false), _closing(false), _isWritingAsync(false)
+        _remotePort(_socket.remote_endpoint().port()), _readBuffer(), _statistics(), _reportedStatistics(), _closed(false), _closing(false), _isWritingAsync(false)
     {
         _readBuffer.Resize(READ_BLOCK_SIZE);
     }
@@ -103,7 +166,21 @@ public:
 
     void QueuePacket(MessageBuffer&& buffer)
     {
-        _writeQueue.push(std::move(buffer));
+        std::shared_ptr<MessageBuffer> owner = std::make_shared<MessageBuffer>(std::move(buffer));
+        QueueBuffer(owner, owner->GetReadPointer(), owner->GetActiveSize());
+    }
+
+    /// Queues bytes owned by owner without copying them, they must not change until written.
+    /// Several sockets may queue the same bytes, consecutive bytes of one owner are written as a single buffer
+    void QueueBuffer(std::shared_ptr<void const> owner, uint8 const* data, std::size_t size)
+    {
+        if (!size)
+            return;
+
+        if (!_writeQueue.empty() && _writeQueue.back().Owner == owner && _writeQueue.back().Data + _writeQueue.back().Size == data)
+            _writeQueue.back().Size += size;
+        else
+            _writeQueue.push_back({ std::move(owner), data, size });
 
 #ifdef TC_SOCKET_USE_IOCP
         AsyncProcessQueue();
@@ -112,6 +189,18 @@ public:
 
     bool IsOpen() const { return !_closed && !_closing; }
 
+    /// Traffic of the socket since it was opened, can be read by any thread
+    SocketStatistics GetStatistics() const { return _statistics.Get(); }
+
+    /// Traffic since the previous call, only called by the network thread owning the socket
+    SocketStatistics TakeUnreportedStatistics()
+    {
+        SocketStatistics statistics = GetStatistics();
+        SocketStatistics unreported = statistics - _reportedStatistics;
+        _reportedStatistics = statistics;
+        return unreported;
+    }
+
     void CloseSocket()
     {
         if (_closed.exchange(true))
@@ -146,6 +235,10 @@ public:
 protected:
     virtual void OnClose() { }
 
+    // counters are only written by the thread owning the socket
+    void CountReceivedPacket() { SocketStatisticsCounters::Add(_statistics.PacketsReceived, 1); }
+    void CountSentPackets(uint64 count) { SocketStatisticsCounters::Add(_statistics.PacketsSent, count); }
+
     virtual void ReadHandler() = 0;
 
     bool AsyncProcessQueue()
@@ -156,8 +249,8 @@ protected:
         _isWritingAsync = true;
 
 #ifdef TC_SOCKET_USE_IOCP
-        MessageBuffer& buffer = _writeQueue.front();
-        _socket.async_write_some(boost::asio::buffer(buffer.GetReadPointer(), buffer.GetActiveSize()), std::bind(&Socket<T>::WriteHandler,
+        SocketStatisticsCounters::Add(_statistics.WriteCalls, 1);
+        _socket.async_write_some(GetWriteBuffers(), std::bind(&Socket<T>::WriteHandler,
             this->shared_from_this(), std::placeholders::_1, std::placeholders::_2));
 #else
         _socket.async_write_some(boost::asio::null_buffers(), std::bind(&Socket<T>::WriteHandlerWrapper,
@@ -177,6 +270,42 @@ protected:
     }
 
 private:
+    struct QueuedBuffer
+    {
+        std::shared_ptr<void const> Owner;
+        uint8 const* Data;
+        std::size_t Size;
+    };
+
+    /// front of the write queue as a single scatter-gather write
+    std::vector<boost::asio::const_buffer> const& GetWriteBuffers()
+    {
+        _writeBuffers.clear();
+        for (std::size_t i = 0; i < _writeQueue.size() && i < WRITE_MAX_BUFFERS; ++i)
+            _writeBuffers.emplace_back(_writeQueue[i].Data, _writeQueue[i].Size);
+
+        return _writeBuffers;
+    }
+
+    void WriteCompleted(std::size_t bytes)
+    {
+        SocketStatisticsCounters::Add(_statistics.BytesSent, bytes);
+
+        while (bytes && !_writeQueue.empty())
+        {
+            QueuedBuffer& buffer = _writeQueue.front();
+            if (buffer.Size > bytes)
+            {
+                buffer.Data += bytes;
+                buffer.Size -= bytes;
+                return;
+            }
+
+            bytes -= buffer.Size;
+            _writeQueue.pop_front();
+        }
+    }
+
     void ReadHandlerInternal(boost::system::error_code error, size_t transferredBytes)
     {
         if (error)
@@ -185,8 +314,13 @@ private:
             return;
         }
 
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SocketStatisticsCounters::Add(_statistics.BytesReceived, transferredBytes);
+
         _readBuffer.WriteCompleted(transferredBytes);
         ReadHandler();
+
+        SocketStatisticsCounters::Add(_statistics.ReadHandlerTime, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
     }
 
 #ifdef TC_SOCKET_USE_IOCP
@@ -196,9 +330,7 @@ private:
         if (!error)
         {
             _isWritingAsync = false;
-            _writeQueue.front().ReadCompleted(transferedBytes);
-            if (!_writeQueue.front().GetActiveSize())
-                _writeQueue.pop();
+            WriteCompleted(transferedBytes);
 
             if (!_writeQueue.empty())
                 AsyncProcessQueue();
@@ -222,37 +354,37 @@ private:
         if (_writeQueue.empty())
             return false;
 
-        MessageBuffer& queuedMessage = _writeQueue.front();
-
-        std::size_t bytesToSend = queuedMessage.GetActiveSize();
+        std::vector<boost::asio::const_buffer> const& buffers = GetWriteBuffers();
+        std::size_t bytesToSend = boost::asio::buffer_size(buffers);
 
         boost::system::error_code error;
-        std::size_t bytesSent = _socket.write_some(boost::asio::buffer(queuedMessage.GetReadPointer(), bytesToSend), error);
+        SocketStatisticsCounters::Add(_statistics.WriteCalls, 1);
+        std::size_t bytesSent = _socket.write_some(buffers, error);
 
         if (error)
         {
             if (error == boost::asio::error::would_block || error == boost::asio::error::try_again)
                 return AsyncProcessQueue();
 
-            _writeQueue.pop();
+            _writeQueue.pop_front();
             if (_closing && _writeQueue.empty())
                 CloseSocket();
             return false;
         }
         else if (bytesSent == 0)
         {
-            _writeQueue.pop();
+            _writeQueue.pop_front();
             if (_closing && _writeQueue.empty())
                 CloseSocket();
             return false;
         }
         else if (bytesSent < bytesToSend) // now n > 0
         {
-            queuedMessage.ReadCompleted(bytesSent);
+            WriteCompleted(bytesSent);
             return AsyncProcessQueue();
         }
 
-        _writeQueue.pop();
+        WriteCompleted(bytesSent);
         if (_closing && _writeQueue.empty())
             CloseSocket();
         return !_writeQueue.empty();
@@ -266,7 +398,10 @@ private:
     uint16 _remotePort;
 
     MessageBuffer _readBuffer;
-    std::queue<MessageBuffer> _writeQueue;
+    std::deque<QueuedBuffer> _writeQueue;
+    std::vector<boost::asio::const_buffer> _writeBuffers;
+    SocketStatisticsCounters _statistics;
+    SocketStatistics _reportedStatistics;
 
     std::atomic<bool> _closed;
     std::atomic<bool> _closing;
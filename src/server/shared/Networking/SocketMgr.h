@@ -123,9 +123,35 @@ public:
         return min;
     }
 
+    /// Thread with the least measured load including the sockets placed since it was measured, connection count breaks ties.
+    /// Until every thread has measured its load sockets are placed by connection count
+    uint32 SelectThreadWithMinLoad() const
+    {
+        for (int32 i = 0; i < _threadCount; ++i)
+            if (!_threads[i].HasLoadSamples())
+                return SelectThreadWithMinConnections();
+
+        uint32 min = 0;
+        for (int32 i = 1; i < _threadCount; ++i)
+        {
+            std::chrono::nanoseconds load = _threads[i].GetLoadWithAddedSockets();
+            std::chrono::nanoseconds minLoad = _threads[min].GetLoadWithAddedSockets();
+            if (load < minLoad || (load == minLoad && _threads[i].GetConnectionCount() < _threads[min].GetConnectionCount()))
+                min = i;
+        }
+
+        return min;
+    }
+
+    NetworkThreadStatistics GetNetworkThreadStatistics(int32 threadIndex) const
+    {
+        ASSERT(threadIndex < _threadCount);
+        return _threads[threadIndex].GetStatistics();
+    }
+
     std::pair<tcp::socket*, uint32> GetSocketForAccept()
     {
-        uint32 threadIndex = SelectThreadWithMinConnections();
+        uint32 threadIndex = SelectThreadWithMinLoad();
         return std::make_pair(_threads[threadIndex].GetSocketForAccept(), threadIndex);
     }
 
@@ -20,6 +20,7 @@
 
 #include "Define.h"
 #include "ByteConverter.h"
+#include "PacketPool.h"
 #include <array>
 #include <string>
 #include <vector>
@@ -72,14 +73,12 @@ class TC_SHARED_API ByteBuffer
         constexpr static size_t DEFAULT_SIZE = 0x1000;
 
         // constructor
-        ByteBuffer() : _rpos(0), _wpos(0)
+        ByteBuffer() : _rpos(0), _wpos(0), _storage(PacketPool::AcquireStorage(DEFAULT_SIZE))
         {
-            _storage.reserve(DEFAULT_SIZE);
         }
 
-        ByteBuffer(size_t reserve) : _rpos(0), _wpos(0)
+        ByteBuffer(size_t reserve) : _rpos(0), _wpos(0), _storage(PacketPool::AcquireStorage(reserve))
         {
-            _storage.reserve(reserve);
         }
 
         ByteBuffer(ByteBuffer&& buf) noexcept : _rpos(buf._rpos), _wpos(buf._wpos), _storage(std::move(buf._storage))
@@ -88,7 +87,10 @@ class TC_SHARED_API ByteBuffer
             buf._wpos = 0;
         }
 
-        ByteBuffer(ByteBuffer const& right) = default;
+        ByteBuffer(ByteBuffer const& right) : _rpos(right._rpos), _wpos(right._wpos), _storage(PacketPool::AcquireStorage(right._storage.size()))
+        {
+            _storage.assign(right._storage.begin(), right._storage.end());
+        }
 
         ByteBuffer(MessageBuffer&& buffer);
 
@@ -112,13 +114,17 @@ class TC_SHARED_API ByteBuffer
                 right._rpos = 0;
                 _wpos = right._wpos;
                 right._wpos = 0;
+                PacketPool::ReleaseStorage(_storage);
                 _storage = std::move(right._storage);
             }
 
             return *this;
         }
 
-        virtual ~ByteBuffer() = default;
+        virtual ~ByteBuffer()
+        {
+            PacketPool::ReleaseStorage(_storage);
+        }
 
         void clear()
         {
@@ -0,0 +1,342 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PacketPool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <iterator>
+#include <mutex>
+#include <new>
+
+namespace
+{
+    // bytes every thread may keep of one size class, the depot keeps DepotCacheMultiplier times as much
+    constexpr std::size_t ThreadCacheBytes = 256 * 1024;
+    constexpr std::size_t DepotCacheMultiplier = 4;
+
+    // local counters are published after this many operations
+    constexpr uint32 CounterPublishInterval = 64;
+
+    enum class ThreadCacheState : uint8
+    {
+        Unused,
+        Active,
+        Destroyed
+    };
+
+    // ByteBuffer storage, 64 bytes to 64 KiB
+    struct StorageTraits
+    {
+        using Item = std::vector<uint8>;
+
+        static constexpr std::size_t MinClassShift = 6;
+        static constexpr std::size_t MaxClassShift = 16;
+
+        static std::size_t GetBytes(Item const& item, std::size_t /*classSize*/) { return item.capacity(); }
+        static void Free(Item& item) { Item().swap(item); }
+    };
+
+    // WorldPacket and EncryptablePacket objects, 32 to 256 bytes
+    struct ObjectTraits
+    {
+        using Item = void*;
+
+        static constexpr std::size_t MinClassShift = 5;
+        static constexpr std::size_t MaxClassShift = 8;
+
+        static std::size_t GetBytes(Item /*item*/, std::size_t classSize) { return classSize; }
+        static void Free(Item& item) { ::operator delete(item); item = nullptr; }
+    };
+
+    template<typename Traits>
+    class ThreadCachingPool
+    {
+    public:
+        using Item = typename Traits::Item;
+
+        static constexpr std::size_t ClassCount = Traits::MaxClassShift - Traits::MinClassShift + 1;
+
+        static constexpr std::size_t GetClassSize(std::size_t sizeClass) { return std::size_t(1) << (sizeClass + Traits::MinClassShift); }
+
+        static constexpr std::size_t GetThreadCacheLimit(std::size_t sizeClass)
+        {
+            return std::clamp<std::size_t>(ThreadCacheBytes / GetClassSize(sizeClass), 4, 256);
+        }
+
+        ThreadCachingPool()
+        {
+            for (std::size_t i = 0; i < ClassCount; ++i)
+                _depot[i].reserve(GetThreadCacheLimit(i) * DepotCacheMultiplier);
+        }
+
+        ThreadCachingPool(ThreadCachingPool const&) = delete;
+        ThreadCachingPool& operator=(ThreadCachingPool const&) = delete;
+
+        // false when nothing of the size class is cached
+        bool Acquire(std::size_t sizeClass, Item& item)
+        {
+            ThreadCache* cache = GetThreadCache();
+            if (!cache)
+                return false;
+
+            std::vector<Item>& items = cache->Items[sizeClass];
+            if (items.empty())
+                Refill(sizeClass, items);
+
+            if (items.empty())
+            {
+                ++cache->Misses;
+                cache->CountOperation();
+                return false;
+            }
+
+            item = std::move(items.back());
+            items.pop_back();
+
+            ++cache->Hits;
+            cache->BytesHeld -= int64(Traits::GetBytes(item, GetClassSize(sizeClass)));
+            cache->CountOperation();
+            return true;
+        }
+
+        void Release(std::size_t sizeClass, Item&& item)
+        {
+            ThreadCache* cache = GetThreadCache();
+            if (!cache)
+            {
+                Traits::Free(item);
+                return;
+            }
+
+            std::vector<Item>& items = cache->Items[sizeClass];
+            if (items.size() >= GetThreadCacheLimit(sizeClass))
+                Spill(sizeClass, items, items.size() / 2, cache->BytesHeld);
+
+            cache->BytesHeld += int64(Traits::GetBytes(item, GetClassSize(sizeClass)));
+            items.push_back(std::move(item));
+            cache->CountOperation();
+        }
+
+        PacketPool::Statistics GetStatistics() const
+        {
+            PacketPool::Statistics statistics;
+            statistics.Hits = _hits.load(std::memory_order_relaxed);
+            statistics.Misses = _misses.load(std::memory_order_relaxed);
+            statistics.BytesHeld = uint64(std::max<int64>(_bytesHeld.load(std::memory_order_relaxed), 0));
+            return statistics;
+        }
+
+    private:
+        struct ThreadCache
+        {
+            ThreadCache(ThreadCachingPool& pool, ThreadCache*& current, ThreadCacheState& state) : Pool(pool), Current(current), State(state),
+                Hits(0), Misses(0), BytesHeld(0), Operations(0)
+            {
+                for (std::size_t i = 0; i < ClassCount; ++i)
+                    Items[i].reserve(GetThreadCacheLimit(i));
+
+                Current = this;
+                State = ThreadCacheState::Active;
+            }
+
+            ~ThreadCache()
+            {
+                for (std::size_t i = 0; i < ClassCount; ++i)
+                    Pool.Spill(i, Items[i], Items[i].size(), BytesHeld);
+
+                Publish();
+                Current = nullptr;
+                State = ThreadCacheState::Destroyed;
+            }
+
+            void CountOperation()
+            {
+                if (++Operations >= CounterPublishInterval)
+                    Publish();
+            }
+
+            void Publish()
+            {
+                Pool._hits.fetch_add(Hits, std::memory_order_relaxed);
+                Pool._misses.fetch_add(Misses, std::memory_order_relaxed);
+                Pool._bytesHeld.fetch_add(BytesHeld, std::memory_order_relaxed);
+                Hits = Misses = 0;
+                BytesHeld = 0;
+                Operations = 0;
+            }
+
+            ThreadCachingPool& Pool;
+            ThreadCache*& Current;
+            ThreadCacheState& State;
+            std::array<std::vector<Item>, ClassCount> Items;
+            uint64 Hits;
+            uint64 Misses;
+            int64 BytesHeld;
+            uint32 Operations;
+        };
+
+        ThreadCache* GetThreadCache()
+        {
+            // trivially destructible, still valid while other thread_local objects releasing packets are destroyed after the cache
+            static thread_local ThreadCache* current = nullptr;
+            static thread_local ThreadCacheState state = ThreadCacheState::Unused;
+            if (current)
+                return current;
+
+            if (state == ThreadCacheState::Destroyed)
+                return nullptr;
+
+            static thread_local ThreadCache cache(*this, current, state);
+            return current;
+        }
+
+        // moves half of the thread cache limit from the depot
+        void Refill(std::size_t sizeClass, std::vector<Item>& items)
+        {
+            std::lock_guard<std::mutex> lock(_depotLock);
+            std::vector<Item>& depot = _depot[sizeClass];
+            std::size_t count = std::min(depot.size(), GetThreadCacheLimit(sizeClass) / 2);
+            std::move(depot.end() - count, depot.end(), std::back_inserter(items));
+            depot.resize(depot.size() - count);
+        }
+
+        // moves count items to the depot, items it has no room for are freed
+        void Spill(std::size_t sizeClass, std::vector<Item>& items, std::size_t count, int64& bytesHeld)
+        {
+            if (!count)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(_depotLock);
+                std::vector<Item>& depot = _depot[sizeClass];
+                std::size_t moved = std::min(count, GetThreadCacheLimit(sizeClass) * DepotCacheMultiplier - depot.size());
+                std::move(items.end() - moved, items.end(), std::back_inserter(depot));
+                items.resize(items.size() - moved);
+                count -= moved;
+            }
+
+            for (; count; --count)
+            {
+                bytesHeld -= int64(Traits::GetBytes(items.back(), GetClassSize(sizeClass)));
+                Traits::Free(items.back());
+                items.pop_back();
+            }
+        }
+
+        std::mutex _depotLock;
+        std::array<std::vector<Item>, ClassCount> _depot;
+
+        std::atomic<uint64> _hits{ 0 };
+        std::atomic<uint64> _misses{ 0 };
+        std::atomic<int64> _bytesHeld{ 0 };
+    };
+
+    // never destroyed, packets may still be released while static objects are destroyed
+    ThreadCachingPool<StorageTraits>& GetStoragePool()
+    {
+        static ThreadCachingPool<StorageTraits>* pool = new ThreadCachingPool<StorageTraits>();
+        return *pool;
+    }
+
+    ThreadCachingPool<ObjectTraits>& GetObjectPool()
+    {
+        static ThreadCachingPool<ObjectTraits>* pool = new ThreadCachingPool<ObjectTraits>();
+        return *pool;
+    }
+
+    // smallest size class holding size bytes
+    template<typename Traits>
+    std::size_t GetSizeClassFor(std::size_t size)
+    {
+        if (size <= (std::size_t(1) << Traits::MinClassShift))
+            return 0;
+
+        return std::bit_width(size - 1) - Traits::MinClassShift;
+    }
+}
+
+std::vector<uint8> PacketPool::AcquireStorage(std::size_t size)
+{
+    std::vector<uint8> storage;
+    if (!size)
+        return storage;
+
+    if (size > ThreadCachingPool<StorageTraits>::GetClassSize(ThreadCachingPool<StorageTraits>::ClassCount - 1))
+    {
+        storage.reserve(size);
+        return storage;
+    }
+
+    std::size_t sizeClass = GetSizeClassFor<StorageTraits>(size);
+    if (!GetStoragePool().Acquire(sizeClass, storage))
+        storage.reserve(ThreadCachingPool<StorageTraits>::GetClassSize(sizeClass));
+
+    return storage;
+}
+
+void PacketPool::ReleaseStorage(std::vector<uint8>& storage)
+{
+    // storage is pooled in the largest size class it can hold, too small or too large storage is freed
+    std::size_t capacity = storage.capacity();
+    if (capacity < ThreadCachingPool<StorageTraits>::GetClassSize(0)
+        || capacity >= ThreadCachingPool<StorageTraits>::GetClassSize(ThreadCachingPool<StorageTraits>::ClassCount - 1) * 2)
+        return;
+
+    std::size_t sizeClass = GetSizeClassFor<StorageTraits>(capacity + 1) - 1;
+    storage.clear();
+    GetStoragePool().Release(sizeClass, std::move(storage));
+    storage = std::vector<uint8>();
+}
+
+void* PacketPool::AllocateObject(std::size_t size)
+{
+    if (size > ThreadCachingPool<ObjectTraits>::GetClassSize(ThreadCachingPool<ObjectTraits>::ClassCount - 1))
+        return ::operator new(size);
+
+    std::size_t sizeClass = GetSizeClassFor<ObjectTraits>(size);
+    void* object = nullptr;
+    if (!GetObjectPool().Acquire(sizeClass, object))
+        object = ::operator new(ThreadCachingPool<ObjectTraits>::GetClassSize(sizeClass));
+
+    return object;
+}
+
+void PacketPool::DeallocateObject(void* object, std::size_t size) noexcept
+{
+    if (!object)
+        return;
+
+    if (size > ThreadCachingPool<ObjectTraits>::GetClassSize(ThreadCachingPool<ObjectTraits>::ClassCount - 1))
+    {
+        ::operator delete(object);
+        return;
+    }
+
+    GetObjectPool().Release(GetSizeClassFor<ObjectTraits>(size), std::move(object));
+}
+
+PacketPool::Statistics PacketPool::GetStorageStatistics()
+{
+    return GetStoragePool().GetStatistics();
+}
+
+PacketPool::Statistics PacketPool::GetObjectStatistics()
+{
+    return GetObjectPool().GetStatistics();
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_PACKET_POOL_H
+#define TRINITYCORE_PACKET_POOL_H
+
+#include "Define.h"
+#include <vector>
+
+/*
+ * Size classed free lists for packet storage and packet objects.
+ * Every thread keeps its own cache of each size class, threads releasing more than they acquire
+ * (map threads freeing received packets, network threads freeing sent ones) hand the surplus
+ * to a shared depot that refills the threads allocating them.
+ */
+class TC_SHARED_API PacketPool
+{
+public:
+    struct Statistics
+    {
+        uint64 Hits = 0;
+        uint64 Misses = 0;
+        uint64 BytesHeld = 0;
+    };
+
+    /// Empty storage with capacity of at least size bytes
+    static std::vector<uint8> AcquireStorage(std::size_t size);
+
+    /// Takes the storage for a later AcquireStorage call on any thread, leaves it empty
+    static void ReleaseStorage(std::vector<uint8>& storage);
+
+    /// Memory of packet objects, used by their operator new and operator delete
+    static void* AllocateObject(std::size_t size);
+    static void DeallocateObject(void* object, std::size_t size) noexcept;
+
+    static Statistics GetStorageStatistics();
+    static Statistics GetObjectStatistics();
+};
+
+/// Allocator for std::allocate_shared of packets, places the object together with its control block in PacketPool
+template<typename T>
+class PacketPoolAllocator
+{
+public:
+    using value_type = T;
+
+    PacketPoolAllocator() noexcept = default;
+
+    template<typename U>
+    PacketPoolAllocator(PacketPoolAllocator<U> const&) noexcept { }
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(PacketPool::AllocateObject(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept
+    {
+        PacketPool::DeallocateObject(pointer, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(PacketPoolAllocator<U> const&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(PacketPoolAllocator<U> const&) const noexcept { return false; }
+};
+
+#endif
@@ -34,12 +34,18 @@
 #include "InstanceSaveMgr.h"
 #include "IoContext.h"
 #include "Locales.h"
+#include "MMapFactory.h"
 #include "MapManager.h"
 #include "Metric.h"
 #include "MySQLThreading.h"
 #include "ObjectAccessor.h"
 #include "OpenSSLCrypto.h"
 #include "OutdoorPvP/OutdoorPvPMgr.h"
+#include "PacketLog.h"
+#include "PacketPool.h"
+#include "PathfindingService.h"
+#include "PlayerSaveDelta.h"
+#include "PlayerSaveScheduler.h"
 #include "ProcessPriority.h"
 #include "RASession.h"
 #include "RealmList.h"
@@ -302,6 +308,47 @@ extern int main(int argc, char** argv)
         TC_METRIC_VALUE("db_queue_login", uint64(LoginDatabase.QueueSize()));
         TC_METRIC_VALUE("db_queue_character", uint64(CharacterDatabase.QueueSize()));
         TC_METRIC_VALUE("db_queue_world", uint64(WorldDatabase.QueueSize()));
+        TC_METRIC_VALUE("mmap_navmesh_queries", MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQueryCount());
+        TC_METRIC_VALUE("mmap_navmesh_query_memory", uint64(MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQueryMemory()));
+        TC_METRIC_VALUE("pathfinding_pending_searches", uint64(sPathfindingService->GetPendingSearchCount()));
+        TC_METRIC_VALUE("pathfinding_cache_hits", sPathfindingService->GetCacheHits());
+        TC_METRIC_VALUE("pathfinding_cache_misses", sPathfindingService->GetCacheMisses());
+        TC_METRIC_VALUE("pathfinding_coalesced_requests", sPathfindingService->GetCoalescedRequests());
+        TC_METRIC_VALUE("player_save_statements_written", PlayerSaveStatistics::GetStatementsWritten());
+        TC_METRIC_VALUE("player_save_statements_avoided", PlayerSaveStatistics::GetStatementsAvoided());
+        PlayerSaveStatisticsSnapshot playerSaves = sPlayerSaveScheduler->GetStatistics();
+        TC_METRIC_VALUE("player_save_autosaves", playerSaves.Autosaves);
+        TC_METRIC_VALUE("player_save_priority_saves", playerSaves.PrioritySaves);
+        TC_METRIC_VALUE("player_save_deferred_autosaves", playerSaves.DeferredAutosaves);
+        TC_METRIC_VALUE("player_save_forced_autosaves", playerSaves.ForcedAutosaves);
+        TC_METRIC_VALUE("player_save_rate", playerSaves.SavesPerSecond);
+        TC_METRIC_VALUE("player_save_pending_commits", uint64(playerSaves.PendingCommits));
+        TC_METRIC_VALUE("player_save_latency", playerSaves.AverageLatency);
+        TC_METRIC_VALUE("player_save_max_latency", playerSaves.MaxLatency);
+
+        PacketPool::Statistics packetStorage = PacketPool::GetStorageStatistics();
+        TC_METRIC_VALUE("packet_pool_hits", packetStorage.Hits, TC_METRIC_TAG("pool", "storage"));
+        TC_METRIC_VALUE("packet_pool_misses", packetStorage.Misses, TC_METRIC_TAG("pool", "storage"));
+        TC_METRIC_VALUE("packet_pool_bytes_held", packetStorage.BytesHeld, TC_METRIC_TAG("pool", "storage"));
+        PacketPool::Statistics packetObjects = PacketPool::GetObjectStatistics();
+        TC_METRIC_VALUE("packet_pool_hits", packetObjects.Hits, TC_METRIC_TAG("pool", "object"));
+        TC_METRIC_VALUE("packet_pool_misses", packetObjects.Misses, TC_METRIC_TAG("pool", "object"));
+        TC_METRIC_VALUE("packet_pool_bytes_held", packetObjects.BytesHeld, TC_METRIC_TAG("pool", "object"));
+
+        // network threads are destroyed once the world stopped
+        for (int32 i = 0; !World::IsStopped() && i < sWorldSocketMgr.GetNetworkThreadCount(); ++i)
+        {
+            NetworkThreadStatistics networkThread = sWorldSocketMgr.GetNetworkThreadStatistics(i);
+            std::string thread = std::to_string(i);
+            TC_METRIC_VALUE("network_thread_connections", networkThread.Connections, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_bytes_received", networkThread.Traffic.BytesReceived, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_bytes_sent", networkThread.Traffic.BytesSent, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_packets_received", networkThread.Traffic.PacketsReceived, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_packets_sent", networkThread.Traffic.PacketsSent, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_write_calls", networkThread.Traffic.WriteCalls, TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_busy_time", uint64(std::chrono::duration_cast<std::chrono::microseconds>(networkThread.BusyTime).count()), TC_METRIC_TAG("thread", thread));
+            TC_METRIC_VALUE("network_thread_load", uint64(std::chrono::duration_cast<std::chrono::microseconds>(networkThread.Load).count()), TC_METRIC_TAG("thread", thread));
+        }
     });
 
     TC_METRIC_EVENT("events", "Worldserver started", "");
@@ -376,6 +423,7 @@ extern int main(int argc, char** argv)
         sWorld->UpdateSessions(1);      // real players unload required UpdateSessions call
 
         sWorldSocketMgr.StopNetwork();
+        sPacketLog->Close();
 
         ///- Clean database before leaving
         ClearOnlineAccounts();
@@ -0,0 +1,454 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PacketLogReader.h"
+#include "Opcodes.h"
+#include "PacketLogFormat.h"
+#include "StringFormat.h"
+#include <boost/asio/ip/address.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace
+{
+#pragma pack(push, 1)
+
+    // same layout as written by PacketLog
+    struct LogHeader
+    {
+        char Signature[3];
+        uint16 FormatVersion;
+        uint8 SnifferId;
+        uint32 Build;
+        char Locale[4];
+        uint8 SessionKey[40];
+        uint32 SniffStartUnixtime;
+        uint32 SniffStartTicks;
+        uint32 OptionalDataSize;
+    };
+
+    struct PacketHeader
+    {
+        uint32 Direction;
+        uint32 ConnectionId;
+        uint32 ArrivalTicks;
+        uint32 OptionalDataSize;
+        uint32 Length;
+    };
+
+    struct OptionalData
+    {
+        uint8 SocketIPBytes[16];
+        uint32 SocketPort;
+    };
+
+#pragma pack(pop)
+
+    constexpr uint32 DirectionClientToServer = 0x47534d43;
+    constexpr uint32 DirectionServerToClient = 0x47534d53;
+
+    struct StreamState
+    {
+        std::size_t Index;
+        bool InWorld;
+        bool HasLastTicks;
+        uint32 LastTicks;
+    };
+
+    bool IsHandledByReplayClient(uint32 opcode)
+    {
+        switch (opcode)
+        {
+            case CMSG_AUTH_SESSION:
+            case CMSG_CHAR_ENUM:
+            case CMSG_CHAR_CREATE:
+            case CMSG_CHAR_DELETE:
+            case CMSG_PLAYER_LOGIN:
+            case CMSG_LOGOUT_REQUEST:
+            case CMSG_LOGOUT_CANCEL:
+            case CMSG_PING:
+            case CMSG_KEEP_ALIVE:
+            case CMSG_QUERY_TIME:
+            case CMSG_TIME_SYNC_RESP:
+            case CMSG_WARDEN_DATA:
+            case MSG_MOVE_TELEPORT_ACK:
+            case MSG_MOVE_WORLDPORT_ACK:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::string GetStreamKey(PacketHeader const& header, std::vector<uint8> const& optionalData)
+    {
+        if (optionalData.size() < sizeof(OptionalData))
+            return Trinity::StringFormat("connection {}", header.ConnectionId);
+
+        OptionalData socket;
+        memcpy(&socket, optionalData.data(), sizeof(socket));
+
+        boost::asio::ip::address_v6::bytes_type bytes;
+        memcpy(bytes.data(), socket.SocketIPBytes, bytes.size());
+        if (std::all_of(bytes.begin() + 4, bytes.end(), [](uint8 b) { return b == 0; }))
+            return Trinity::StringFormat("{}.{}.{}.{}:{}", bytes[0], bytes[1], bytes[2], bytes[3], socket.SocketPort);
+
+        return Trinity::StringFormat("[{}]:{}", boost::asio::ip::address_v6(bytes).to_string(), socket.SocketPort);
+    }
+}
+
+std::size_t PacketLogReader::ReadPackedGuid(std::vector<uint8> const& data, uint64& guid)
+{
+    if (data.empty())
+        return 0;
+
+    uint8 mask = data[0];
+    std::size_t size = 1;
+    guid = 0;
+    for (uint8 i = 0; i < 8; ++i)
+    {
+        if (!(mask & (1 << i)))
+            continue;
+
+        if (size >= data.size())
+            return 0;
+
+        guid |= uint64(data[size++]) << (i * 8);
+    }
+
+    return size;
+}
+
+bool PacketLogReader::IsMovementOpcode(uint32 opcode)
+{
+    // opcodes of WorldSession::HandleMovementOpcodes, all start with the packed guid of the mover followed by MovementInfo
+    switch (opcode)
+    {
+        case MSG_MOVE_START_FORWARD:
+        case MSG_MOVE_START_BACKWARD:
+        case MSG_MOVE_STOP:
+        case MSG_MOVE_START_STRAFE_LEFT:
+        case MSG_MOVE_START_STRAFE_RIGHT:
+        case MSG_MOVE_STOP_STRAFE:
+        case MSG_MOVE_JUMP:
+        case MSG_MOVE_START_TURN_LEFT:
+        case MSG_MOVE_START_TURN_RIGHT:
+        case MSG_MOVE_STOP_TURN:
+        case MSG_MOVE_START_PITCH_UP:
+        case MSG_MOVE_START_PITCH_DOWN:
+        case MSG_MOVE_STOP_PITCH:
+        case MSG_MOVE_SET_RUN_MODE:
+        case MSG_MOVE_SET_WALK_MODE:
+        case MSG_MOVE_FALL_LAND:
+        case MSG_MOVE_START_SWIM:
+        case MSG_MOVE_STOP_SWIM:
+        case MSG_MOVE_SET_FACING:
+        case MSG_MOVE_SET_PITCH:
+        case MSG_MOVE_HEARTBEAT:
+        case CMSG_MOVE_FALL_RESET:
+        case CMSG_MOVE_SET_FLY:
+        case MSG_MOVE_START_ASCEND:
+        case MSG_MOVE_STOP_ASCEND:
+        case CMSG_MOVE_CHNG_TRANSPORT:
+        case MSG_MOVE_START_DESCEND:
+            return true;
+        default:
+            return false;
+    }
+}
+
+namespace
+{
+    /// Splits the packets of a log into the streams of the recorded clients
+    class StreamBuilder
+    {
+    public:
+        explicit StreamBuilder(std::vector<ReplayStream>& streams) : _streams(streams) { }
+
+        void AddPacket(std::string const& key, bool fromClient, uint32 ticks, uint32 opcode, std::vector<uint8> data);
+
+    private:
+        std::vector<ReplayStream>& _streams;
+        std::unordered_map<std::string, StreamState> _states;
+    };
+
+    void StreamBuilder::AddPacket(std::string const& key, bool fromClient, uint32 ticks, uint32 opcode, std::vector<uint8> data)
+    {
+        auto [itr, inserted] = _states.try_emplace(key, StreamState{ _streams.size(), true, false, 0 });
+        StreamState& state = itr->second;
+        if (inserted)
+            _streams.emplace_back().Source = key;
+
+        // the address was reused by a new connection or character
+        auto startNewStream = [&]()
+        {
+            if (_streams[state.Index].Packets.empty())
+                return;
+
+            state = { _streams.size(), state.InWorld, false, 0 };
+            _streams.emplace_back().Source = key;
+        };
+
+        ReplayStream* stream = &_streams[state.Index];
+        if (!fromClient)
+        {
+            if (opcode == SMSG_LOGIN_VERIFY_WORLD && data.size() >= 16 && stream->Packets.empty())
+            {
+                stream->HasStartPosition = true;
+                memcpy(&stream->StartX, &data[4], sizeof(float));
+                memcpy(&stream->StartY, &data[8], sizeof(float));
+                memcpy(&stream->StartZ, &data[12], sizeof(float));
+            }
+            else if (opcode == SMSG_LOGOUT_COMPLETE)
+                state.InWorld = false;
+
+            return;
+        }
+
+        if (opcode == CMSG_AUTH_SESSION)
+        {
+            startNewStream();
+            state.InWorld = false;
+            return;
+        }
+
+        if (opcode == CMSG_PLAYER_LOGIN && data.size() >= sizeof(uint64))
+        {
+            uint64 guid;
+            memcpy(&guid, data.data(), sizeof(guid));
+            if (_streams[state.Index].PlayerGuid != guid)
+                startNewStream();
+
+            stream = &_streams[state.Index];
+            stream->PlayerGuid = guid;
+            state.InWorld = true;
+            return;
+        }
+
+        if (!state.InWorld || IsHandledByReplayClient(opcode))
+            return;
+
+        // recording started after the login, the first movement tells the character and where it was
+        if (PacketLogReader::IsMovementOpcode(opcode))
+        {
+            uint64 guid;
+            std::size_t guidSize = PacketLogReader::ReadPackedGuid(data, guid);
+            if (guidSize && !stream->PlayerGuid)
+                stream->PlayerGuid = guid;
+
+            // flags, extra flags, time
+            std::size_t positionOffset = guidSize + 4 + 2 + 4;
+            if (guidSize && !stream->HasStartPosition && data.size() >= positionOffset + 3 * sizeof(float))
+            {
+                stream->HasStartPosition = true;
+                memcpy(&stream->StartX, &data[positionOffset], sizeof(float));
+                memcpy(&stream->StartY, &data[positionOffset + 4], sizeof(float));
+                memcpy(&stream->StartZ, &data[positionOffset + 8], sizeof(float));
+            }
+        }
+
+        uint32 delay = state.HasLastTicks ? ticks - state.LastTicks : 0;
+        state.HasLastTicks = true;
+        state.LastTicks = ticks;
+        stream->Packets.push_back({ opcode, delay, std::move(data) });
+    }
+
+    bool ReadPktFile(FILE* file, std::string const& fileName, StreamBuilder& builder, std::string& error)
+    {
+        LogHeader logHeader;
+        if (fread(&logHeader, sizeof(logHeader), 1, file) != 1 || memcmp(logHeader.Signature, "PKT", 3) != 0 || logHeader.FormatVersion != 0x0301)
+        {
+            error = Trinity::StringFormat("{} is not a PKT 3.1 file", fileName);
+            return false;
+        }
+
+        if (fseek(file, logHeader.OptionalDataSize, SEEK_CUR) != 0)
+        {
+            error = Trinity::StringFormat("{} is truncated", fileName);
+            return false;
+        }
+
+        std::vector<uint8> optionalData;
+        PacketHeader header;
+        while (fread(&header, sizeof(header), 1, file) == 1)
+        {
+            uint32 opcode = 0;
+            optionalData.resize(header.OptionalDataSize);
+            if (header.Length < sizeof(opcode)
+                || (!optionalData.empty() && fread(optionalData.data(), optionalData.size(), 1, file) != 1)
+                || fread(&opcode, sizeof(opcode), 1, file) != 1)
+            {
+                error = Trinity::StringFormat("{} is truncated", fileName);
+                return false;
+            }
+
+            std::vector<uint8> data(header.Length - sizeof(opcode));
+            if (!data.empty() && fread(data.data(), data.size(), 1, file) != 1)
+            {
+                error = Trinity::StringFormat("{} is truncated", fileName);
+                return false;
+            }
+
+            if (header.Direction != DirectionClientToServer && header.Direction != DirectionServerToClient)
+                continue;
+
+            builder.AddPacket(GetStreamKey(header, optionalData), header.Direction == DirectionClientToServer, header.ArrivalTicks, opcode, std::move(data));
+        }
+
+        return true;
+    }
+
+    std::string GetStreamKey(PacketLogFormat::ConnectionData const& connection)
+    {
+        if (!connection.IsV6)
+            return Trinity::StringFormat("{}.{}.{}.{}:{}", connection.Address[0], connection.Address[1], connection.Address[2], connection.Address[3], connection.Port);
+
+        boost::asio::ip::address_v6::bytes_type bytes;
+        memcpy(bytes.data(), connection.Address, bytes.size());
+        return Trinity::StringFormat("[{}]:{}", boost::asio::ip::address_v6(bytes).to_string(), connection.Port);
+    }
+
+    bool ReadIndexedFile(FILE* file, std::string const& fileName, StreamBuilder& builder, std::string& error)
+    {
+        PacketLogFormat::FileHeader fileHeader;
+        if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 || fileHeader.Magic != PacketLogFormat::FileMagic || fileHeader.Version != PacketLogFormat::Version)
+        {
+            error = Trinity::StringFormat("{} is not an indexed packet log of version {}", fileName, PacketLogFormat::Version);
+            return false;
+        }
+
+        std::unordered_map<uint32, std::string> connections;
+        std::vector<uint8> stored;
+        std::vector<uint8> block;
+        PacketLogFormat::BlockHeader header;
+        // blocks are read in order, the index at the end is only needed to seek
+        while (fread(&header, sizeof(header.Magic), 1, file) == 1 && header.Magic == PacketLogFormat::BlockMagic)
+        {
+            if (fread(reinterpret_cast<uint8*>(&header) + sizeof(header.Magic), sizeof(header) - sizeof(header.Magic), 1, file) != 1)
+            {
+                error = Trinity::StringFormat("{} is truncated", fileName);
+                return false;
+            }
+
+            stored.resize(header.StoredSize);
+            if (!stored.empty() && fread(stored.data(), stored.size(), 1, file) != 1)
+            {
+                // the server stopped while writing the block
+                error = Trinity::StringFormat("{} is truncated", fileName);
+                return false;
+            }
+
+            if (header.Compression == PACKET_LOG_COMPRESSION_ZLIB)
+            {
+                block.resize(header.Size);
+                uLongf size = header.Size;
+                if (uncompress(block.data(), &size, stored.data(), stored.size()) != Z_OK || size != header.Size)
+                {
+                    error = Trinity::StringFormat("{} contains a corrupted block", fileName);
+                    return false;
+                }
+            }
+            else
+                block.swap(stored);
+
+            std::size_t offset = 0;
+            PacketLogFormat::RecordHeader record;
+            while (offset + sizeof(record) <= block.size())
+            {
+                memcpy(&record, &block[offset], sizeof(record));
+                offset += sizeof(record);
+                if (offset + record.Size > block.size())
+                {
+                    error = Trinity::StringFormat("{} contains a corrupted block", fileName);
+                    return false;
+                }
+
+                uint8 const* body = &block[offset];
+                offset += record.Size;
+                switch (record.Type)
+                {
+                    case PACKET_LOG_RECORD_CONNECT:
+                    {
+                        PacketLogFormat::ConnectionData connection;
+                        if (record.Size < sizeof(connection))
+                            break;
+
+                        memcpy(&connection, body, sizeof(connection));
+                        connections[record.ConnectionId] = GetStreamKey(connection);
+                        break;
+                    }
+                    case PACKET_LOG_RECORD_CLIENT_PACKET:
+                    case PACKET_LOG_RECORD_SERVER_PACKET:
+                    {
+                        PacketLogFormat::PacketData packet;
+                        if (record.Size < sizeof(packet))
+                            break;
+
+                        memcpy(&packet, body, sizeof(packet));
+                        auto itr = connections.find(record.ConnectionId);
+                        std::string key = itr != connections.end() ? itr->second : Trinity::StringFormat("connection {}", record.ConnectionId);
+                        builder.AddPacket(key, record.Type == PACKET_LOG_RECORD_CLIENT_PACKET, record.Ticks, packet.Opcode,
+                            std::vector<uint8>(body + sizeof(packet), body + record.Size));
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+bool PacketLogReader::Read(std::string const& fileName, std::vector<ReplayStream>& streams, std::string& error)
+{
+    std::unique_ptr<FILE, int(*)(FILE*)> file(fopen(fileName.c_str(), "rb"), &fclose);
+    if (!file)
+    {
+        error = Trinity::StringFormat("Cannot open {}", fileName);
+        return false;
+    }
+
+    uint32 magic = 0;
+    if (fread(&magic, sizeof(magic), 1, file.get()) != 1 || fseek(file.get(), 0, SEEK_SET) != 0)
+    {
+        error = Trinity::StringFormat("{} is empty", fileName);
+        return false;
+    }
+
+    StreamBuilder builder(streams);
+    if (magic == PacketLogFormat::FileMagic)
+    {
+        if (!ReadIndexedFile(file.get(), fileName, builder, error))
+            return false;
+    }
+    else if (!ReadPktFile(file.get(), fileName, builder, error))
+        return false;
+
+    std::erase_if(streams, [](ReplayStream const& stream) { return stream.Packets.empty(); });
+    if (streams.empty())
+    {
+        error = Trinity::StringFormat("{} contains no client packets sent in world", fileName);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_PACKET_LOG_READER_H
+#define TRINITYCORE_PACKET_LOG_READER_H
+
+#include "Define.h"
+#include <string>
+#include <vector>
+
+struct ReplayPacket
+{
+    uint32 Opcode;
+    uint32 Delay;                                           // milliseconds after the previous packet of the stream
+    std::vector<uint8> Data;
+};
+
+/// Client packets one recorded connection sent while its character was in world
+struct ReplayStream
+{
+    std::string Source;                                     // address and port of the recorded client
+    uint64 PlayerGuid = 0;                                  // recorded character, replaced by the one of the replaying client
+    bool HasStartPosition = false;                          // recorded movement is moved by the distance between both start positions
+    float StartX = 0.0f;
+    float StartY = 0.0f;
+    float StartZ = 0.0f;
+    std::vector<ReplayPacket> Packets;
+};
+
+namespace PacketLogReader
+{
+    /// Splits a PKT 3.1 or indexed file written by PacketLog into the streams of the recorded clients,
+    /// packets handled by the replaying clients themselves (authentication, login, pings, acks) are left out
+    bool Read(std::string const& fileName, std::vector<ReplayStream>& streams, std::string& error);
+
+    bool IsMovementOpcode(uint32 opcode);
+
+    /// Returns the number of bytes of the packed guid at the start of data, 0 if it is incomplete
+    std::size_t ReadPackedGuid(std::vector<uint8> const& data, uint64& guid);
+}
+
+#endif
@@ -0,0 +1,352 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* @file PacketReplay.cpp
+* @brief Load generator replaying client packets recorded by PacketLog
+*
+* Every synthetic client logs in with its own account and character and then
+* sends the packets of one recorded client stream in a loop. Round trip latency
+* of the session update, world update time and memory of the worldserver are
+* reported while the clients run and summarized at the end.
+*/
+
+#include "Config.h"
+#include "CryptoRandom.h"
+#include "DatabaseEnv.h"
+#include "DatabaseLoader.h"
+#include "Errors.h"
+#include "IoContext.h"
+#include "MySQLThreading.h"
+#include "OpenSSLCrypto.h"
+#include "PacketLogReader.h"
+#include "ReplayClient.h"
+#include "ReplayStatistics.h"
+#include "Resolver.h"
+#include "SRP6.h"
+#include "Util.h"
+#include <boost/asio/signal_set.hpp>
+#include <boost/dll/runtime_symbol_info.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options.hpp>
+#include <cctype>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace boost::program_options;
+namespace fs = boost::filesystem;
+
+#ifndef _TRINITY_CORE_CONFIG
+    #define _TRINITY_CORE_CONFIG  "worldserver.conf"
+#endif
+
+namespace
+{
+    struct ReplayOptions
+    {
+        fs::path ConfigFile;
+        std::string PacketLogFile;
+        std::string Host;
+        uint16 Port = 0;
+        uint32 Clients = 0;
+        uint32 Threads = 0;
+        uint32 Duration = 0;
+        uint32 ConnectInterval = 0;
+        uint32 ReportInterval = 0;
+        float Speed = 1.0f;
+        std::string AccountPrefix;
+        uint32 ServerProcessId = 0;
+        uint32 MaxLatency = 0;
+        uint32 MaxUpdateTime = 0;
+    };
+
+    constexpr uint32 MaxAccountNameLength = 16;
+
+    // consonant and vowel pairs, names must not repeat a letter three times
+    std::string GetCharacterName(uint32 index)
+    {
+        constexpr std::string_view Consonants = "bcdfghklmnprst";
+        constexpr std::string_view Vowels = "aeiou";
+
+        std::string name = "Replay";
+        for (uint8 i = 0; i < 3; ++i)
+        {
+            uint32 syllable = index % (Consonants.size() * Vowels.size());
+            index /= Consonants.size() * Vowels.size();
+            name += Consonants[syllable / Vowels.size()];
+            name += Vowels[syllable % Vowels.size()];
+        }
+
+        return name;
+    }
+
+    /// Creates the missing accounts and stores a new session key for each of them, as the authserver would at logon
+    void PrepareAccounts(ReplayOptions const& options, uint32 realmId, std::vector<ReplayClientSettings>& clients)
+    {
+        for (uint32 i = 0; i < options.Clients; ++i)
+        {
+            ReplayClientSettings& client = clients.emplace_back();
+            client.Account = options.AccountPrefix + std::to_string(i + 1);
+            client.Key = Trinity::Crypto::GetRandomBytes<SESSION_KEY_LENGTH>();
+            client.CharacterName = GetCharacterName(i);
+            client.RealmId = realmId;
+            client.Speed = options.Speed;
+            client.ReportsUpdateTime = i == 0;
+            client.UpdateTimeInterval = Seconds(options.ReportInterval);
+
+            LoginDatabasePreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_ACCOUNT_ID_BY_NAME);
+            stmt->setString(0, client.Account);
+            if (!LoginDatabase.Query(stmt))
+            {
+                stmt = LoginDatabase.GetPreparedStatement(LOGIN_INS_ACCOUNT);
+                stmt->setString(0, client.Account);
+                auto [salt, verifier] = Trinity::Crypto::SRP6::MakeRegistrationData(client.Account, client.Account);
+                stmt->setBinary(1, salt);
+                stmt->setBinary(2, verifier);
+                stmt->setString(3, "");
+                stmt->setString(4, "");
+                LoginDatabase.DirectExecute(stmt);
+            }
+
+            LoginDatabase.DirectPExecute("UPDATE account SET session_key_auth = 0x{}, os = 'Win', failed_logins = 0 WHERE username = '{}'",
+                ByteArrayToHexStr(client.Key), client.Account);
+        }
+    }
+
+    /// Resident memory of a process in kilobytes, 0 when it cannot be read
+    uint64 GetResidentMemory(uint32 processId)
+    {
+#if TRINITY_PLATFORM == TRINITY_PLATFORM_UNIX
+        std::ifstream status("/proc/" + std::to_string(processId) + "/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.starts_with("VmRSS:"))
+                return std::strtoull(line.c_str() + 6, nullptr, 10);
+#else
+        (void)processId;
+#endif
+        return 0;
+    }
+
+    void PrintLatency(char const* label, LatencySummary const& latency)
+    {
+        printf("%s%u samples, avg %u ms, median %u ms, p95 %u ms, max %u ms\n", label, uint32(latency.Samples), uint32(latency.Average.count()),
+            uint32(latency.Median.count()), uint32(latency.Percentile95.count()), uint32(latency.Max.count()));
+    }
+
+    bool ParseOptions(int argc, char** argv, ReplayOptions& options)
+    {
+        options_description all("Allowed options");
+        all.add_options()
+            ("help,h", "print usage message")
+            ("config,c", value<fs::path>(&options.ConfigFile)->default_value(fs::absolute(_TRINITY_CORE_CONFIG)),
+                "worldserver configuration file, used for LoginDatabaseInfo, WorldServerPort and RealmID")
+            ("log,l", value<std::string>(&options.PacketLogFile), "packet log written by the worldserver (PacketLogFile)")
+            ("host", value<std::string>(&options.Host)->default_value("127.0.0.1"), "address of the worldserver")
+            ("port,p", value<uint16>(&options.Port)->default_value(0), "port of the worldserver, WorldServerPort of the configuration by default")
+            ("clients,n", value<uint32>(&options.Clients)->default_value(10), "number of synthetic clients, recorded streams are shared when there are more clients")
+            ("threads,t", value<uint32>(&options.Threads)->default_value(1), "number of network threads of the clients")
+            ("duration,d", value<uint32>(&options.Duration)->default_value(60), "seconds to run after the first client connected")
+            ("connect-interval", value<uint32>(&options.ConnectInterval)->default_value(100), "milliseconds between two client connections")
+            ("report-interval", value<uint32>(&options.ReportInterval)->default_value(10), "seconds between two reports")
+            ("speed", value<float>(&options.Speed)->default_value(1.0f), "multiplies the pace of the recorded packets")
+            ("account-prefix", value<std::string>(&options.AccountPrefix)->default_value("REPLAY"), "accounts are named <prefix><client number>, created when missing")
+            ("server-pid", value<uint32>(&options.ServerProcessId)->default_value(0), "reports the resident memory of this worldserver process")
+            ("max-latency", value<uint32>(&options.MaxLatency)->default_value(0), "fails when the 95th percentile of the latency exceeds this many milliseconds")
+            ("max-update-time", value<uint32>(&options.MaxUpdateTime)->default_value(0), "fails when the average world update time exceeds this many milliseconds")
+            ;
+
+        positional_options_description positional;
+        positional.add("log", 1);
+
+        variables_map variablesMap;
+        try
+        {
+            store(command_line_parser(argc, argv).options(all).positional(positional).run(), variablesMap);
+            notify(variablesMap);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << e.what() << "\n";
+            return false;
+        }
+
+        if (variablesMap.count("help") || options.PacketLogFile.empty())
+        {
+            std::cout << "Usage: packetreplay [options] <packet log>\n" << all << "\n";
+            return false;
+        }
+
+        Utf8ToUpperOnlyLatin(options.AccountPrefix);
+        if (options.AccountPrefix.empty() || !std::all_of(options.AccountPrefix.begin(), options.AccountPrefix.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; })
+            || options.AccountPrefix.size() + std::to_string(options.Clients).size() > MaxAccountNameLength)
+        {
+            std::cerr << "Account prefix must be made of latin letters and digits, at most " << MaxAccountNameLength << " characters with the client number\n";
+            return false;
+        }
+
+        if (!options.Clients || !options.Threads || !options.ReportInterval || options.Speed <= 0.0f)
+        {
+            std::cerr << "Clients, threads, report interval and speed must be positive\n";
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    signal(SIGABRT, &Trinity::AbortHandler);
+
+    ReplayOptions options;
+    if (!ParseOptions(argc, argv, options))
+        return 1;
+
+    std::string configError;
+    if (!sConfigMgr->LoadInitial(options.ConfigFile.generic_string(), std::vector<std::string>(argv, argv + argc), configError))
+    {
+        printf("Error in config file: %s\n", configError.c_str());
+        return 1;
+    }
+
+    std::vector<ReplayStream> streams;
+    std::string error;
+    if (!PacketLogReader::Read(options.PacketLogFile, streams, error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+
+    for (ReplayStream const& stream : streams)
+        printf("Stream of %s: %u packets\n", stream.Source.c_str(), uint32(stream.Packets.size()));
+
+    if (!options.Port)
+        options.Port = uint16(sConfigMgr->GetIntDefault("WorldServerPort", 8085));
+
+    OpenSSLCrypto::threadsSetup(boost::dll::program_location().remove_filename());
+    std::shared_ptr<void> opensslHandle(nullptr, [](void*) { OpenSSLCrypto::threadsCleanup(); });
+
+    std::vector<ReplayClientSettings> clientSettings;
+    {
+        MySQL::Library_Init();
+        DatabaseLoader loader("tool.packetreplay", DatabaseLoader::DATABASE_NONE);
+        loader.AddDatabase(LoginDatabase, "Login");
+        if (!loader.Load())
+        {
+            printf("Cannot connect to the login database of %s\n", options.ConfigFile.generic_string().c_str());
+            return 1;
+        }
+
+        PrepareAccounts(options, uint32(sConfigMgr->GetIntDefault("RealmID", 0)), clientSettings);
+        LoginDatabase.Close();
+        MySQL::Library_End();
+    }
+
+    Trinity::Asio::IoContext ioContext;
+    Trinity::Asio::Resolver resolver(ioContext);
+    Optional<boost::asio::ip::tcp::endpoint> endpoint = resolver.Resolve(boost::asio::ip::tcp::v4(), options.Host, std::to_string(options.Port));
+    if (!endpoint)
+    {
+        printf("Cannot resolve %s\n", options.Host.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stopRequested(false);
+    boost::asio::signal_set signals(ioContext, SIGINT, SIGTERM);
+    signals.async_wait([&stopRequested](boost::system::error_code const& error, int /*signalNumber*/)
+    {
+        if (!error)
+            stopRequested = true;
+    });
+
+    // keeps the threads running while no client has work
+    auto work = boost::asio::make_work_guard(ioContext.get_executor());
+    std::vector<std::thread> threads;
+    for (uint32 i = 0; i < options.Threads; ++i)
+        threads.emplace_back([&ioContext]() { ioContext.run(); });
+
+    printf("Replaying %u streams with %u clients against %s:%u for %u seconds\n", uint32(streams.size()), options.Clients, options.Host.c_str(),
+        uint32(options.Port), options.Duration);
+
+    ReplayStatistics statistics;
+    std::vector<std::shared_ptr<ReplayClient>> clients;
+    TimePoint startTime = std::chrono::steady_clock::now();
+    TimePoint endTime = startTime + Seconds(options.Duration);
+    TimePoint nextReport = startTime + Seconds(options.ReportInterval);
+    uint64 peakMemory = 0;
+    while (!stopRequested && std::chrono::steady_clock::now() < endTime)
+    {
+        TimePoint now = std::chrono::steady_clock::now();
+        while (clients.size() < clientSettings.size() && now >= startTime + Milliseconds(options.ConnectInterval) * clients.size())
+        {
+            std::size_t index = clients.size();
+            clients.push_back(std::make_shared<ReplayClient>(ioContext, clientSettings[index], streams[index % streams.size()], statistics));
+            clients.back()->Start(*endpoint);
+        }
+
+        if (now >= nextReport)
+        {
+            nextReport += Seconds(options.ReportInterval);
+
+            ReplayStatistics::Interval interval = statistics.TakeInterval();
+            uint64 memory = options.ServerProcessId ? GetResidentMemory(options.ServerProcessId) : 0;
+            peakMemory = std::max(peakMemory, memory);
+
+            printf("[%4us] clients: %u connected, %u in world, %u failed | packets/s: %u sent, %u received, %u KB/s | update time: %u ms avg, %u ms max | memory: %u MB\n",
+                uint32(std::chrono::duration_cast<Seconds>(now - startTime).count()), interval.Connected, interval.InWorld, interval.Failed,
+                uint32(interval.PacketsSent / options.ReportInterval), uint32(interval.PacketsReceived / options.ReportInterval),
+                uint32(interval.BytesReceived / 1024 / options.ReportInterval), interval.UpdateTime.Average, interval.UpdateTime.Max, uint32(memory / 1024));
+            PrintLatency("       latency: ", interval.Latency);
+        }
+
+        std::this_thread::sleep_for(10ms);
+    }
+
+    for (std::shared_ptr<ReplayClient> const& client : clients)
+        client->Stop();
+
+    signals.cancel();
+    work.reset();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    LatencySummary latency = statistics.GetTotalLatency();
+    UpdateTimeSummary updateTime = statistics.GetTotalUpdateTime();
+    printf("Summary: %u of %u clients failed\n", statistics.Failed.load(), uint32(clients.size()));
+    PrintLatency("  latency: ", latency);
+    printf("  update time: %u samples, avg %u ms, max %u ms\n", uint32(updateTime.Samples), updateTime.Average, updateTime.Max);
+    if (options.ServerProcessId)
+        printf("  peak memory: %u MB\n", uint32(peakMemory / 1024));
+
+    bool failed = statistics.Failed.load() == clients.size();
+    if (options.MaxLatency && latency.Percentile95 > Milliseconds(options.MaxLatency))
+    {
+        printf("Latency p95 %u ms exceeds %u ms\n", uint32(latency.Percentile95.count()), options.MaxLatency);
+        failed = true;
+    }
+
+    if (options.MaxUpdateTime && updateTime.Average > options.MaxUpdateTime)
+    {
+        printf("Average update time %u ms exceeds %u ms\n", updateTime.Average, options.MaxUpdateTime);
+        failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,576 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayClient.h"
+#include "CryptoHash.h"
+#include "CryptoRandom.h"
+#include "HMAC.h"
+#include "PacketLogReader.h"
+#include "Random.h"
+#include "ReplayStatistics.h"
+#include "SharedDefines.h"
+#include "StringFormat.h"
+#include <boost/asio/write.hpp>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace
+{
+    constexpr uint32 ClientBuild = 12340;
+
+    // the first character of an account that has none
+    constexpr uint8 CreatedCharacterRace = RACE_HUMAN;
+    constexpr uint8 CreatedCharacterClass = CLASS_WARRIOR;
+
+    constexpr std::string_view UpdateTimeMessage = "Update time diff: ";
+}
+
+ReplayClient::ReplayClient(Trinity::Asio::IoContext& ioContext, ReplayClientSettings settings, ReplayStream const& stream, ReplayStatistics& statistics)
+    : _settings(std::move(settings)), _stream(stream), _statistics(statistics), _strand(ioContext), _socket(ioContext), _replayTimer(ioContext),
+    _probeTimer(ioContext), _startTime(std::chrono::steady_clock::now()), _state(ClientState::Connecting), _stopping(false), _cryptInitialized(false),
+    _header(), _headerSize(0), _payloadSize(0), _writing(false), _playerGuid(0), _language(LANG_COMMON), _offsetX(0.0f), _offsetY(0.0f),
+    _offsetZ(0.0f), _nextPacket(0)
+{
+}
+
+void ReplayClient::Start(boost::asio::ip::tcp::endpoint const& endpoint)
+{
+    _socket.async_connect(endpoint, Trinity::Asio::bind_executor(_strand, [self = shared_from_this()](boost::system::error_code const& error)
+    {
+        if (error)
+        {
+            self->Close(Trinity::StringFormat("cannot connect: {}", error.message()));
+            return;
+        }
+
+        ++self->_statistics.Connected;
+        self->_state = ClientState::Authenticating;
+        self->AsyncRead();
+    }));
+}
+
+void ReplayClient::Stop()
+{
+    boost::asio::post(_strand, [self = shared_from_this()]()
+    {
+        self->_stopping = true;
+        self->Close("");
+    });
+}
+
+void ReplayClient::AsyncRead()
+{
+    _readBuffer.Normalize();
+    _readBuffer.EnsureFreeSpace();
+    _socket.async_read_some(boost::asio::buffer(_readBuffer.GetWritePointer(), _readBuffer.GetRemainingSpace()),
+        Trinity::Asio::bind_executor(_strand, [self = shared_from_this()](boost::system::error_code const& error, std::size_t transferredBytes)
+    {
+        self->ReadHandler(error, transferredBytes);
+    }));
+}
+
+void ReplayClient::ReadHandler(boost::system::error_code const& error, std::size_t transferredBytes)
+{
+    if (_state == ClientState::Closed)
+        return;
+
+    if (error)
+    {
+        Close(Trinity::StringFormat("disconnected: {}", error.message()));
+        return;
+    }
+
+    _readBuffer.WriteCompleted(transferredBytes);
+    _statistics.BytesReceived += transferredBytes;
+    if (!ReadPackets())
+        return;
+
+    AsyncRead();
+}
+
+bool ReplayClient::ReadPackets()
+{
+    while (_readBuffer.GetActiveSize() > 0)
+    {
+        if (!_packet)
+        {
+            // size is 2 bytes big endian, 3 when the highest bit of the first byte is set, then 2 bytes opcode
+            while (_readBuffer.GetActiveSize() > 0 && (_headerSize < 4 || (_headerSize < 5 && (_header[0] & 0x80))))
+            {
+                uint8& headerByte = _header[_headerSize++];
+                headerByte = *_readBuffer.GetReadPointer();
+                _readBuffer.ReadCompleted(1);
+                if (_cryptInitialized)
+                    _decrypt.UpdateData(&headerByte, 1);
+            }
+
+            bool largePacket = (_header[0] & 0x80) != 0;
+            if (_headerSize < (largePacket ? 5 : 4))
+                break;
+
+            uint32 size = largePacket ? (uint32(_header[0] & 0x7F) << 16) | (uint32(_header[1]) << 8) | _header[2] : (uint32(_header[0]) << 8) | _header[1];
+            uint8 const* opcode = &_header[_headerSize - 2];
+            if (size < 2)
+            {
+                Close(Trinity::StringFormat("received malformed packet header (size: {})", size));
+                return false;
+            }
+
+            _payloadSize = size - 2;
+            _packet.emplace(uint16(opcode[0] | (opcode[1] << 8)), _payloadSize);
+            _headerSize = 0;
+        }
+
+        std::size_t readSize = std::min(_readBuffer.GetActiveSize(), _payloadSize - _packet->size());
+        if (readSize)
+        {
+            _packet->append(_readBuffer.GetReadPointer(), readSize);
+            _readBuffer.ReadCompleted(readSize);
+        }
+
+        if (_packet->size() < _payloadSize)
+            break;
+
+        WorldPacket packet(std::move(*_packet));
+        _packet.reset();
+        ++_statistics.PacketsReceived;
+
+        try
+        {
+            HandlePacket(packet);
+        }
+        catch (ByteBufferException const&)
+        {
+            Close(Trinity::StringFormat("received malformed packet {}", packet.GetOpcode()));
+        }
+
+        if (_state == ClientState::Closed)
+            return false;
+    }
+
+    return true;
+}
+
+void ReplayClient::SendPacket(WorldPacket const& packet)
+{
+    if (_state == ClientState::Closed)
+        return;
+
+    // size is big endian and counts the opcode
+    uint8 header[6];
+    uint16 size = uint16(packet.size() + 4);
+    uint32 opcode = packet.GetOpcode();
+    header[0] = uint8(size >> 8);
+    header[1] = uint8(size);
+    for (uint8 i = 0; i < 4; ++i)
+        header[2 + i] = uint8(opcode >> (i * 8));
+
+    if (_cryptInitialized)
+        _encrypt.UpdateData(header, sizeof(header));
+
+    _pendingWrite.insert(_pendingWrite.end(), std::begin(header), std::end(header));
+    if (!packet.empty())
+        _pendingWrite.insert(_pendingWrite.end(), packet.contents(), packet.contents() + packet.size());
+
+    ++_statistics.PacketsSent;
+    if (!_writing)
+        AsyncWrite();
+}
+
+void ReplayClient::AsyncWrite()
+{
+    _writing = true;
+    _writeBuffer.swap(_pendingWrite);
+    _pendingWrite.clear();
+
+    boost::asio::async_write(_socket, boost::asio::buffer(_writeBuffer),
+        Trinity::Asio::bind_executor(_strand, [self = shared_from_this()](boost::system::error_code const& error, std::size_t /*transferredBytes*/)
+    {
+        self->_writing = false;
+        if (self->_state == ClientState::Closed)
+            return;
+
+        if (error)
+        {
+            self->Close(Trinity::StringFormat("cannot send: {}", error.message()));
+            return;
+        }
+
+        if (!self->_pendingWrite.empty())
+            self->AsyncWrite();
+    }));
+}
+
+void ReplayClient::Close(std::string const& reason)
+{
+    if (_state == ClientState::Closed)
+        return;
+
+    if (!_stopping)
+    {
+        printf("%s: %s\n", _settings.Account.c_str(), reason.c_str());
+        if (_state != ClientState::InWorld)
+            ++_statistics.Failed;
+    }
+
+    if (_state == ClientState::InWorld)
+        --_statistics.InWorld;
+
+    if (_state != ClientState::Connecting)
+        --_statistics.Connected;
+
+    _state = ClientState::Closed;
+    _replayTimer.cancel();
+    _probeTimer.cancel();
+
+    boost::system::error_code error;
+    _socket.shutdown(boost::asio::socket_base::shutdown_both, error);
+    _socket.close(error);
+}
+
+void ReplayClient::HandlePacket(WorldPacket& packet)
+{
+    switch (packet.GetOpcode())
+    {
+        case SMSG_AUTH_CHALLENGE:
+            HandleAuthChallenge(packet);
+            break;
+        case SMSG_AUTH_RESPONSE:
+            HandleAuthResponse(packet);
+            break;
+        case SMSG_CHAR_ENUM:
+            HandleCharEnum(packet);
+            break;
+        case SMSG_CHAR_CREATE:
+            HandleCharCreate(packet);
+            break;
+        case SMSG_LOGIN_VERIFY_WORLD:
+            HandleLoginVerifyWorld(packet);
+            break;
+        case SMSG_NEW_WORLD:
+            HandleNewWorld(packet);
+            break;
+        case MSG_MOVE_TELEPORT_ACK:
+            HandleMoveTeleport(packet);
+            break;
+        case SMSG_TIME_SYNC_REQ:
+            HandleTimeSyncRequest(packet);
+            break;
+        case SMSG_QUERY_TIME_RESPONSE:
+            HandleQueryTimeResponse(packet);
+            break;
+        case SMSG_MESSAGECHAT:
+            HandleMessageChat(packet);
+            break;
+        case SMSG_LOGOUT_COMPLETE:
+            Close("logged out by the server");
+            break;
+        default:
+            break;
+    }
+}
+
+void ReplayClient::HandleAuthChallenge(WorldPacket& packet)
+{
+    std::array<uint8, 4> serverSeed;
+    packet.read_skip<uint32>();
+    packet.read(serverSeed);
+
+    std::array<uint8, 4> localChallenge = Trinity::Crypto::GetRandomBytes<4>();
+    uint8 const zero[4] = { };
+
+    // same digest as checked by WorldSocket::HandleAuthSessionCallback
+    Trinity::Crypto::SHA1 sha;
+    sha.UpdateData(_settings.Account);
+    sha.UpdateData(zero, sizeof(zero));
+    sha.UpdateData(localChallenge);
+    sha.UpdateData(serverSeed);
+    sha.UpdateData(_settings.Key);
+    sha.Finalize();
+
+    WorldPacket authSession(CMSG_AUTH_SESSION, 4 + 4 + _settings.Account.size() + 1 + 4 + 4 + 4 + 4 + 4 + 8 + 20 + 4);
+    authSession << uint32(ClientBuild);
+    authSession << uint32(0);                               // LoginServerID
+    authSession << _settings.Account;
+    authSession << uint32(0);                               // LoginServerType
+    authSession.append(localChallenge);
+    authSession << uint32(0);                               // RegionID
+    authSession << uint32(0);                               // BattlegroupID
+    authSession << uint32(_settings.RealmId);
+    authSession << uint64(0);                               // DosResponse
+    authSession.append(sha.GetDigest());
+    authSession << uint32(0);                               // no addons
+    SendPacket(authSession);
+
+    // everything after the auth session is encrypted, the client uses the keys of the server the other way round
+    uint8 const encryptionKey[] = { 0xC2, 0xB3, 0x72, 0x3C, 0xC6, 0xAE, 0xD9, 0xB5, 0x34, 0x3C, 0x53, 0xEE, 0x2F, 0x43, 0x67, 0xCE };
+    uint8 const decryptionKey[] = { 0xCC, 0x98, 0xAE, 0x04, 0xE8, 0x97, 0xEA, 0xCA, 0x12, 0xDD, 0xC0, 0x93, 0x42, 0x91, 0x53, 0x57 };
+    _encrypt.Init(Trinity::Crypto::HMAC_SHA1::GetDigestOf(encryptionKey, _settings.Key));
+    _decrypt.Init(Trinity::Crypto::HMAC_SHA1::GetDigestOf(decryptionKey, _settings.Key));
+
+    std::array<uint8, 1024> syncBuf;
+    _encrypt.UpdateData(syncBuf);
+    _decrypt.UpdateData(syncBuf);
+    _cryptInitialized = true;
+}
+
+void ReplayClient::HandleAuthResponse(WorldPacket& packet)
+{
+    uint8 result = packet.read<uint8>();
+    if (result == AUTH_WAIT_QUEUE)
+        return;
+
+    if (result != AUTH_OK)
+    {
+        Close(Trinity::StringFormat("authentication failed (result {})", result));
+        return;
+    }
+
+    _state = ClientState::CharacterList;
+    SendPacket(WorldPacket(CMSG_CHAR_ENUM, 0));
+}
+
+void ReplayClient::HandleCharEnum(WorldPacket& packet)
+{
+    uint8 count = packet.read<uint8>();
+    if (!count)
+    {
+        if (_state == ClientState::CreatingCharacter)
+        {
+            Close("created character is not listed");
+            return;
+        }
+
+        _state = ClientState::CreatingCharacter;
+        WorldPacket charCreate(CMSG_CHAR_CREATE, _settings.CharacterName.size() + 1 + 9);
+        charCreate << _settings.CharacterName;
+        charCreate << uint8(CreatedCharacterRace);
+        charCreate << uint8(CreatedCharacterClass);
+        charCreate << uint8(GENDER_MALE);
+        charCreate << uint8(0);                             // skin
+        charCreate << uint8(0);                             // face
+        charCreate << uint8(0);                             // hair style
+        charCreate << uint8(0);                             // hair color
+        charCreate << uint8(0);                             // facial hair
+        charCreate << uint8(0);                             // outfit
+        SendPacket(charCreate);
+        return;
+    }
+
+    std::string name;
+    packet >> _playerGuid;
+    packet >> name;
+    uint8 race = packet.read<uint8>();
+    _language = (RACEMASK_ALLIANCE & (1 << (race - 1))) ? LANG_COMMON : LANG_ORCISH;
+
+    _state = ClientState::LoggingIn;
+    WorldPacket playerLogin(CMSG_PLAYER_LOGIN, 8);
+    playerLogin << uint64(_playerGuid);
+    SendPacket(playerLogin);
+}
+
+void ReplayClient::HandleCharCreate(WorldPacket& packet)
+{
+    uint8 result = packet.read<uint8>();
+    if (result != CHAR_CREATE_SUCCESS)
+    {
+        Close(Trinity::StringFormat("cannot create character {} (result {})", _settings.CharacterName, result));
+        return;
+    }
+
+    SendPacket(WorldPacket(CMSG_CHAR_ENUM, 0));
+}
+
+void ReplayClient::HandleLoginVerifyWorld(WorldPacket& packet)
+{
+    float x, y, z;
+    packet.read_skip<uint32>();                             // map
+    packet >> x >> y >> z;
+
+    if (_state != ClientState::LoggingIn)
+        return;
+
+    // recorded movement continues from where this character is
+    if (_stream.HasStartPosition)
+    {
+        _offsetX = x - _stream.StartX;
+        _offsetY = y - _stream.StartY;
+        _offsetZ = z - _stream.StartZ;
+    }
+
+    _state = ClientState::InWorld;
+    ++_statistics.InWorld;
+
+    // clients replaying the same stream start at different packets not to act in lockstep
+    _nextPacket = urand(0, _stream.Packets.size() - 1);
+    _nextUpdateTimeQuery = std::chrono::steady_clock::now();
+    ScheduleReplay();
+    ScheduleProbe();
+}
+
+void ReplayClient::HandleNewWorld(WorldPacket& /*packet*/)
+{
+    SendPacket(WorldPacket(MSG_MOVE_WORLDPORT_ACK, 0));
+}
+
+void ReplayClient::HandleMoveTeleport(WorldPacket& packet)
+{
+    uint8 guidMask = packet.read<uint8>();
+    packet.read_skip(std::popcount(guidMask));
+    uint32 counter = packet.read<uint32>();
+
+    WorldPacket teleportAck(MSG_MOVE_TELEPORT_ACK, 8 + 4 + 4);
+    teleportAck.appendPackGUID(_playerGuid);
+    teleportAck << uint32(counter);
+    teleportAck << uint32(GetClientTicks());
+    SendPacket(teleportAck);
+}
+
+void ReplayClient::HandleTimeSyncRequest(WorldPacket& packet)
+{
+    uint32 counter = packet.read<uint32>();
+
+    WorldPacket timeSyncResponse(CMSG_TIME_SYNC_RESP, 4 + 4);
+    timeSyncResponse << uint32(counter);
+    timeSyncResponse << uint32(GetClientTicks());
+    SendPacket(timeSyncResponse);
+}
+
+void ReplayClient::HandleQueryTimeResponse(WorldPacket& /*packet*/)
+{
+    if (_pendingQueryTimes.empty())
+        return;
+
+    _statistics.AddLatency(std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - _pendingQueryTimes.front()));
+    _pendingQueryTimes.pop_front();
+}
+
+void ReplayClient::HandleMessageChat(WorldPacket& packet)
+{
+    if (!_settings.ReportsUpdateTime)
+        return;
+
+    std::string_view contents(reinterpret_cast<char const*>(packet.contents()), packet.size());
+    std::size_t position = contents.find(UpdateTimeMessage);
+    if (position == std::string_view::npos)
+        return;
+
+    _statistics.AddUpdateTime(uint32(strtoul(contents.data() + position + UpdateTimeMessage.size(), nullptr, 10)));
+}
+
+void ReplayClient::ScheduleReplay()
+{
+    ReplayPacket const& next = _stream.Packets[_nextPacket];
+    _replayTimer.expires_after(std::chrono::duration_cast<Milliseconds>(std::chrono::duration<float, std::milli>(next.Delay / _settings.Speed)));
+    _replayTimer.async_wait(Trinity::Asio::bind_executor(_strand, [self = shared_from_this()](boost::system::error_code const& error)
+    {
+        if (error || self->_state != ClientState::InWorld)
+            return;
+
+        ReplayPacket const& packet = self->_stream.Packets[self->_nextPacket];
+        self->SendPacket(self->Retarget(packet.Opcode, packet.Data));
+        self->_nextPacket = (self->_nextPacket + 1) % self->_stream.Packets.size();
+        self->ScheduleReplay();
+    }));
+}
+
+void ReplayClient::ScheduleProbe()
+{
+    _probeTimer.expires_after(1s);
+    _probeTimer.async_wait(Trinity::Asio::bind_executor(_strand, [self = shared_from_this()](boost::system::error_code const& error)
+    {
+        if (error || self->_state != ClientState::InWorld)
+            return;
+
+        // answered in order by the session update, at most one second apart
+        self->_pendingQueryTimes.push_back(std::chrono::steady_clock::now());
+        self->SendPacket(WorldPacket(CMSG_QUERY_TIME, 0));
+
+        if (self->_settings.ReportsUpdateTime && std::chrono::steady_clock::now() >= self->_nextUpdateTimeQuery)
+        {
+            std::string_view command = ".server info";
+            WorldPacket messageChat(CMSG_MESSAGECHAT, 4 + 4 + command.size() + 1);
+            messageChat << uint32(CHAT_MSG_SAY);
+            messageChat << uint32(self->_language);
+            messageChat << command;
+            self->SendPacket(messageChat);
+            self->_nextUpdateTimeQuery += self->_settings.UpdateTimeInterval;
+        }
+
+        self->ScheduleProbe();
+    }));
+}
+
+WorldPacket ReplayClient::Retarget(uint32 opcode, std::vector<uint8> const& data) const
+{
+    WorldPacket packet(opcode, data.size() + 8);
+    std::size_t copiedBytes = 0;
+
+    // mover guid, flags, extra flags, time and position of MovementInfo
+    if (PacketLogReader::IsMovementOpcode(opcode))
+    {
+        uint64 mover;
+        std::size_t guidSize = PacketLogReader::ReadPackedGuid(data, mover);
+        std::size_t positionOffset = guidSize + 4 + 2 + 4;
+        if (guidSize && mover == _stream.PlayerGuid && data.size() >= positionOffset + 3 * sizeof(float))
+        {
+            float position[3];
+            memcpy(position, &data[positionOffset], sizeof(position));
+
+            packet.appendPackGUID(_playerGuid);
+            packet.append(&data[guidSize], 4 + 2);
+            packet << uint32(GetClientTicks());
+            packet << float(position[0] + _offsetX);
+            packet << float(position[1] + _offsetY);
+            packet << float(position[2] + _offsetZ);
+            copiedBytes = positionOffset + sizeof(position);
+        }
+    }
+
+    if (copiedBytes < data.size())
+        packet.append(&data[copiedBytes], data.size() - copiedBytes);
+
+    // the recorded character in raw form, for example as target
+    if (_stream.PlayerGuid && packet.size() >= sizeof(uint64))
+    {
+        for (std::size_t i = 0; i + sizeof(uint64) <= packet.size(); ++i)
+        {
+            if (memcmp(packet.contents() + i, &_stream.PlayerGuid, sizeof(uint64)) != 0)
+                continue;
+
+            packet.put<uint64>(i, _playerGuid);
+            i += sizeof(uint64) - 1;
+        }
+    }
+
+    // chat type followed by the language of the recorded faction
+    if (opcode == CMSG_MESSAGECHAT && packet.size() >= 8)
+    {
+        uint32 language = packet.read<uint32>(4);
+        if (language == LANG_COMMON || language == LANG_ORCISH)
+            packet.put<uint32>(4, _language);
+    }
+
+    return packet;
+}
+
+uint32 ReplayClient::GetClientTicks() const
+{
+    return uint32(std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now() - _startTime).count());
+}
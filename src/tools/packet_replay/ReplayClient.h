@@ -0,0 +1,132 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_REPLAY_CLIENT_H
+#define TRINITYCORE_REPLAY_CLIENT_H
+
+#include "ARC4.h"
+#include "AuthDefines.h"
+#include "DeadlineTimer.h"
+#include "MessageBuffer.h"
+#include "Optional.h"
+#include "Strand.h"
+#include "WorldPacket.h"
+#include <boost/asio/ip/tcp.hpp>
+#include <deque>
+#include <memory>
+
+struct ReplayStream;
+class ReplayStatistics;
+
+struct ReplayClientSettings
+{
+    std::string Account;
+    SessionKey Key;
+    std::string CharacterName;                              // created when the account has no character
+    uint32 RealmId;
+    float Speed;                                            // multiplies the pace of the recorded packets
+    bool ReportsUpdateTime;                                 // asks for .server info every UpdateTimeInterval
+    Milliseconds UpdateTimeInterval;
+};
+
+/// One synthetic client: authenticates with the session key stored for its account, logs in its
+/// first character and then sends the packets of a recorded stream in a loop with their recorded delays
+class ReplayClient : public std::enable_shared_from_this<ReplayClient>
+{
+public:
+    ReplayClient(Trinity::Asio::IoContext& ioContext, ReplayClientSettings settings, ReplayStream const& stream, ReplayStatistics& statistics);
+
+    void Start(boost::asio::ip::tcp::endpoint const& endpoint);
+    void Stop();
+
+private:
+    enum class ClientState
+    {
+        Connecting,
+        Authenticating,
+        CharacterList,
+        CreatingCharacter,
+        LoggingIn,
+        InWorld,
+        Closed
+    };
+
+    void AsyncRead();
+    void ReadHandler(boost::system::error_code const& error, std::size_t transferredBytes);
+    bool ReadPackets();
+
+    void SendPacket(WorldPacket const& packet);
+    void AsyncWrite();
+
+    void Close(std::string const& reason);
+
+    void HandlePacket(WorldPacket& packet);
+    void HandleAuthChallenge(WorldPacket& packet);
+    void HandleAuthResponse(WorldPacket& packet);
+    void HandleCharEnum(WorldPacket& packet);
+    void HandleCharCreate(WorldPacket& packet);
+    void HandleLoginVerifyWorld(WorldPacket& packet);
+    void HandleNewWorld(WorldPacket& packet);
+    void HandleMoveTeleport(WorldPacket& packet);
+    void HandleTimeSyncRequest(WorldPacket& packet);
+    void HandleQueryTimeResponse(WorldPacket& packet);
+    void HandleMessageChat(WorldPacket& packet);
+
+    void ScheduleReplay();
+    void ScheduleProbe();
+    WorldPacket Retarget(uint32 opcode, std::vector<uint8> const& data) const;
+
+    uint32 GetClientTicks() const;
+
+    ReplayClientSettings _settings;
+    ReplayStream const& _stream;
+    ReplayStatistics& _statistics;
+
+    Trinity::Asio::Strand _strand;
+    boost::asio::ip::tcp::socket _socket;
+    Trinity::Asio::DeadlineTimer _replayTimer;
+    Trinity::Asio::DeadlineTimer _probeTimer;
+    TimePoint _startTime;
+    ClientState _state;
+    bool _stopping;
+
+    Trinity::Crypto::ARC4 _encrypt;
+    Trinity::Crypto::ARC4 _decrypt;
+    bool _cryptInitialized;
+
+    MessageBuffer _readBuffer;
+    uint8 _header[5];
+    uint8 _headerSize;
+    Optional<WorldPacket> _packet;
+    std::size_t _payloadSize;
+
+    std::vector<uint8> _writeBuffer;
+    std::vector<uint8> _pendingWrite;
+    bool _writing;
+
+    uint64 _playerGuid;
+    uint32 _language;
+    float _offsetX;
+    float _offsetY;
+    float _offsetZ;
+    std::size_t _nextPacket;
+
+    std::deque<TimePoint> _pendingQueryTimes;
+    TimePoint _nextUpdateTimeQuery;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayStatistics.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+ReplayStatistics::ReplayStatistics() : Connected(0), InWorld(0), Failed(0), PacketsSent(0), PacketsReceived(0), BytesReceived(0),
+    _reportedLatencies(0), _reportedUpdateTimes(0), _reportedPacketsSent(0), _reportedPacketsReceived(0), _reportedBytesReceived(0)
+{
+}
+
+void ReplayStatistics::AddLatency(Milliseconds latency)
+{
+    std::lock_guard<std::mutex> lock(_samplesLock);
+    _latencies.push_back(latency);
+}
+
+void ReplayStatistics::AddUpdateTime(uint32 updateTime)
+{
+    std::lock_guard<std::mutex> lock(_samplesLock);
+    _updateTimes.push_back(updateTime);
+}
+
+ReplayStatistics::Interval ReplayStatistics::TakeInterval()
+{
+    Interval interval;
+    interval.Connected = Connected.load(std::memory_order_relaxed);
+    interval.InWorld = InWorld.load(std::memory_order_relaxed);
+    interval.Failed = Failed.load(std::memory_order_relaxed);
+
+    uint64 packetsSent = PacketsSent.load(std::memory_order_relaxed);
+    uint64 packetsReceived = PacketsReceived.load(std::memory_order_relaxed);
+    uint64 bytesReceived = BytesReceived.load(std::memory_order_relaxed);
+    interval.PacketsSent = packetsSent - std::exchange(_reportedPacketsSent, packetsSent);
+    interval.PacketsReceived = packetsReceived - std::exchange(_reportedPacketsReceived, packetsReceived);
+    interval.BytesReceived = bytesReceived - std::exchange(_reportedBytesReceived, bytesReceived);
+
+    std::lock_guard<std::mutex> lock(_samplesLock);
+    interval.Latency = Summarize(std::vector<Milliseconds>(_latencies.begin() + _reportedLatencies, _latencies.end()));
+    interval.UpdateTime = Summarize(std::vector<uint32>(_updateTimes.begin() + _reportedUpdateTimes, _updateTimes.end()));
+    _reportedLatencies = _latencies.size();
+    _reportedUpdateTimes = _updateTimes.size();
+    return interval;
+}
+
+LatencySummary ReplayStatistics::GetTotalLatency() const
+{
+    std::lock_guard<std::mutex> lock(_samplesLock);
+    return Summarize(_latencies);
+}
+
+UpdateTimeSummary ReplayStatistics::GetTotalUpdateTime() const
+{
+    std::lock_guard<std::mutex> lock(_samplesLock);
+    return Summarize(_updateTimes);
+}
+
+LatencySummary ReplayStatistics::Summarize(std::vector<Milliseconds> latencies)
+{
+    LatencySummary summary;
+    if (latencies.empty())
+        return summary;
+
+    std::sort(latencies.begin(), latencies.end());
+    summary.Samples = latencies.size();
+    summary.Average = std::accumulate(latencies.begin(), latencies.end(), Milliseconds::zero()) / latencies.size();
+    summary.Median = latencies[latencies.size() / 2];
+    summary.Percentile95 = latencies[latencies.size() * 95 / 100];
+    summary.Max = latencies.back();
+    return summary;
+}
+
+UpdateTimeSummary ReplayStatistics::Summarize(std::vector<uint32> const& updateTimes)
+{
+    UpdateTimeSummary summary;
+    if (updateTimes.empty())
+        return summary;
+
+    summary.Samples = updateTimes.size();
+    summary.Average = uint32(std::accumulate(updateTimes.begin(), updateTimes.end(), uint64(0)) / updateTimes.size());
+    summary.Max = *std::max_element(updateTimes.begin(), updateTimes.end());
+    return summary;
+}
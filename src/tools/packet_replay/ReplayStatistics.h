@@ -0,0 +1,94 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_REPLAY_STATISTICS_H
+#define TRINITYCORE_REPLAY_STATISTICS_H
+
+#include "Define.h"
+#include "Duration.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+struct LatencySummary
+{
+    std::size_t Samples = 0;
+    Milliseconds Average = 0ms;
+    Milliseconds Median = 0ms;
+    Milliseconds Percentile95 = 0ms;
+    Milliseconds Max = 0ms;
+};
+
+struct UpdateTimeSummary
+{
+    std::size_t Samples = 0;
+    uint32 Average = 0;
+    uint32 Max = 0;
+};
+
+/// Counters of all replaying clients, written from the network threads and read by the reports
+class ReplayStatistics
+{
+public:
+    struct Interval
+    {
+        uint32 Connected;
+        uint32 InWorld;
+        uint32 Failed;
+        uint64 PacketsSent;
+        uint64 PacketsReceived;
+        uint64 BytesReceived;
+        LatencySummary Latency;
+        UpdateTimeSummary UpdateTime;
+    };
+
+    ReplayStatistics();
+
+    std::atomic<uint32> Connected;
+    std::atomic<uint32> InWorld;
+    std::atomic<uint32> Failed;
+    std::atomic<uint64> PacketsSent;
+    std::atomic<uint64> PacketsReceived;
+    std::atomic<uint64> BytesReceived;
+
+    /// Round trip of CMSG_QUERY_TIME, the server answers it from the session update
+    void AddLatency(Milliseconds latency);
+
+    /// Average world update time reported by .server info
+    void AddUpdateTime(uint32 updateTime);
+
+    /// Returns what was counted since the previous call, the samples are kept for the summary of the whole run
+    Interval TakeInterval();
+
+    LatencySummary GetTotalLatency() const;
+    UpdateTimeSummary GetTotalUpdateTime() const;
+
+    static LatencySummary Summarize(std::vector<Milliseconds> latencies);
+    static UpdateTimeSummary Summarize(std::vector<uint32> const& updateTimes);
+
+private:
+    mutable std::mutex _samplesLock;
+    std::vector<Milliseconds> _latencies;
+    std::vector<uint32> _updateTimes;
+    std::size_t _reportedLatencies;
+    std::size_t _reportedUpdateTimes;
+    uint64 _reportedPacketsSent;
+    uint64 _reportedPacketsReceived;
+    uint64 _reportedBytesReceived;
+};
+
+#endif
@@ -18,11 +18,16 @@
 #include "DummyData.h"
 
 #include "AchievementMgr.h"
+#include "DBCStores.h"
 #include "ItemDefines.h"
 #include "ItemTemplate.h"
 #include "ObjectMgr.h"
+#include "RBAC.h"
 #include "SpellInfo.h"
 #include "SpellMgr.h"
+#include "WorldSession.h"
+#include "WorldSocket.h"
+#include <algorithm>
 
 /*static*/ ItemTemplate& UnitTestDataLoader::GetItemTemplate(uint32 itemId, std::string_view name)
 {
@@ -157,6 +162,23 @@ static UnitTestDataLoader::DBC<AchievementEntry, &AchievementEntry::ID> achievem
     toc5.Points = 10;
 }
 
+static UnitTestDataLoader::DBC<MapEntry, &MapEntry::ID> maps(sMapStore);
+/*static*/ void UnitTestDataLoader::LoadMapTemplates()
+{
+    if (!maps.Empty())
+        return;
+
+    auto loader = maps.Loader();
+
+    MapEntry& easternKingdoms = loader.Add();
+    easternKingdoms = {};
+    easternKingdoms.ID = 0;
+    easternKingdoms.InstanceType = MAP_COMMON;
+    std::fill(std::begin(easternKingdoms.MapName), std::end(easternKingdoms.MapName), "");
+    easternKingdoms.MapName[LOCALE_enUS] = "Eastern Kingdoms";
+    easternKingdoms.CorpseMapID = -1;
+}
+
 static UnitTestDataLoader::DBC<SpellEntry, &SpellEntry::ID> spells(sSpellStore);
 static UnitTestDataLoader::DBC<TalentEntry, &TalentEntry::ID> talents(sTalentStore);
 /*static*/ void UnitTestDataLoader::LoadSpellInfo()
@@ -336,3 +358,15 @@ static UnitTestDataLoader::DBC<TalentEntry, &TalentEntry::ID> talents(sTalentSto
     // this needs to be after the loader destructors
     sSpellMgr->LoadSpellInfoStore();
 }
+
+/*static*/ void UnitTestDataLoader::LoadEmptyPermissions(WorldSession& session)
+{
+    delete session._RBACData;
+    session._RBACData = new rbac::RBACData(session.GetAccountId(), session.GetAccountName(), 0, session.GetSecurity());
+}
+
+/*static*/ void UnitTestDataLoader::AddSessionToWorld(WorldSocket& socket)
+{
+    socket._waitForFlush = socket._coalescePackets;
+}
+
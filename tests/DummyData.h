@@ -28,6 +28,8 @@
 struct ItemTemplate;
 
 class SpellInfo;
+class WorldSession;
+class WorldSocket;
 
 class UnitTestDataLoader
 {
@@ -74,7 +76,12 @@ class UnitTestDataLoader
 
         static void LoadAchievementTemplates();
         static void LoadItemTemplates();
+        static void LoadMapTemplates();
         static void LoadSpellInfo();
+        // gives a session without database an empty permission set, players of the session can be created then
+        static void LoadEmptyPermissions(WorldSession& session);
+        // the socket then handles its packets like those of a session added to the world
+        static void AddSessionToWorld(WorldSocket& socket);
 
     private:
         static ItemTemplate& GetItemTemplate(uint32 id, std::string_view name);
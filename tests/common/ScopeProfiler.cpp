@@ -0,0 +1,180 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "ScopeProfiler.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct BossAI { virtual ~BossAI() = default; };
+    struct LichKingAI : BossAI { };
+
+    void Spin(std::chrono::microseconds duration)
+    {
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+            ;
+    }
+
+    std::map<std::string, uint64> ReadFoldedStacks()
+    {
+        std::string fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme.folded")).string();
+
+        std::size_t stackCount = 0;
+        REQUIRE(ScopeProfiler::WriteFoldedStacks(fileName, stackCount));
+
+        std::map<std::string, uint64> stacks;
+        std::ifstream file(fileName);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::size_t separator = line.rfind(' ');
+            REQUIRE(separator != std::string::npos);
+            stacks[line.substr(0, separator)] = std::stoull(line.substr(separator + 1));
+        }
+
+        std::remove(fileName.c_str());
+        REQUIRE(stacks.size() == stackCount);
+        return stacks;
+    }
+}
+
+TEST_CASE("Scope profiler writes folded stacks", "[ScopeProfiler]")
+{
+    SECTION("nested scopes are measured without the time of their children")
+    {
+        ScopeProfiler::Start(1);
+        std::thread([]()
+        {
+            ScopeProfiler::Scope update(ScopeProfiler::SCOPE_ROOT, nullptr, "Map::Update");
+            Spin(2000us);
+            {
+                LichKingAI ai;
+                BossAI& base = ai;
+                ScopeProfiler::Scope aiUpdate(ScopeProfiler::SCOPE_NESTED, typeid(base), "UpdateAI");
+                Spin(3000us);
+            }
+        }).join();
+        ScopeProfiler::Stop();
+
+        std::map<std::string, uint64> stacks = ReadFoldedStacks();
+        REQUIRE(stacks.size() == 2);
+        REQUIRE(stacks["Map::Update"] >= 2000);
+        REQUIRE(stacks["Map::Update"] < 3000);
+
+        // named after the dynamic type, demangled names of the anonymous namespace differ between compilers
+        auto ai = std::find_if(stacks.begin(), stacks.end(), [](std::pair<std::string const, uint64> const& stack)
+        {
+            return stack.first.starts_with("Map::Update;") && stack.first.ends_with("LichKingAI::UpdateAI");
+        });
+        REQUIRE(ai != stacks.end());
+        REQUIRE(ai->second >= 3000);
+    }
+
+    SECTION("only scopes of sampled roots are measured")
+    {
+        ScopeProfiler::Start(2);
+        for (char const* handler : { "CMSG_MESSAGECHAT", "CMSG_CAST_SPELL", "CMSG_EMOTE", "CMSG_LOGOUT_REQUEST" })
+        {
+            ScopeProfiler::Scope update(ScopeProfiler::SCOPE_ROOT, nullptr, "WorldSession::Update");
+            ScopeProfiler::Scope nestedRoot(ScopeProfiler::SCOPE_ROOT, nullptr, "Map::UpdateRegion");
+            ScopeProfiler::Scope opcode(ScopeProfiler::SCOPE_NESTED, nullptr, handler);
+            Spin(100us);
+        }
+
+        // outside of any root
+        {
+            ScopeProfiler::Scope script(ScopeProfiler::SCOPE_NESTED, "WorldScript", "OnUpdate");
+            Spin(100us);
+        }
+        ScopeProfiler::Stop();
+
+        std::map<std::string, uint64> stacks = ReadFoldedStacks();
+        REQUIRE(stacks.count("WorldSession::Update;Map::UpdateRegion;CMSG_MESSAGECHAT") == 1);
+        REQUIRE(stacks.count("WorldSession::Update;Map::UpdateRegion;CMSG_EMOTE") == 1);
+        for (auto const& [stack, microseconds] : stacks)
+        {
+            REQUIRE(stack.find("CMSG_CAST_SPELL") == std::string::npos);
+            REQUIRE(stack.find("CMSG_LOGOUT_REQUEST") == std::string::npos);
+            REQUIRE(stack.find("WorldScript") == std::string::npos);
+        }
+
+        // time is estimated for the skipped roots
+        REQUIRE(stacks["WorldSession::Update;Map::UpdateRegion;CMSG_EMOTE"] >= 200);
+    }
+
+    SECTION("reset discards what was recorded")
+    {
+        ScopeProfiler::Start(1);
+        {
+            ScopeProfiler::Scope update(ScopeProfiler::SCOPE_ROOT, nullptr, "Map::Update");
+            Spin(100us);
+        }
+        ScopeProfiler::Reset();
+        ScopeProfiler::Stop();
+
+        REQUIRE(ReadFoldedStacks().empty());
+    }
+}
+
+TEST_CASE("Scope profiler overhead", "[.][benchmark][ScopeProfiler]")
+{
+    // a session update handling a few packets, each calling a script hook
+    auto update = []()
+    {
+        uint32 handled = 0;
+        ScopeProfiler::Scope session(ScopeProfiler::SCOPE_ROOT, nullptr, "WorldSession::Update");
+        for (char const* handler : { "CMSG_MESSAGECHAT", "CMSG_CAST_SPELL", "MSG_MOVE_HEARTBEAT", "CMSG_EMOTE" })
+        {
+            ScopeProfiler::Scope opcode(ScopeProfiler::SCOPE_NESTED, nullptr, handler);
+            ScopeProfiler::Scope script(ScopeProfiler::SCOPE_NESTED, "PlayerScript", "OnChat");
+            Spin(1us);
+            ++handled;
+        }
+        return handled;
+    };
+
+    ScopeProfiler::Stop();
+    BENCHMARK("stopped")
+    {
+        return update();
+    };
+
+    ScopeProfiler::Start(16);
+    BENCHMARK("one in 16 updates")
+    {
+        return update();
+    };
+
+    ScopeProfiler::Start(1);
+    BENCHMARK("every update")
+    {
+        return update();
+    };
+    ScopeProfiler::Stop();
+}
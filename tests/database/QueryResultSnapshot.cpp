@@ -0,0 +1,249 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "Field.h"
+#include "PreparedStatement.h"
+#include "QueryResult.h"
+#include "QueryResultSnapshot.h"
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+#include <fstream>
+#include <optional>
+
+namespace
+{
+    /// Text protocol rows as a snapshot stores them: per value uint32 size, the characters and '\0', aligned to 4 bytes
+    std::shared_ptr<std::vector<char>> MakeRows(std::vector<std::vector<char const*>> const& rows)
+    {
+        std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>();
+        for (std::vector<char const*> const& row : rows)
+        {
+            for (char const* value : row)
+            {
+                buffer->resize((buffer->size() + 3) & ~std::size_t(3));
+                uint32 size = value ? std::strlen(value) : 0xFFFFFFFF;
+                buffer->insert(buffer->end(), reinterpret_cast<char const*>(&size), reinterpret_cast<char const*>(&size) + sizeof(size));
+                if (value)
+                    buffer->insert(buffer->end(), value, value + std::strlen(value) + 1);
+            }
+        }
+
+        return buffer;
+    }
+
+    /// Binary protocol rows as a snapshot stores them: like text rows, but the values start aligned to 8 bytes
+    std::shared_ptr<std::vector<char>> MakeBinaryRows(std::vector<std::vector<std::optional<std::vector<char>>>> const& rows)
+    {
+        // aligned like the buffers of recorded results, the test relies on it to check alignment of the values
+        std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>();
+        for (auto const& row : rows)
+        {
+            for (std::optional<std::vector<char>> const& value : row)
+            {
+                buffer->resize((buffer->size() + 3) & ~std::size_t(3));
+                uint32 size = value ? value->size() : 0xFFFFFFFF;
+                buffer->insert(buffer->end(), reinterpret_cast<char const*>(&size), reinterpret_cast<char const*>(&size) + sizeof(size));
+                if (!value)
+                    continue;
+
+                buffer->resize((buffer->size() + 7) & ~std::size_t(7));
+                buffer->insert(buffer->end(), value->begin(), value->end());
+                buffer->push_back('\0');
+            }
+        }
+
+        return buffer;
+    }
+
+    template<typename T>
+    std::vector<char> Bytes(T value)
+    {
+        return std::vector<char>(reinterpret_cast<char const*>(&value), reinterpret_cast<char const*>(&value) + sizeof(T));
+    }
+
+    PreparedQueryResult MakePreparedResult()
+    {
+        std::vector<QueryResultFieldMetadata> fieldMetadata(3);
+        fieldMetadata[0].Name = "guid";
+        fieldMetadata[0].TypeName = "LONGLONG";
+        fieldMetadata[0].Type = DatabaseFieldTypes::Int64;
+        fieldMetadata[1].Name = "scale";
+        fieldMetadata[1].TypeName = "FLOAT";
+        fieldMetadata[1].Type = DatabaseFieldTypes::Float;
+        fieldMetadata[2].Name = "name";
+        fieldMetadata[2].TypeName = "VAR_STRING";
+        fieldMetadata[2].Type = DatabaseFieldTypes::Binary;
+
+        std::shared_ptr<std::vector<char>> rows = MakeBinaryRows({
+            { Bytes<int64>(-5000000000LL), Bytes<float>(1.5f), std::vector<char>{ 'M', 'o', 'g', 'g', 'e', 'r' } },
+            { Bytes<int64>(7), std::nullopt, std::vector<char>{ 'x' } }
+        });
+        return std::make_shared<PreparedResultSet>(std::move(fieldMetadata), 2, rows->data(), rows);
+    }
+
+    void RequirePreparedRows(PreparedQueryResult const& result)
+    {
+        REQUIRE(result);
+        REQUIRE(result->GetRowCount() == 2);
+        REQUIRE(result->GetFieldCount() == 3);
+        REQUIRE((*result)[0].GetInt64() == -5000000000LL);
+        REQUIRE((*result)[1].GetFloat() == 1.5f);
+        REQUIRE((*result)[2].GetString() == "Mogger");
+        REQUIRE(result->NextRow());
+        REQUIRE((*result)[0].GetInt64() == 7);
+        REQUIRE((*result)[1].IsNull());
+        REQUIRE((*result)[2].GetString() == "x");
+        REQUIRE_FALSE(result->NextRow());
+    }
+
+    QueryResult MakeResult()
+    {
+        std::vector<QueryResultFieldMetadata> fieldMetadata(2);
+        fieldMetadata[0].Name = "entry";
+        fieldMetadata[0].TypeName = "LONG";
+        fieldMetadata[0].Type = DatabaseFieldTypes::Int32;
+        fieldMetadata[1].Name = "name";
+        fieldMetadata[1].TypeName = "VAR_STRING";
+        fieldMetadata[1].Type = DatabaseFieldTypes::Binary;
+
+        std::shared_ptr<std::vector<char>> rows = MakeRows({ { "1", "Hogger" }, { "2", nullptr } });
+        QueryResult result = std::make_shared<ResultSet>(std::move(fieldMetadata), 2, rows->data(), rows);
+        result->NextRow();
+        return result;
+    }
+
+    void RequireRows(QueryResult const& result)
+    {
+        REQUIRE(result);
+        REQUIRE(result->GetRowCount() == 2);
+        REQUIRE(result->GetFieldCount() == 2);
+        REQUIRE(std::string_view(result->GetFieldMetadata(1).Name) == "name");
+        REQUIRE((*result)[0].GetUInt32() == 1);
+        REQUIRE((*result)[1].GetString() == "Hogger");
+        REQUIRE(result->NextRow());
+        REQUIRE((*result)[0].GetUInt32() == 2);
+        REQUIRE((*result)[1].IsNull());
+        REQUIRE_FALSE(result->NextRow());
+    }
+}
+
+TEST_CASE("QueryResultSnapshot", "[QueryResultSnapshot]")
+{
+    std::string fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+
+    QueryResultSnapshot recording;
+    REQUIRE_FALSE(recording.Open(fileName, "revision 1"));
+    RequireRows(recording.Record("SELECT entry, name FROM creature_template", MakeResult()));
+    REQUIRE_FALSE(recording.Record("SELECT entry FROM creature WHERE 0", QueryResult()));
+
+    PreparedStatementBase stmt(12, 3);
+    stmt.setUInt32(0, 530);
+    stmt.setString(1, "a', 'b");
+    stmt.setNull(2);
+    std::string const preparedKey = QueryResultSnapshot::GetKey(&stmt);
+    RequirePreparedRows(recording.Record(preparedKey, MakePreparedResult()));
+    REQUIRE(recording.HasChanges());
+    REQUIRE(recording.Write(fileName));
+
+    SECTION("Results are read back from the file")
+    {
+        QueryResultSnapshot snapshot;
+        REQUIRE(snapshot.Open(fileName, "revision 1"));
+
+        QueryResult result;
+        REQUIRE(snapshot.Find("SELECT entry, name FROM creature_template", result));
+        RequireRows(result);
+
+        REQUIRE(snapshot.Find("SELECT entry FROM creature WHERE 0", result));
+        REQUIRE_FALSE(result);
+
+        PreparedQueryResult preparedResult;
+        REQUIRE(snapshot.Find(preparedKey, preparedResult));
+        RequirePreparedRows(preparedResult);
+
+        REQUIRE_FALSE(snapshot.Find("SELECT entry FROM gameobject", result));
+        REQUIRE(snapshot.GetStatistics().Hits == 3);
+        REQUIRE(snapshot.GetStatistics().Misses == 1);
+        REQUIRE_FALSE(snapshot.HasChanges());
+    }
+
+    SECTION("Prepared statements with other parameters have other keys")
+    {
+        PreparedStatementBase other(12, 3);
+        other.setUInt32(0, 530);
+        other.setString(1, "a");
+        other.setString(2, "b");
+        REQUIRE(QueryResultSnapshot::GetKey(&other) != preparedKey);
+
+        PreparedStatementBase first(13, 1);
+        first.setBinary(0, std::vector<uint8>{ 1, 2 });
+        PreparedStatementBase second(13, 1);
+        second.setBinary(0, std::vector<uint8>{ 1, 3 });
+        REQUIRE(QueryResultSnapshot::GetKey(&first) != QueryResultSnapshot::GetKey(&second));
+    }
+
+    SECTION("Files of another revision are not used")
+    {
+        QueryResultSnapshot snapshot;
+        REQUIRE_FALSE(snapshot.Open(fileName, "revision 2"));
+
+        QueryResult result;
+        REQUIRE_FALSE(snapshot.Find("SELECT entry, name FROM creature_template", result));
+    }
+
+    SECTION("Damaged files are not used")
+    {
+        {
+            std::fstream file(fileName, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(-1, std::ios::end);
+            file.put('x');
+        }
+
+        QueryResultSnapshot snapshot;
+        REQUIRE_FALSE(snapshot.Open(fileName, "revision 1"));
+    }
+
+    SECTION("Writes while loading keep the snapshot from being used again")
+    {
+        QueryResultSnapshot snapshot;
+        REQUIRE(snapshot.Open(fileName, "revision 1"));
+        snapshot.OnDatabaseWrite();
+        REQUIRE(snapshot.Record("SELECT 1", MakeResult()));
+        REQUIRE_FALSE(snapshot.HasChanges());
+
+        snapshot.Finish(fileName);
+        REQUIRE_FALSE(boost::filesystem::exists(fileName));
+    }
+
+    SECTION("Writes after loading remove the file")
+    {
+        QueryResultSnapshot snapshot;
+        REQUIRE(snapshot.Open(fileName, "revision 1"));
+        snapshot.Finish(fileName);
+        REQUIRE(boost::filesystem::exists(fileName));
+
+        QueryResult result;
+        REQUIRE_FALSE(snapshot.Find("SELECT entry, name FROM creature_template", result));
+
+        snapshot.OnDatabaseWrite();
+        REQUIRE_FALSE(boost::filesystem::exists(fileName));
+    }
+
+    boost::filesystem::remove(fileName);
+}
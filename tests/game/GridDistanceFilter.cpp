@@ -0,0 +1,221 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "GridDefines.h"
+#include "GridDistanceFilter.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Trinity;
+using Implementation = GridDistanceFilter::Implementation;
+
+namespace
+{
+    struct PackedPositions
+    {
+        std::vector<float> X;
+        std::vector<float> Y;
+        std::vector<float> Z;
+        std::vector<float> CombatReach;
+        std::vector<uint32> PhaseMask;
+
+        GridPositionSpan Span(std::size_t first, std::size_t count) const
+        {
+            GridPositionSpan span;
+            span.X = X.data() + first;
+            span.Y = Y.data() + first;
+            span.Z = Z.data() + first;
+            span.CombatReach = CombatReach.data() + first;
+            span.PhaseMask = PhaseMask.data() + first;
+            span.Count = uint32(count);
+            return span;
+        }
+    };
+
+    // objects spread over one cell, mostly in the normal phase
+    PackedPositions GeneratePositions(std::size_t count, uint32 seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coord(0.0f, SIZE_OF_GRID_CELL);
+        std::uniform_real_distribution<float> height(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> reach(0.0f, 5.0f);
+        std::uniform_int_distribution<uint32> phase(0, 7);
+
+        PackedPositions positions;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            positions.X.push_back(coord(rng));
+            positions.Y.push_back(coord(rng));
+            positions.Z.push_back(height(rng));
+            positions.CombatReach.push_back(reach(rng));
+            positions.PhaseMask.push_back(phase(rng) ? 1 : 2);
+        }
+        return positions;
+    }
+
+    GridDistanceQuery MakeQuery(float range, bool is3D, bool addTargetReach)
+    {
+        GridDistanceQuery query;
+        query.X = SIZE_OF_GRID_CELL / 2;
+        query.Y = SIZE_OF_GRID_CELL / 2;
+        query.Z = 0.0f;
+        query.Range = range;
+        query.Is3D = is3D;
+        query.AddTargetReach = addTargetReach;
+        query.PhaseMask = 1;
+        return query;
+    }
+
+    // checks the way the grid stores do, in chunks of a cell container
+    std::size_t CountMatches(Implementation implementation, GridDistanceQuery const& query, PackedPositions const& positions)
+    {
+        uint32 matches[64];
+        std::size_t total = 0;
+        for (std::size_t first = 0; first < positions.X.size(); first += 64)
+            total += GridDistanceFilter::Filter(implementation, query, positions.Span(first, std::min<std::size_t>(64, positions.X.size() - first)), matches);
+        return total;
+    }
+
+    // what searchers do without the filter: dereference every object and test it through a virtual call
+    struct CandidateObject
+    {
+        virtual ~CandidateObject() = default;
+        virtual float GetCombatReach() const = 0;
+
+        float X, Y, Z;
+        uint32 PhaseMask;
+    };
+
+    struct CandidateUnit : CandidateObject
+    {
+        float GetCombatReach() const override { return Reach; }
+        float Reach;
+    };
+
+    std::size_t CountMatchesPerObject(std::vector<std::unique_ptr<CandidateObject>> const& objects, GridDistanceQuery const& query)
+    {
+        std::size_t total = 0;
+        for (std::unique_ptr<CandidateObject> const& object : objects)
+        {
+            if (!(object->PhaseMask & query.PhaseMask))
+                continue;
+
+            float dx = object->X - query.X;
+            float dy = object->Y - query.Y;
+            float dz = query.Is3D ? object->Z - query.Z : 0.0f;
+            float limit = query.Range + (query.AddTargetReach ? object->GetCombatReach() : 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= limit * limit)
+                ++total;
+        }
+        return total;
+    }
+}
+
+TEST_CASE("Every supported implementation matches the scalar filter", "[GridDistanceFilter]")
+{
+    PackedPositions positions = GeneratePositions(1027, 7);
+
+    for (Implementation implementation : { Implementation::SSE2, Implementation::AVX2 })
+    {
+        if (!GridDistanceFilter::IsSupported(implementation))
+            continue;
+
+        INFO(GridDistanceFilter::GetImplementationName(implementation));
+
+        for (GridDistanceQuery const& query : { MakeQuery(5.0f, true, true), MakeQuery(15.0f, false, false), MakeQuery(40.0f, true, false), MakeQuery(0.0f, false, true) })
+        {
+            // odd sizes exercise the scalar tails
+            for (std::size_t count : { 0, 3, 13, 64, 1027 })
+            {
+                GridPositionSpan span = positions.Span(0, count);
+                std::vector<uint32> expected(count + 1), found(count + 1);
+                expected.resize(GridDistanceFilter::Filter(Implementation::Scalar, query, span, expected.data()));
+                found.resize(GridDistanceFilter::Filter(implementation, query, span, found.data()));
+
+                REQUIRE(found == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Phase mask rejects objects in other phases", "[GridDistanceFilter]")
+{
+    PackedPositions positions = GeneratePositions(100, 3);
+    GridDistanceQuery query = MakeQuery(1000.0f, true, true);
+
+    std::vector<uint32> matches(100);
+    uint32 found = GridDistanceFilter::Filter(query, positions.Span(0, 100), matches.data());
+    for (uint32 i = 0; i < found; ++i)
+        REQUIRE(positions.PhaseMask[matches[i]] == 1);
+
+    query.PhaseMask = 0;
+    REQUIRE(GridDistanceFilter::Filter(query, positions.Span(0, 100), matches.data()) == 0);
+}
+
+TEST_CASE("Grid searcher distance checks", "[.][benchmark][GridDistanceFilter]")
+{
+    std::size_t const count = 4096;
+    PackedPositions positions = GeneratePositions(count, 11);
+
+    std::vector<std::unique_ptr<CandidateObject>> objects;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::unique_ptr<CandidateUnit> unit = std::make_unique<CandidateUnit>();
+        unit->X = positions.X[i];
+        unit->Y = positions.Y[i];
+        unit->Z = positions.Z[i];
+        unit->PhaseMask = positions.PhaseMask[i];
+        unit->Reach = positions.CombatReach[i];
+        objects.push_back(std::move(unit));
+    }
+
+    // query shapes of the check families using the filter
+    std::pair<char const*, GridDistanceQuery> const checks[] =
+    {
+        { "unit in range checks (3D + target reach)", MakeQuery(10.0f, true, true) },
+        { "all objects in range checks (2D + target reach)", MakeQuery(30.0f, false, true) },
+        { "message delivery (2D center distance)", MakeQuery(25.0f, false, false) }
+    };
+
+    for (auto const& [name, query] : checks)
+    {
+        std::size_t expected = CountMatchesPerObject(objects, query);
+
+        BENCHMARK(std::string(name) + ", per object")
+        {
+            return CountMatchesPerObject(objects, query);
+        };
+
+        for (Implementation implementation : { Implementation::Scalar, Implementation::SSE2, Implementation::AVX2 })
+        {
+            if (!GridDistanceFilter::IsSupported(implementation))
+                continue;
+
+            REQUIRE(CountMatches(implementation, query, positions) == expected);
+
+            BENCHMARK(std::string(name) + ", " + GridDistanceFilter::GetImplementationName(implementation))
+            {
+                return CountMatches(implementation, query, positions);
+            };
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "GameObject.h"
+#include "GridRefManager.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // game objects that are not in world, linked into one grid container
+    class TestCell
+    {
+    public:
+        ~TestCell()
+        {
+            for (std::unique_ptr<GameObject> const& object : _objects)
+                if (object->IsInGrid())
+                    object->RemoveFromGrid();
+        }
+
+        GameObject& Add(float x, float y, uint32 phaseMask)
+        {
+            GameObject& object = *_objects.emplace_back(std::make_unique<GameObject>());
+            object._Create(_objects.size(), HighGuid::GameObject, phaseMask);
+            object.Relocate(x, y, 0.0f);
+            object.AddToGrid(_container);
+            return object;
+        }
+
+        GridRefManager<GameObject>& GetContainer() { return _container; }
+        GridPositionStore& GetPositions() { return _container.GetPositions(); }
+
+    private:
+        GridRefManager<GameObject> _container;
+        std::vector<std::unique_ptr<GameObject>> _objects;
+    };
+
+    std::vector<WorldObject*> FindInRange(GridPositionStore& positions, float x, float y, float range)
+    {
+        Trinity::GridDistanceQuery query;
+        query.X = x;
+        query.Y = y;
+        query.Range = range;
+        query.Is3D = false;
+        query.PhaseMask = PHASEMASK_NORMAL;
+
+        std::vector<WorldObject*> found;
+        positions.VisitInRange(query, [&found](WorldObject* object)
+        {
+            found.push_back(object);
+            return true;
+        });
+        return found;
+    }
+}
+
+TEST_CASE("Objects removed while visiting a grid container", "[GridPositionStore]")
+{
+    TestCell cell;
+    std::vector<GameObject*> objects;
+    for (uint32 i = 0; i < 21; ++i)
+        objects.push_back(&cell.Add(float(i), 0.0f, i % 3 ? PHASEMASK_NORMAL : 2));
+
+    SECTION("Removing the visited object does not skip the others")
+    {
+        std::map<WorldObject*, uint32> visits;
+        cell.GetPositions().VisitInPhase(PHASEMASK_NORMAL, [&visits](WorldObject* object)
+        {
+            ++visits[object];
+            object->ToGameObject()->RemoveFromGrid();
+            return true;
+        });
+
+        for (GameObject* object : objects)
+            REQUIRE(visits[object] == (object->GetPhaseMask() == PHASEMASK_NORMAL ? 1u : 0u));
+
+        REQUIRE(cell.GetPositions().Size() == 7);
+    }
+
+    SECTION("Objects removed before their visit are not visited")
+    {
+        std::vector<WorldObject*> visited;
+        cell.GetPositions().VisitInRange(Trinity::GridDistanceQuery{ 0.0f, 0.0f, 0.0f, 100.0f, false, false, PHASEMASK_NORMAL }, [&](WorldObject* object)
+        {
+            visited.push_back(object);
+            if (visited.size() == 1)
+                for (GameObject* other : objects)
+                    if (other != object && other->GetPositionX() >= 10.0f)
+                        other->RemoveFromGrid();
+            return true;
+        });
+
+        // objects 1, 2, 4, 5, 7 and 8 are in phase and closer than 10 yards
+        REQUIRE(visited.size() == 6);
+        REQUIRE(cell.GetPositions().Size() == 10);
+        REQUIRE(FindInRange(cell.GetPositions(), 0.0f, 0.0f, 100.0f).size() == 6);
+    }
+
+    SECTION("Objects added while visiting stay linked")
+    {
+        uint32 visits = 0;
+        cell.GetPositions().VisitInPhase(PHASEMASK_NORMAL, [&](WorldObject* object)
+        {
+            ++visits;
+            object->ToGameObject()->RemoveFromGrid();
+            if (visits == 1)
+                cell.Add(50.0f, 0.0f, 2);
+            return true;
+        });
+
+        REQUIRE(visits == 14);
+        REQUIRE(cell.GetPositions().Size() == 8);
+        REQUIRE(FindInRange(cell.GetPositions(), 0.0f, 0.0f, 100.0f).empty());
+    }
+}
+
+TEST_CASE("World location setters update the grid positions", "[GridPositionStore]")
+{
+    TestCell cell;
+    GameObject& object = cell.Add(0.0f, 0.0f, PHASEMASK_NORMAL);
+
+    object.WorldRelocate(0, 100.0f, 100.0f, 0.0f, 0.0f);
+    REQUIRE(FindInRange(cell.GetPositions(), 0.0f, 0.0f, 5.0f).empty());
+    REQUIRE(FindInRange(cell.GetPositions(), 100.0f, 100.0f, 5.0f).size() == 1);
+
+    object.RelocateOffset({ 50.0f, 0.0f, 0.0f, 0.0f });
+    REQUIRE(FindInRange(cell.GetPositions(), 100.0f, 100.0f, 5.0f).empty());
+    REQUIRE(FindInRange(cell.GetPositions(), 150.0f, 100.0f, 5.0f).size() == 1);
+
+    object.WorldRelocate(WorldLocation(0, 20.0f, 20.0f));
+    REQUIRE(FindInRange(cell.GetPositions(), 20.0f, 20.0f, 5.0f).size() == 1);
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "MapRegionPartitioner.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    bool AreClose(CellCoord const& left, CellCoord const& right, uint32 separation)
+    {
+        uint32 dx = left.x_coord > right.x_coord ? left.x_coord - right.x_coord : right.x_coord - left.x_coord;
+        uint32 dy = left.y_coord > right.y_coord ? left.y_coord - right.y_coord : right.y_coord - left.y_coord;
+        return dx < separation && dy < separation;
+    }
+}
+
+TEST_CASE("Close anchors share a region", "[MapRegionPartitioner]")
+{
+    std::vector<CellCoord> anchors = { { 100, 100 }, { 104, 100 }, { 300, 300 }, { 108, 100 } };
+
+    std::vector<MapRegionPartitioner::Region> regions = MapRegionPartitioner::Partition(anchors, {}, 5);
+
+    REQUIRE(regions.size() == 2);
+    REQUIRE(regions[0] == MapRegionPartitioner::Region{ 0, 1, 3 });
+    REQUIRE(regions[1] == MapRegionPartitioner::Region{ 2 });
+}
+
+TEST_CASE("Links merge distant anchors", "[MapRegionPartitioner]")
+{
+    std::vector<CellCoord> anchors = { { 10, 10 }, { 200, 200 }, { 400, 400 } };
+
+    std::vector<MapRegionPartitioner::Region> regions = MapRegionPartitioner::Partition(anchors, { { 2, 0 } }, 5);
+
+    REQUIRE(regions.size() == 2);
+    REQUIRE(regions[0] == MapRegionPartitioner::Region{ 0, 2 });
+    REQUIRE(regions[1] == MapRegionPartitioner::Region{ 1 });
+}
+
+TEST_CASE("Required separation covers both activation areas", "[MapRegionPartitioner]")
+{
+    uint32 separation = MapRegionPartitioner::GetRequiredSeparation(90.0f, 150.0f);
+
+    REQUIRE(float(separation - 2) * SIZE_OF_GRID_CELL >= 2.0f * (90.0f + 150.0f));
+}
+
+TEST_CASE("Random anchors are partitioned deterministically into independent regions", "[MapRegionPartitioner]")
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32> cluster(0, 15);
+    std::uniform_int_distribution<uint32> offset(0, 40);
+
+    for (uint32 iteration = 0; iteration < 50; ++iteration)
+    {
+        uint32 const separation = 8;
+        std::vector<CellCoord> anchors;
+        for (uint32 i = 0; i < 500; ++i)
+            anchors.emplace_back(cluster(rng) * 32 + offset(rng) % 24, cluster(rng) * 32 + offset(rng) % 24);
+
+        std::vector<std::pair<std::size_t, std::size_t>> links;
+        for (uint32 i = 0; i < 20; ++i)
+            links.emplace_back(rng() % anchors.size(), rng() % anchors.size());
+
+        std::vector<MapRegionPartitioner::Region> regions = MapRegionPartitioner::Partition(anchors, links, separation);
+
+        // same input, same result
+        REQUIRE(regions == MapRegionPartitioner::Partition(anchors, links, separation));
+
+        // every anchor is in exactly one region
+        std::vector<std::size_t> regionOf(anchors.size(), regions.size());
+        for (std::size_t i = 0; i < regions.size(); ++i)
+        {
+            REQUIRE(std::is_sorted(regions[i].begin(), regions[i].end()));
+            if (i > 0)
+                REQUIRE(regions[i - 1].front() < regions[i].front());
+
+            for (std::size_t anchor : regions[i])
+            {
+                REQUIRE(regionOf[anchor] == regions.size());
+                regionOf[anchor] = i;
+            }
+        }
+
+        for (std::size_t region : regionOf)
+            REQUIRE(region < regions.size());
+
+        // anchors of different regions never come closer than the separation
+        for (std::size_t i = 0; i < anchors.size(); ++i)
+            for (std::size_t j = i + 1; j < anchors.size(); ++j)
+                if (AreClose(anchors[i], anchors[j], separation))
+                    REQUIRE(regionOf[i] == regionOf[j]);
+
+        for (std::pair<std::size_t, std::size_t> const& link : links)
+            REQUIRE(regionOf[link.first] == regionOf[link.second]);
+    }
+}
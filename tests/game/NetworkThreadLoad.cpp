@@ -0,0 +1,170 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "NetworkThread.h"
+#include "Socket.h"
+#include "SocketMgr.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    class TestSocket : public Socket<TestSocket>
+    {
+    public:
+        using Socket<TestSocket>::Socket;
+
+        void Start() override { }
+
+    protected:
+        void ReadHandler() override { }
+    };
+
+    // thread that is never started, its connections and load are set by the test
+    class TestNetworkThread : public NetworkThread<TestSocket>
+    {
+    public:
+        void AddConnections(int32 count)
+        {
+            for (int32 i = 0; i < count; ++i)
+                AddSocket(nullptr);
+        }
+
+        void MeasureLoad(std::chrono::nanoseconds busyTimePerSecond)
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            StartLoadWindow(now);
+            UpdateLoad(now + 1s, busyTimePerSecond);
+        }
+    };
+
+    class TestSocketMgr : public SocketMgr<TestSocket>
+    {
+    public:
+        explicit TestSocketMgr(int32 threadCount)
+        {
+            _threadCount = threadCount;
+            _threads = CreateThreads();
+        }
+
+        ~TestSocketMgr()
+        {
+            delete[] static_cast<TestNetworkThread*>(_threads);
+            _threads = nullptr;
+            _threadCount = 0;
+        }
+
+        TestNetworkThread& GetThread(int32 index) { return static_cast<TestNetworkThread*>(_threads)[index]; }
+
+    protected:
+        NetworkThread<TestSocket>* CreateThreads() const override { return new TestNetworkThread[_threadCount]; }
+    };
+}
+
+TEST_CASE("Network thread load is measured per second and smoothed", "[NetworkThread]")
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    NetworkThreadLoad load;
+    load.Start(start);
+    load.Add(start + 500ms, 100ms);
+    REQUIRE_FALSE(load.HasSamples());
+    REQUIRE(load.Get() == 0ns);
+
+    // the first window is taken as it is
+    load.Add(start + 1s, 150ms);
+    REQUIRE(load.HasSamples());
+    REQUIRE(load.Get() == 250ms);
+
+    // a window of two seconds counts busy time per second
+    load.Add(start + 1500ms, 0ns);
+    REQUIRE(load.Get() == 250ms);
+    load.Add(start + 3s, 500ms);
+    REQUIRE(load.Get() == 250ms);
+
+    // later windows count for a quarter
+    load.Add(start + 4s, 650ms);
+    REQUIRE(load.Get() == 350ms);
+    load.Add(start + 5s, 0ns);
+    REQUIRE(load.Get() == 262500us);
+}
+
+TEST_CASE("New sockets are placed on the network thread with the least load", "[NetworkThread]")
+{
+    TestSocketMgr mgr(3);
+    mgr.GetThread(0).AddConnections(3);
+    mgr.GetThread(1).AddConnections(1);
+    mgr.GetThread(2).AddConnections(2);
+
+    SECTION("connection count places sockets until every thread has measured its load")
+    {
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 1);
+
+        mgr.GetThread(0).MeasureLoad(1ms);
+        mgr.GetThread(2).MeasureLoad(1ms);
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 1);
+    }
+
+    SECTION("measured load wins over connection count")
+    {
+        mgr.GetThread(0).AddConnections(50);
+        mgr.GetThread(0).MeasureLoad(10ms);
+        mgr.GetThread(1).MeasureLoad(300ms);
+        mgr.GetThread(2).MeasureLoad(20ms);
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 0);
+    }
+
+    SECTION("sockets placed since the last measurement count as load")
+    {
+        mgr.GetThread(0).MeasureLoad(30ms);
+        mgr.GetThread(1).MeasureLoad(10ms);
+        mgr.GetThread(2).MeasureLoad(20ms);
+
+        // a new socket costs the average load of the measured sockets of its thread
+        mgr.GetThread(1).AddConnections(3);
+        REQUIRE(mgr.GetThread(1).GetLoadWithAddedSockets() == 40ms);
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 2);
+
+        // until the next measurement includes them
+        mgr.GetThread(1).MeasureLoad(10ms);
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 1);
+    }
+
+    SECTION("a burst of accepts on idle threads is spread over all of them")
+    {
+        mgr.GetThread(0).MeasureLoad(100us);
+        mgr.GetThread(1).MeasureLoad(50us);
+        mgr.GetThread(2).MeasureLoad(150us);
+
+        for (int32 i = 0; i < 300; ++i)
+            mgr.GetThread(mgr.SelectThreadWithMinLoad()).AddConnections(1);
+
+        REQUIRE(mgr.GetThread(0).GetConnectionCount() == 103);
+        REQUIRE(mgr.GetThread(1).GetConnectionCount() == 102);
+        REQUIRE(mgr.GetThread(2).GetConnectionCount() == 101);
+    }
+
+    SECTION("connection count breaks ties")
+    {
+        mgr.GetThread(0).MeasureLoad(50ms);
+        mgr.GetThread(1).MeasureLoad(200ms);
+        mgr.GetThread(2).MeasureLoad(50ms);
+        REQUIRE(mgr.SelectThreadWithMinLoad() == 2);
+    }
+}
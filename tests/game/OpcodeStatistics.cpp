@@ -0,0 +1,140 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "LockedQueue.h"
+#include "MPSCQueue.h"
+#include "OpcodeStatistics.h"
+#include "WorldPacket.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    OpcodeHandlerStatistics const* Find(std::vector<OpcodeHandlerStatistics> const& statistics, OpcodeClient opcode, OpcodeStatisticsContext context)
+    {
+        auto itr = std::find_if(statistics.begin(), statistics.end(), [&](OpcodeHandlerStatistics const& opcodeStatistics)
+        {
+            return opcodeStatistics.Opcode == opcode && opcodeStatistics.Context == context;
+        });
+
+        return itr != statistics.end() ? &*itr : nullptr;
+    }
+}
+
+TEST_CASE("Opcode statistics of all threads are summed up", "[OpcodeStatistics]")
+{
+    sOpcodeStatistics->Reset();
+
+    sOpcodeStatistics->Record(CMSG_MESSAGECHAT, OPCODE_STATISTICS_WORLD, 100us);
+    std::thread([]()
+    {
+        sOpcodeStatistics->Record(CMSG_MESSAGECHAT, OPCODE_STATISTICS_WORLD, 300us);
+        sOpcodeStatistics->Record(MSG_MOVE_HEARTBEAT, OPCODE_STATISTICS_MAP, 5us);
+    }).join();
+
+    std::vector<OpcodeHandlerStatistics> statistics = sOpcodeStatistics->Collect();
+    REQUIRE(statistics.size() == 2);
+
+    OpcodeHandlerStatistics const* chat = Find(statistics, CMSG_MESSAGECHAT, OPCODE_STATISTICS_WORLD);
+    REQUIRE(chat);
+    REQUIRE(chat->Count == 2);
+    REQUIRE(chat->TotalTime == 400us);
+    REQUIRE(chat->MaxTime == 300us);
+
+    OpcodeHandlerStatistics const* heartbeat = Find(statistics, MSG_MOVE_HEARTBEAT, OPCODE_STATISTICS_MAP);
+    REQUIRE(heartbeat);
+    REQUIRE(heartbeat->Count == 1);
+    REQUIRE(!Find(statistics, MSG_MOVE_HEARTBEAT, OPCODE_STATISTICS_WORLD));
+
+    SECTION("reset drops what every thread counted")
+    {
+        sOpcodeStatistics->Reset();
+        REQUIRE(sOpcodeStatistics->Collect().empty());
+
+        // counters of the exited thread are reused by the next thread
+        std::thread([]()
+        {
+            sOpcodeStatistics->Record(MSG_MOVE_HEARTBEAT, OPCODE_STATISTICS_MAP, 7us);
+        }).join();
+
+        statistics = sOpcodeStatistics->Collect();
+        REQUIRE(statistics.size() == 1);
+        REQUIRE(statistics[0].Count == 1);
+        REQUIRE(statistics[0].TotalTime == 7us);
+    }
+}
+
+TEST_CASE("Receiving packets from network threads", "[.][benchmark][OpcodeStatistics]")
+{
+    // 4 network threads queue packets for a session while it is updated
+    constexpr uint32 Producers = 4;
+    constexpr uint32 PacketsPerProducer = 25000;
+
+    BENCHMARK("LockedQueue")
+    {
+        LockedQueue<WorldPacket*> queue;
+        std::vector<std::thread> producers;
+        for (uint32 i = 0; i < Producers; ++i)
+            producers.emplace_back([&queue]() { for (uint32 j = 0; j < PacketsPerProducer; ++j) queue.add(new WorldPacket(CMSG_MESSAGECHAT, 0)); });
+
+        uint32 handled = 0;
+        WorldPacket* packet;
+        while (handled < Producers * PacketsPerProducer)
+        {
+            while (queue.next(packet))
+            {
+                delete packet;
+                ++handled;
+            }
+        }
+
+        for (std::thread& producer : producers)
+            producer.join();
+        return handled;
+    };
+
+    BENCHMARK("MPSCQueue drained in batches")
+    {
+        MPSCQueue<WorldPacket, &WorldPacket::QueueLink> queue;
+        std::vector<std::thread> producers;
+        for (uint32 i = 0; i < Producers; ++i)
+            producers.emplace_back([&queue]() { for (uint32 j = 0; j < PacketsPerProducer; ++j) queue.Enqueue(new WorldPacket(CMSG_MESSAGECHAT, 0)); });
+
+        uint32 handled = 0;
+        std::deque<WorldPacket*> batch;
+        WorldPacket* packet;
+        while (handled < Producers * PacketsPerProducer)
+        {
+            while (queue.Dequeue(packet))
+                batch.push_back(packet);
+
+            for (; !batch.empty(); batch.pop_front())
+            {
+                delete batch.front();
+                ++handled;
+            }
+        }
+
+        for (std::thread& producer : producers)
+            producer.join();
+        return handled;
+    };
+}
@@ -0,0 +1,197 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "PacketPool.h"
+#include "WorldPacket.h"
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST_CASE("Packet storage is reused", "[PacketPool]")
+{
+    SECTION("ByteBuffer returns its storage when destroyed")
+    {
+        uint8 const* storage;
+        {
+            WorldPacket packet(SMSG_MESSAGECHAT, 200);
+            packet << uint32(1);
+            storage = packet.contents();
+        }
+
+        WorldPacket packet(SMSG_MESSAGECHAT, 150);
+        packet << uint32(2);
+        REQUIRE(packet.contents() == storage);
+    }
+
+    SECTION("storage has at least the requested capacity")
+    {
+        for (std::size_t size : { 1, 64, 65, 200, 4096, 40000, 100000 })
+        {
+            std::vector<uint8> storage = PacketPool::AcquireStorage(size);
+            REQUIRE(storage.empty());
+            REQUIRE(storage.capacity() >= size);
+            PacketPool::ReleaseStorage(storage);
+            REQUIRE(storage.capacity() == 0);
+        }
+    }
+
+    SECTION("storage released by another thread is moved through the depot")
+    {
+        // empty this thread's cache and the depot of the size class
+        std::vector<std::vector<uint8>> held;
+        for (uint32 i = 0; i < 64; ++i)
+            held.push_back(PacketPool::AcquireStorage(30000));
+
+        std::set<uint8 const*> released;
+        std::thread([&released]()
+        {
+            for (uint32 i = 0; i < 8; ++i)
+            {
+                std::vector<uint8> storage = PacketPool::AcquireStorage(30000);
+                released.insert(storage.data());
+                PacketPool::ReleaseStorage(storage);
+            }
+        }).join();
+
+        std::vector<uint8> storage = PacketPool::AcquireStorage(30000);
+        REQUIRE(released.count(storage.data()) == 1);
+
+        PacketPool::ReleaseStorage(storage);
+        for (std::vector<uint8>& buffer : held)
+            PacketPool::ReleaseStorage(buffer);
+    }
+}
+
+TEST_CASE("Packet objects are reused", "[PacketPool]")
+{
+    WorldPacket* packet = new WorldPacket(SMSG_MESSAGECHAT);
+    void* memory = packet;
+    delete packet;
+
+    packet = new WorldPacket(CMSG_MESSAGECHAT);
+    REQUIRE(static_cast<void*>(packet) == memory);
+    delete packet;
+
+    std::shared_ptr<WorldPacket const> shared = MakeSharedWorldPacket(SMSG_MESSAGECHAT, 64);
+    REQUIRE(shared->GetOpcode() == SMSG_MESSAGECHAT);
+
+    // counters of a thread are published when it exits
+    PacketPool::Statistics before = PacketPool::GetObjectStatistics();
+    std::thread([]()
+    {
+        for (uint32 i = 0; i < 100; ++i)
+            delete new WorldPacket(SMSG_MESSAGECHAT);
+    }).join();
+
+    PacketPool::Statistics after = PacketPool::GetObjectStatistics();
+    REQUIRE(after.Hits + after.Misses - before.Hits - before.Misses == 100);
+    REQUIRE(after.Hits - before.Hits >= 99);
+    REQUIRE(after.BytesHeld > 0);
+}
+
+namespace
+{
+    // received packet without pooling, as allocated before PacketPool
+    struct UnpooledPacket
+    {
+        explicit UnpooledPacket(std::size_t size) { Storage.reserve(200); Storage.resize(size); }
+
+        std::vector<uint8> Storage;
+        uint16 Opcode = CMSG_MESSAGECHAT;
+        TimePoint ReceivedTime;
+    };
+
+    // network thread allocating received packets, map thread freeing them after handling
+    template<typename Packet, typename Allocate>
+    std::size_t ReceiveAndHandle(Allocate allocate)
+    {
+        std::mutex lock;
+        std::condition_variable queued;
+        std::condition_variable handledBatches;
+        std::vector<std::vector<Packet*>> queue;
+        bool done = false;
+
+        std::size_t handled = 0;
+        std::thread mapThread([&]()
+        {
+            for (;;)
+            {
+                std::vector<std::vector<Packet*>> batches;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    queued.wait(guard, [&]() { return done || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+
+                    batches.swap(queue);
+                }
+                handledBatches.notify_one();
+
+                for (std::vector<Packet*>& batch : batches)
+                {
+                    for (Packet* packet : batch)
+                        delete packet;
+
+                    handled += batch.size();
+                }
+            }
+        });
+
+        for (uint32 i = 0; i < 1000; ++i)
+        {
+            std::vector<Packet*> batch;
+            for (uint32 j = 0; j < 100; ++j)
+                batch.push_back(allocate(16 + j));
+
+            // map thread keeps up with the network thread, only a few batches are in flight
+            std::unique_lock<std::mutex> guard(lock);
+            handledBatches.wait(guard, [&]() { return queue.size() < 2; });
+            queue.push_back(std::move(batch));
+            queued.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            done = true;
+            queued.notify_one();
+        }
+
+        mapThread.join();
+        return handled;
+    }
+}
+
+TEST_CASE("Allocating received packets on one thread and freeing them on another", "[.][benchmark][PacketPool]")
+{
+    BENCHMARK("operator new and std::vector")
+    {
+        return ReceiveAndHandle<UnpooledPacket>([](std::size_t size) { return new UnpooledPacket(size); });
+    };
+
+    BENCHMARK("PacketPool")
+    {
+        return ReceiveAndHandle<WorldPacket>([](std::size_t size)
+        {
+            WorldPacket* packet = new WorldPacket(CMSG_MESSAGECHAT, 200);
+            packet->resize(size);
+            return packet;
+        });
+    };
+}
@@ -0,0 +1,209 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "MapRegionPartitioner.h"
+#include "ParallelRegionUpdate.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    struct TestObject
+    {
+        float X;
+        float Y;
+        float Step;
+        uint32 Zone;
+    };
+
+    uint32 GetZone(float x)
+    {
+        return uint32(std::floor((x + 10000.0f) / 100.0f));
+    }
+
+    // what outdoor pvp and battlefield managers see of a zone change, only touched from deferred tasks
+    struct ZoneEvent
+    {
+        std::size_t Object;
+        bool Enter;
+        uint32 Zone;
+    };
+}
+
+TEST_CASE("Objects crossing region boundaries keep shared state consistent", "[ParallelRegionUpdate]")
+{
+    Trinity::ThreadPool pool(3);
+    ParallelRegionUpdate update;
+
+    // pairs of objects start in separate regions, walk into each other's region and out again on the other side
+    std::vector<TestObject> objects;
+    for (std::size_t i = 0; i < 40; ++i)
+    {
+        float x = -8000.0f + float(i) * 400.0f;
+        objects.push_back({ x, 100.0f, (i % 2) ? -40.0f : 40.0f, GetZone(x) });
+    }
+
+    std::unordered_map<uint32, uint32> zonePlayerCount;
+    std::vector<ZoneEvent> zoneEvents;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        ++zonePlayerCount[objects[i].Zone];
+        zoneEvents.push_back({ i, true, objects[i].Zone });
+    }
+
+    std::unordered_set<std::size_t> regionCounts;
+    std::atomic<uint32> unlockedAccesses(0);
+    std::atomic<uint32> tasksDuringUpdate(0);
+    for (uint32 tick = 0; tick < 20; ++tick)
+    {
+        std::vector<CellCoord> anchors;
+        for (TestObject const& object : objects)
+            anchors.push_back(Trinity::ComputeCellCoord(object.X, object.Y));
+
+        std::vector<MapRegionPartitioner::Region> regions = MapRegionPartitioner::Partition(anchors, {}, 2);
+        regionCounts.insert(regions.size());
+
+        std::atomic<std::size_t> deferredTasks(0);
+        std::atomic<std::size_t> deferredBroadcasts(0);
+        std::vector<std::size_t> broadcastOrder;
+        std::size_t tasksRun = 0;
+        update.Run(pool, regions.size(), [&](std::size_t region)
+        {
+            for (std::size_t i : regions[region])
+            {
+                TestObject& object = objects[i];
+                object.X += object.Step;
+
+                uint32 newZone = GetZone(object.X);
+                if (newZone == object.Zone)
+                    continue;
+
+                uint32 oldZone = object.Zone;
+                object.Zone = newZone;
+
+                // Map::UpdatePlayerZoneStats
+                {
+                    std::unique_lock<std::recursive_mutex> lock = update.AcquireLock();
+                    if (!lock.owns_lock())
+                        ++unlockedAccesses;
+
+                    --zonePlayerCount[oldZone];
+                    ++zonePlayerCount[newZone];
+                }
+
+                // Player::UpdateZone
+                update.Defer([&, i, oldZone]()
+                {
+                    if (update.IsActive())
+                        ++tasksDuringUpdate;
+                    zoneEvents.push_back({ i, false, oldZone });
+                    ++tasksRun;
+                });
+                update.Defer([&, i, newZone]()
+                {
+                    if (update.IsActive())
+                        ++tasksDuringUpdate;
+                    zoneEvents.push_back({ i, true, newZone });
+                    ++tasksRun;
+                });
+                update.DeferBroadcast([&]()
+                {
+                    broadcastOrder.push_back(tasksRun);
+                });
+                deferredTasks += 2;
+                ++deferredBroadcasts;
+            }
+        });
+
+        REQUIRE_FALSE(update.IsActive());
+        REQUIRE_FALSE(update.AcquireLock().owns_lock());
+        REQUIRE(tasksRun == 0);
+
+        ParallelRegionUpdate::DeferredCounts counts = update.RunDeferred();
+        REQUIRE(counts.Tasks == deferredTasks);
+        REQUIRE(counts.Broadcasts == deferredBroadcasts);
+        REQUIRE(tasksRun == deferredTasks);
+
+        // broadcasts go out after every task ran
+        for (std::size_t order : broadcastOrder)
+            REQUIRE(order == deferredTasks);
+
+        REQUIRE(update.RunDeferred().Tasks == 0);
+    }
+
+    REQUIRE(unlockedAccesses == 0);
+    REQUIRE(tasksDuringUpdate == 0);
+
+    // the objects did cross region boundaries: pairs merged into one region and split again
+    REQUIRE(regionCounts.size() > 1);
+
+    std::unordered_map<uint32, uint32> expectedCount;
+    for (TestObject const& object : objects)
+        ++expectedCount[object.Zone];
+
+    for (std::pair<uint32 const, uint32> const& zoneCount : zonePlayerCount)
+        REQUIRE(zoneCount.second == expectedCount[zoneCount.first]);
+
+    // every object left the zone it entered last, in order
+    std::vector<std::vector<ZoneEvent>> eventsByObject(objects.size());
+    for (ZoneEvent const& zoneEvent : zoneEvents)
+        eventsByObject[zoneEvent.Object].push_back(zoneEvent);
+
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        std::vector<ZoneEvent> const& events = eventsByObject[i];
+        REQUIRE(events.size() % 2 == 1);
+        REQUIRE(events.size() > 1);
+        for (std::size_t j = 0; j < events.size(); ++j)
+        {
+            REQUIRE(events[j].Enter == (j % 2 == 0));
+            if (j % 2)
+                REQUIRE(events[j].Zone == events[j - 1].Zone);
+            else if (j)
+                REQUIRE(events[j].Zone != events[j - 1].Zone);
+        }
+
+        REQUIRE(events.back().Zone == objects[i].Zone);
+    }
+
+    pool.Join();
+}
+
+TEST_CASE("A failing region does not leave the update active", "[ParallelRegionUpdate]")
+{
+    Trinity::ThreadPool pool(2);
+    ParallelRegionUpdate update;
+
+    std::atomic<uint32> updatedRegions(0);
+    REQUIRE_THROWS_AS(update.Run(pool, 4, [&](std::size_t region)
+    {
+        ++updatedRegions;
+        if (region == 2)
+            throw std::runtime_error("region failed");
+    }), std::runtime_error);
+
+    REQUIRE(updatedRegions == 4);
+    REQUIRE_FALSE(update.IsActive());
+
+    pool.Join();
+}
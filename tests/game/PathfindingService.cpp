@@ -0,0 +1,362 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "DetourCommon.h"
+#include "DetourNavMeshBuilder.h"
+#include "MMapFactory.h"
+#include "MMapManager.h"
+#include "MapDefines.h"
+#include "PathfindingService.h"
+#include "PathGenerator.h"
+#include "StringFormat.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint32 TestMapId = 9000;
+    constexpr int32 GridCells = 64;
+    constexpr float CellSize = 2.0f;
+
+    bool IsWall(int32 x, int32 z)
+    {
+        // walls every 8 cells with gaps at alternating ends, paths have to go around them
+        if (x % 8 != 7)
+            return false;
+
+        return (x / 8) % 2 ? z >= GridCells - 20 : z < 20;
+    }
+
+    // one tile of 2x2 yard quads written as .mmap and .mmtile, loaded through MMapManager
+    struct TestNavMesh
+    {
+        TestNavMesh() : BasePath((std::filesystem::temp_directory_path() / "tc_pathfinding_test").string() + "/")
+        {
+            std::filesystem::create_directories(BasePath + "mmaps");
+
+            std::vector<unsigned short> verts;
+            for (int32 z = 0; z <= GridCells; ++z)
+                for (int32 x = 0; x <= GridCells; ++x)
+                    verts.insert(verts.end(), { uint16(x), 0, uint16(z) });
+
+            int32 const nvp = DT_VERTS_PER_POLYGON;
+            std::vector<int32> polyIndex(GridCells * GridCells, -1);
+            int32 polyCount = 0;
+            for (int32 z = 0; z < GridCells; ++z)
+                for (int32 x = 0; x < GridCells; ++x)
+                    if (!IsWall(x, z))
+                        polyIndex[z * GridCells + x] = polyCount++;
+
+            auto vertex = [](int32 x, int32 z) { return uint16(z * (GridCells + 1) + x); };
+            auto neighbour = [&](int32 x, int32 z) -> uint16
+            {
+                if (x < 0 || z < 0 || x >= GridCells || z >= GridCells || polyIndex[z * GridCells + x] < 0)
+                    return 0xffff;
+                return uint16(polyIndex[z * GridCells + x]);
+            };
+
+            std::vector<unsigned short> polys(polyCount * nvp * 2, 0xffff);
+            for (int32 z = 0; z < GridCells; ++z)
+            {
+                for (int32 x = 0; x < GridCells; ++x)
+                {
+                    int32 index = polyIndex[z * GridCells + x];
+                    if (index < 0)
+                        continue;
+
+                    unsigned short* poly = &polys[index * nvp * 2];
+                    poly[0] = vertex(x, z);
+                    poly[1] = vertex(x, z + 1);
+                    poly[2] = vertex(x + 1, z + 1);
+                    poly[3] = vertex(x + 1, z);
+                    poly[nvp + 0] = neighbour(x - 1, z);
+                    poly[nvp + 1] = neighbour(x, z + 1);
+                    poly[nvp + 2] = neighbour(x + 1, z);
+                    poly[nvp + 3] = neighbour(x, z - 1);
+                }
+            }
+
+            std::vector<unsigned short> flags(polyCount, NAV_GROUND);
+            std::vector<unsigned char> areas(polyCount, 0);
+
+            dtNavMeshCreateParams params = { };
+            params.verts = verts.data();
+            params.vertCount = int32(verts.size() / 3);
+            params.polys = polys.data();
+            params.polyFlags = flags.data();
+            params.polyAreas = areas.data();
+            params.polyCount = polyCount;
+            params.nvp = nvp;
+            params.walkableHeight = 2.0f;
+            params.walkableRadius = 0.5f;
+            params.walkableClimb = 1.0f;
+            params.bmax[0] = GridCells * CellSize;
+            params.bmax[1] = 1.0f;
+            params.bmax[2] = GridCells * CellSize;
+            params.cs = CellSize;
+            params.ch = CellSize;
+            params.buildBvTree = true;
+
+            unsigned char* data = nullptr;
+            int32 dataSize = 0;
+            REQUIRE(dtCreateNavMeshData(&params, &data, &dataSize));
+
+            dtNavMeshParams meshParams = { };
+            meshParams.tileWidth = GridCells * CellSize;
+            meshParams.tileHeight = GridCells * CellSize;
+            meshParams.maxTiles = 1;
+            meshParams.maxPolys = 1 << 14;
+
+            FILE* map = fopen(Trinity::StringFormat("{}mmaps/{:03}.mmap", BasePath, TestMapId).c_str(), "wb");
+            REQUIRE(map);
+            fwrite(&meshParams, sizeof(meshParams), 1, map);
+            fclose(map);
+
+            MmapTileHeader header;
+            header.size = uint32(dataSize);
+            FILE* tile = fopen(Trinity::StringFormat("{}mmaps/{:03}0000.mmtile", BasePath, TestMapId).c_str(), "wb");
+            REQUIRE(tile);
+            fwrite(&header, sizeof(header), 1, tile);
+            fwrite(data, dataSize, 1, tile);
+            fclose(tile);
+            dtFree(data);
+
+            REQUIRE(MMAP::MMapFactory::createOrGetMMapManager()->loadMap(BasePath, TestMapId, 0, 0));
+            Query = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(TestMapId);
+            REQUIRE(Query);
+
+            Filter.setIncludeFlags(NAV_GROUND);
+        }
+
+        ~TestNavMesh()
+        {
+            sPathfindingService->UnloadMap(TestMapId);
+            sPathfindingService->Unload();
+
+            std::error_code error;
+            std::filesystem::remove_all(BasePath, error);
+        }
+
+        dtPolyRef FindPoly(float const* point) const
+        {
+            float const extents[VERTEX_SIZE] = { 2.0f, 4.0f, 2.0f };
+            dtPolyRef poly = INVALID_POLYREF;
+            Query->findNearestPoly(point, extents, &Filter, &poly, nullptr);
+            return poly;
+        }
+
+        std::string BasePath;
+        dtNavMeshQuery const* Query = nullptr;
+        dtQueryFilter Filter;
+    };
+
+    struct ChaseRequest
+    {
+        float Start[VERTEX_SIZE];
+        float End[VERTEX_SIZE];
+    };
+
+    // Packs of chasers following targets wandering around the walls, one request per chaser and update
+    std::vector<std::vector<ChaseRequest>> RecordChaseScenario(uint32 targets, uint32 chasersPerTarget, uint32 updates)
+    {
+        std::mt19937 random(20240611);
+        std::uniform_real_distribution<float> position(1.0f, GridCells * CellSize - 1.0f);
+        std::uniform_real_distribution<float> spread(-3.0f, 3.0f);
+        std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+
+        auto clamp = [](float value) { return std::min(std::max(value, 1.0f), GridCells * CellSize - 1.0f); };
+        auto walkable = [&](float x, float z) { return !IsWall(int32(x / CellSize), int32(z / CellSize)); };
+        auto randomPoint = [&](float& x, float& z)
+        {
+            do
+            {
+                x = position(random);
+                z = position(random);
+            } while (!walkable(x, z));
+        };
+
+        std::vector<std::array<float, 2>> targetPositions(targets);
+        std::vector<std::array<float, 2>> chaserPositions(targets * chasersPerTarget);
+        for (uint32 i = 0; i < targets; ++i)
+        {
+            randomPoint(targetPositions[i][0], targetPositions[i][1]);
+            for (uint32 j = 0; j < chasersPerTarget; ++j)
+                randomPoint(chaserPositions[i * chasersPerTarget + j][0], chaserPositions[i * chasersPerTarget + j][1]);
+        }
+
+        std::vector<std::vector<ChaseRequest>> scenario(updates);
+        for (uint32 update = 0; update < updates; ++update)
+        {
+            for (uint32 i = 0; i < targets; ++i)
+            {
+                float x = clamp(targetPositions[i][0] + step(random));
+                float z = clamp(targetPositions[i][1] + step(random));
+                if (walkable(x, z))
+                    targetPositions[i] = { x, z };
+
+                for (uint32 j = 0; j < chasersPerTarget; ++j)
+                {
+                    std::array<float, 2>& chaser = chaserPositions[i * chasersPerTarget + j];
+                    ChaseRequest request = { { chaser[0], 0.0f, chaser[1] }, { targetPositions[i][0], 0.0f, targetPositions[i][1] } };
+                    scenario[update].push_back(request);
+
+                    // the pack closes in, staying a few yards apart
+                    float nextX = clamp(chaser[0] + (targetPositions[i][0] - chaser[0]) * 0.2f + spread(random) * 0.2f);
+                    float nextZ = clamp(chaser[1] + (targetPositions[i][1] - chaser[1]) * 0.2f + spread(random) * 0.2f);
+                    if (walkable(nextX, nextZ))
+                        chaser = { nextX, nextZ };
+                }
+            }
+        }
+
+        return scenario;
+    }
+}
+
+TEST_CASE("Navmesh corridors are cached and shared", "[PathfindingService]")
+{
+    TestNavMesh mesh;
+    sPathfindingService->Initialize(2, 16, Milliseconds(60000));
+
+    float const start[VERTEX_SIZE] = { 3.0f, 0.0f, 3.0f };
+    float const end[VERTEX_SIZE] = { 21.0f, 0.0f, 3.0f };
+    dtPolyRef startPoly = mesh.FindPoly(start);
+    dtPolyRef endPoly = mesh.FindPoly(end);
+    REQUIRE(startPoly != INVALID_POLYREF);
+    REQUIRE(endPoly != INVALID_POLYREF);
+
+    std::shared_ptr<NavMeshSearch const> first = sPathfindingService->RequestSearch(TestMapId, startPoly, endPoly, start, end, mesh.Filter, MAX_PATH_LENGTH);
+    std::shared_ptr<NavMeshSearch const> second = sPathfindingService->RequestSearch(TestMapId, startPoly, endPoly, start, end, mesh.Filter, MAX_PATH_LENGTH);
+    REQUIRE(first);
+    REQUIRE(second);
+    while (!first->IsDone() || !second->IsDone())
+        std::this_thread::yield();
+
+    // the wall in between is open from 40 yards on
+    REQUIRE(dtStatusSucceed(first->GetStatus()));
+    REQUIRE(first->GetPath().size() > 30);
+    REQUIRE(first->GetPath().front() == startPoly);
+    REQUIRE(first->GetPath().back() == endPoly);
+    REQUIRE(second->GetPath() == first->GetPath());
+
+    dtPolyRef path[MAX_PATH_LENGTH];
+    REQUIRE(sPathfindingService->FindCachedPath(TestMapId, startPoly, endPoly, mesh.Filter, path, MAX_PATH_LENGTH) == first->GetPath().size());
+    REQUIRE(std::equal(first->GetPath().begin(), first->GetPath().end(), path));
+
+    // shorter buffers get the start of the corridor
+    REQUIRE(sPathfindingService->FindCachedPath(TestMapId, startPoly, endPoly, mesh.Filter, path, 10) == 10);
+
+    SECTION("other filters do not share corridors")
+    {
+        dtQueryFilter swimming;
+        swimming.setIncludeFlags(NAV_WATER);
+        REQUIRE(sPathfindingService->FindCachedPath(TestMapId, startPoly, endPoly, swimming, path, MAX_PATH_LENGTH) == 0);
+    }
+
+    SECTION("oldest corridors are dropped first")
+    {
+        for (dtPolyRef poly = 1; poly <= 16; ++poly)
+            sPathfindingService->CachePath(TestMapId, poly, poly, mesh.Filter, &poly, 1);
+
+        REQUIRE(sPathfindingService->FindCachedPath(TestMapId, startPoly, endPoly, mesh.Filter, path, MAX_PATH_LENGTH) == 0);
+        REQUIRE(sPathfindingService->FindCachedPath(TestMapId, 16, 16, mesh.Filter, path, MAX_PATH_LENGTH) == 1);
+    }
+}
+
+TEST_CASE("Replaying chase scenarios", "[.][benchmark][PathfindingService]")
+{
+    TestNavMesh mesh;
+    std::vector<std::vector<ChaseRequest>> scenario = RecordChaseScenario(40, 5, 50);
+
+    // what every chasing unit did before: its own search on the map thread
+    BENCHMARK("synchronous search per unit")
+    {
+        std::size_t polys = 0;
+        dtPolyRef path[MAX_PATH_LENGTH];
+        for (std::vector<ChaseRequest> const& update : scenario)
+        {
+            for (ChaseRequest const& request : update)
+            {
+                int32 length = 0;
+                mesh.Query->findPath(mesh.FindPoly(request.Start), mesh.FindPoly(request.End), request.Start, request.End, &mesh.Filter, path, &length, MAX_PATH_LENGTH);
+                polys += length;
+            }
+        }
+        return polys;
+    };
+
+    for (uint32 threads : { 0, 2 })
+    {
+        // the results of an update are collected on the next one, like movement generators poll them
+        BENCHMARK(Trinity::StringFormat("pathfinding service, {} threads", threads))
+        {
+            sPathfindingService->Initialize(threads, 4096, Milliseconds(2000));
+
+            std::size_t polys = 0;
+            dtPolyRef path[MAX_PATH_LENGTH];
+            std::vector<std::shared_ptr<NavMeshSearch const>> pending;
+            for (std::vector<ChaseRequest> const& update : scenario)
+            {
+                for (std::shared_ptr<NavMeshSearch const> const& search : pending)
+                {
+                    while (!search->IsDone())
+                        std::this_thread::yield();
+                    polys += search->GetPath().size();
+                }
+                pending.clear();
+
+                for (ChaseRequest const& request : update)
+                {
+                    dtPolyRef startPoly = mesh.FindPoly(request.Start);
+                    dtPolyRef endPoly = mesh.FindPoly(request.End);
+                    if (uint32 length = sPathfindingService->FindCachedPath(TestMapId, startPoly, endPoly, mesh.Filter, path, MAX_PATH_LENGTH))
+                        polys += length;
+                    else if (std::shared_ptr<NavMeshSearch const> search = sPathfindingService->RequestSearch(TestMapId, startPoly, endPoly, request.Start, request.End, mesh.Filter, MAX_PATH_LENGTH))
+                        pending.push_back(std::move(search));
+                    else
+                    {
+                        int32 found = 0;
+                        if (dtStatusSucceed(mesh.Query->findPath(startPoly, endPoly, request.Start, request.End, &mesh.Filter, path, &found, MAX_PATH_LENGTH)))
+                            sPathfindingService->CachePath(TestMapId, startPoly, endPoly, mesh.Filter, path, found);
+                        polys += found;
+                    }
+                }
+            }
+
+            for (std::shared_ptr<NavMeshSearch const> const& search : pending)
+            {
+                while (!search->IsDone())
+                    std::this_thread::yield();
+                polys += search->GetPath().size();
+            }
+
+            return polys;
+        };
+    }
+
+    INFO("cache hits " << sPathfindingService->GetCacheHits() << ", misses " << sPathfindingService->GetCacheMisses() << ", coalesced " << sPathfindingService->GetCoalescedRequests());
+    REQUIRE(sPathfindingService->GetCacheHits() > 0);
+}
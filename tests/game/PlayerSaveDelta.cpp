@@ -0,0 +1,516 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "CharacterDatabase.h"
+#include "DummyData.h"
+#include "Player.h"
+#include "PlayerSaveDelta.h"
+#include "PreparedStatement.h"
+#include "SpellAuraEffects.h"
+#include "SpellAuras.h"
+#include "SpellMgr.h"
+#include "World.h"
+#include "WorldSession.h"
+#include <memory>
+#include <random>
+
+namespace
+{
+    struct TestRow
+    {
+        int32 Amount;
+        int32 Duration;
+
+        bool operator==(TestRow const& right) const = default;
+    };
+
+    using TestRows = DeltaSaveRows<uint32, TestRow>;
+
+    /// Applies the statements of a save to a table the way the database would
+    struct Table
+    {
+        std::map<uint32, TestRow> Rows;
+        uint32 Statements = 0;
+
+        DeltaSaveResult Save(TestRows& saveRows, TestRows::RowMap const& current)
+        {
+            return saveRows.Save(current,
+                [&](uint32 key, TestRow const& row) { Rows[key] = row; ++Statements; },
+                [&](uint32 key) { Rows.erase(key); ++Statements; },
+                [&]() { Rows.clear(); ++Statements; });
+        }
+    };
+
+    /// The statements Player writes for character_aura, character_glyphs and character_stats
+    struct StatementInfo
+    {
+        char const* Table;
+        uint8 Parameters;       // placeholders of the SQL in CharacterDatabase.cpp
+        bool Replace;           // REPLACE of a whole row, otherwise DELETE of the rows starting with all parameters
+        uint8 KeyColumns;       // primary key, the leading columns of the row
+    };
+
+    std::map<uint32, StatementInfo> const Statements =
+    {
+        { CHAR_REP_AURA,                { "character_aura",   18, true,  5 } },
+        { CHAR_DEL_CHAR_AURA_BY_KEY,    { "character_aura",    5, false, 5 } },
+        { CHAR_DEL_CHAR_AURA,           { "character_aura",    1, false, 5 } },
+        { CHAR_REP_CHAR_GLYPHS,         { "character_glyphs",  8, true,  2 } },
+        { CHAR_DEL_CHAR_GLYPHS_BY_SPEC, { "character_glyphs",  2, false, 2 } },
+        { CHAR_DEL_CHAR_GLYPHS,         { "character_glyphs",  1, false, 2 } },
+        { CHAR_REP_CHAR_STATS,          { "character_stats",  31, true,  1 } },
+        { CHAR_DEL_CHAR_STATS,          { "character_stats",   1, false, 1 } }
+    };
+
+    /// Runs the statements against tables kept in memory, rows are the parameter values as text
+    struct TestDatabase
+    {
+        typedef std::vector<std::string> Values;
+        std::map<std::string, std::map<Values, Values>> Tables;
+        uint32 Executed = 0;
+
+        static Values GetValues(PreparedStatementBase const* stmt)
+        {
+            Values values;
+            for (PreparedStatementData const& parameter : stmt->GetParameters())
+                values.push_back(std::visit([](auto const& value) { return PreparedStatementData::ToString(value); }, parameter.data));
+            return values;
+        }
+
+        void Execute(CharacterDatabasePreparedStatement const* stmt)
+        {
+            StatementInfo const& info = Statements.at(stmt->GetIndex());
+            std::map<Values, Values>& table = Tables[info.Table];
+            Values values = GetValues(stmt);
+            ++Executed;
+
+            if (info.Replace)
+            {
+                table[Values(values.begin(), values.begin() + info.KeyColumns)] = values;
+                return;
+            }
+
+            std::erase_if(table, [&](std::pair<Values const, Values> const& row)
+            {
+                return std::equal(values.begin(), values.end(), row.first.begin());
+            });
+        }
+
+        /// Statements are collected until the transaction is committed
+        DeltaSaveStatements GetStatements(std::vector<std::unique_ptr<CharacterDatabasePreparedStatement>>& transaction)
+        {
+            return
+            {
+                [](uint32 index) { return new CharacterDatabasePreparedStatement(index, Statements.at(index).Parameters); },
+                [&transaction](CharacterDatabasePreparedStatement* stmt) { transaction.emplace_back(stmt); }
+            };
+        }
+
+        void Commit(std::vector<std::unique_ptr<CharacterDatabasePreparedStatement>>& transaction)
+        {
+            for (std::unique_ptr<CharacterDatabasePreparedStatement> const& stmt : transaction)
+                Execute(stmt.get());
+            transaction.clear();
+        }
+    };
+
+    /// Copies the remaining time of the auras in full into delta, where it may be longer by less than tolerance
+    void RequireSameRows(TestDatabase delta, TestDatabase const& full, int32 durationTolerance)
+    {
+        std::size_t const remainTime = 14;
+        auto fullAuras = full.Tables.find("character_aura");
+        auto deltaAuras = delta.Tables.find("character_aura");
+        if (fullAuras != full.Tables.end() && deltaAuras != delta.Tables.end())
+        {
+            for (auto& [key, values] : deltaAuras->second)
+            {
+                auto fullRow = fullAuras->second.find(key);
+                if (fullRow == fullAuras->second.end())
+                    continue;
+
+                int32 ranDown = std::stoi(values[remainTime]) - std::stoi(fullRow->second[remainTime]);
+                REQUIRE(ranDown >= 0);
+                REQUIRE(ranDown < std::max(durationTolerance, 1));
+                values[remainTime] = fullRow->second[remainTime];
+            }
+        }
+
+        REQUIRE(delta.Tables == full.Tables);
+    }
+
+    /// A character not in world, saved by Player::SaveDeltaSaveRows
+    class TestCharacter
+    {
+    public:
+        explicit TestCharacter(ObjectGuid::LowType guid) : _session(guid, "player", nullptr, SEC_PLAYER, 2, 0, Minutes(0), LOCALE_enUS, 0, false)
+        {
+            UnitTestDataLoader::LoadEmptyPermissions(_session);
+            _player = std::make_unique<Player>(&_session);
+            _player->_Create(guid, HighGuid::Player, PHASEMASK_NORMAL);
+            _player->SetUInt32Value(UNIT_FIELD_LEVEL, 80);
+        }
+
+        ~TestCharacter()
+        {
+            _player->RemoveAllAuras();
+        }
+
+        Player& GetPlayer() { return *_player; }
+
+        // other casters are looked up on the map, the character is not on one
+        Aura* Cast(ObjectGuid castItem, uint8 effectMask, int32 duration)
+        {
+            Aura* aura = FindAura(castItem, effectMask);
+            if (!aura)
+            {
+                AuraCreateInfo createInfo(sSpellMgr->AssertSpellInfo(974), effectMask, _player.get());
+                createInfo
+                    .SetCasterGUID(_player->GetGUID())
+                    .SetCastItemGUID(castItem);
+                aura = Aura::TryCreate(createInfo);
+                REQUIRE(aura);
+            }
+
+            aura->SetMaxDuration(duration);
+            aura->SetDuration(duration);
+            return aura;
+        }
+
+        void RunDown(int32 duration)
+        {
+            for (auto const& [spellId, aura] : _player->GetOwnedAuras())
+                if (aura->GetDuration() > duration)
+                    aura->SetDuration(aura->GetDuration() - duration);
+        }
+
+        // what happens between two autosaves: auras are cast, dispelled and run down by a second, glyphs and stats change
+        void Change(std::mt19937& rng)
+        {
+            std::uniform_int_distribution<uint32> values(0, 9);
+            for (uint32 change = 0; change < 4; ++change)
+            {
+                ObjectGuid castItem = values(rng) < 3 ? ObjectGuid::Empty : ObjectGuid::Create<HighGuid::Item>(values(rng) + 1);
+                uint8 effectMask = uint8(1 + values(rng) % 3);
+                Aura* aura = FindAura(castItem, effectMask);
+                switch (values(rng) % 4)
+                {
+                    case 0:
+                        if (aura)
+                            aura->Remove();
+                        break;
+                    case 1:
+                        aura = Cast(castItem, effectMask, values(rng) < 5 ? -1 : 30000);
+                        aura->SetCharges(uint8(1 + values(rng)));
+                        break;
+                    case 2:
+                        if (aura)
+                            aura->GetEffect(effectMask & 1 ? EFFECT_0 : EFFECT_1)->SetAmount(int32(values(rng)));
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            RunDown(1000);
+
+            // dual spec is learned and lost again, glyphs are changed now and then
+            _player->SetSpecsCount(values(rng) < 8 ? 2 : 1);
+            for (uint8 spec = 0; spec < _player->GetSpecsCount(); ++spec)
+            {
+                if (values(rng) >= 2)
+                    continue;
+
+                _player->SetActiveSpec(spec);
+                _player->SetGlyph(values(rng) % MAX_GLYPH_SLOT_INDEX, 700 + values(rng));
+            }
+            _player->SetActiveSpec(0);
+
+            _player->SetMaxHealth(10000 + values(rng));
+            _player->SetStat(STAT_STAMINA, 500 + values(rng) % 2);
+            _player->SetFloatValue(PLAYER_CRIT_PERCENTAGE, 5.0f + values(rng) % 2);
+        }
+
+    private:
+        Aura* FindAura(ObjectGuid castItem, uint8 effectMask)
+        {
+            for (auto const& [spellId, aura] : _player->GetOwnedAuras())
+                if (aura->GetCastItemGUID() == castItem && aura->GetEffectMask() == effectMask)
+                    return aura;
+
+            return nullptr;
+        }
+
+        WorldSession _session;
+        std::unique_ptr<Player> _player;
+    };
+
+    /// Config of the saves, restored when the test ends
+    struct SaveConfig
+    {
+        SaveConfig() : _delta(sWorld->getBoolConfig(CONFIG_PLAYER_SAVE_DELTA)), _minLevel(sWorld->getIntConfig(CONFIG_MIN_LEVEL_STAT_SAVE)),
+            _interval(sWorld->getIntConfig(CONFIG_INTERVAL_SAVE))
+        {
+            sWorld->setIntConfig(CONFIG_MIN_LEVEL_STAT_SAVE, 1);
+            sWorld->setIntConfig(CONFIG_INTERVAL_SAVE, DurationTolerance);
+        }
+
+        ~SaveConfig()
+        {
+            sWorld->setBoolConfig(CONFIG_PLAYER_SAVE_DELTA, _delta);
+            sWorld->setIntConfig(CONFIG_MIN_LEVEL_STAT_SAVE, _minLevel);
+            sWorld->setIntConfig(CONFIG_INTERVAL_SAVE, _interval);
+        }
+
+        static constexpr int32 DurationTolerance = 5000;
+
+    private:
+        bool _delta;
+        uint32 _minLevel;
+        uint32 _interval;
+    };
+}
+
+TEST_CASE("DeltaSaveRows", "[DeltaSaveRows]")
+{
+    TestRows saveRows;
+    Table table;
+    // rows of the character from a previous session that do not exist anymore
+    table.Rows[99] = { 1, 1 };
+
+    SECTION("First save rewrites the table")
+    {
+        DeltaSaveResult result = table.Save(saveRows, { { 1, { 10, 100 } }, { 2, { 20, -1 } } });
+        REQUIRE(table.Rows == TestRows::RowMap{ { 1, { 10, 100 } }, { 2, { 20, -1 } } });
+        REQUIRE(result.Written == 3);
+        REQUIRE(result.Avoided == 0);
+        REQUIRE(table.Statements == 3);
+        REQUIRE(saveRows.IsSynchronized());
+    }
+
+    SECTION("Unchanged rows are skipped")
+    {
+        table.Save(saveRows, { { 1, { 10, 100 } }, { 2, { 20, -1 } } });
+        table.Statements = 0;
+
+        DeltaSaveResult result = table.Save(saveRows, { { 1, { 10, 90 } }, { 2, { 20, -1 } }, { 3, { 30, -1 } } });
+        REQUIRE(table.Rows == TestRows::RowMap{ { 1, { 10, 90 } }, { 2, { 20, -1 } }, { 3, { 30, -1 } } });
+        REQUIRE(result.Written == 2);
+        REQUIRE(result.Avoided == 2);
+        REQUIRE(table.Statements == 2);
+
+        result = table.Save(saveRows, { { 1, { 10, 90 } }, { 2, { 20, -1 } }, { 3, { 30, -1 } } });
+        REQUIRE(result.Written == 0);
+        REQUIRE(result.Avoided == 4);
+    }
+
+    SECTION("Removed rows are deleted")
+    {
+        table.Save(saveRows, { { 1, { 10, 100 } }, { 2, { 20, -1 } } });
+
+        DeltaSaveResult result = table.Save(saveRows, { { 2, { 20, -1 } } });
+        REQUIRE(table.Rows == TestRows::RowMap{ { 2, { 20, -1 } } });
+        REQUIRE(result.Written == 1);
+    }
+
+    SECTION("Rewrite is used when the difference is larger")
+    {
+        TestRows::RowMap rows;
+        for (uint32 i = 0; i < 10; ++i)
+            rows[i] = { int32(i), -1 };
+        table.Save(saveRows, rows);
+
+        DeltaSaveResult result = table.Save(saveRows, {});
+        REQUIRE(table.Rows.empty());
+        REQUIRE(result.Written == 1);
+        REQUIRE(result.Avoided == 0);
+    }
+
+    SECTION("Invalidate rewrites the table")
+    {
+        table.Save(saveRows, { { 1, { 10, 100 } } });
+        saveRows.Invalidate();
+        table.Rows[5] = { 5, 5 };
+
+        DeltaSaveResult result = table.Save(saveRows, { { 1, { 10, 100 } } });
+        REQUIRE(table.Rows == TestRows::RowMap{ { 1, { 10, 100 } } });
+        REQUIRE(result.Written == 2);
+    }
+}
+
+TEST_CASE("DeltaSaveRows matches a full save", "[DeltaSaveRows]")
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32> keys(0, 40);
+    std::uniform_int_distribution<uint32> actions(0, 9);
+
+    TestRows saveRows;
+    Table deltaTable;
+    Table fullTable;
+    TestRows::RowMap current;
+    uint64 deltaStatements = 0;
+    uint64 fullStatements = 0;
+
+    // auras come and go, timed ones tick down, a few change stacks
+    for (uint32 save = 0; save < 500; ++save)
+    {
+        for (uint32 change = 0; change < 5; ++change)
+        {
+            uint32 key = keys(rng);
+            switch (actions(rng))
+            {
+                case 0:
+                case 1:
+                    current.erase(key);
+                    break;
+                case 2:
+                case 3:
+                    current[key] = { int32(key), actions(rng) < 5 ? -1 : 30000 };
+                    break;
+                case 4:
+                    if (current.count(key))
+                        ++current[key].Amount;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        for (auto& [key, row] : current)
+            if (row.Duration > 0)
+                row.Duration -= 100;
+
+        DeltaSaveResult result = deltaTable.Save(saveRows, current);
+        deltaStatements += result.Written;
+
+        TestRows fullSave;
+        fullStatements += fullTable.Save(fullSave, current).Written;
+
+        REQUIRE(deltaTable.Rows == fullTable.Rows);
+        REQUIRE(deltaTable.Rows == current);
+        REQUIRE(result.Written + result.Avoided == 1 + current.size());
+    }
+
+    REQUIRE(deltaStatements == deltaTable.Statements);
+    REQUIRE(deltaStatements < fullStatements);
+}
+
+TEST_CASE("Player delta saves match full saves", "[DeltaSaveRows]")
+{
+    UnitTestDataLoader::LoadSpellInfo();
+    SaveConfig config;
+
+    // the same character saved with PlayerSave.Delta enabled and disabled
+    std::mt19937 rng(7);
+    TestCharacter character(7);
+    TestCharacter fullCharacter(7);
+    auto change = [&]()
+    {
+        std::mt19937 fullRng = rng;
+        character.Change(rng);
+        fullCharacter.Change(fullRng);
+    };
+
+    // another character in the same tables
+    TestDatabase deltaDatabase;
+    std::vector<std::unique_ptr<CharacterDatabasePreparedStatement>> transaction;
+    {
+        TestCharacter other(8);
+        other.Change(rng);
+        sWorld->setBoolConfig(CONFIG_PLAYER_SAVE_DELTA, true);
+        other.GetPlayer().SaveDeltaSaveRows(deltaDatabase.GetStatements(transaction));
+        deltaDatabase.Commit(transaction);
+    }
+    TestDatabase fullDatabase = deltaDatabase;
+
+    auto save = [&]()
+    {
+        sWorld->setBoolConfig(CONFIG_PLAYER_SAVE_DELTA, true);
+        character.GetPlayer().SaveDeltaSaveRows(deltaDatabase.GetStatements(transaction));
+    };
+
+    auto fullSave = [&]()
+    {
+        std::vector<std::unique_ptr<CharacterDatabasePreparedStatement>> fullTransaction;
+        sWorld->setBoolConfig(CONFIG_PLAYER_SAVE_DELTA, false);
+        fullCharacter.GetPlayer().SaveDeltaSaveRows(fullDatabase.GetStatements(fullTransaction));
+        fullDatabase.Commit(fullTransaction);
+    };
+
+    SECTION("Every save leaves the same rows")
+    {
+        for (uint32 i = 0; i < 300; ++i)
+        {
+            change();
+
+            save();
+            deltaDatabase.Commit(transaction);
+            fullSave();
+
+            RequireSameRows(deltaDatabase, fullDatabase, SaveConfig::DurationTolerance);
+        }
+
+        REQUIRE(deltaDatabase.Executed < fullDatabase.Executed);
+    }
+
+    SECTION("Auras running down are rewritten once per autosave interval")
+    {
+        character.Cast(ObjectGuid::Empty, 1, 30000);
+        save();
+        deltaDatabase.Commit(transaction);
+        uint32 executed = deltaDatabase.Executed;
+
+        for (int32 ranDown = 1000; ranDown < SaveConfig::DurationTolerance; ranDown += 1000)
+        {
+            character.RunDown(1000);
+            save();
+            deltaDatabase.Commit(transaction);
+            REQUIRE(deltaDatabase.Executed == executed);
+        }
+
+        character.RunDown(1000);
+        save();
+        deltaDatabase.Commit(transaction);
+        REQUIRE(deltaDatabase.Executed == executed + 1);
+    }
+
+    SECTION("A failed commit is followed by a rewrite")
+    {
+        save();
+        deltaDatabase.Commit(transaction);
+
+        for (uint32 i = 0; i < 50; ++i)
+        {
+            change();
+
+            // Player::CommitSave
+            save();
+            if (i % 3 == 0)
+            {
+                transaction.clear();
+                character.GetPlayer().InvalidateDeltaSaveRows();
+                continue;
+            }
+
+            deltaDatabase.Commit(transaction);
+            fullSave();
+
+            RequireSameRows(deltaDatabase, fullDatabase, SaveConfig::DurationTolerance);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "PlayerSaveScheduler.h"
+#include <algorithm>
+
+namespace
+{
+    uint32 StartAutosaves(PlayerSaveScheduler& scheduler, uint32 requests)
+    {
+        uint32 started = 0;
+        for (uint32 i = 0; i < requests; ++i)
+            if (scheduler.RequestAutosave(0))
+                ++started;
+
+        return started;
+    }
+}
+
+TEST_CASE("PlayerSaveScheduler", "[PlayerSaveScheduler]")
+{
+    PlayerSaveScheduler scheduler;
+    scheduler.SetLimits(90000, 10, 100);
+
+    SECTION("Autosaves are limited per second")
+    {
+        uint32 started = 0;
+        for (uint32 i = 0; i < 20; ++i)
+        {
+            scheduler.Update(50, 0, 0);
+            started += StartAutosaves(scheduler, 1000);
+        }
+
+        REQUIRE(started == 10);
+        REQUIRE(scheduler.GetStatistics().DeferredAutosaves > 0);
+    }
+
+    SECTION("Unused budget is not kept for more than a second")
+    {
+        for (uint32 i = 0; i < 100; ++i)
+            scheduler.Update(100, 0, 0);
+
+        REQUIRE(StartAutosaves(scheduler, 1000) == 10);
+    }
+
+    SECTION("Budget follows the online players")
+    {
+        scheduler.SetLimits(90000, 0, 0);
+        scheduler.Update(1000, 4500, 0);
+        REQUIRE(scheduler.GetSavesPerSecond() == 100);
+
+        scheduler.Update(1000, 0, 0);
+        REQUIRE(scheduler.GetSavesPerSecond() == 1);
+    }
+
+    SECTION("Budget shrinks with the database queue")
+    {
+        scheduler.Update(1000, 0, 100);
+        REQUIRE(scheduler.GetSavesPerSecond() == 10);
+        scheduler.Update(1000, 0, 150);
+        REQUIRE(scheduler.GetSavesPerSecond() == 5);
+        scheduler.Update(1000, 0, 200);
+        REQUIRE(scheduler.GetSavesPerSecond() == 0);
+        REQUIRE(StartAutosaves(scheduler, 1000) == 0);
+    }
+
+    SECTION("Priority saves are taken from the autosave budget")
+    {
+        scheduler.Update(1000, 0, 0);
+        for (uint32 i = 0; i < 5; ++i)
+            scheduler.OnPrioritySave();
+
+        REQUIRE(StartAutosaves(scheduler, 1000) == 5);
+
+        for (uint32 i = 0; i < 15; ++i)
+            scheduler.OnPrioritySave();
+
+        // the debt is limited to one second of budget
+        scheduler.Update(500, 0, 0);
+        REQUIRE(StartAutosaves(scheduler, 1000) == 0);
+        scheduler.Update(1500, 0, 0);
+        REQUIRE(StartAutosaves(scheduler, 1000) == 5);
+        REQUIRE(scheduler.GetStatistics().PrioritySaves == 20);
+    }
+
+    SECTION("Autosaves deferred for a whole interval are started anyway")
+    {
+        scheduler.Update(1000, 0, 200);
+        REQUIRE_FALSE(scheduler.RequestAutosave(89999));
+        REQUIRE(scheduler.RequestAutosave(90000));
+        REQUIRE(scheduler.GetStatistics().ForcedAutosaves == 1);
+    }
+
+    SECTION("First saves are spread over the interval")
+    {
+        std::vector<uint32> delays;
+        for (uint32 i = 0; i < 1000; ++i)
+            delays.push_back(scheduler.GetFirstSaveDelay());
+
+        std::sort(delays.begin(), delays.end());
+        REQUIRE(delays.front() >= 45000);
+        REQUIRE(delays.back() < 135000);
+
+        // no gap is much larger than interval / logins
+        uint32 largestGap = 0;
+        for (std::size_t i = 1; i < delays.size(); ++i)
+            largestGap = std::max(largestGap, delays[i] - delays[i - 1]);
+
+        REQUIRE(largestGap <= 3 * 90000 / 1000);
+    }
+}
@@ -0,0 +1,377 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "DummyData.h"
+#include "OpenSSLCrypto.h"
+#include "PacketPool.h"
+#include "Socket.h"
+#include "WorldPacket.h"
+#include "WorldSocket.h"
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/dll/runtime_symbol_info.hpp>
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+    struct AllocationCounter
+    {
+        uint64 Allocations = 0;
+        uint64 Bytes = 0;
+        uint64 PooledAllocations = 0;   ///< packet objects and storage served by PacketPool without reaching operator new
+
+        uint64 Total() const { return Allocations + PooledAllocations; }
+    };
+
+    // counter of the allocations made by this thread through the global operator new below, if any
+    thread_local AllocationCounter* CountedAllocations = nullptr;
+
+    class CountAllocations
+    {
+    public:
+        explicit CountAllocations(AllocationCounter& counter) : _previous(CountedAllocations) { CountedAllocations = &counter; }
+        ~CountAllocations() { CountedAllocations = _previous; }
+
+        CountAllocations(CountAllocations const&) = delete;
+        CountAllocations& operator=(CountAllocations const&) = delete;
+
+    private:
+        AllocationCounter* _previous;
+    };
+
+    // runs send on a thread of its own, the packet pool cache of that thread publishes its counters when it exits
+    template<typename Send>
+    AllocationCounter CountPacketAllocations(Send&& send)
+    {
+        PacketPool::Statistics const storage = PacketPool::GetStorageStatistics();
+        PacketPool::Statistics const objects = PacketPool::GetObjectStatistics();
+
+        AllocationCounter counter;
+        std::thread([&]()
+        {
+            CountAllocations counting(counter);
+            send();
+        }).join();
+
+        // misses went through operator new and are counted already
+        counter.PooledAllocations = PacketPool::GetStorageStatistics().Hits - storage.Hits + PacketPool::GetObjectStatistics().Hits - objects.Hits;
+        return counter;
+    }
+
+    class TestSocket : public Socket<TestSocket>
+    {
+    public:
+        using Socket<TestSocket>::Socket;
+
+        void Start() override { }
+
+    protected:
+        void ReadHandler() override { }
+    };
+
+    // server side socket under test and the client reading what it wrote
+    template<class ServerSocket = TestSocket>
+    struct SocketPair
+    {
+        explicit SocketPair(boost::asio::io_context& context) : Client(context)
+        {
+            tcp::acceptor acceptor(context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+            Client.connect(acceptor.local_endpoint());
+            Server = std::make_shared<ServerSocket>(acceptor.accept());
+        }
+
+        std::vector<uint8> Read(std::size_t size)
+        {
+            std::vector<uint8> data(size);
+            boost::asio::read(Client, boost::asio::buffer(data));
+            return data;
+        }
+
+        tcp::socket Client;
+        std::shared_ptr<ServerSocket> Server;
+    };
+
+    std::shared_ptr<WorldPacket const> MakePayload(std::size_t size)
+    {
+        std::shared_ptr<WorldPacket> packet = std::make_shared<WorldPacket>(SMSG_MESSAGECHAT, size);
+        for (std::size_t i = 0; i < size; ++i)
+            *packet << uint8(i);
+        return packet;
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (CountedAllocations)
+    {
+        ++CountedAllocations->Allocations;
+        CountedAllocations->Bytes += size;
+    }
+
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept
+{
+    std::free(memory);
+}
+
+TEST_CASE("Socket writes shared buffers without copying them", "[SocketWriteQueue]")
+{
+    boost::asio::io_context context;
+    SocketPair<> pair(context);
+
+    std::shared_ptr<WorldPacket const> payload = MakePayload(300);
+
+    std::shared_ptr<std::array<uint8, 8>> headers = std::make_shared<std::array<uint8, 8>>();
+    std::iota(headers->begin(), headers->end(), uint8(200));
+
+    // header, payload, header, payload - the two headers can't be merged as the payload is between them
+    pair.Server->QueueBuffer(headers, headers->data(), 4);
+    pair.Server->QueueBuffer(payload, payload->contents(), payload->size());
+    pair.Server->QueueBuffer(headers, headers->data() + 4, 4);
+    pair.Server->QueueBuffer(payload, payload->contents(), payload->size());
+
+    REQUIRE(payload.use_count() == 3);
+    REQUIRE(pair.Server->Update());
+    REQUIRE(pair.Server->GetStatistics().WriteCalls == 1);
+
+    std::vector<uint8> written = pair.Read(2 * (4 + 300));
+    REQUIRE(std::equal(headers->begin(), headers->begin() + 4, written.begin()));
+    REQUIRE(std::equal(payload->contents(), payload->contents() + 300, written.begin() + 4));
+    REQUIRE(std::equal(headers->begin() + 4, headers->end(), written.begin() + 304));
+    REQUIRE(std::equal(payload->contents(), payload->contents() + 300, written.begin() + 308));
+
+    // written buffers are released
+    REQUIRE(payload.use_count() == 1);
+    REQUIRE(headers.use_count() == 1);
+
+    // traffic is reported once to the network thread
+    SocketStatistics statistics = pair.Server->TakeUnreportedStatistics();
+    REQUIRE(statistics.BytesSent == 2 * (4 + 300));
+    REQUIRE(statistics.WriteCalls == 1);
+    REQUIRE(pair.Server->TakeUnreportedStatistics().BytesSent == 0);
+    REQUIRE(pair.Server->GetStatistics().BytesSent == 2 * (4 + 300));
+
+    SECTION("consecutive bytes of the same owner are merged")
+    {
+        pair.Server->QueueBuffer(payload, payload->contents(), 100);
+        pair.Server->QueueBuffer(payload, payload->contents() + 100, 200);
+        REQUIRE(payload.use_count() == 2);
+
+        MessageBuffer owned(16);
+        owned.Write("owned", 5);
+        pair.Server->QueuePacket(std::move(owned));
+
+        REQUIRE(pair.Server->Update());
+        written = pair.Read(305);
+        REQUIRE(std::equal(payload->contents(), payload->contents() + 300, written.begin()));
+        REQUIRE(std::string(written.begin() + 300, written.end()) == "owned");
+    }
+}
+
+TEST_CASE("WorldSocket holds packets of a session in the world until they are flushed", "[SocketWriteQueue]")
+{
+    // the packet header cipher of WorldSocket needs the legacy provider
+    OpenSSLCrypto::threadsSetup(boost::dll::program_location().remove_filename());
+    std::shared_ptr<void> opensslHandle(nullptr, [](void*) { OpenSSLCrypto::threadsCleanup(); });
+
+    boost::asio::io_context context;
+    SocketPair<WorldSocket> pair(context);
+
+    // no auth crypt yet, headers are sent as they are: big endian size including the opcode, then the opcode
+    std::vector<std::shared_ptr<WorldPacket const>> packets = { MakePayload(100), MakePayload(200), MakePayload(300) };
+    std::size_t const written = 3 * 4 + 100 + 200 + 300;
+
+    auto requireWritten = [&]()
+    {
+        std::vector<uint8> data = pair.Read(written);
+        std::size_t offset = 0;
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+        {
+            REQUIRE(((data[offset] << 8) | data[offset + 1]) == int32(packet->size() + 2));
+            REQUIRE((data[offset + 2] | (data[offset + 3] << 8)) == SMSG_MESSAGECHAT);
+            REQUIRE(std::equal(packet->contents(), packet->contents() + packet->size(), data.begin() + offset + 4));
+            offset += 4 + packet->size();
+        }
+    };
+
+    SECTION("Packets are held until FlushPackets, then sent in one write")
+    {
+        pair.Server->SetCoalescePackets(true);
+        UnitTestDataLoader::AddSessionToWorld(*pair.Server);
+
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+            pair.Server->SendPacket(packet);
+
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->GetStatistics().PacketsSent == 0);
+        REQUIRE(pair.Server->GetStatistics().WriteCalls == 0);
+        REQUIRE(pair.Client.available() == 0);
+
+        pair.Server->FlushPackets();
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->GetStatistics().PacketsSent == 3);
+        REQUIRE(pair.Server->GetStatistics().WriteCalls == 1);
+        requireWritten();
+
+        // one flush releases the packets sent before it only
+        pair.Server->SendPacket(packets[0]);
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->GetStatistics().PacketsSent == 3);
+    }
+
+    SECTION("Sessions not in the world yet are not held back")
+    {
+        pair.Server->SetCoalescePackets(true);
+
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+            pair.Server->SendPacket(packet);
+
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->GetStatistics().PacketsSent == 3);
+        requireWritten();
+    }
+
+    SECTION("Packets are not held without Network.CoalescePackets")
+    {
+        UnitTestDataLoader::AddSessionToWorld(*pair.Server);
+
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+            pair.Server->SendPacket(packet);
+
+        REQUIRE(pair.Server->Update());
+        REQUIRE(pair.Server->GetStatistics().PacketsSent == 3);
+        requireWritten();
+    }
+}
+
+TEST_CASE("Broadcasting a packet to 100 sockets", "[.][benchmark][SocketWriteQueue]")
+{
+    OpenSSLCrypto::threadsSetup(boost::dll::program_location().remove_filename());
+    std::shared_ptr<void> opensslHandle(nullptr, [](void*) { OpenSSLCrypto::threadsCleanup(); });
+
+    boost::asio::io_context context;
+    std::vector<std::unique_ptr<SocketPair<WorldSocket>>> receivers;
+    for (uint32 i = 0; i < 100; ++i)
+        receivers.push_back(std::make_unique<SocketPair<WorldSocket>>(context));
+
+    WorldPacket const packet = *MakePayload(300);
+    std::size_t const written = 4 + packet.size();
+
+    // what the broadcast notifiers did before, every receiver gets its own copy
+    auto sendCopies = [&]()
+    {
+        for (std::unique_ptr<SocketPair<WorldSocket>>& receiver : receivers)
+        {
+            receiver->Server->SendPacket(packet);
+            receiver->Server->Update();
+            receiver->Read(written);
+        }
+        return receivers.size();
+    };
+
+    // one copy shared by all receivers, each only writes its own header
+    auto sendShared = [&]()
+    {
+        std::shared_ptr<WorldPacket const> shared = std::make_shared<WorldPacket const>(packet);
+        for (std::unique_ptr<SocketPair<WorldSocket>>& receiver : receivers)
+        {
+            receiver->Server->SendPacket(shared);
+            receiver->Server->Update();
+            receiver->Read(written);
+        }
+        return receivers.size();
+    };
+
+    // the first send of every socket allocates its header buffer
+    sendShared();
+
+    AllocationCounter const copies = CountPacketAllocations(sendCopies);
+    AllocationCounter const shared = CountPacketAllocations(sendShared);
+
+    INFO("copy per receiver: " << copies.Total() << " allocations (" << copies.PooledAllocations << " pooled, " << copies.Bytes << " bytes from the heap), "
+        "shared payload: " << shared.Total() << " allocations (" << shared.PooledAllocations << " pooled, " << shared.Bytes << " bytes from the heap)");
+    // every receiver past the first costs at least the packet object and the storage of its copy
+    REQUIRE(copies.Total() >= shared.Total() + 2 * (receivers.size() - 1));
+
+    BENCHMARK("copy per receiver")
+    {
+        return sendCopies();
+    };
+
+    BENCHMARK("shared payload")
+    {
+        return sendShared();
+    };
+}
+
+TEST_CASE("Writing the packets of one world update", "[.][benchmark][SocketWriteQueue]")
+{
+    boost::asio::io_context context;
+    SocketPair<> pair(context);
+
+    // movement, aura and spell packets sent to one client during an update
+    std::vector<std::shared_ptr<WorldPacket const>> packets;
+    for (uint32 i = 0; i < 20; ++i)
+        packets.push_back(MakePayload(20 + i * 10));
+
+    std::size_t const written = std::accumulate(packets.begin(), packets.end(), std::size_t(0), [](std::size_t size, std::shared_ptr<WorldPacket const> const& packet)
+    {
+        return size + packet->size();
+    });
+
+    // network thread picking up packets while the update sends them
+    BENCHMARK("write per packet")
+    {
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+        {
+            pair.Server->QueueBuffer(packet, packet->contents(), packet->size());
+            pair.Server->Update();
+        }
+
+        pair.Read(written);
+        return pair.Server->GetStatistics().WriteCalls;
+    };
+
+    // coalesced until the session flushed them
+    BENCHMARK("write per update")
+    {
+        for (std::shared_ptr<WorldPacket const> const& packet : packets)
+            pair.Server->QueueBuffer(packet, packet->contents(), packet->size());
+
+        pair.Server->Update();
+        pair.Read(written);
+        return pair.Server->GetStatistics().WriteCalls;
+    };
+}
@@ -0,0 +1,209 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "CellImpl.h"
+#include "Creature.h"
+#include "CreatureAI.h"
+#include "DummyData.h"
+#include "GridDefines.h"
+#include "GridNotifiers.h"
+#include "Map.h"
+#include "SpatialHash.h"
+#include "World.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace
+{
+    struct Point
+    {
+        float X;
+        float Y;
+    };
+
+    // points spread over a square of the given size around the map center
+    std::vector<Point> GeneratePoints(std::size_t count, uint32 seed, float size = SIZE_OF_GRIDS)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coord(-size / 2, size / 2);
+
+        std::vector<Point> points(count);
+        for (Point& point : points)
+            point = { coord(rng), coord(rng) };
+        return points;
+    }
+
+    bool IsInRange(Point const& left, Point const& right, float range)
+    {
+        float dx = left.X - right.X;
+        float dy = left.Y - right.Y;
+        return dx * dx + dy * dy <= range * range;
+    }
+
+    class SightCountingAI : public CreatureAI
+    {
+    public:
+        SightCountingAI(Creature* creature, uint64& sightings) : CreatureAI(creature), _sightings(sightings) { }
+
+        void MoveInLineOfSight(Unit* /*who*/) override { ++_sightings; }
+        void UpdateAI(uint32 /*diff*/) override { }
+
+    private:
+        uint64& _sightings;
+    };
+
+    // creature without a database template counting the units it sees, Creature would select its ai through the template
+    class SightCountingCreature : public Creature
+    {
+    public:
+        SightCountingCreature(Map& map, ObjectGuid::LowType guid, Point const& position, uint64& sightings)
+        {
+            static CreatureTemplate const emptyTemplate = {};
+            m_creatureInfo = &emptyTemplate;
+
+            _Create(guid, HighGuid::Unit, PHASEMASK_NORMAL);
+            SetMap(&map);
+            Relocate(position.X, position.Y, 0.0f);
+            SetAI(new SightCountingAI(this, sightings));
+        }
+
+        // Creature and Unit also set up motion, formation and ai from the template
+        void AddToWorld() override { WorldObject::AddToWorld(); }
+        void RemoveFromWorld() override { WorldObject::RemoveFromWorld(); }
+    };
+
+    // creatures crowded in a block of cells, all of them waiting for their delayed relocation notify
+    class CellBlock
+    {
+    public:
+        explicit CellBlock(std::size_t count) : _map(0, 0, 0, REGULAR_DIFFICULTY), _sightRange(sWorld->getFloatConfig(CONFIG_SIGHT_MONSTER)), _sightings(0)
+        {
+            sWorld->setFloatConfig(CONFIG_SIGHT_MONSTER, 50.0f);
+
+            for (Point const& point : GeneratePoints(count, uint32(count), 4 * SIZE_OF_GRID_CELL))
+            {
+                SightCountingCreature* creature = _creatures.emplace_back(std::make_unique<SightCountingCreature>(_map, _creatures.size() + 1, point, _sightings)).get();
+                _map.LoadGrid(point.X, point.Y);
+                _map.AddToMap<Creature>(creature);
+                creature->AddToNotify(NOTIFY_VISIBILITY_CHANGED);
+            }
+        }
+
+        ~CellBlock()
+        {
+            for (std::unique_ptr<SightCountingCreature> const& creature : _creatures)
+                _map.RemoveFromMap<Creature>(creature.get(), false);
+
+            _map.UnloadAll();
+            sWorld->setFloatConfig(CONFIG_SIGHT_MONSTER, _sightRange);
+        }
+
+        // what DelayedUnitRelocation did for every creature before the batch
+        uint64 NotifyPerUnit()
+        {
+            _sightings = 0;
+            for (std::unique_ptr<SightCountingCreature> const& creature : _creatures)
+            {
+                Trinity::CreatureRelocationNotifier relocate(*creature);
+                Cell::VisitAllObjects(creature.get(), relocate, MAX_VISIBILITY_DISTANCE);
+            }
+            return _sightings;
+        }
+
+        uint64 NotifyBatched(std::size_t minMovers)
+        {
+            _sightings = 0;
+            Trinity::CreatureRelocationBatch batch(_map, minMovers);
+            for (std::unique_ptr<SightCountingCreature> const& creature : _creatures)
+                batch.i_movers.push_back(creature.get());
+            batch.Process();
+            return _sightings;
+        }
+
+    private:
+        Map _map;
+        float _sightRange;
+        uint64 _sightings;
+        std::vector<std::unique_ptr<SightCountingCreature>> _creatures;
+    };
+}
+
+TEST_CASE("Range queries match a full scan", "[SpatialHash]")
+{
+    std::vector<Point> points = GeneratePoints(2000, 42);
+
+    Trinity::SpatialHash<uint32> hash(50.0f);
+    for (uint32 i = 0; i < points.size(); ++i)
+        hash.Insert(points[i].X, points[i].Y, i);
+    hash.Build();
+
+    REQUIRE(hash.Size() == points.size());
+
+    for (float range : { 5.0f, 50.0f, 120.0f })
+    {
+        for (std::size_t i = 0; i < points.size(); i += 37)
+        {
+            std::vector<uint32> found;
+            hash.VisitInRange(points[i].X, points[i].Y, range, [&found](uint32 index) { found.push_back(index); });
+            std::sort(found.begin(), found.end());
+
+            std::vector<uint32> expected;
+            for (uint32 j = 0; j < points.size(); ++j)
+                if (IsInRange(points[i], points[j], range))
+                    expected.push_back(j);
+
+            REQUIRE(found == expected);
+        }
+    }
+}
+
+TEST_CASE("Empty hash finds nothing", "[SpatialHash]")
+{
+    Trinity::SpatialHash<uint32> hash(50.0f);
+    hash.Build();
+
+    bool found = false;
+    hash.VisitInRange(0.0f, 0.0f, 100.0f, [&found](uint32) { found = true; });
+    REQUIRE_FALSE(found);
+}
+
+TEST_CASE("Relocation notifiers on a block of cells", "[.][benchmark][SpatialHash]")
+{
+    UnitTestDataLoader::LoadMapTemplates();
+
+    for (std::size_t count : { 100, 1000, 5000 })
+    {
+        CellBlock block(count);
+        uint64 const sightings = block.NotifyPerUnit();
+        REQUIRE(sightings > 0);
+        REQUIRE(block.NotifyBatched(0) == sightings);
+        REQUIRE(block.NotifyBatched(count + 1) == sightings);
+
+        BENCHMARK("per unit notifier, " + std::to_string(count) + " creatures")
+        {
+            return block.NotifyPerUnit();
+        };
+
+        BENCHMARK("batched spatial hash, " + std::to_string(count) + " creatures")
+        {
+            return block.NotifyBatched(0);
+        };
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "StartupTaskGraph.h"
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    struct Recorder
+    {
+        std::mutex Lock;
+        std::vector<std::string> Finished;
+
+        StartupTaskGraph::Task Record(std::string name, Milliseconds duration = Milliseconds::zero())
+        {
+            return [this, name, duration]()
+            {
+                std::this_thread::sleep_for(duration);
+                std::lock_guard<std::mutex> guard(Lock);
+                Finished.push_back(name);
+            };
+        }
+
+        bool FinishedBefore(std::string const& first, std::string const& second) const
+        {
+            auto firstItr = std::find(Finished.begin(), Finished.end(), first);
+            auto secondItr = std::find(Finished.begin(), Finished.end(), second);
+            return firstItr != Finished.end() && secondItr != Finished.end() && firstItr < secondItr;
+        }
+    };
+}
+
+TEST_CASE("StartupTaskGraph", "[StartupTaskGraph]")
+{
+    Recorder recorder;
+    StartupTaskGraph graph;
+    graph.Add("spells", {}, recorder.Record("spells", Milliseconds(20)));
+    graph.Add("items", { "spells" }, recorder.Record("items"));
+    graph.Add("texts", {}, recorder.Record("texts"));
+    graph.Add("creatures", { "spells" }, recorder.Record("creatures", Milliseconds(20)));
+    graph.Add("loot", { "items", "creatures" }, recorder.Record("loot"));
+    graph.Add("conditions", { "loot", "texts" }, recorder.Record("conditions"));
+
+    SECTION("One thread runs the tasks in the order they were added")
+    {
+        graph.Run(1);
+        REQUIRE(recorder.Finished == std::vector<std::string>{ "spells", "items", "texts", "creatures", "loot", "conditions" });
+        REQUIRE(graph.GetStartOrder() == recorder.Finished);
+    }
+
+    SECTION("Several threads respect the dependencies")
+    {
+        graph.Run(4);
+        REQUIRE(recorder.Finished.size() == 6);
+        REQUIRE(recorder.FinishedBefore("spells", "items"));
+        REQUIRE(recorder.FinishedBefore("spells", "creatures"));
+        REQUIRE(recorder.FinishedBefore("items", "loot"));
+        REQUIRE(recorder.FinishedBefore("creatures", "loot"));
+        REQUIRE(recorder.FinishedBefore("loot", "conditions"));
+        REQUIRE(recorder.FinishedBefore("texts", "conditions"));
+        // texts does not wait for spells
+        REQUIRE(recorder.FinishedBefore("texts", "spells"));
+    }
+
+    SECTION("The critical path follows the longest chain")
+    {
+        graph.Run(4);
+        REQUIRE(graph.GetCriticalPath() == std::vector<std::string>{ "spells", "creatures", "loot", "conditions" });
+        REQUIRE(graph.GetCriticalPathDuration() >= Milliseconds(40));
+        REQUIRE(graph.GetDuration() >= graph.GetCriticalPathDuration());
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "TerrainFileStore.h"
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // removes the file again when the test ends
+    struct TemporaryFile
+    {
+        TemporaryFile(char const* name, std::size_t size) : Path((std::filesystem::temp_directory_path() / name).string())
+        {
+            std::vector<uint8> contents(size);
+            for (std::size_t i = 0; i < size; ++i)
+                contents[i] = uint8(i * 7);
+
+            FILE* out = fopen(Path.c_str(), "wb");
+            REQUIRE(out);
+            REQUIRE(fwrite(contents.data(), 1, contents.size(), out) == contents.size());
+            fclose(out);
+        }
+
+        ~TemporaryFile()
+        {
+            std::error_code error;
+            std::filesystem::remove(Path, error);
+        }
+
+        std::string Path;
+    };
+
+    // what every grid did before terrain files were shared: read its own heap copy
+    std::unique_ptr<std::vector<uint8>> ReadCopy(std::string const& path)
+    {
+        std::unique_ptr<std::vector<uint8>> copy = std::make_unique<std::vector<uint8>>();
+        FILE* in = fopen(path.c_str(), "rb");
+        fseek(in, 0, SEEK_END);
+        copy->resize(std::size_t(ftell(in)));
+        fseek(in, 0, SEEK_SET);
+        if (fread(copy->data(), 1, copy->size(), in) != copy->size())
+            copy->clear();
+        fclose(in);
+        return copy;
+    }
+}
+
+TEST_CASE("Terrain files are opened once and shared", "[TerrainFileStore]")
+{
+    TemporaryFile file("tc_terrain_store_test.map", 4096);
+    std::size_t openFiles = sTerrainFileStore->GetOpenFileCount();
+
+    std::shared_ptr<TerrainFile const> first = sTerrainFileStore->Acquire(file.Path);
+    std::shared_ptr<TerrainFile const> second = sTerrainFileStore->Acquire(file.Path);
+    REQUIRE(first);
+    REQUIRE(first == second);
+    REQUIRE(first->GetSize() == 4096);
+    REQUIRE(first->GetData()[100] == uint8(700));
+    REQUIRE(sTerrainFileStore->GetOpenFileCount() == openFiles + 1);
+
+    first.reset();
+    REQUIRE(sTerrainFileStore->GetOpenFileCount() == openFiles + 1);
+
+    second.reset();
+    REQUIRE(sTerrainFileStore->GetOpenFileCount() == openFiles);
+}
+
+TEST_CASE("Missing and empty terrain files", "[TerrainFileStore]")
+{
+    REQUIRE(!sTerrainFileStore->Acquire((std::filesystem::temp_directory_path() / "tc_terrain_store_missing.map").string()));
+
+    TemporaryFile empty("tc_terrain_store_empty.map", 0);
+    std::shared_ptr<TerrainFile const> file = sTerrainFileStore->Acquire(empty.Path);
+    REQUIRE(file);
+    REQUIRE(file->GetSize() == 0);
+}
+
+TEST_CASE("Loading terrain of many instances", "[.][benchmark][TerrainFileStore]")
+{
+    // about the size of a grid with float heights and liquids
+    std::size_t const fileSize = 160 * 1024;
+    std::size_t const instances = 200;
+    TemporaryFile file("tc_terrain_store_benchmark.map", fileSize);
+
+    // all instances keep their terrain at the same time, memory stays at one copy of the file
+    {
+        std::vector<std::shared_ptr<TerrainFile const>> shared;
+        for (std::size_t i = 0; i < instances; ++i)
+            shared.push_back(sTerrainFileStore->Acquire(file.Path));
+        REQUIRE(sTerrainFileStore->GetOpenFileBytes() == fileSize);
+    }
+
+    BENCHMARK("heap copy per instance")
+    {
+        std::vector<std::unique_ptr<std::vector<uint8>>> copies;
+        for (std::size_t i = 0; i < instances; ++i)
+            copies.push_back(ReadCopy(file.Path));
+        return copies.size();
+    };
+
+    BENCHMARK("shared terrain file")
+    {
+        std::vector<std::shared_ptr<TerrainFile const>> shared;
+        for (std::size_t i = 0; i < instances; ++i)
+            shared.push_back(sTerrainFileStore->Acquire(file.Path));
+        return shared.size();
+    };
+}
@@ -0,0 +1,214 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "DummyData.h"
+#include "Group.h"
+#include "Player.h"
+#include "UpdateData.h"
+#include "UpdateFieldFlags.h"
+#include "UpdateFieldFragments.h"
+#include "WorldPacket.h"
+#include "WorldSession.h"
+#include <memory>
+
+namespace
+{
+    // players that are not in world, with the update fields of a new character
+    class TestPlayers
+    {
+    public:
+        TestPlayers() : _session(1, "player", nullptr, SEC_PLAYER, 2, 0, Minutes(0), LOCALE_enUS, 0, false),
+            _gamemasterSession(2, "gamemaster", nullptr, SEC_GAMEMASTER, 2, 0, Minutes(0), LOCALE_enUS, 0, false)
+        {
+            UnitTestDataLoader::LoadEmptyPermissions(_session);
+            UnitTestDataLoader::LoadEmptyPermissions(_gamemasterSession);
+        }
+
+        ~TestPlayers()
+        {
+            for (std::unique_ptr<Player> const& player : _players)
+                player->SetGroup(nullptr);
+        }
+
+        Player& Create(bool gamemaster = false)
+        {
+            Player& player = *_players.emplace_back(std::make_unique<Player>(gamemaster ? &_gamemasterSession : &_session));
+            player._Create(_players.size(), HighGuid::Player, PHASEMASK_NORMAL);
+            if (gamemaster)
+                player.SetGameMaster(true);
+
+            player.ClearUpdateMask(false);
+            return player;
+        }
+
+    private:
+        WorldSession _session;
+        WorldSession _gamemasterSession;
+        std::vector<std::unique_ptr<Player>> _players;
+    };
+
+    bool IsTracked(uint32 tick) { return tick % 14 >= 7; }
+
+    // one combat tick of a raid member: public, party member and private fields changed
+    void ChangeFields(Player& player, uint32 tick)
+    {
+        player.ClearUpdateMask(false);
+        player.SetUInt32Value(UNIT_FIELD_HEALTH, 100000 - tick * 100);
+        player.SetUInt32Value(UNIT_FIELD_POWER1, tick * 10);
+        player.SetGuidValue(UNIT_FIELD_TARGET, ObjectGuid::Create<HighGuid::Unit>(1, tick % 40 + 1));
+        if (tick % 3 == 0)
+            player.SetUInt32Value(PLAYER_QUEST_LOG_1_1, tick);
+        if (tick % 4 == 0)
+            player.SetUInt32Value(PLAYER_FIELD_COINAGE, tick);
+        // gamemasters always see units as interactible
+        if (tick % 5 == 0)
+            player.ToggleFlag(UNIT_FIELD_FLAGS, UNIT_FLAG_UNINTERACTIBLE | UNIT_FLAG_IN_COMBAT);
+        // dynamic flags are in every update, tracked units are serialized for each observer
+        player.SetUInt32Value(UNIT_DYNAMIC_FLAGS, (tick % 3 == 0 ? UNIT_DYNFLAG_DEAD : 0) | (IsTracked(tick) ? UNIT_DYNFLAG_TRACK_UNIT : 0));
+    }
+
+    std::vector<uint8> BuildPacket(UpdateData& data)
+    {
+        WorldPacket packet;
+        REQUIRE(data.BuildPacket(&packet));
+        return std::vector<uint8>(packet.contents(), packet.contents() + packet.size());
+    }
+}
+
+TEST_CASE("Values update fragments reuse their storage", "[UpdateFieldFragments]")
+{
+    UpdateFieldFragments fragments;
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC) == nullptr);
+
+    fragments.Create(UF_FLAG_PUBLIC) << uint32(1);
+    fragments.Create(UF_FLAG_PUBLIC | UF_FLAG_OWNER) << uint32(2);
+    REQUIRE(fragments.GetFragmentCount() == 2);
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC) != nullptr);
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC)->read<uint32>(0) == 1);
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC | UF_FLAG_OWNER)->read<uint32>(0) == 2);
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC | UPDATE_VIEW_KEY_GAMEMASTER) == nullptr);
+
+    uint8 const* storage = fragments.Find(UF_FLAG_PUBLIC)->contents();
+
+    fragments.Clear();
+    REQUIRE(fragments.GetFragmentCount() == 0);
+    REQUIRE(fragments.Find(UF_FLAG_PUBLIC) == nullptr);
+
+    ByteBuffer& next = fragments.Create(UF_FLAG_PUBLIC | UPDATE_VIEW_KEY_GAMEMASTER);
+    REQUIRE(next.empty());
+    next << uint32(3);
+    REQUIRE(next.contents() == storage);
+}
+
+TEST_CASE("Spliced values updates match the updates built for each observer", "[UpdateFieldFragments]")
+{
+    Group raid;
+    TestPlayers players;
+
+    Player& tank = players.Create();
+    Player& healer = players.Create();
+    Player& outsider = players.Create();
+    Player& bystander = players.Create();
+    Player& gamemaster = players.Create(true);
+    tank.SetGroup(&raid, 0);
+    healer.SetGroup(&raid, 1);
+
+    // self, party member, public twice and gamemaster views of the tank
+    std::vector<Player*> const observers = { &tank, &healer, &outsider, &bystander, &gamemaster };
+
+    for (uint32 tick = 1; tick <= 70; ++tick)
+    {
+        ChangeFields(tank, tick);
+
+        UpdateFieldFragments fragments;
+        UpdateDataMapType spliced;
+        UpdateDataMapType built;
+        for (Player* observer : observers)
+        {
+            tank.BuildFieldsUpdate(observer, spliced, &fragments);
+            tank.BuildFieldsUpdate(observer, built);
+        }
+
+        if (IsTracked(tick))
+            REQUIRE(fragments.GetFragmentCount() == 0);
+        else
+        {
+            REQUIRE(fragments.GetFragmentCount() == 4);
+            REQUIRE(fragments.GetSharedBytes() > 0);
+        }
+
+        for (Player* observer : observers)
+        {
+            INFO("tick " << tick << ", observer " << observer->GetGUID().ToString());
+            REQUIRE(BuildPacket(spliced.at(observer)) == BuildPacket(built.at(observer)));
+        }
+    }
+
+    tank.ClearUpdateMask(false);
+}
+
+TEST_CASE("Sharing values updates with a 40 man raid", "[.][benchmark][UpdateFieldFragments]")
+{
+    // 40 raid members and a gamemaster next to a player who is not part of the raid, so every raid member sees its public fields
+    TestPlayers players;
+    Player& target = players.Create();
+
+    std::vector<Player*> observers;
+    for (uint32 i = 0; i < 40; ++i)
+        observers.push_back(&players.Create());
+    observers.push_back(&players.Create(true));
+
+    uint32 tick = 0;
+    UpdateFieldFragments fragments;
+    for (uint32 i = 0; i < 100; ++i)
+    {
+        ChangeFields(target, i * 14 + 1);
+
+        fragments.Clear();
+        UpdateDataMapType updates;
+        for (Player* observer : observers)
+            target.BuildFieldsUpdate(observer, updates, &fragments);
+    }
+
+    // serialized bytes per 100 ticks
+    CHECK(fragments.GetSharedBytes() > fragments.GetSerializedBytes() * 15);
+    INFO("serialized bytes: " << fragments.GetSerializedBytes() << ", shared bytes: " << fragments.GetSharedBytes());
+
+    UpdateDataMapType updates;
+    BENCHMARK("serialize for every observer")
+    {
+        ChangeFields(target, ++tick * 14 + 1);
+        updates.clear();
+        for (Player* observer : observers)
+            target.BuildFieldsUpdate(observer, updates);
+        return updates.size();
+    };
+
+    BENCHMARK("serialize once per view and splice")
+    {
+        ChangeFields(target, ++tick * 14 + 1);
+        fragments.Clear();
+        updates.clear();
+        for (Player* observer : observers)
+            target.BuildFieldsUpdate(observer, updates, &fragments);
+        return updates.size();
+    };
+
+    target.ClearUpdateMask(false);
+}